@@ -0,0 +1,144 @@
+/*	BenchmarkFileFormats.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <benchmark/benchmark.h>
+#include <molecular/util/Hash.h>
+#include <molecular/util/IniFile.h>
+#include <molecular/util/StringStore.h>
+#include <molecular/util/TgaFile.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace molecular;
+using namespace molecular::util;
+
+static void StringStoreFindString(benchmark::State& state)
+{
+	std::string text;
+	std::vector<Hash> hashes;
+	for(int i = 0; i < state.range(0); ++i)
+	{
+		std::string path = "textures/level" + std::to_string(i % 16) + "/texture" + std::to_string(i) + ".dds";
+		hashes.push_back(HashUtils::MakeHash(path));
+		text += path + "\n";
+	}
+	text.pop_back();
+
+	StringStore store;
+	store.LoadFromText(text.data(), text.size());
+	for(auto _: state)
+	{
+		for(auto hash: hashes)
+			benchmark::DoNotOptimize(store.FindString(hash));
+	}
+	state.SetItemsProcessed(state.iterations() * hashes.size());
+}
+BENCHMARK(StringStoreFindString)->Arg(64)->Arg(4096);
+
+static void StringStoreFindStringPerfectHash(benchmark::State& state)
+{
+	std::string text;
+	std::vector<Hash> hashes;
+	for(int i = 0; i < state.range(0); ++i)
+	{
+		std::string path = "textures/level" + std::to_string(i % 16) + "/texture" + std::to_string(i) + ".dds";
+		hashes.push_back(HashUtils::MakeHash(path));
+		text += path + "\n";
+	}
+	text.pop_back();
+
+	StringStore textStore;
+	textStore.LoadFromText(text.data(), text.size());
+	const std::vector<uint8_t> file = textStore.ToPerfectHashFile();
+	StringStore store;
+	store.LoadFromMappedFile(file.data(), file.size());
+	for(auto _: state)
+	{
+		for(auto hash: hashes)
+			benchmark::DoNotOptimize(store.FindString(hash));
+	}
+	state.SetItemsProcessed(state.iterations() * hashes.size());
+}
+BENCHMARK(StringStoreFindStringPerfectHash)->Arg(64)->Arg(4096);
+
+static void IniFileLoad(benchmark::State& state)
+{
+	std::string text;
+	for(int section = 0; section < state.range(0); ++section)
+	{
+		text += "# Material " + std::to_string(section) + "\n";
+		text += "[material" + std::to_string(section) + "]\n";
+		text += "diffuseTexture = textures/diffuse" + std::to_string(section) + ".dds\n";
+		text += "normalMap = textures/normal" + std::to_string(section) + ".dds\n";
+		text += "\tdiffuseColor = 1 0.5 0.25\n";
+		text += "specularPower=32 # Comment\n\n";
+	}
+
+	for(auto _: state)
+	{
+		IniFile file(text.data(), text.size());
+		benchmark::DoNotOptimize(file);
+	}
+	state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(IniFileLoad)->Arg(16)->Arg(256);
+
+/// Create uncompressed bottom-up BGRA TGA file
+static std::vector<uint8_t> MakeTgaFile(uint16_t width, uint16_t height)
+{
+	TgaFile2::Header header;
+	header.imageType = 2;
+	header.paletteBegin0 = header.paletteBegin1 = header.paletteLength0 = 0;
+	header.xOrigin0 = header.xOrigin1 = header.yOrigin0 = header.yOrigin1 = 0;
+	header.width0 = width & 0xff;
+	header.width1 = width >> 8;
+	header.height0 = height & 0xff;
+	header.height1 = height >> 8;
+	header.bitsPerPixel = 32;
+	header.imageDescriptor = 8; // 8 alpha bits, origin at the bottom
+
+	std::vector<uint8_t> file(sizeof(header) + width * height * 4);
+	memcpy(file.data(), &header, sizeof(header));
+	for(size_t i = sizeof(header); i < file.size(); ++i)
+		file[i] = uint8_t(i);
+	return file;
+}
+
+static void TgaFileCopyImageDataTopDown(benchmark::State& state)
+{
+	const uint16_t extent = uint16_t(state.range(0));
+	const std::vector<uint8_t> data = MakeTgaFile(extent, extent);
+	TgaFile2 file(data.data(), data.size());
+	std::vector<uint8_t> output(file.GetImageSize());
+	for(auto _: state)
+	{
+		file.CopyImageDataTopDown(output.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * output.size());
+}
+BENCHMARK(TgaFileCopyImageDataTopDown)->Arg(256)->Arg(2048);
@@ -0,0 +1,132 @@
+/*	BenchmarkGeometry.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <benchmark/benchmark.h>
+#include <molecular/util/AxisAlignedBox.h>
+#include <molecular/util/Box.h>
+#include <molecular/util/Frustum.h>
+#include <molecular/util/Math.h>
+#include <molecular/util/Matrix4.h>
+#include <molecular/util/PlaneSet.h>
+
+#include <array>
+#include <random>
+
+using namespace molecular;
+using namespace molecular::util;
+
+static Frustum MakeFrustum()
+{
+	Matrix4 projection = Matrix4::ProjectionPerspective(0.5f * Math::kPi_f, 1, 0.5, 100);
+	Matrix<4,4> view = Matrix4::RotationX(-0.5f * Math::kPi_f) * Matrix4::RotationZ(0.25f * Math::kPi_f);
+	return Frustum(projection * view);
+}
+
+/// Boxes scattered around the frustum origin, so that all intersect states occur
+static std::vector<AxisAlignedBox> MakeBoxes(size_t count)
+{
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> size(0.1f, 5.0f);
+	std::vector<AxisAlignedBox> boxes;
+	for(size_t i = 0; i < count; ++i)
+	{
+		float x = position(generator), y = position(generator), z = position(generator);
+		boxes.push_back(AxisAlignedBox(x, y, z, x + size(generator), y + size(generator), z + size(generator)));
+	}
+	return boxes;
+}
+
+static void FrustumCheckPoint(benchmark::State& state)
+{
+	const Frustum frustum = MakeFrustum();
+	const auto boxes = MakeBoxes(1024);
+	for(auto _: state)
+	{
+		for(auto& box: boxes)
+			benchmark::DoNotOptimize(frustum.Check(box.GetCenter()));
+	}
+	state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(FrustumCheckPoint);
+
+static void FrustumCheckSphere(benchmark::State& state)
+{
+	const Frustum frustum = MakeFrustum();
+	const auto boxes = MakeBoxes(1024);
+	for(auto _: state)
+	{
+		for(auto& box: boxes)
+			benchmark::DoNotOptimize(frustum.Check(box.GetCenter(), 2.0f));
+	}
+	state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(FrustumCheckSphere);
+
+static void FrustumCheckBox(benchmark::State& state)
+{
+	const Frustum frustum = MakeFrustum();
+	const auto boxes = MakeBoxes(1024);
+	for(auto _: state)
+	{
+		for(auto& box: boxes)
+			benchmark::DoNotOptimize(frustum.Check(box));
+	}
+	state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(FrustumCheckBox);
+
+static void PlaneSetClipPolygon(benchmark::State& state)
+{
+	const Frustum frustum = MakeFrustum();
+	auto planes = frustum.GetPlanes();
+	// Large quad crossing all frustum planes:
+	const std::array<Vector3, 4> polygon = {{Vector3(-200, -200, 10), Vector3(200, -200, 10), Vector3(200, 200, 10), Vector3(-200, 200, 10)}};
+	std::array<Vector3, 16> output;
+	for(auto _: state)
+	{
+		auto end = PlaneSet::ClipPolygon(planes.begin(), planes.end(), polygon.begin(), polygon.end(), output.begin());
+		benchmark::DoNotOptimize(end);
+		benchmark::ClobberMemory();
+	}
+}
+BENCHMARK(PlaneSetClipPolygon);
+
+static void BoxToAxisAligned(benchmark::State& state)
+{
+	std::vector<Box> boxes;
+	for(auto& aaBox: MakeBoxes(1024))
+	{
+		boxes.emplace_back(aaBox);
+		boxes.back().Transform(Matrix4::RotationZ(0.3f));
+	}
+	for(auto _: state)
+	{
+		for(auto& box: boxes)
+			benchmark::DoNotOptimize(box.ToAxisAligned());
+	}
+	state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(BoxToAxisAligned);
@@ -0,0 +1,123 @@
+/*	BenchmarkScope.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <benchmark/benchmark.h>
+#include <molecular/gfx/Scope.h>
+#include <molecular/gfx/ProgramProvider.h>
+#include <molecular/util/IteratorAdapters.h>
+
+using namespace molecular;
+using molecular::gfx::Uniform;
+using Scope = molecular::gfx::Scope;
+
+/// Hashes of typical variable names
+static std::vector<Hash> MakeKeys(int count, int seed = 0)
+{
+	std::vector<Hash> keys;
+	for(int i = 0; i < count; ++i)
+		keys.push_back(util::HashUtils::MakeHash("variable" + std::to_string(seed * 1000 + i)));
+	return keys;
+}
+
+/// Fills a chain of scopes similar to a render graph of the given depth
+struct ScopeChain
+{
+	ScopeChain(int depth, int variablesPerScope)
+	{
+		scopes.emplace_back(new Scope);
+		for(int i = 1; i < depth; ++i)
+			scopes.emplace_back(new Scope(*scopes.back()));
+
+		for(int i = 0; i < depth; ++i)
+		{
+			auto scopeKeys = MakeKeys(variablesPerScope, i);
+			for(auto key: scopeKeys)
+				scopes[i]->Set(key, Uniform<float>(float(i)));
+			keys.insert(keys.end(), scopeKeys.begin(), scopeKeys.end());
+		}
+	}
+
+	Scope& Leaf() {return *scopes.back();}
+
+	std::vector<std::unique_ptr<Scope>> scopes;
+	std::vector<Hash> keys;
+};
+
+static void ScopeBind(benchmark::State& state)
+{
+	const auto keys = MakeKeys(state.range(0));
+	for(auto _: state)
+	{
+		Scope scope;
+		for(auto key: keys)
+			*scope.Bind<Uniform<float>>(key) = 1.0f;
+		benchmark::DoNotOptimize(scope);
+	}
+	state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(ScopeBind)->Arg(8)->Arg(32)->Arg(128);
+
+static void ScopeGet(benchmark::State& state)
+{
+	ScopeChain chain(state.range(0), 8);
+	Scope& leaf = chain.Leaf();
+	for(auto _: state)
+	{
+		for(auto key: chain.keys)
+			benchmark::DoNotOptimize(*leaf.Get<Uniform<float>>(key));
+	}
+	state.SetItemsProcessed(state.iterations() * chain.keys.size());
+}
+BENCHMARK(ScopeGet)->Arg(1)->Arg(4)->Arg(8);
+
+static void ScopeToMap(benchmark::State& state)
+{
+	ScopeChain chain(state.range(0), 8);
+	Scope& leaf = chain.Leaf();
+	for(auto _: state)
+	{
+		auto map = leaf.ToMap();
+		benchmark::DoNotOptimize(map);
+	}
+}
+BENCHMARK(ScopeToMap)->Arg(1)->Arg(4)->Arg(8);
+
+/// Lookup into ProgramProvider with the variable set of a typical draw call
+/** The cache is empty because filling it requires a GL context, so this measures
+	hash combination and the hash table probe. */
+static void ProgramProviderFindProgram(benchmark::State& state)
+{
+	ScopeChain chain(4, state.range(0) / 4);
+	auto variables = chain.Leaf().ToMap();
+	gfx::RenderCmdSink renderer;
+	programgenerator::ProgramGenerator generator;
+	gfx::ProgramProvider provider(renderer, generator);
+	for(auto _: state)
+	{
+		auto program = provider.FindProgram(util::MakePairFirstIterator(variables.begin()), util::MakePairFirstIterator(variables.end()));
+		benchmark::DoNotOptimize(program);
+	}
+}
+BENCHMARK(ProgramProviderFindProgram)->Arg(16)->Arg(32)->Arg(64);
@@ -0,0 +1,53 @@
+/*	BenchmarkTerrain.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <benchmark/benchmark.h>
+#include <molecular/gfx/functions/DrawTerrain.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace molecular;
+using namespace molecular::gfx;
+
+static void DrawTerrainGenerateNormalMap(benchmark::State& state)
+{
+	const unsigned int extent = state.range(0);
+	std::vector<float> heightmap(extent * extent);
+	for(unsigned int y = 0; y < extent; y++)
+	{
+		for(unsigned int x = 0; x < extent; x++)
+			heightmap[y * extent + x] = std::sin(x * 0.1f) * std::sin(y * 0.1f) * 20;
+	}
+
+	std::vector<uint8_t> normalMap(extent * extent * 4);
+	for(auto _: state)
+	{
+		DrawTerrain::GenerateNormalMap(extent, extent, heightmap.data(), 1.0f, 0.1f, 0.1f, normalMap.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * heightmap.size());
+}
+BENCHMARK(DrawTerrainGenerateNormalMap)->Arg(257)->Arg(1025);
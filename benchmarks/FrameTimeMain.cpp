@@ -0,0 +1,147 @@
+/*	FrameTimeMain.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file FrameTimeMain.cpp
+	Measures CPU frame times of a SyntheticScene in a hidden window or an EGL offscreen context. */
+
+#include "SyntheticScene.h"
+
+#include <molecular/gfx/glfw/GlfwContext.h>
+#include <molecular/gfx/glfw/GlfwFileLoader.h>
+#include <molecular/gfx/glfw/GlfwRenderManager.h>
+#include <molecular/gfx/glfw/GlfwWindow.h>
+#include <molecular/gfx/RenderManager.h>
+#if OpenGL_EGL_FOUND
+#include <molecular/gfx/opengl/EglOffscreenContext.h>
+#endif
+
+#include <molecular/util/CommandLineParser.h>
+#include <molecular/util/FileServer.h>
+#include <molecular/util/TaskDispatcher.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+using namespace molecular;
+using namespace molecular::gfx;
+using RenderManager = GlfwRenderManager;
+
+/// Get percentile from sorted values
+static double Percentile(const std::vector<double>& sortedValues, double percentile)
+{
+	size_t index = std::min(sortedValues.size() - 1, size_t(percentile * sortedValues.size()));
+	return sortedValues[index];
+}
+
+void Run(int argc, char** argv)
+{
+	CommandLineParser cmd;
+	CommandLineParser::Option<std::string> assetDir(cmd, "asset-dir", "Asset directory", "assets");
+	CommandLineParser::Option<std::string> mesh(cmd, "mesh", "Mesh file drawn by every object", "mesh.nmb");
+	CommandLineParser::Option<int> objects(cmd, "objects", "Number of DrawMesh instances", 1000);
+	CommandLineParser::Option<int> materials(cmd, "materials", "Number of distinct materials", 10);
+	CommandLineParser::Option<int> lights(cmd, "lights", "Number of SetupLight functions", 1);
+	CommandLineParser::Option<int> csm(cmd, "csm", "Enable cascaded shadow mapping if not 0", 0);
+	CommandLineParser::Option<int> warmupFrames(cmd, "warmup-frames", "Frames to draw before measuring, for loading assets", 100);
+	CommandLineParser::Option<int> frames(cmd, "frames", "Number of measured frames", 1000);
+#if OpenGL_EGL_FOUND
+	CommandLineParser::Option<int> headless(cmd, "headless", "Render into an EGL offscreen context instead of a hidden window if not 0", 0);
+#endif
+	cmd.Parse(argc, argv);
+
+	TaskDispatcher dispatcher;
+	GlfwFileLoader fileLoader(dispatcher);
+	FileServer<GlfwFileLoader> fileServer(fileLoader, *assetDir, dispatcher);
+
+	std::unique_ptr<GlfwWindow> window;
+	std::unique_ptr<RenderContext> renderContext;
+#if OpenGL_EGL_FOUND
+	if(*headless != 0)
+		renderContext.reset(new EglOffscreenContext(1280, 720));
+	else
+#endif
+	{
+		window.reset(new GlfwWindow("molecular-gfx-frametime", false));
+		glfwSwapInterval(0);
+		renderContext.reset(new GlfwContext(window->GetWindow()));
+	}
+	RenderContext& context = *renderContext;
+	RenderCmdSink commandSink;
+	RenderManager renderManager(context, fileServer, dispatcher, commandSink);
+
+	SyntheticScene<RenderManager>::Parameters parameters;
+	parameters.objectCount = *objects;
+	parameters.materialCount = *materials;
+	parameters.lightCount = *lights;
+	parameters.cascadedShadowMapping = (*csm != 0);
+	parameters.mesh = HashUtils::MakeHash(*mesh);
+	SyntheticScene<RenderManager> scene(renderManager, parameters);
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve(*frames);
+	for(int i = 0; i < *warmupFrames + *frames; ++i)
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		auto start = std::chrono::steady_clock::now();
+		renderManager.DrawOneFrame(scene.GetRoot());
+		auto end = std::chrono::steady_clock::now();
+		// Keep GPU work from piling up, but leave it out of the measurement:
+		glFinish();
+		if(i >= *warmupFrames)
+			frameTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+		if(window)
+			glfwPollEvents();
+	}
+
+	if(frameTimes.empty())
+		return;
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	std::cout << "objects=" << *objects
+			<< " materials=" << *materials
+			<< " lights=" << *lights
+			<< " csm=" << *csm
+			<< " frames=" << frameTimes.size()
+			<< " p50=" << Percentile(frameTimes, 0.5)
+			<< "ms p95=" << Percentile(frameTimes, 0.95)
+			<< "ms p99=" << Percentile(frameTimes, 0.99)
+			<< "ms max=" << frameTimes.back() << "ms" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		Run(argc, argv);
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/*	SyntheticScene.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_GFX_SYNTHETICSCENE_H
+#define MOLECULAR_GFX_SYNTHETICSCENE_H
+
+#include <molecular/gfx/functions/CascadedShadowMapping.h>
+#include <molecular/gfx/functions/DrawMesh.h>
+#include <molecular/gfx/functions/FlatScene.h>
+#include <molecular/gfx/functions/SetupLight.h>
+#include <molecular/gfx/functions/Transform.h>
+#include <molecular/gfx/functions/ViewSetup.h>
+#include <molecular/util/Math.h>
+#include <molecular/util/Quaternion.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace molecular
+{
+namespace gfx
+{
+
+/// Parameterized render graph for scaling measurements
+/** Builds ViewSetup -> SetupLight (lightCount times) -> [CascadedShadowMapping] -> FlatScene,
+	with objectCount Transform -> DrawMesh pairs below the FlatScene. Objects are distributed
+	pseudo-randomly, so results are reproducible for a given seed.
+
+	Each material sets a distinct uniform, so every material results in its own program in the
+	ProgramProvider. SetupLight only supports a single directional light, so additional lights
+	only add scope and uniform overhead. */
+template<class TRenderManager>
+class SyntheticScene
+{
+public:
+	struct Parameters
+	{
+		unsigned int objectCount = 1000;
+		unsigned int materialCount = 10;
+		unsigned int lightCount = 1;
+		bool cascadedShadowMapping = false;
+
+		/// Mesh file drawn by every object
+		Hash mesh = 0;
+
+		/// Objects are placed within a cube of this edge length
+		float extent = 100.0f;
+		unsigned int seed = 1;
+	};
+
+	SyntheticScene(TRenderManager& manager, const Parameters& parameters);
+
+	/// Root of the render graph, to be passed to RenderManager::DrawOneFrame()
+	RenderFunction& GetRoot() {return mViewSetup;}
+
+	ViewSetup& GetViewSetup() {return mViewSetup;}
+
+private:
+	ViewSetup mViewSetup;
+	std::vector<std::unique_ptr<SetupLight>> mLights;
+	std::unique_ptr<CascadedShadowMapping> mShadowMapping;
+	FlatScene mScene;
+	std::vector<std::unique_ptr<Transform>> mTransforms;
+	std::vector<std::unique_ptr<DrawMesh<TRenderManager>>> mMeshes;
+};
+
+/*****************************************************************************/
+
+template<class TRenderManager>
+SyntheticScene<TRenderManager>::SyntheticScene(TRenderManager& manager, const Parameters& parameters) :
+	mViewSetup(manager),
+	mScene(manager)
+{
+	std::mt19937 generator(parameters.seed);
+	std::uniform_real_distribution<float> position(-0.5f * parameters.extent, 0.5f * parameters.extent);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	mViewSetup.SetCamera(Vector3(-parameters.extent, 0, 0), Quaternion::kIdentity);
+	mViewSetup.SetProjectionPerspective(0.3f * util::Math::kPi_f, 0.1f, 2.0f * parameters.extent);
+
+	SingleCalleeRenderFunction* parent = &mViewSetup;
+	for(unsigned int i = 0; i < parameters.lightCount; ++i)
+	{
+		mLights.emplace_back(new SetupLight(manager));
+		mLights.back()->SetDirectionalLight(true, Vector3(unit(generator) - 0.5f, -1, unit(generator) - 0.5f));
+		parent->SetCallee(mLights.back().get());
+		parent = mLights.back().get();
+	}
+
+	if(parameters.cascadedShadowMapping)
+	{
+		mShadowMapping.reset(new CascadedShadowMapping(manager));
+		mShadowMapping->SetShadowDrawingDistance(parameters.extent);
+		parent->SetCallee(mShadowMapping.get());
+		parent = mShadowMapping.get();
+	}
+	parent->SetCallee(&mScene);
+
+	for(unsigned int i = 0; i < parameters.objectCount; ++i)
+	{
+		mMeshes.emplace_back(new DrawMesh<TRenderManager>(manager));
+		mMeshes.back()->SetMeshFile(parameters.mesh);
+
+		mTransforms.emplace_back(new Transform(manager));
+		Transform& transform = *mTransforms.back();
+		transform.SetTransform(Matrix4::Translation(position(generator), position(generator), position(generator)));
+		transform.SetCallee(mMeshes.back().get());
+		if(parameters.materialCount > 0)
+		{
+			unsigned int material = i % parameters.materialCount;
+			transform.SetUniform("diffuseColor"_H, Vector3(unit(generator), unit(generator), unit(generator)));
+			transform.SetUniform(HashUtils::MakeHash("syntheticMaterial" + std::to_string(material)), 1.0f);
+		}
+		mScene.Insert(&transform);
+	}
+}
+
+}
+}
+
+#endif // MOLECULAR_GFX_SYNTHETICSCENE_H
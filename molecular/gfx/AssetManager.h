@@ -27,10 +27,14 @@ SOFTWARE.
 #define MOLECULAR_ASSETMANAGER_H
 
 #include <molecular/util/Hash.h>
+#include <molecular/util/Logging.h>
 #include <molecular/util/NonCopyable.h>
 #include <unordered_map>
+#include <algorithm>
 #include <cassert>
 #include <array>
+#include <limits>
+#include <vector>
 
 
 namespace molecular
@@ -59,6 +63,12 @@ class AssetManager : util::NonCopyable
 public:
 	class Asset;
 
+	static const unsigned int kLodLevels = lodLevels;
+
+	/// Priority of requests that do not specify one
+	/** Higher than any on-screen size, so these are loaded first. */
+	static constexpr float kDefaultPriority = std::numeric_limits<float>::max();
+
 	/// Interface to an asset loader
 	/** This has to be implemented for each new AssetManager class. */
 	class Loader
@@ -66,6 +76,12 @@ public:
 	public:
 		virtual T Create() = 0;
 		virtual void Destroy(T& asset) = 0;
+
+		/// Start loading levels minLevel to maxLevel
+		/** The load occupies one of SetMaxLoadsInFlight() slots until every
+			level is no longer kLoading. So each level has to end up kLoaded,
+			kNotLoaded or kFailed, on errors too. Exceptions mark all levels
+			as kFailed. */
 		virtual void StartLoad(Asset& asset, unsigned int minLevel, unsigned int maxLevel) = 0;
 		virtual void Unload(T& asset, unsigned int minLevel, unsigned int maxLevel) = 0;
 
@@ -83,8 +99,11 @@ public:
 		friend class AssetManager;
 	public:
 		/// Initiate loading if necessary and return underlying object
-		/** Using specific texture LOD levels is not supported on GLES. */
-		T Use(unsigned int lodLevel = 0);
+		/** Using specific texture LOD levels is not supported on GLES.
+			@param priority Importance of the request, usually the size on
+				screen in pixels. The highest priority passed in a frame
+				counts. Loads are started in order of priority. */
+		T Use(unsigned int lodLevel = 0, float priority = kDefaultPriority);
 
 		/// Current loading state
 		enum State
@@ -97,7 +116,12 @@ public:
 
 		/** Used by Loader classes. */
 		void SetState(unsigned int lodLevel, State state) {assert(lodLevel < lodLevels); mStates[lodLevel] = state;}
-//		State GetState(unsigned int lodLevel) {return mStates[lodLevel];}
+		State GetState(unsigned int lodLevel) const {assert(lodLevel < lodLevels); return mStates[lodLevel];}
+
+		/// Set memory used by a LOD level in bytes
+		/** Used by Loader classes. Counts towards the memory budget while the
+			level is loaded. */
+		void SetSize(unsigned int lodLevel, size_t size) {assert(lodLevel < lodLevels); mSizes[lodLevel] = size;}
 
 		/// Get the underlying object
 		/** Does not initiate loading. Used by Loader classes. */
@@ -106,32 +130,72 @@ public:
 		/** Used by Loader classes. */
 		const Location& GetLocation() {return mLocation;}
 
+		/// Check if a level was used recently enough to still be worth loading
+		/** Loader classes can check this before uploading data to skip levels
+			that were cancelled while their I/O was running. Such levels should
+			be set to kNotLoaded. */
+		bool IsWanted(unsigned int lodLevel) const
+		{
+			assert(lodLevel < lodLevels);
+			return mLastUsed[lodLevel] >= mManager.mFramecounter - mManager.mCancelAfterFrames;
+		}
+
 	private:
-		Asset(Loader& loader, const Location& location) :
+		Asset(AssetManager& manager, const Location& location) :
 			mLocation(location),
-			mAsset(loader.Create()),
-			mLoader(loader)
+			mAsset(manager.mLoader.Create()),
+			mManager(manager)
 		{
 			mLastUsed.fill(0);
 			mStates.fill(kNotLoaded);
+			mSizes.fill(0);
 		}
 		Asset(Asset&) = delete;
 
 		~Asset()
 		{
-			mLoader.Destroy(mAsset);
+			mManager.mLoader.Destroy(mAsset);
 		}
 		Asset& operator=(Asset&) = delete;
 
 		std::array<int, lodLevels> mLastUsed; // Frame counter
 		std::array<State, lodLevels> mStates;
+		std::array<size_t, lodLevels> mSizes;
 		Location mLocation;
 		T mAsset;
-		Loader& mLoader;
+		AssetManager& mManager;
+		float mPriority = 0;
+		int mPriorityFrame = -1;
 	};
 
+	/// Start queued loads and unload levels not used recently
+	/** Call once per frame. Queued loads are started highest priority first
+		while fewer than SetMaxLoadsInFlight() are running. Queued loads not
+		used for SetCancelAfterFrames() frames are dropped. Unloads if over
+		the memory budget. */
 	void Update(int framecounter);
 
+	/// Maximum number of loads handed to the Loader at the same time
+	/** 0 means no limit. */
+	void SetMaxLoadsInFlight(unsigned int count) {mMaxLoadsInFlight = count;}
+
+	/// Frames without use after which queued loads are cancelled
+	void SetCancelAfterFrames(int frames) {mCancelAfterFrames = frames;}
+
+	/// Number of loads waiting to be started
+	size_t GetQueuedLoadCount() const {return mQueuedLoads.size();}
+
+	/// Set memory budget in bytes
+	/** Update() unloads levels not used in the current or previous frame,
+		least recently used first, until the loaded levels fit. Only sizes
+		reported with Asset::SetSize() count. With mipmapStyle, larger levels
+		are unloaded first and the smallest level stays loaded. 0 disables
+		unloading, which is the default. */
+	void SetMemoryBudget(size_t bytes) {mMemoryBudget = bytes;}
+
+	/// Memory used by loaded levels as reported by the Loader
+	size_t GetMemoryUsage() const;
+
 	/// Get Asset object for given location
 	/** Loading is not initiated. Use Asset::Use for that. */
 	Asset* GetAsset(const Location& location);
@@ -140,7 +204,28 @@ protected:
 
 
 private:
+	/// Range of levels requested together
+	struct Load
+	{
+		Asset* asset;
+		unsigned int minLevel;
+		unsigned int maxLevel;
+	};
+
+	/// Start queued loads, drop stale ones
+	void StartLoads();
+
+	/// Unload levels if over the memory budget
+	void EnforceMemoryBudget();
+
 	Loader& mLoader;
+	int mFramecounter = 0;
+	size_t mMemoryBudget = 0;
+	unsigned int mMaxLoadsInFlight = 8;
+	int mCancelAfterFrames = 10;
+
+	std::vector<Load> mQueuedLoads;
+	std::vector<Load> mLoadsInFlight;
 
 	/** Entries are currently never removed during normal operation. */
 	std::unordered_map<Hash, Asset*> mAssets;
@@ -153,7 +238,7 @@ typename AssetManager<T, lodLevels, mipmapStyle, Location>::Asset* AssetManager<
 	auto it = mAssets.find(hash);
 	if(it == mAssets.end())
 	{
-		Asset* asset = new Asset(mLoader, location);
+		Asset* asset = new Asset(*this, location);
 		mAssets.insert(std::make_pair(hash, asset));
 		return asset;
 	}
@@ -181,31 +266,172 @@ AssetManager<T, lodLevels, mipmapStyle, Location>::~AssetManager()
 }
 
 template<class T, int lodLevels, bool mipmapStyle, class Location>
-T AssetManager<T, lodLevels, mipmapStyle, Location>::Asset::Use(unsigned int lodLevel)
+T AssetManager<T, lodLevels, mipmapStyle, Location>::Asset::Use(unsigned int lodLevel, float priority)
 {
 	assert(lodLevel < lodLevels);
+	const int framecounter = mManager.mFramecounter;
+	if(mPriorityFrame != framecounter || priority > mPriority)
+	{
+		mPriority = priority;
+		mPriorityFrame = framecounter;
+	}
 
 	unsigned int maxLevel = lodLevel;
 	if(mipmapStyle)
 	{
+		// Smallest level first, so there is something to draw early:
+		if(lodLevel < lodLevels - 1 && mStates[lodLevels - 1] == kNotLoaded)
+			Use(lodLevels - 1, priority);
+
+		// Drawing with a level can sample all smaller levels:
+		for(unsigned int i = lodLevel; i < lodLevels; ++i)
+			mLastUsed[i] = framecounter;
+
 		while(maxLevel < lodLevels && mStates[maxLevel] == kNotLoaded)
 			maxLevel++;
 		maxLevel--;
 	}
+	else
+		mLastUsed[lodLevel] = framecounter;
 
 	if(mStates[lodLevel] == kNotLoaded)
 	{
-		mStates[lodLevel] = kLoading;
-		mLoader.StartLoad(*this, lodLevel, maxLevel);
+		// Queued levels count as loading so they are not queued twice:
+		for(unsigned int i = lodLevel; i <= maxLevel; ++i)
+			mStates[i] = kLoading;
+		mManager.mQueuedLoads.push_back(Load{this, lodLevel, maxLevel});
 	}
 
 	return mAsset;
 }
 
 template<class T, int lodLevels, bool mipmapStyle, class Location>
-void AssetManager<T, lodLevels, mipmapStyle, Location>::Update(int /*framecounter*/)
+void AssetManager<T, lodLevels, mipmapStyle, Location>::Update(int framecounter)
+{
+	mFramecounter = framecounter;
+	StartLoads();
+	EnforceMemoryBudget();
+}
+
+template<class T, int lodLevels, bool mipmapStyle, class Location>
+void AssetManager<T, lodLevels, mipmapStyle, Location>::StartLoads()
+{
+	// Loads are done when the Loader changed the state of all levels:
+	mLoadsInFlight.erase(std::remove_if(mLoadsInFlight.begin(), mLoadsInFlight.end(), [](const Load& load){
+		for(unsigned int i = load.minLevel; i <= load.maxLevel; ++i)
+		{
+			if(load.asset->mStates[i] == Asset::kLoading)
+				return false;
+		}
+		return true;
+	}), mLoadsInFlight.end());
+
+	// Cancel loads nobody asked for recently:
+	mQueuedLoads.erase(std::remove_if(mQueuedLoads.begin(), mQueuedLoads.end(), [](const Load& load){
+		if(load.asset->IsWanted(load.minLevel))
+			return false;
+		for(unsigned int i = load.minLevel; i <= load.maxLevel; ++i)
+			load.asset->mStates[i] = Asset::kNotLoaded;
+		return true;
+	}), mQueuedLoads.end());
+
+	// Stable, so the smallest mipmap level queued first stays first:
+	std::stable_sort(mQueuedLoads.begin(), mQueuedLoads.end(), [](const Load& a, const Load& b){
+		return a.asset->mPriority > b.asset->mPriority;
+	});
+
+	size_t started = 0;
+	for(; started < mQueuedLoads.size(); ++started)
+	{
+		if(mMaxLoadsInFlight != 0 && mLoadsInFlight.size() >= mMaxLoadsInFlight)
+			break;
+		const Load& load = mQueuedLoads[started];
+		mLoadsInFlight.push_back(load);
+		try
+		{
+			mLoader.StartLoad(*load.asset, load.minLevel, load.maxLevel);
+		}
+		catch(std::exception& e)
+		{
+			LOG(ERROR) << "Error starting load: " << e.what();
+			for(unsigned int i = load.minLevel; i <= load.maxLevel; ++i)
+				load.asset->mStates[i] = Asset::kFailed;
+		}
+	}
+	mQueuedLoads.erase(mQueuedLoads.begin(), mQueuedLoads.begin() + started);
+}
+
+template<class T, int lodLevels, bool mipmapStyle, class Location>
+void AssetManager<T, lodLevels, mipmapStyle, Location>::EnforceMemoryBudget()
+{
+	const int framecounter = mFramecounter;
+	if(mMemoryBudget == 0)
+		return;
+
+	size_t usage = GetMemoryUsage();
+	if(usage <= mMemoryBudget)
+		return;
+
+	struct Candidate
+	{
+		Asset* asset;
+		unsigned int level;
+		int lastUsed;
+	};
+
+	std::vector<Candidate> candidates;
+	const unsigned int unloadableLevels = mipmapStyle ? lodLevels - 1 : lodLevels;
+	for(auto& it: mAssets)
+	{
+		Asset& asset = *it.second;
+		for(unsigned int i = 0; i < unloadableLevels; ++i)
+		{
+			if(asset.mStates[i] == Asset::kLoaded && asset.mSizes[i] > 0 && asset.mLastUsed[i] < framecounter - 1)
+				candidates.push_back(Candidate{&asset, i, asset.mLastUsed[i]});
+		}
+	}
+
+	// Least recently used first, larger levels first if used at the same time:
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b){
+		return a.lastUsed < b.lastUsed || (a.lastUsed == b.lastUsed && a.level < b.level);
+	});
+
+	for(auto& candidate: candidates)
+	{
+		if(usage <= mMemoryBudget)
+			break;
+
+		Asset& asset = *candidate.asset;
+		if(mipmapStyle)
+		{
+			// Do not leave gaps between loaded levels:
+			bool largerLevelLoaded = false;
+			for(unsigned int i = 0; i < candidate.level; ++i)
+				largerLevelLoaded |= (asset.mStates[i] == Asset::kLoaded || asset.mStates[i] == Asset::kLoading);
+			if(largerLevelLoaded)
+				continue;
+		}
+
+		mLoader.Unload(asset.mAsset, candidate.level, candidate.level);
+		asset.mStates[candidate.level] = Asset::kNotLoaded;
+		usage -= asset.mSizes[candidate.level];
+		asset.mSizes[candidate.level] = 0;
+	}
+}
+
+template<class T, int lodLevels, bool mipmapStyle, class Location>
+size_t AssetManager<T, lodLevels, mipmapStyle, Location>::GetMemoryUsage() const
 {
-	// TODO
+	size_t usage = 0;
+	for(auto& it: mAssets)
+	{
+		for(unsigned int i = 0; i < lodLevels; ++i)
+		{
+			if(it.second->mStates[i] == Asset::kLoaded)
+				usage += it.second->mSizes[i];
+		}
+	}
+	return usage;
 }
 
 }
@@ -24,6 +24,9 @@ SOFTWARE.
 */
 
 #include "DefaultProgramData.h"
+#include <molecular/programgenerator/ProgramFile.h>
+
+#include <string>
 
 namespace molecular
 {
@@ -32,8 +35,90 @@ namespace gfx
 using namespace programgenerator;
 using namespace util;
 
+/// Decoding of quantized vertex attributes written by molecular-meshcook
+/** Positions are 16 bit normalized within the mesh bounds, DrawMeshData sets
+	scale and offset. Normals and tangents are octahedral encoded, tangents
+	with the sign of the bitangent in z. */
+static const char kQuantizedAttributes[] =
+		"vertex\n"
+		"vec4 vertexPosition(attr vec4 vertexPositionQuantizedAttr, vec3 vertexPositionScale, vec3 vertexPositionOffset)\n"
+		"{\n"
+		"\tvertexPosition = vec4(vertexPositionQuantizedAttr.xyz * vertexPositionScale + vertexPositionOffset, 1.0);\n"
+		"}\n"
+		"\n"
+		"vertex\n"
+		"vec3 vertexNormal(attr vec2 vertexNormalOctAttr)\n"
+		"{\n"
+		"\tvec3 _n = vec3(vertexNormalOctAttr, 1.0 - abs(vertexNormalOctAttr.x) - abs(vertexNormalOctAttr.y));\n"
+		"\tfloat _t = max(-_n.z, 0.0);\n"
+		"\t_n.xy += vec2(_n.x >= 0.0 ? -_t : _t, _n.y >= 0.0 ? -_t : _t);\n"
+		"\tvertexNormal = normalize(_n);\n"
+		"}\n"
+		"\n"
+		"vertex\n"
+		"vec4 vertexTangent(attr vec4 vertexTangentOctAttr)\n"
+		"{\n"
+		"\tvec3 _n = vec3(vertexTangentOctAttr.xy, 1.0 - abs(vertexTangentOctAttr.x) - abs(vertexTangentOctAttr.y));\n"
+		"\tfloat _t = max(-_n.z, 0.0);\n"
+		"\t_n.xy += vec2(_n.x >= 0.0 ? -_t : _t, _n.y >= 0.0 ? -_t : _t);\n"
+		"\tvertexTangent = vec4(normalize(_n), vertexTangentOctAttr.z < 0.0 ? -1.0 : 1.0);\n"
+		"}\n";
+
+/// Blending of morph target deltas set up by DrawMeshData
+/** One variant per number of active targets. Variants with more targets have
+	higher priority, so all bound deltas get applied. Quantized positions and
+	normals are not morphed. */
+static std::string MakeMorphTargetFunctions()
+{
+	std::string text;
+	for(unsigned int count = 1; count <= DefaultProgramData::kMaxActiveMorphTargets; ++count)
+	{
+		std::string positionInputs, positionSum, normalInputs, normalSum;
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const std::string index = std::to_string(i);
+			positionInputs += ", attr vec3 morphPositionDelta" + index + "Attr";
+			positionSum += " + morphPositionDelta" + index + "Attr * morphWeights[" + index + "]";
+			normalInputs += ", attr vec3 morphNormalDelta" + index + "Attr";
+			normalSum += " + morphNormalDelta" + index + "Attr * morphWeights[" + index + "]";
+		}
+		text += "vertex\n"
+				"vec4 vertexPosition(attr vec4 vertexPositionAttr" + positionInputs + ", vec4 morphWeights)\n"
+				"{\n"
+				"\tvertexPosition = vec4(vertexPositionAttr.xyz" + positionSum + ", vertexPositionAttr.w);\n"
+				"}\n"
+				"\n"
+				"vertex\n"
+				"vec3 vertexNormal(attr vec3 vertexNormalAttr" + normalInputs + ", vec4 morphWeights)\n"
+				"{\n"
+				"\tvertexNormal = normalize(vertexNormalAttr" + normalSum + ");\n"
+				"}\n"
+				"\n";
+	}
+	return text;
+}
+
+/// Add variables and functions of a program file
+/** @param priority If not 0, functions get this plus their number of inputs
+		as priority, so variants with more inputs are preferred. */
+static void AddProgramFile(ProgramGenerator& generator, std::string text, int priority = 0)
+{
+	ProgramFile file(&text[0], &text[0] + text.size());
+	for(auto& variable: file.GetVariables())
+		generator.AddVariable(variable);
+	for(auto function: file.GetFunctions())
+	{
+		if(priority)
+			function.priority = priority + static_cast<int>(function.inputs.size());
+		generator.AddFunction(function);
+	}
+}
+
 void DefaultProgramData::FeedToGenerator(ProgramGenerator& generator)
 {
+	AddProgramFile(generator, kQuantizedAttributes);
+	AddProgramFile(generator, MakeMorphTargetFunctions(), 1);
+
 	ProgramGenerator::Function specularArray;
 	specularArray.stage = ProgramGenerator::Function::Stage::kFragmentStage;
 	specularArray.source.push_back(
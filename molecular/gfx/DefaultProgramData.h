@@ -37,6 +37,11 @@ namespace gfx
 class DefaultProgramData
 {
 public:
+	/// Morph targets blended in the vertex shader at once
+	/** Attributes are morphPositionDelta0Attr, morphNormalDelta0Attr and so
+		on, the weights are in the vec4 morphWeights. */
+	static const unsigned int kMaxActiveMorphTargets = 4;
+
 	static void FeedToGenerator(programgenerator::ProgramGenerator& generator);
 };
 
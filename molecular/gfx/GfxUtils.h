@@ -26,9 +26,13 @@ SOFTWARE.
 #ifndef MOLECULAR_GFXUTILS_H
 #define MOLECULAR_GFXUTILS_H
 
+#include <molecular/util/AxisAlignedBox.h>
+#include <molecular/util/Vector2.h>
 #include <molecular/util/Vector3.h>
 #include <molecular/util/Matrix4.h>
 
+#include <algorithm>
+
 namespace molecular
 {
 namespace gfx
@@ -41,7 +45,7 @@ using namespace util;
 	@param view View matrix.
 	@param point Point to unproject in normalised device coordinates (from -1 to 1 in all axes).
 	@returns Point in world coordinates. */
-Vector3 Unproject(const Matrix4& proj, const Matrix4& view, const Vector3& point)
+inline Vector3 Unproject(const Matrix4& proj, const Matrix4& view, const Vector3& point)
 {
 	Matrix4 unproj = (proj * view).Inverse();
 	Vector4 worldCoords = unproj * Vector4(point, 1.0f);
@@ -49,6 +53,32 @@ Vector3 Unproject(const Matrix4& proj, const Matrix4& view, const Vector3& point
 	return Vector3(worldCoords[0] * div, worldCoords[1] * div, worldCoords[2] * div);
 }
 
+/// Size of a box on screen
+/** @param modelViewProjection Transforms box coordinates to clip space.
+	@param viewportSize Viewport width and height in pixels.
+	@returns Larger extent of the projected box in pixels. Boxes reaching
+		behind the camera get the larger viewport extent. */
+inline float ScreenFootprint(const Matrix4& modelViewProjection, const AxisAlignedBox& box, const Vector2& viewportSize)
+{
+	const Vector3& min = box.GetMin();
+	const Vector3& max = box.GetMax();
+	float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+	for(int corner = 0; corner < 8; ++corner)
+	{
+		const Vector4 position((corner & 4) ? max[0] : min[0], (corner & 2) ? max[1] : min[1], (corner & 1) ? max[2] : min[2], 1.0f);
+		const Vector4 clip = modelViewProjection * position;
+		if(clip[3] <= 0.0f)
+			return std::max(viewportSize[0], viewportSize[1]);
+		const float x = clip[0] / clip[3];
+		const float y = clip[1] / clip[3];
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+	}
+	return std::max((maxX - minX) * 0.5f * viewportSize[0], (maxY - minY) * 0.5f * viewportSize[1]);
+}
+
 }
 }
 
@@ -29,6 +29,10 @@ SOFTWARE.
 #include <molecular/util/AxisAlignedBox.h>
 #include <molecular/util/Hash.h>
 
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
 namespace molecular
 {
 namespace gfx
@@ -39,12 +43,16 @@ static_assert(sizeof(util::AxisAlignedBox) == 6 * sizeof(float), "AxisAlignedBox
 
 /// File format for collection of bounding boxes
 /** Associates hash values to bounding boxes. Used to determine if meshes are in view and have to be
-	loaded. */
+	loaded. With kMagicHashed, hashes and boxes are stored in an open-addressing hash table with
+	count slots, count being a power of two. An entry lives in slot hash & (count - 1) or, on
+	collision, in one of the following slots. Empty slots have hash 0. Such files are built at cook
+	time with BuildHashed(). */
 struct MeshBoundsCollectionFile
 {
 	static const uint32_t kMagic = 0x505eb0f1;
+	static const uint32_t kMagicHashed = 0x505eb0f2;
 	uint32_t magic;
-	uint32_t count;
+	uint32_t count; ///< Number of entries, number of slots with kMagicHashed
 	uint32_t hashes[0];
 
 	const util::AxisAlignedBox& GetBoundsByIndex(unsigned int index) const
@@ -53,8 +61,25 @@ struct MeshBoundsCollectionFile
 		return boxes[index];
 	}
 
+	/// Check if an index refers to an empty slot of a hashed file
+	bool IsEmpty(unsigned int index) const {return magic == kMagicHashed && hashes[index] == 0;}
+
 	const util::AxisAlignedBox& GetBounds(Hash mesh) const
 	{
+		if(magic == kMagicHashed)
+		{
+			const uint32_t mask = count - 1;
+			uint32_t slot = mesh & mask;
+			for(uint32_t i = 0; i < count; ++i, slot = (slot + 1) & mask)
+			{
+				if(hashes[slot] == 0)
+					break;
+				if(hashes[slot] == mesh)
+					return GetBoundsByIndex(slot);
+			}
+			return util::AxisAlignedBox::kDefault;
+		}
+
 		for(unsigned int i = 0; i < count; ++i)
 		{
 			if(hashes[i] == mesh)
@@ -63,8 +88,53 @@ struct MeshBoundsCollectionFile
 
 		return util::AxisAlignedBox::kDefault;
 	}
+
+	/// Number of slots for a given number of meshes
+	/** Keeps the load factor at or below 0.5. */
+	static uint32_t GetTableSize(uint32_t count)
+	{
+		uint32_t tableSize = 1;
+		while(tableSize < count * 2)
+			tableSize *= 2;
+		return tableSize;
+	}
+
+	/// Build file contents with hash table
+	/** Throws std::runtime_error if a hash is 0 or occurs twice. */
+	static std::vector<uint8_t> BuildHashed(const Hash* meshes, const util::AxisAlignedBox* bounds, uint32_t count);
 };
 
+/*****************************************************************************/
+
+inline std::vector<uint8_t> MeshBoundsCollectionFile::BuildHashed(const Hash* meshes, const util::AxisAlignedBox* bounds, uint32_t count)
+{
+	const uint32_t tableSize = GetTableSize(count);
+	const uint32_t mask = tableSize - 1;
+	std::vector<uint8_t> contents(sizeof(MeshBoundsCollectionFile) + tableSize * (sizeof(Hash) + sizeof(util::AxisAlignedBox)), 0);
+	MeshBoundsCollectionFile& file = *reinterpret_cast<MeshBoundsCollectionFile*>(contents.data());
+	file.magic = kMagicHashed;
+	file.count = tableSize;
+	util::AxisAlignedBox* boxes = const_cast<util::AxisAlignedBox*>(&file.GetBoundsByIndex(0));
+	for(uint32_t i = 0; i < tableSize; ++i)
+		boxes[i] = util::AxisAlignedBox::kDefault;
+
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		if(meshes[i] == 0)
+			throw std::runtime_error("Mesh hash 0 cannot be stored in hashed bounds collection");
+		uint32_t slot = meshes[i] & mask;
+		while(file.hashes[slot] != 0)
+		{
+			if(file.hashes[slot] == meshes[i])
+				throw std::runtime_error("Duplicate mesh in bounds collection");
+			slot = (slot + 1) & mask;
+		}
+		file.hashes[slot] = meshes[i];
+		boxes[slot] = bounds[i];
+	}
+	return contents;
+}
+
 }
 }
 
@@ -0,0 +1,940 @@
+/*	MeshCooking.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "MeshCooking.h"
+#include <molecular/gfx/MeshLodFile.h>
+#include <molecular/gfx/NmbMeshDataSource.h>
+#include <molecular/gfx/PreparedMesh.h>
+#include <molecular/util/MemoryStreamStorage.h>
+#include <molecular/util/MeshOptimization.h>
+#include <molecular/util/NmbFile.h>
+#include <molecular/util/VertexQuantization.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace molecular
+{
+namespace gfx
+{
+namespace MeshCooking
+{
+
+using namespace util;
+using meshfile::MeshFile;
+
+static size_t GetIndexSize(IndexBufferInfo::Type type)
+{
+	switch(type)
+	{
+	case IndexBufferInfo::Type::kUInt8: return 1;
+	case IndexBufferInfo::Type::kUInt16: return 2;
+	case IndexBufferInfo::Type::kUInt32: return 4;
+	}
+	throw std::runtime_error("Unknown index type");
+}
+
+static size_t GetTypeSize(VertexAttributeInfo::Type type)
+{
+	switch(type)
+	{
+	case VertexAttributeInfo::kInt8:
+	case VertexAttributeInfo::kUInt8:
+		return 1;
+	case VertexAttributeInfo::kInt16:
+	case VertexAttributeInfo::kUInt16:
+	case VertexAttributeInfo::kHalf:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+/// Indices of one index specification, widened to 32 bit
+static std::vector<uint32_t> ReadIndices(const MeshFile& file, const IndexBufferInfo& info)
+{
+	if(info.buffer >= file.numBuffers)
+		throw std::runtime_error("Index specification references invalid buffer");
+	const MeshFile::Buffer& buffer = file.GetBuffer(info.buffer);
+	const size_t indexSize = GetIndexSize(info.type);
+	if(info.offset + size_t(info.count) * indexSize > buffer.size)
+		throw std::runtime_error("Index specification exceeds buffer");
+
+	const uint8_t* data = static_cast<const uint8_t*>(file.GetBufferData(info.buffer)) + info.offset;
+	std::vector<uint32_t> indices(info.count);
+	for(size_t i = 0; i < info.count; ++i)
+	{
+		uint32_t index = 0;
+		memcpy(&index, data + i * indexSize, indexSize); // Little endian
+		indices[i] = index;
+	}
+	return indices;
+}
+
+/// Mesh file split up for editing
+struct Mesh
+{
+	/// MeshFile with all tables, without buffer data
+	std::vector<uint8_t> header;
+
+	std::vector<std::vector<uint8_t>> buffers;
+
+	/// Indices of each index specification, widened to 32 bit
+	std::vector<std::vector<uint32_t>> indices;
+
+	/// Per vertex data set: Other sets use the same buffers, vertices stay in place
+	std::vector<bool> sharesBuffers;
+
+	MeshFile& GetFile() {return *reinterpret_cast<MeshFile*>(header.data());}
+};
+
+/// Split compiled mesh file
+/** The header and tables must come before all buffer data. */
+static Mesh ReadMesh(const std::vector<uint8_t>& contents)
+{
+	const MeshFile& file = *reinterpret_cast<const MeshFile*>(contents.data());
+	gfx::PreparedMesh::FromMeshFile(file); // Validates header
+
+	size_t headerEnd = contents.size();
+	for(unsigned int i = 0; i < file.numBuffers; ++i)
+	{
+		const MeshFile::Buffer& buffer = file.GetBuffer(i);
+		if(file.GetBufferData(i) != contents.data() + buffer.offset || buffer.offset + buffer.size > contents.size())
+			throw std::runtime_error("Unsupported mesh file layout");
+		headerEnd = std::min<size_t>(headerEnd, buffer.offset);
+	}
+	for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+	{
+		if(reinterpret_cast<const uint8_t*>(&file.GetIndexSpec(i) + 1) > contents.data() + headerEnd)
+			throw std::runtime_error("Unsupported mesh file layout");
+	}
+
+	Mesh mesh;
+	mesh.header.assign(contents.begin(), contents.begin() + headerEnd);
+	mesh.buffers.resize(file.numBuffers);
+	for(unsigned int i = 0; i < file.numBuffers; ++i)
+	{
+		const uint8_t* data = static_cast<const uint8_t*>(file.GetBufferData(i));
+		mesh.buffers[i].assign(data, data + file.GetBuffer(i).size);
+	}
+
+	std::vector<int> bufferSet(file.numBuffers, -1);
+	mesh.sharesBuffers.assign(file.numVertexDataSets, false);
+	for(unsigned int set = 0; set < file.numVertexDataSets; ++set)
+	{
+		for(unsigned int s = 0; s < file.GetVertexDataSet(set).numVertexSpecs; ++s)
+		{
+			const unsigned int buffer = file.GetVertexSpec(set, s).buffer;
+			if(buffer >= file.numBuffers)
+				throw std::runtime_error("Vertex attribute references invalid buffer");
+			if(bufferSet[buffer] >= 0 && bufferSet[buffer] != int(set))
+				mesh.sharesBuffers[set] = mesh.sharesBuffers[bufferSet[buffer]] = true;
+			bufferSet[buffer] = set;
+		}
+	}
+
+	mesh.indices.resize(file.numIndexSpecs);
+	for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+		mesh.indices[i] = ReadIndices(file, file.GetIndexSpec(i));
+	return mesh;
+}
+
+std::vector<uint8_t> WriteMeshFile(const AxisAlignedBox& bounds,
+		const std::vector<uint32_t>& vertexCounts,
+		const std::vector<std::vector<VertexAttributeInfo>>& attributes,
+		const std::vector<IndexBufferInfo>& indexSpecs,
+		const std::vector<MeshFile::Buffer::Type>& types,
+		const std::vector<std::vector<uint8_t>>& buffers)
+{
+	std::vector<uint8_t> output(sizeof(MeshFile), 0);
+	const size_t buffersOffset = output.size();
+	output.resize(output.size() + buffers.size() * sizeof(MeshFile::Buffer), 0);
+	std::vector<size_t> setOffsets;
+	for(auto& setAttributes: attributes)
+	{
+		setOffsets.push_back(output.size());
+		output.resize(output.size() + sizeof(MeshFile::VertexDataSet), 0);
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(setAttributes.data());
+		output.insert(output.end(), bytes, bytes + setAttributes.size() * sizeof(VertexAttributeInfo));
+	}
+	const size_t indexSpecsOffset = output.size();
+	const uint8_t* indexSpecBytes = reinterpret_cast<const uint8_t*>(indexSpecs.data());
+	output.insert(output.end(), indexSpecBytes, indexSpecBytes + indexSpecs.size() * sizeof(IndexBufferInfo));
+
+	std::vector<MeshFile::Buffer> bufferTable(buffers.size());
+	for(size_t b = 0; b < buffers.size(); ++b)
+	{
+		output.resize((output.size() + 15) / 16 * 16);
+		memset(&bufferTable[b], 0, sizeof(MeshFile::Buffer));
+		bufferTable[b].type = types[b];
+		bufferTable[b].offset = output.size();
+		bufferTable[b].size = buffers[b].size();
+		output.insert(output.end(), buffers[b].begin(), buffers[b].end());
+	}
+	memcpy(output.data() + buffersOffset, bufferTable.data(), bufferTable.size() * sizeof(MeshFile::Buffer));
+
+	MeshFile& file = *reinterpret_cast<MeshFile*>(output.data());
+	file.magic = MeshFile::kMagic;
+	file.version = MeshFile::kVersion;
+	for(int i = 0; i < 3; ++i)
+	{
+		file.boundsMin[i] = bounds.GetMin()[i];
+		file.boundsMax[i] = bounds.GetMax()[i];
+	}
+	file.numBuffers = static_cast<uint32_t>(buffers.size());
+	file.numVertexDataSets = static_cast<uint32_t>(attributes.size());
+	file.numIndexSpecs = static_cast<uint32_t>(indexSpecs.size());
+	for(size_t set = 0; set < attributes.size(); ++set)
+	{
+		MeshFile::VertexDataSet& vertexDataSet = *reinterpret_cast<MeshFile::VertexDataSet*>(output.data() + setOffsets[set]);
+		vertexDataSet.numVertices = vertexCounts[set];
+		vertexDataSet.numVertexSpecs = static_cast<uint32_t>(attributes[set].size());
+	}
+
+	// Tables must be where the reader expects them:
+	bool matches = true;
+	for(unsigned int b = 0; b < file.numBuffers; ++b)
+		matches = matches && reinterpret_cast<const uint8_t*>(&file.GetBuffer(b)) == output.data() + buffersOffset + b * sizeof(MeshFile::Buffer);
+	for(unsigned int set = 0; set < file.numVertexDataSets; ++set)
+	{
+		matches = matches && reinterpret_cast<const uint8_t*>(&file.GetVertexDataSet(set)) == output.data() + setOffsets[set];
+		for(unsigned int s = 0; s < attributes[set].size(); ++s)
+			matches = matches && reinterpret_cast<const uint8_t*>(&file.GetVertexSpec(set, s)) == output.data() + setOffsets[set] + sizeof(MeshFile::VertexDataSet) + s * sizeof(VertexAttributeInfo);
+	}
+	for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+		matches = matches && reinterpret_cast<const uint8_t*>(&file.GetIndexSpec(i)) == output.data() + indexSpecsOffset + i * sizeof(IndexBufferInfo);
+	if(!matches)
+		throw std::runtime_error("Mesh file layout not supported by this converter");
+	return output;
+}
+
+std::vector<uint8_t> ConvertNmb(const std::vector<uint8_t>& contents, NmbStatistics* statistics)
+{
+	MemoryReadStorage storage(contents.data(), contents.size());
+	NmbFile nmb(storage);
+
+	AxisAlignedBox bounds;
+	std::vector<uint32_t> vertexCounts;
+	std::vector<std::vector<VertexAttributeInfo>> attributes;
+	std::vector<IndexBufferInfo> indexSpecs;
+	std::vector<MeshFile::Buffer::Type> types;
+	std::vector<std::vector<uint8_t>> buffers;
+	NmbStatistics nmbStatistics;
+	for(auto& nmbMesh: nmb.GetMeshes())
+	{
+		if(nmbMesh.vertexBuffers.empty())
+			continue;
+		const unsigned int set = static_cast<unsigned int>(attributes.size());
+		const size_t vertexCount = nmbMesh.vertexBuffers.front().elementCount;
+		size_t stride = 0;
+		for(auto& vertexBuffer: nmbMesh.vertexBuffers)
+		{
+			if(size_t(vertexBuffer.elementCount) != vertexCount || vertexBuffer.values.size() != vertexCount * vertexBuffer.elementSize)
+				throw std::runtime_error("NMB vertex buffer \"" + vertexBuffer.name + "\" has wrong size");
+			stride += vertexBuffer.elementSize * sizeof(float);
+		}
+
+		const unsigned int vertexBufferIndex = static_cast<unsigned int>(buffers.size());
+		std::vector<uint8_t> vertices(vertexCount * stride);
+		attributes.emplace_back();
+		size_t offset = 0;
+		for(auto& vertexBuffer: nmbMesh.vertexBuffers)
+		{
+			VertexAttributeInfo info;
+			info.type = VertexAttributeInfo::kFloat;
+			info.components = vertexBuffer.elementSize;
+			info.semantic = gfx::NmbMeshDataSource::GetSemantic(vertexBuffer.name);
+			info.normalized = false;
+			info.buffer = vertexBufferIndex;
+			info.offset = static_cast<uint32_t>(offset);
+			info.stride = static_cast<uint32_t>(stride);
+			if(info.semantic == VertexAttributeInfo::kUnknown)
+				nmbStatistics.unknownVertexBuffers.push_back(vertexBuffer.name);
+			attributes.back().push_back(info);
+
+			const size_t elementSize = vertexBuffer.elementSize * sizeof(float);
+			for(size_t v = 0; v < vertexCount; ++v)
+			{
+				const float* element = vertexBuffer.values.data() + v * vertexBuffer.elementSize;
+				memcpy(vertices.data() + v * stride + offset, element, elementSize);
+				if(info.semantic == VertexAttributeInfo::kPosition && vertexBuffer.elementSize >= 3)
+					bounds.Stretch(Vector3(element[0], element[1], element[2]));
+			}
+			offset += elementSize;
+		}
+		vertexCounts.push_back(static_cast<uint32_t>(vertexCount));
+		types.push_back(MeshFile::Buffer::Type::kVertex);
+		buffers.push_back(std::move(vertices));
+
+		if(nmbMesh.indexBuffers.empty())
+			continue;
+		const unsigned int indexBufferIndex = static_cast<unsigned int>(buffers.size());
+		std::vector<uint8_t> indices;
+		for(auto& indexBuffer: nmbMesh.indexBuffers)
+		{
+			IndexBufferInfo info;
+			info.type = IndexBufferInfo::Type::kUInt16;
+			switch(indexBuffer.operation)
+			{
+			case NmbFile::IndexBuffer::kTriangles:
+				info.mode = IndexBufferInfo::Mode::kTriangles;
+				break;
+
+			case NmbFile::IndexBuffer::kTriangleStrip:
+				info.mode = IndexBufferInfo::Mode::kTriangleStrip;
+				break;
+
+			default:
+				info.mode = IndexBufferInfo::Mode::kPoints;
+			}
+			info.buffer = indexBufferIndex;
+			info.offset = static_cast<uint32_t>(indices.size());
+			info.count = static_cast<uint32_t>(indexBuffer.indices.size());
+			info.vertexDataSet = set;
+			indexSpecs.push_back(info);
+
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(indexBuffer.indices.data());
+			indices.insert(indices.end(), bytes, bytes + indexBuffer.indices.size() * sizeof(uint16_t));
+		}
+		types.push_back(MeshFile::Buffer::Type::kIndex);
+		buffers.push_back(std::move(indices));
+	}
+	if(attributes.empty())
+		throw std::runtime_error("NMB file contains no meshes");
+	if(bounds.GetMin()[0] > bounds.GetMax()[0])
+		bounds = AxisAlignedBox(0, 0, 0, 0, 0, 0); // No positions
+	nmbStatistics.meshes = static_cast<unsigned int>(attributes.size());
+	if(statistics)
+		*statistics = std::move(nmbStatistics);
+	return WriteMeshFile(bounds, vertexCounts, attributes, indexSpecs, types, buffers);
+}
+
+/// Move vertices of all attributes to their new index
+static void RemapVertices(Mesh& mesh, unsigned int vertexDataSet, const std::vector<uint32_t>& remap)
+{
+	MeshFile& file = mesh.GetFile();
+	const MeshFile::VertexDataSet& set = file.GetVertexDataSet(vertexDataSet);
+	const std::vector<std::vector<uint8_t>> source = mesh.buffers;
+	for(unsigned int s = 0; s < set.numVertexSpecs; ++s)
+	{
+		const VertexAttributeInfo& attribute = file.GetVertexSpec(vertexDataSet, s);
+		const size_t elementSize = attribute.components * GetTypeSize(attribute.type);
+		const size_t stride = attribute.stride ? attribute.stride : elementSize;
+		std::vector<uint8_t>& destination = mesh.buffers.at(attribute.buffer);
+		if(attribute.offset + (remap.size() - 1) * stride + elementSize > destination.size())
+			throw std::runtime_error("Vertex attribute exceeds buffer");
+		for(size_t v = 0; v < remap.size(); ++v)
+			memcpy(destination.data() + attribute.offset + remap[v] * stride, source[attribute.buffer].data() + attribute.offset + v * stride, elementSize);
+	}
+}
+
+/// Float positions of a vertex data set
+/** @returns nullptr if there are none. */
+static const uint8_t* GetPositions(Mesh& mesh, unsigned int vertexDataSet, size_t& outStride)
+{
+	MeshFile& file = mesh.GetFile();
+	for(unsigned int s = 0; s < file.GetVertexDataSet(vertexDataSet).numVertexSpecs; ++s)
+	{
+		const VertexAttributeInfo& attribute = file.GetVertexSpec(vertexDataSet, s);
+		if(attribute.semantic == VertexAttributeInfo::kPosition && attribute.type == VertexAttributeInfo::kFloat && attribute.components >= 3)
+		{
+			outStride = attribute.stride ? attribute.stride : attribute.components * sizeof(float);
+			const size_t vertexCount = file.GetVertexDataSet(vertexDataSet).numVertices;
+			if(vertexCount > 0 && attribute.offset + (vertexCount - 1) * outStride + 3 * sizeof(float) > mesh.buffers.at(attribute.buffer).size())
+				throw std::runtime_error("Vertex attribute exceeds buffer");
+			return mesh.buffers.at(attribute.buffer).data() + attribute.offset;
+		}
+	}
+	return nullptr;
+}
+
+static size_t CountTriangles(Mesh& mesh)
+{
+	size_t triangles = 0;
+	for(unsigned int i = 0; i < mesh.GetFile().numIndexSpecs; ++i)
+	{
+		if(mesh.GetFile().GetIndexSpec(i).mode == IndexBufferInfo::Mode::kTriangles)
+			triangles += mesh.indices[i].size() / 3;
+	}
+	return triangles;
+}
+
+/// Format of an attribute after quantization
+static VertexAttributeInfo GetQuantizedFormat(const VertexAttributeInfo& attribute)
+{
+	VertexAttributeInfo quantized = attribute;
+	if(attribute.type != VertexAttributeInfo::kFloat)
+		return quantized;
+
+	if(attribute.semantic == VertexAttributeInfo::kPosition && attribute.components >= 3)
+	{
+		quantized.type = VertexAttributeInfo::kUInt16;
+		quantized.components = 4; // Padded to 8 bytes
+		quantized.normalized = true;
+		quantized.semantic = "vertexPositionQuantizedAttr"_H;
+	}
+	else if(attribute.semantic == VertexAttributeInfo::kNormal && attribute.components == 3)
+	{
+		quantized.type = VertexAttributeInfo::kInt16;
+		quantized.components = 2;
+		quantized.normalized = true;
+		quantized.semantic = "vertexNormalOctAttr"_H;
+	}
+	else if(attribute.semantic == "vertexTangentAttr"_H && attribute.components >= 3)
+	{
+		quantized.type = VertexAttributeInfo::kInt16;
+		quantized.components = 4; // Octahedral xy, handedness, padding
+		quantized.normalized = true;
+		quantized.semantic = "vertexTangentOctAttr"_H;
+	}
+	else if(attribute.semantic == VertexAttributeInfo::kTextureCoords)
+	{
+		quantized.type = VertexAttributeInfo::kHalf;
+	}
+	return quantized;
+}
+
+static void QuantizeVertex(const VertexAttributeInfo& attribute, const VertexAttributeInfo& quantized, const float* in, uint8_t* out, const float boundsMin[3], const float extent[3])
+{
+	if(quantized.semantic == "vertexPositionQuantizedAttr"_H)
+	{
+		const uint16_t position[4] = {
+			VertexQuantization::ToUnorm16(in[0], boundsMin[0], extent[0]),
+			VertexQuantization::ToUnorm16(in[1], boundsMin[1], extent[1]),
+			VertexQuantization::ToUnorm16(in[2], boundsMin[2], extent[2]),
+			0xffff
+		};
+		memcpy(out, position, sizeof(position));
+	}
+	else if(quantized.semantic == "vertexNormalOctAttr"_H)
+	{
+		int16_t normal[2];
+		VertexQuantization::EncodeOctahedral(in, normal);
+		memcpy(out, normal, sizeof(normal));
+	}
+	else if(quantized.semantic == "vertexTangentOctAttr"_H)
+	{
+		int16_t tangent[4] = {0, 0, 0, 0};
+		VertexQuantization::EncodeOctahedral(in, tangent);
+		tangent[2] = (attribute.components >= 4 && in[3] < 0) ? -32767 : 32767;
+		memcpy(out, tangent, sizeof(tangent));
+	}
+	else if(quantized.type == VertexAttributeInfo::kHalf)
+	{
+		for(unsigned int c = 0; c < attribute.components; ++c)
+		{
+			const uint16_t half = VertexQuantization::ToHalf(in[c]);
+			memcpy(out + c * 2, &half, 2);
+		}
+	}
+	else
+		memcpy(out, in, attribute.components * GetTypeSize(attribute.type));
+}
+
+/// Interleave vertex buffers, drop unused vertices and optionally quantize
+/** Quantization stores positions as 16 bit, normals and tangents
+	octahedral and UVs as half floats. Positions are normalized to the mesh
+	bounds, which are tightened here and serve as dequantization parameters,
+	see DrawMeshData. Vertex buffers used by more than one vertex data set
+	are left alone. Expects vertices renumbered by OptimizeVertexFetch(), so
+	unused ones are at the end.
+	@returns Vertex bytes before and after. */
+static std::pair<size_t, size_t> RelayoutVertices(Mesh& mesh, bool quantize)
+{
+	MeshFile& file = mesh.GetFile();
+	std::vector<std::vector<uint8_t>>& buffers = mesh.buffers;
+	float boundsMin[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+	float boundsMax[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+	for(unsigned int set = 0; set < file.numVertexDataSets; ++set)
+	{
+		size_t stride = 0;
+		const uint8_t* positions = GetPositions(mesh, set, stride);
+		for(size_t v = 0; positions && v < file.GetVertexDataSet(set).numVertices; ++v)
+		{
+			float position[3];
+			memcpy(position, positions + v * stride, sizeof(position));
+			for(int i = 0; i < 3; ++i)
+			{
+				boundsMin[i] = std::min(boundsMin[i], position[i]);
+				boundsMax[i] = std::max(boundsMax[i], position[i]);
+			}
+		}
+	}
+	float extent[3] = {0, 0, 0};
+	if(quantize && boundsMin[0] <= boundsMax[0])
+	{
+		for(int i = 0; i < 3; ++i)
+		{
+			file.boundsMin[i] = boundsMin[i];
+			file.boundsMax[i] = boundsMax[i];
+			extent[i] = boundsMax[i] - boundsMin[i];
+		}
+	}
+
+	size_t before = 0, after = 0;
+	for(unsigned int set = 0; set < file.numVertexDataSets; ++set)
+	{
+		MeshFile::VertexDataSet& vertexDataSet = const_cast<MeshFile::VertexDataSet&>(file.GetVertexDataSet(set));
+		const size_t sourceVertexCount = vertexDataSet.numVertices;
+		size_t vertexCount = sourceVertexCount;
+		if(!mesh.sharesBuffers[set])
+		{
+			uint32_t used = 0;
+			bool indexed = false;
+			for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+			{
+				if(file.GetIndexSpec(i).vertexDataSet != set)
+					continue;
+				indexed = true;
+				for(uint32_t index: mesh.indices[i])
+					used = std::max(used, index + 1);
+			}
+			if(indexed)
+				vertexCount = std::min<size_t>(used, sourceVertexCount);
+		}
+
+		for(unsigned int b = 0; b < file.numBuffers; ++b)
+		{
+			std::vector<unsigned int> specs;
+			for(unsigned int s = 0; s < vertexDataSet.numVertexSpecs; ++s)
+			{
+				if(file.GetVertexSpec(set, s).buffer == b)
+					specs.push_back(s);
+			}
+			if(specs.empty())
+				continue;
+			before += buffers[b].size();
+			if(mesh.sharesBuffers[set])
+			{
+				after += buffers[b].size();
+				continue;
+			}
+
+			// New interleaved layout, each attribute 4 byte aligned:
+			std::vector<VertexAttributeInfo> formats;
+			std::vector<size_t> offsets;
+			size_t stride = 0;
+			for(unsigned int s: specs)
+			{
+				formats.push_back(quantize ? GetQuantizedFormat(file.GetVertexSpec(set, s)) : file.GetVertexSpec(set, s));
+				offsets.push_back(stride);
+				stride += (formats.back().components * GetTypeSize(formats.back().type) + 3) / 4 * 4;
+			}
+
+			std::vector<uint8_t> relaid(stride * vertexCount, 0);
+			for(size_t i = 0; i < specs.size(); ++i)
+			{
+				const VertexAttributeInfo& attribute = file.GetVertexSpec(set, specs[i]);
+				const size_t elementSize = attribute.components * GetTypeSize(attribute.type);
+				const size_t sourceStride = attribute.stride ? attribute.stride : elementSize;
+				if(sourceVertexCount > 0 && attribute.offset + (sourceVertexCount - 1) * sourceStride + elementSize > buffers[b].size())
+					throw std::runtime_error("Vertex attribute exceeds buffer");
+				std::vector<float> element(attribute.components);
+				for(size_t v = 0; v < vertexCount; ++v)
+				{
+					const uint8_t* source = buffers[b].data() + attribute.offset + v * sourceStride;
+					uint8_t* destination = relaid.data() + v * stride + offsets[i];
+					if(quantize && attribute.type == VertexAttributeInfo::kFloat)
+					{
+						memcpy(element.data(), source, elementSize);
+						QuantizeVertex(attribute, formats[i], element.data(), destination, boundsMin, extent);
+					}
+					else
+						memcpy(destination, source, elementSize);
+				}
+			}
+			for(size_t i = 0; i < specs.size(); ++i)
+			{
+				VertexAttributeInfo& attribute = const_cast<VertexAttributeInfo&>(file.GetVertexSpec(set, specs[i]));
+				attribute = formats[i];
+				attribute.offset = static_cast<uint32_t>(offsets[i]);
+				attribute.stride = static_cast<uint32_t>(stride);
+			}
+			buffers[b].swap(relaid);
+			after += buffers[b].size();
+		}
+		vertexDataSet.numVertices = static_cast<uint32_t>(vertexCount);
+	}
+	return std::make_pair(before, after);
+}
+
+/// Optimize all triangle index specifications
+/** Converts strips to lists, reorders triangles and vertices. */
+static void Optimize(Mesh& mesh, unsigned int cacheSize, bool overdraw, LevelStatistics& statistics)
+{
+	MeshFile& file = mesh.GetFile();
+	std::vector<std::vector<uint32_t>>& indices = mesh.indices;
+	for(unsigned int set = 0; set < file.numVertexDataSets; ++set)
+	{
+		const size_t vertexCount = file.GetVertexDataSet(set).numVertices;
+		size_t positionStride = 0;
+		const void* positions = GetPositions(mesh, set, positionStride);
+
+		std::vector<uint32_t> allIndices;
+		std::vector<uint32_t> allBefore;
+		for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+		{
+			IndexBufferInfo& info = const_cast<IndexBufferInfo&>(file.GetIndexSpec(i));
+			if(info.vertexDataSet != set)
+				continue;
+
+			if(info.mode == IndexBufferInfo::Mode::kTriangleStrip)
+			{
+				indices[i] = MeshOptimization::StripToList(indices[i]);
+				info.mode = IndexBufferInfo::Mode::kTriangles;
+			}
+			if(info.mode == IndexBufferInfo::Mode::kTriangles)
+			{
+				allBefore.insert(allBefore.end(), indices[i].begin(), indices[i].end());
+				std::vector<size_t> clusters;
+				indices[i] = MeshOptimization::OptimizeVertexCache(indices[i], vertexCount, cacheSize, &clusters);
+				if(overdraw && positions)
+					indices[i] = MeshOptimization::OptimizeOverdraw(indices[i], clusters, positions, positionStride, vertexCount);
+			}
+			allIndices.insert(allIndices.end(), indices[i].begin(), indices[i].end());
+		}
+		if(allBefore.empty())
+			continue; // No triangles
+		LevelStatistics::VertexDataSet setStatistics;
+		setStatistics.index = set;
+		setStatistics.before = MeshOptimization::Analyze(allBefore, vertexCount, cacheSize);
+
+		// Renumber vertices across all index specifications of this set:
+		if(!mesh.sharesBuffers[set])
+		{
+			const std::vector<uint32_t> remap = MeshOptimization::OptimizeVertexFetch(allIndices, vertexCount);
+			RemapVertices(mesh, set, remap);
+			for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+			{
+				if(file.GetIndexSpec(i).vertexDataSet != set)
+					continue;
+				for(uint32_t& index: indices[i])
+					index = remap[index];
+			}
+		}
+
+		std::vector<uint32_t> allAfter;
+		for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+		{
+			if(file.GetIndexSpec(i).vertexDataSet == set && file.GetIndexSpec(i).mode == IndexBufferInfo::Mode::kTriangles)
+				allAfter.insert(allAfter.end(), indices[i].begin(), indices[i].end());
+		}
+		setStatistics.after = MeshOptimization::Analyze(allAfter, vertexCount, cacheSize);
+		statistics.vertexDataSets.push_back(setStatistics);
+	}
+}
+
+/// Reduce triangles of all triangle index specifications
+/** @param ratio Fraction of triangles to keep.
+	@returns Largest deviation from the original surface. */
+static float Simplify(Mesh& mesh, float ratio)
+{
+	MeshFile& file = mesh.GetFile();
+	float maxError = 0;
+	for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+	{
+		const IndexBufferInfo& info = file.GetIndexSpec(i);
+		size_t stride = 0;
+		const uint8_t* positions = GetPositions(mesh, info.vertexDataSet, stride);
+		if(info.mode != IndexBufferInfo::Mode::kTriangles || !positions)
+			continue;
+
+		const size_t target = static_cast<size_t>(mesh.indices[i].size() / 3 * ratio) * 3;
+		float error = 0;
+		mesh.indices[i] = MeshOptimization::Simplify(mesh.indices[i], positions, stride, file.GetVertexDataSet(info.vertexDataSet).numVertices, target, &error);
+		maxError = std::max(maxError, error);
+	}
+	return maxError;
+}
+
+/// Split all triangle index specifications into culling clusters
+/** Call after Optimize(), before quantization. */
+static std::vector<gfx::MeshLodFile::Cluster> BuildClusters(Mesh& mesh, unsigned int clusterSize)
+{
+	MeshFile& file = mesh.GetFile();
+	std::vector<gfx::MeshLodFile::Cluster> clusters;
+	for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+	{
+		const IndexBufferInfo& info = file.GetIndexSpec(i);
+		size_t stride = 0;
+		const uint8_t* positions = GetPositions(mesh, info.vertexDataSet, stride);
+		if(info.mode != IndexBufferInfo::Mode::kTriangles || !positions)
+			continue; // Drawn as a whole
+
+		const size_t vertexCount = file.GetVertexDataSet(info.vertexDataSet).numVertices;
+		for(auto& cluster: MeshOptimization::BuildClusters(mesh.indices[i], positions, stride, vertexCount, clusterSize))
+		{
+			gfx::MeshLodFile::Cluster out;
+			std::copy(cluster.center, cluster.center + 3, out.center);
+			out.radius = cluster.radius;
+			std::copy(cluster.coneAxis, cluster.coneAxis + 3, out.coneAxis);
+			out.coneCutoff = cluster.coneCutoff;
+			out.indexSpec = i;
+			out.firstIndex = static_cast<uint32_t>(cluster.firstIndex);
+			out.indexCount = static_cast<uint32_t>(cluster.indexCount);
+			out.reserved = 0;
+			clusters.push_back(out);
+		}
+	}
+	return clusters;
+}
+
+/// Append cluster table to a level's mesh file
+static void AppendClusters(std::vector<uint8_t>& file, gfx::MeshLodFile::Level& level, const std::vector<gfx::MeshLodFile::Cluster>& clusters)
+{
+	file.resize((file.size() + 15) / 16 * 16);
+	level.clustersOffset = file.size();
+	level.numClusters = static_cast<uint32_t>(clusters.size());
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(clusters.data());
+	file.insert(file.end(), bytes, bytes + clusters.size() * sizeof(gfx::MeshLodFile::Cluster));
+	level.size = file.size();
+}
+
+/// Rebuild index buffers and put everything together
+static std::vector<uint8_t> WriteMesh(Mesh& mesh)
+{
+	MeshFile& file = mesh.GetFile();
+	std::vector<std::vector<uint8_t>>& buffers = mesh.buffers;
+	for(unsigned int b = 0; b < file.numBuffers; ++b)
+	{
+		if(file.GetBuffer(b).type != MeshFile::Buffer::Type::kIndex)
+			continue;
+		buffers[b].clear();
+		for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+		{
+			IndexBufferInfo& info = const_cast<IndexBufferInfo&>(file.GetIndexSpec(i));
+			if(info.buffer != b)
+				continue;
+			const size_t indexSize = GetIndexSize(info.type);
+			buffers[b].resize((buffers[b].size() + indexSize - 1) / indexSize * indexSize);
+			info.offset = static_cast<uint32_t>(buffers[b].size());
+			info.count = static_cast<uint32_t>(mesh.indices[i].size());
+			for(uint32_t index: mesh.indices[i])
+			{
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&index); // Little endian
+				buffers[b].insert(buffers[b].end(), bytes, bytes + indexSize);
+			}
+		}
+	}
+
+	std::vector<uint8_t> output(mesh.header);
+	std::vector<size_t> offsets;
+	for(unsigned int b = 0; b < file.numBuffers; ++b)
+	{
+		output.resize((output.size() + 15) / 16 * 16);
+		offsets.push_back(output.size());
+		output.insert(output.end(), buffers[b].begin(), buffers[b].end());
+	}
+
+	// Appending buffers may reallocate, so the buffer table is filled in last:
+	MeshFile& outFile = *reinterpret_cast<MeshFile*>(output.data());
+	for(unsigned int b = 0; b < file.numBuffers; ++b)
+	{
+		MeshFile::Buffer& buffer = const_cast<MeshFile::Buffer&>(outFile.GetBuffer(b));
+		buffer.offset = offsets[b];
+		buffer.size = buffers[b].size();
+	}
+	return output;
+}
+
+/// Move position stream attributes into a buffer of their own
+/** Depth-only passes then fetch only this tightly packed stream, see
+	PreparedMesh::IsPositionStreamAttribute(). Vertex data sets sharing
+	buffers, without other attributes or with a separate stream already are
+	left alone. Call RelayoutVertices() afterwards to compact the buffers
+	the attributes were moved out of. */
+static Mesh SplitPositionStreams(Mesh& mesh, LevelStatistics& statistics)
+{
+	const std::vector<uint8_t> contents = WriteMesh(mesh);
+	const MeshFile& file = *reinterpret_cast<const MeshFile*>(contents.data());
+
+	std::vector<MeshFile::Buffer::Type> types;
+	std::vector<std::vector<uint8_t>> buffers;
+	for(unsigned int b = 0; b < file.numBuffers; ++b)
+	{
+		const uint8_t* data = static_cast<const uint8_t*>(file.GetBufferData(b));
+		types.push_back(file.GetBuffer(b).type);
+		buffers.emplace_back(data, data + file.GetBuffer(b).size);
+	}
+	std::vector<IndexBufferInfo> indexSpecs;
+	for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+		indexSpecs.push_back(file.GetIndexSpec(i));
+
+	std::vector<uint32_t> vertexCounts;
+	std::vector<std::vector<VertexAttributeInfo>> attributes(file.numVertexDataSets);
+	unsigned int streams = 0;
+	for(unsigned int set = 0; set < file.numVertexDataSets; ++set)
+	{
+		const size_t vertexCount = file.GetVertexDataSet(set).numVertices;
+		vertexCounts.push_back(static_cast<uint32_t>(vertexCount));
+		for(unsigned int s = 0; s < file.GetVertexDataSet(set).numVertexSpecs; ++s)
+			attributes[set].push_back(file.GetVertexSpec(set, s));
+		if(mesh.sharesBuffers[set])
+			continue;
+
+		std::vector<VertexAttributeInfo*> stream;
+		std::vector<unsigned int> otherBuffers;
+		for(auto& attribute: attributes[set])
+		{
+			if(gfx::PreparedMesh::IsPositionStreamAttribute(attribute.semantic))
+				stream.push_back(&attribute);
+			else
+				otherBuffers.push_back(attribute.buffer);
+		}
+		const bool separate = std::none_of(stream.begin(), stream.end(), [&](const VertexAttributeInfo* attribute){
+			return std::find(otherBuffers.begin(), otherBuffers.end(), attribute->buffer) != otherBuffers.end();
+		});
+		if(stream.empty() || otherBuffers.empty() || separate)
+			continue;
+
+		std::vector<size_t> offsets;
+		size_t stride = 0;
+		for(auto attribute: stream)
+		{
+			offsets.push_back(stride);
+			stride += (attribute->components * GetTypeSize(attribute->type) + 3) / 4 * 4;
+		}
+		std::vector<uint8_t> streamData(stride * vertexCount, 0);
+		for(size_t i = 0; i < stream.size(); ++i)
+		{
+			VertexAttributeInfo& attribute = *stream[i];
+			const std::vector<uint8_t>& source = buffers.at(attribute.buffer);
+			const size_t elementSize = attribute.components * GetTypeSize(attribute.type);
+			const size_t sourceStride = attribute.stride ? attribute.stride : elementSize;
+			if(vertexCount > 0 && attribute.offset + (vertexCount - 1) * sourceStride + elementSize > source.size())
+				throw std::runtime_error("Vertex attribute exceeds buffer");
+			for(size_t v = 0; v < vertexCount; ++v)
+				memcpy(streamData.data() + v * stride + offsets[i], source.data() + attribute.offset + v * sourceStride, elementSize);
+			attribute.buffer = static_cast<uint32_t>(buffers.size());
+			attribute.offset = static_cast<uint32_t>(offsets[i]);
+			attribute.stride = static_cast<uint32_t>(stride);
+		}
+		types.push_back(MeshFile::Buffer::Type::kVertex);
+		buffers.push_back(std::move(streamData));
+		++streams;
+	}
+	if(streams == 0)
+		return mesh;
+
+	statistics.positionStreams = streams;
+	const AxisAlignedBox bounds(file.boundsMin[0], file.boundsMin[1], file.boundsMin[2], file.boundsMax[0], file.boundsMax[1], file.boundsMax[2]);
+	return ReadMesh(WriteMeshFile(bounds, vertexCounts, attributes, indexSpecs, types, buffers));
+}
+
+std::vector<uint8_t> Cook(const std::vector<uint8_t>& contents, unsigned int cacheSize, bool overdraw, bool quantize, unsigned int levels, float ratio, unsigned int clusterSize, bool positionStream, std::vector<LevelStatistics>* statistics)
+{
+	std::vector<LevelStatistics> levelStatistics(1);
+	Mesh mesh = ReadMesh(contents);
+	Optimize(mesh, cacheSize, overdraw, levelStatistics.front());
+	const float diagonal = std::sqrt(
+			std::pow(mesh.GetFile().boundsMax[0] - mesh.GetFile().boundsMin[0], 2.0f)
+			+ std::pow(mesh.GetFile().boundsMax[1] - mesh.GetFile().boundsMin[1], 2.0f)
+			+ std::pow(mesh.GetFile().boundsMax[2] - mesh.GetFile().boundsMin[2], 2.0f));
+
+	std::vector<std::vector<uint8_t>> files;
+	std::vector<gfx::MeshLodFile::Level> table;
+	size_t triangles = CountTriangles(mesh);
+	{
+		Mesh level = mesh;
+		std::vector<gfx::MeshLodFile::Cluster> clusters;
+		if(clusterSize)
+			clusters = BuildClusters(level, clusterSize);
+		if(positionStream)
+			level = SplitPositionStreams(level, levelStatistics.front());
+		if(quantize || positionStream)
+		{
+			const std::pair<size_t, size_t> bytes = RelayoutVertices(level, quantize);
+			if(quantize)
+			{
+				levelStatistics.front().quantizationBytesBefore = bytes.first;
+				levelStatistics.front().quantizationBytesAfter = bytes.second;
+			}
+		}
+		files.push_back(WriteMesh(level));
+		table.push_back(gfx::MeshLodFile::Level{0, files.back().size(), 0.0f, static_cast<uint32_t>(triangles), 0, 0, 0});
+		if(clusterSize)
+			AppendClusters(files.back(), table.back(), clusters);
+		levelStatistics.front().triangles = triangles;
+		levelStatistics.front().clusters = clusters.size();
+	}
+
+	// Each level is simplified from the original, so errors do not add up:
+	for(unsigned int i = 1; i < std::min(levels, unsigned(gfx::MeshLodFile::kMaxLevels)); ++i)
+	{
+		Mesh level = mesh;
+		const float error = Simplify(level, std::pow(ratio, float(i)));
+		const size_t levelTriangles = CountTriangles(level);
+		if(levelTriangles == 0 || levelTriangles > triangles * 9 / 10)
+			break; // Not worth another level
+		triangles = levelTriangles;
+
+		LevelStatistics current;
+		Optimize(level, cacheSize, overdraw, current);
+		std::vector<gfx::MeshLodFile::Cluster> clusters;
+		if(clusterSize)
+			clusters = BuildClusters(level, clusterSize);
+		if(positionStream)
+			level = SplitPositionStreams(level, current);
+		const std::pair<size_t, size_t> bytes = RelayoutVertices(level, quantize);
+		if(quantize)
+		{
+			current.quantizationBytesBefore = bytes.first;
+			current.quantizationBytesAfter = bytes.second;
+		}
+		files.push_back(WriteMesh(level));
+		table.push_back(gfx::MeshLodFile::Level{0, files.back().size(), diagonal > 0.0f ? error / diagonal : 0.0f, static_cast<uint32_t>(triangles), 0, 0, 0});
+		if(clusterSize)
+			AppendClusters(files.back(), table.back(), clusters);
+		current.triangles = triangles;
+		current.clusters = clusters.size();
+		current.error = error;
+		levelStatistics.push_back(std::move(current));
+	}
+	if(statistics)
+		*statistics = std::move(levelStatistics);
+	if(files.size() == 1 && clusterSize == 0)
+		return files.front();
+
+	std::vector<uint8_t> output(gfx::MeshLodFile::GetHeaderSize(static_cast<unsigned int>(files.size())));
+	for(size_t i = 0; i < files.size(); ++i)
+	{
+		output.resize((output.size() + 15) / 16 * 16);
+		table[i].offset = output.size();
+		output.insert(output.end(), files[i].begin(), files[i].end());
+	}
+	gfx::MeshLodFile& lodFile = *reinterpret_cast<gfx::MeshLodFile*>(output.data());
+	lodFile.magic = gfx::MeshLodFile::kMagic;
+	lodFile.numLevels = static_cast<uint32_t>(files.size());
+	memcpy(lodFile.levels, table.data(), table.size() * sizeof(gfx::MeshLodFile::Level));
+	return output;
+}
+
+}
+}
+}
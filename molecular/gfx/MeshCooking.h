@@ -0,0 +1,122 @@
+/*	MeshCooking.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_MESHCOOKING_H
+#define MOLECULAR_MESHCOOKING_H
+
+#include <molecular/meshfile/MeshFile.h>
+#include <molecular/util/AxisAlignedBox.h>
+#include <molecular/util/MeshOptimization.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace molecular
+{
+namespace gfx
+{
+
+/// Offline preparation of compiled mesh files, used by molecular-meshcook
+/** Reorders meshes for the post-transform vertex cache, overdraw and vertex
+	fetch locality. Triangle strips are converted to lists. Optionally
+	quantizes vertex attributes, builds simplified levels of detail and
+	culling clusters into a MeshLodFile and moves positions into a separate
+	stream for depth-only passes. The output is loaded by MeshLoader as is. */
+namespace MeshCooking
+{
+
+/// What Cook() did to one level of detail
+/** Filled in for the caller to report, the cooking functions print
+	nothing. */
+struct LevelStatistics
+{
+	/// Vertex cache efficiency of a vertex data set's triangles
+	struct VertexDataSet
+	{
+		unsigned int index = 0;
+		util::MeshOptimization::Statistics before;
+		util::MeshOptimization::Statistics after;
+	};
+
+	std::vector<VertexDataSet> vertexDataSets;
+
+	/// Vertex data sets whose position stream was moved to a buffer of its own
+	unsigned int positionStreams = 0;
+
+	/// Bytes of vertex data before and after quantization, 0 if not quantized
+	size_t quantizationBytesBefore = 0, quantizationBytesAfter = 0;
+
+	size_t triangles = 0;
+	size_t clusters = 0;
+
+	/// Largest deviation from the original surface, 0 for the first level
+	float error = 0;
+};
+
+/// What ConvertNmb() did
+struct NmbStatistics
+{
+	unsigned int meshes = 0;
+
+	/// Names of vertex buffers without known semantic
+	std::vector<std::string> unknownVertexBuffers;
+};
+
+/// Optimize compiled mesh file, optionally build levels of detail
+/** @param levels Number of levels including the original. With more than
+		one, the result is a MeshLodFile if simplification succeeds.
+	@param ratio Fraction of triangles each level keeps of the previous one.
+	@param clusterSize Triangles per culling cluster. If not 0, the result is
+		always a MeshLodFile.
+	@param positionStream Store position stream attributes in buffers of
+		their own, see PreparedMesh::IsPositionStreamAttribute().
+	@param statistics Receives one entry per level written if not null. */
+std::vector<uint8_t> Cook(const std::vector<uint8_t>& contents, unsigned int cacheSize, bool overdraw, bool quantize, unsigned int levels, float ratio, unsigned int clusterSize, bool positionStream, std::vector<LevelStatistics>* statistics = nullptr);
+
+/// Convert NVidia NMB file to compiled mesh file
+/** Each NMB mesh becomes a vertex data set with one interleaved vertex
+	buffer and one 16 bit index buffer. Bounds are computed from the
+	positions.
+	@param statistics Filled in if not null. */
+std::vector<uint8_t> ConvertNmb(const std::vector<uint8_t>& contents, NmbStatistics* statistics = nullptr);
+
+/// Lay out compiled mesh file from scratch
+/** Tables follow the header in the order buffers, vertex data sets with
+	their attributes, index specifications. Buffer data comes last. Buffer
+	offsets and sizes are filled in here. The result is checked against the
+	MeshFile accessors. */
+std::vector<uint8_t> WriteMeshFile(const util::AxisAlignedBox& bounds,
+		const std::vector<uint32_t>& vertexCounts,
+		const std::vector<std::vector<VertexAttributeInfo>>& attributes,
+		const std::vector<IndexBufferInfo>& indexSpecs,
+		const std::vector<meshfile::MeshFile::Buffer::Type>& types,
+		const std::vector<std::vector<uint8_t>>& buffers);
+
+}
+}
+}
+
+#endif
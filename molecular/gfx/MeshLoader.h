@@ -29,20 +29,30 @@ SOFTWARE.
 #include "MeshManager.h"
 
 #include <molecular/gfx/functions/DrawMeshData.h>
+#include <molecular/gfx/MeshLodFile.h>
 #include <molecular/gfx/NmbMeshDataSource.h>
+#include <molecular/gfx/PreparedMesh.h>
 
 #include <molecular/util/FileTypeIdentification.h>
 #include <molecular/util/MemoryStreamStorage.h>
 #include <molecular/util/NmbFile.h>
 #include <molecular/util/TaskDispatcher.h>
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 namespace molecular
 {
 namespace gfx
 {
 
 /// Loads mesh files
-/** @todo LOD */
+/** Levels of MeshLodFiles are read with range reads if the file is not
+	memory-mapped, so only the levels in use occupy memory. Other mesh files
+	have a single level. Morph targets of the MeshLocator are read once before
+	the first level, each level then gets its own deltas, see
+	PreparedMesh::AddMorphTarget(). */
 template<class TRenderManager>
 class MeshLoader : public MeshManager::Loader
 {
@@ -51,18 +61,83 @@ public:
 
 	MeshLoader(RenderManager& renderManager);
 
-	DrawMeshData* Create() override;
-	void Destroy(DrawMeshData*& asset) override;
+	MeshLods* Create() override;
+	void Destroy(MeshLods*& asset) override;
 	void StartLoad(MeshManager::Asset& asset, unsigned int minLevel, unsigned int maxLevel) override;
-	void Unload(DrawMeshData*& asset, unsigned int minLevel, unsigned int maxLevel) override;
+	void Unload(MeshLods*& asset, unsigned int minLevel, unsigned int maxLevel) override;
 
 private:
-	static void StoreMesh(MeshManager::Asset& destination, Blob& blob);
+	/// Loading state of one asset
+	struct Stream
+	{
+		/// Level table, empty until the header is read
+		/** One level spanning the whole file for files without levels. */
+		std::vector<MeshLodFile::Level> levels;
+
+		/// Levels requested while the header or morph targets are being read
+		std::vector<unsigned int> pendingLevels;
+
+		/// One per morph target of the MeshLocator, nullptr if it failed
+		std::vector<std::shared_ptr<const MorphTargetData>> morphTargets;
+
+		/// Morph targets still being read
+		size_t pendingTargets = 0;
+
+		/// Contents of the whole file while morph targets are being read
+		std::shared_ptr<Blob> pendingFile;
+
+		/// Levels can be loaded
+		bool IsReady() const {return !levels.empty() && pendingTargets == 0;}
+	};
+
+	/// Parse level table and load the levels requested so far
+	/** @param data Start of the file, at least the header.
+		@param fileSize Size of the whole file.
+		@param wholeFile Contents of the whole file if it was read completely. */
+	void HandleHeader(MeshManager::Asset& target, const void* data, size_t size, size_t fileSize, std::shared_ptr<Blob> wholeFile);
+
+	/// Read morph targets of the MeshLocator and prepare them in the task queue
+	/** @returns false if the files cannot be read. */
+	bool ReadMorphTargets(MeshManager::Asset& target);
+
+	/// Store prepared morph target, load pending levels after the last one
+	void StoreMorphTarget(MeshManager::Asset& target, size_t index, std::shared_ptr<const MorphTargetData> data);
+
+	/// Load levels requested while the header or morph targets were read
+	void LoadPendingLevels(MeshManager::Asset& target, std::shared_ptr<Blob> wholeFile);
 
-	static void StoreCompiledMesh(MeshManager::Asset& destination, Blob& blob);
-	static void StoreNmb(MeshManager::Asset& destination, Blob& blob);
+	/// Read level and prepare it in the task queue
+	/** Levels not in the file are substituted with the coarsest one. Marks
+		the level failed if the read cannot be started. */
+	void LoadLevel(MeshManager::Asset& target, unsigned int level, std::shared_ptr<Blob> wholeFile);
+
+	/// Parse mesh in the calling thread and enqueue upload in the GL task queue
+	/** @param data File contents from a Blob or a memory-mapped package file.
+		@param contents Blob holding data, if any. Kept alive until the upload
+			is done because compiled meshes are stored without copying.
+		@param wantedLevel Level requested, differs from level if it was
+			substituted.
+		@param levelInfo Entry of the level table, locates the clusters.
+		@param morphTargets Stream::morphTargets */
+	void PrepareMesh(MeshManager::Asset& destination, unsigned int level, unsigned int wantedLevel, const MeshLodFile::Level& levelInfo, const std::vector<std::shared_ptr<const MorphTargetData>>& morphTargets, const void* data, size_t size, std::shared_ptr<Blob> contents);
+
+	/// Parse morph target file, level 0 of MeshLodFiles
+	static MorphTargetData PrepareMorphTarget(const void* data, size_t size);
+
+	static PreparedMesh PrepareCompiledMesh(const void* data, size_t size);
+	/// Slow path, NMB files should be converted by molecular-meshcook
+	static PreparedMesh PrepareNmb(const void* data, size_t size);
+
+	/// Upload prepared mesh in the GL thread
+	static void StoreMesh(MeshManager::Asset& destination, unsigned int level, unsigned int wantedLevel, const PreparedMesh& mesh);
+
+	/// Mark level as failed in the GL thread
+	static void StoreFailure(MeshManager::Asset& destination, unsigned int level);
 
 	RenderManager& mRenderManager;
+
+	/// Only accessed in the render thread
+	std::unordered_map<MeshManager::Asset*, Stream> mStreams;
 };
 
 /*****************************************************************************/
@@ -74,14 +149,20 @@ MeshLoader<TRenderManager>::MeshLoader(RenderManager& renderManager) :
 }
 
 template<class TRenderManager>
-DrawMeshData* MeshLoader<TRenderManager>::Create()
+MeshLods* MeshLoader<TRenderManager>::Create()
 {
-	return new DrawMeshData(mRenderManager);
+	MeshLods* lods = new MeshLods;
+	for(auto& level: lods->levels)
+		level = new DrawMeshData(mRenderManager);
+	lods->errors.fill(0.0f);
+	return lods;
 }
 
 template<class TRenderManager>
-void MeshLoader<TRenderManager>::Destroy(DrawMeshData*& asset)
+void MeshLoader<TRenderManager>::Destroy(MeshLods*& asset)
 {
+	for(auto& level: asset->levels)
+		delete level;
 	delete asset;
 	asset = nullptr;
 }
@@ -89,80 +170,333 @@ void MeshLoader<TRenderManager>::Destroy(DrawMeshData*& asset)
 template<class TRenderManager>
 void MeshLoader<TRenderManager>::StartLoad(MeshManager::Asset& asset, unsigned int minLevel, unsigned int maxLevel)
 {
-	// No LOD for now:
-	assert(minLevel == 0);
-	assert(maxLevel == 0);
-
 	const Hash file = asset.GetLocation().meshFile;
 	try
 	{
-		mRenderManager.GetFileServer().ReadFile(file, std::bind(StoreMesh, std::ref(asset), std::placeholders::_1), mRenderManager.GetGlTaskQueue());
+		Stream& stream = mStreams[&asset];
+		if(stream.IsReady())
+		{
+			for(unsigned int i = minLevel; i <= maxLevel; ++i)
+				LoadLevel(asset, i, nullptr);
+			return;
+		}
+
+		const bool readingHeader = !stream.pendingLevels.empty();
+		for(unsigned int i = minLevel; i <= maxLevel; ++i)
+			stream.pendingLevels.push_back(i);
+		if(readingHeader)
+			return;
+
+		MeshManager::Asset* target = &asset;
+		size_t size = 0;
+		if(const void* data = mRenderManager.GetFileServer().MapFile(file, size))
+			HandleHeader(asset, data, size, size, nullptr);
+		else if(mRenderManager.GetFileServer().GetFileSize(file, size) && size > 0)
+		{
+			auto handleHeader = [this, target, size](Blob& blob){HandleHeader(*target, blob.GetData(), blob.GetSize(), size, nullptr);};
+			const size_t headerSize = std::min(size, MeshLodFile::GetHeaderSize(MeshLodFile::kMaxLevels));
+			mRenderManager.GetFileServer().ReadFileRange(file, 0, headerSize, handleHeader, mRenderManager.GetGlTaskQueue());
+		}
+		else
+		{
+			auto handleFile = [this, target](Blob& blob)
+			{
+				std::shared_ptr<Blob> contents = std::make_shared<Blob>(std::move(blob));
+				HandleHeader(*target, contents->GetData(), contents->GetSize(), contents->GetSize(), contents);
+			};
+			mRenderManager.GetFileServer().ReadFile(file, handleFile, mRenderManager.GetGlTaskQueue());
+		}
 	}
 	catch(std::exception& e)
 	{
 		LOG(ERROR) << e.what();
-		asset.SetState(0, MeshManager::Asset::kFailed);
+		mStreams.erase(&asset);
+		for(unsigned int i = minLevel; i <= maxLevel; ++i)
+			asset.SetState(i, MeshManager::Asset::kFailed);
+	}
+}
+
+template<class TRenderManager>
+void MeshLoader<TRenderManager>::Unload(MeshLods*& asset, unsigned int minLevel, unsigned int maxLevel)
+{
+	for(unsigned int i = minLevel; i <= maxLevel; ++i)
+		asset->levels[i]->Unload();
+}
+
+template<class TRenderManager>
+void MeshLoader<TRenderManager>::HandleHeader(MeshManager::Asset& target, const void* data, size_t size, size_t fileSize, std::shared_ptr<Blob> wholeFile)
+{
+	Stream& stream = mStreams[&target];
+	try
+	{
+		if(size == 0)
+			throw std::runtime_error("File cannot be read");
+
+		MeshLods& lods = *target.GetAsset();
+		if(MeshLodFile::IsValidHeader(data, size))
+		{
+			const MeshLodFile& file = *static_cast<const MeshLodFile*>(data);
+			const unsigned int levelCount = std::min<unsigned int>(file.numLevels, MeshLods::kMaxLevels);
+			for(unsigned int i = 0; i < levelCount; ++i)
+			{
+				if(file.levels[i].offset + file.levels[i].size > fileSize)
+					throw std::runtime_error("Mesh level exceeds file");
+				stream.levels.push_back(file.levels[i]);
+				lods.errors[i] = file.levels[i].error;
+			}
+		}
+		else if(FileTypeIdentification::IsMeshLodChain(data, size))
+			throw std::runtime_error("Invalid mesh level table");
+		else
+			stream.levels.push_back(MeshLodFile::Level{0, fileSize, 0.0f, 0, 0, 0, 0});
+		lods.levelCount = static_cast<unsigned int>(stream.levels.size());
+
+		const size_t morphTargetCount = target.GetLocation().morphTargets.size();
+		if(morphTargetCount > 0 && stream.morphTargets.empty())
+		{
+			stream.morphTargets.resize(morphTargetCount);
+			stream.pendingTargets = morphTargetCount;
+			stream.pendingFile = wholeFile;
+			if(ReadMorphTargets(target))
+				return; // Levels are loaded with the last morph target
+			stream.pendingTargets = 0;
+		}
+		LoadPendingLevels(target, wholeFile);
+	}
+	catch(std::exception& e)
+	{
+		LOG(ERROR) << "Error loading mesh " << target.GetLocation().meshFile << ": " << e.what();
+		for(unsigned int level: stream.pendingLevels)
+			target.SetState(level, MeshManager::Asset::kFailed);
+		mStreams.erase(&target);
+	}
+}
+
+template<class TRenderManager>
+bool MeshLoader<TRenderManager>::ReadMorphTargets(MeshManager::Asset& target)
+{
+	MeshManager::Asset* destination = &target;
+	auto prepare = [this, destination](size_t index, Blob& blob)
+	{
+		std::shared_ptr<const MorphTargetData> data;
+		try
+		{
+			data = std::make_shared<MorphTargetData>(PrepareMorphTarget(blob.GetData(), blob.GetSize()));
+		}
+		catch(std::exception& e)
+		{
+			LOG(ERROR) << "Error loading morph target " << destination->GetLocation().morphTargets.at(index) << ": " << e.what();
+		}
+		mRenderManager.GetGlTaskQueue().EnqueueTask([=](){StoreMorphTarget(*destination, index, data);});
+	};
+
+	const std::vector<Hash>& files = target.GetLocation().morphTargets;
+	try
+	{
+		mRenderManager.GetFileServer().ReadFiles(files.data(), files.size(), prepare, mRenderManager.GetTaskQueue());
+	}
+	catch(std::exception& e)
+	{
+		LOG(ERROR) << "Error reading morph targets of mesh " << target.GetLocation().meshFile << ": " << e.what();
+		return false;
 	}
+	return true;
 }
 
 template<class TRenderManager>
-void MeshLoader<TRenderManager>::Unload(DrawMeshData*& asset, unsigned int minLevel, unsigned int maxLevel)
+void MeshLoader<TRenderManager>::StoreMorphTarget(MeshManager::Asset& target, size_t index, std::shared_ptr<const MorphTargetData> data)
 {
-	// No LOD for now:
-	assert(minLevel == 0);
-	assert(maxLevel == 0);
+	auto it = mStreams.find(&target);
+	if(it == mStreams.end())
+		return;
+	Stream& stream = it->second;
+	stream.morphTargets.at(index) = data;
+	// Zero if reading the other targets failed and levels were loaded without them:
+	if(stream.pendingTargets == 0 || --stream.pendingTargets > 0)
+		return;
+
+	std::shared_ptr<Blob> wholeFile = std::move(stream.pendingFile);
+	try
+	{
+		LoadPendingLevels(target, wholeFile);
+	}
+	catch(std::exception& e)
+	{
+		LOG(ERROR) << "Error loading mesh " << target.GetLocation().meshFile << ": " << e.what();
+		for(unsigned int level: stream.pendingLevels)
+			target.SetState(level, MeshManager::Asset::kFailed);
+		mStreams.erase(&target);
+	}
+}
 
-	asset->Unload();
+template<class TRenderManager>
+void MeshLoader<TRenderManager>::LoadPendingLevels(MeshManager::Asset& target, std::shared_ptr<Blob> wholeFile)
+{
+	Stream& stream = mStreams.at(&target);
+	for(unsigned int level: stream.pendingLevels)
+		LoadLevel(target, level, wholeFile);
+	stream.pendingLevels.clear();
 }
 
 template<class TRenderManager>
-void MeshLoader<TRenderManager>::StoreMesh(MeshManager::Asset& destination, Blob& blob)
+void MeshLoader<TRenderManager>::LoadLevel(MeshManager::Asset& target, unsigned int level, std::shared_ptr<Blob> wholeFile)
 {
-	if(FileTypeIdentification::IsCompiledMesh(blob.GetData(), blob.GetSize()))
-		StoreCompiledMesh(destination, blob);
-	else if(FileTypeIdentification::IsNmb(blob.GetData(), blob.GetSize()))
-		StoreNmb(destination, blob);
-	else
-		LOG(WARNING) << "MeshLoader: Unknown mesh file type";
+	const Stream& stream = mStreams.at(&target);
+	unsigned int fileLevel = level;
+	if(level >= stream.levels.size())
+	{
+		// Load coarsest level instead, so there is something to draw:
+		target.SetState(level, MeshManager::Asset::kNotLoaded);
+		fileLevel = static_cast<unsigned int>(stream.levels.size() - 1);
+		if(target.GetState(fileLevel) != MeshManager::Asset::kNotLoaded)
+			return;
+		target.SetState(fileLevel, MeshManager::Asset::kLoading);
+	}
+
+	const Hash file = target.GetLocation().meshFile;
+	try
+	{
+		const MeshLodFile::Level levelInfo = stream.levels[fileLevel];
+		const std::vector<std::shared_ptr<const MorphTargetData>> morphTargets = stream.morphTargets;
+		const size_t offset = levelInfo.offset;
+		const size_t size = levelInfo.size;
+		MeshManager::Asset* destination = &target;
+		size_t fileSize = 0;
+		if(wholeFile)
+		{
+			const uint8_t* data = static_cast<const uint8_t*>(wholeFile->GetData()) + offset;
+			mRenderManager.GetTaskQueue().EnqueueTask([=](){PrepareMesh(*destination, fileLevel, level, levelInfo, morphTargets, data, size, wholeFile);});
+		}
+		else if(const void* data = mRenderManager.GetFileServer().MapFile(file, fileSize))
+		{
+			// Parse in place, no copy:
+			const uint8_t* levelData = static_cast<const uint8_t*>(data) + offset;
+			mRenderManager.GetTaskQueue().EnqueueTask([=](){PrepareMesh(*destination, fileLevel, level, levelInfo, morphTargets, levelData, size, nullptr);});
+		}
+		else
+		{
+			auto prepare = [this, destination, fileLevel, level, levelInfo, morphTargets](Blob& blob)
+			{
+				std::shared_ptr<Blob> contents = std::make_shared<Blob>(std::move(blob));
+				PrepareMesh(*destination, fileLevel, level, levelInfo, morphTargets, contents->GetData(), contents->GetSize(), contents);
+			};
+			mRenderManager.GetFileServer().ReadFileRange(file, offset, size, prepare, mRenderManager.GetTaskQueue());
+		}
+	}
+	catch(std::exception& e)
+	{
+		LOG(ERROR) << "Error reading mesh " << file << ": " << e.what();
+		target.SetState(fileLevel, MeshManager::Asset::kFailed);
+		target.SetState(level, MeshManager::Asset::kFailed);
+	}
 }
 
 template<class TRenderManager>
-void MeshLoader<TRenderManager>::StoreCompiledMesh(MeshManager::Asset& destination, Blob& blob)
+void MeshLoader<TRenderManager>::PrepareMesh(MeshManager::Asset& destination, unsigned int level, unsigned int wantedLevel, const MeshLodFile::Level& levelInfo, const std::vector<std::shared_ptr<const MorphTargetData>>& morphTargets, const void* data, size_t size, std::shared_ptr<Blob> contents)
 {
-	const meshfile::MeshFile& file = *static_cast<const meshfile::MeshFile*>(blob.GetData());
+	MeshManager::Asset* target = &destination;
 	try
 	{
-		destination.GetAsset()->Load(file);
-		destination.SetState(0, MeshManager::Asset::kLoaded);
+		std::shared_ptr<PreparedMesh> mesh;
+		if(FileTypeIdentification::IsCompiledMesh(data, size))
+		{
+			mesh = std::make_shared<PreparedMesh>(PrepareCompiledMesh(data, size));
+			if(levelInfo.numClusters > 0)
+			{
+				if(levelInfo.clustersOffset + levelInfo.numClusters * sizeof(MeshLodFile::Cluster) > size)
+					throw std::runtime_error("Mesh clusters exceed level");
+				const MeshLodFile::Cluster* clusters = reinterpret_cast<const MeshLodFile::Cluster*>(static_cast<const uint8_t*>(data) + levelInfo.clustersOffset);
+				mesh->clusters.assign(clusters, clusters + levelInfo.numClusters);
+			}
+		}
+		else if(FileTypeIdentification::IsNmb(data, size))
+		{
+			mesh = std::make_shared<PreparedMesh>(PrepareNmb(data, size));
+			contents.reset(); // Everything copied into the PreparedMesh
+		}
+		else
+			throw std::runtime_error("Unknown mesh file type");
+		for(auto& morphTarget: morphTargets)
+			mesh->AddMorphTarget(morphTarget ? *morphTarget : MorphTargetData());
+		// Release file contents only after upload:
+		mRenderManager.GetGlTaskQueue().EnqueueTask([=]() mutable {StoreMesh(*target, level, wantedLevel, *mesh); contents.reset();});
 	}
 	catch(std::exception& e)
 	{
-		LOG(ERROR) << "StoreCompiledMesh failed: " << e.what();
-		destination.GetAsset()->Unload();
-		destination.SetState(0, MeshManager::Asset::kFailed);
+		LOG(ERROR) << "PrepareMesh failed: " << e.what();
+		mRenderManager.GetGlTaskQueue().EnqueueTask([=](){StoreFailure(*target, level);});
 	}
 }
 
+template<class TRenderManager>
+MorphTargetData MeshLoader<TRenderManager>::PrepareMorphTarget(const void* data, size_t size)
+{
+	if(MeshLodFile::IsValidHeader(data, size))
+	{
+		const MeshLodFile::Level& level = static_cast<const MeshLodFile*>(data)->levels[0];
+		if(level.offset + level.size > size)
+			throw std::runtime_error("Mesh level exceeds file");
+		data = static_cast<const uint8_t*>(data) + level.offset;
+		size = level.size;
+	}
+
+	if(FileTypeIdentification::IsCompiledMesh(data, size))
+		return MorphTargetData::FromPreparedMesh(PrepareCompiledMesh(data, size));
+	else if(FileTypeIdentification::IsNmb(data, size))
+		return MorphTargetData::FromPreparedMesh(PrepareNmb(data, size));
+	throw std::runtime_error("Unknown morph target file type");
+}
+
+template<class TRenderManager>
+PreparedMesh MeshLoader<TRenderManager>::PrepareCompiledMesh(const void* data, size_t /*size*/)
+{
+	return PreparedMesh::FromMeshFile(*static_cast<const meshfile::MeshFile*>(data));
+}
+
+template<class TRenderManager>
+PreparedMesh MeshLoader<TRenderManager>::PrepareNmb(const void* data, size_t size)
+{
+	MemoryReadStorage storage(data, size);
+	util::NmbFile nmb(storage);
+	NmbMeshDataSource source(nmb);
+	return PreparedMesh::FromSource(source);
+}
 
 template<class TRenderManager>
-void MeshLoader<TRenderManager>::StoreNmb(MeshManager::Asset& destination, Blob& blob)
+void MeshLoader<TRenderManager>::StoreMesh(MeshManager::Asset& destination, unsigned int level, unsigned int wantedLevel, const PreparedMesh& mesh)
 {
-	MemoryReadStorage storage(blob.GetData(), blob.GetSize());
+	if(!destination.IsWanted(wantedLevel))
+	{
+		// Cancelled while loading:
+		destination.SetState(level, MeshManager::Asset::kNotLoaded);
+		return;
+	}
+
 	try
 	{
-		util::NmbFile nmb(storage);
-		NmbMeshDataSource source(nmb);
-		destination.GetAsset()->Load(source);
-		destination.SetState(0, MeshManager::Asset::kLoaded);
+		destination.GetAsset()->levels[level]->Load(mesh);
+		size_t size = 0;
+		for(auto& buffer: mesh.vertexBuffers)
+			size += buffer.size;
+		for(auto& buffer: mesh.indexBuffers)
+			size += buffer.size;
+		destination.SetState(level, MeshManager::Asset::kLoaded);
+		destination.SetSize(level, size);
 	}
 	catch(std::exception& e)
 	{
-		LOG(ERROR) << "StoreNmb failed: " << e.what();
-		destination.GetAsset()->Unload();
-		destination.SetState(0, MeshManager::Asset::kFailed);
+		LOG(ERROR) << "StoreMesh failed: " << e.what();
+		StoreFailure(destination, level);
 	}
 }
 
+template<class TRenderManager>
+void MeshLoader<TRenderManager>::StoreFailure(MeshManager::Asset& destination, unsigned int level)
+{
+	destination.GetAsset()->levels[level]->Unload();
+	destination.SetState(level, MeshManager::Asset::kFailed);
+}
+
 }
 }
 
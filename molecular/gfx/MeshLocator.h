@@ -27,7 +27,6 @@ SOFTWARE.
 #define MOLECULAR_MESHLOCATOR_H
 
 #include <vector>
-#include <string>
 #include <molecular/util/Hash.h>
 
 namespace molecular
@@ -41,17 +40,10 @@ struct MeshLocator
 	/// Mesh file path
 	util::Hash meshFile;
 
-	/// Specifies a morph target file path and its weight
-	struct MorphTarget
-	{
-		/// Morph target file name
-		std::string file;
-
-		/// Morph target weight
-		/** From 0 to 1. */
-		float weight;
-	};
-	std::vector<MorphTarget> morphTargets;
+	/// Morph target file paths
+	/** Weights are not part of the locator, so all weight combinations share
+		one asset. They are set when drawing, see DrawMesh. */
+	std::vector<util::Hash> morphTargets;
 };
 
 }
@@ -0,0 +1,120 @@
+/*	MeshLodFile.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_MESHLODFILE_H
+#define MOLECULAR_MESHLODFILE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace molecular
+{
+namespace gfx
+{
+
+/// File format for a chain of levels of detail of a mesh
+/** Each level is a complete compiled mesh file, so levels can be read with
+	range reads and loaded and unloaded individually. Level 0 is the most
+	detailed one. A level can have a table of Clusters after its mesh file,
+	inside the level's range. Written by molecular-meshcook. */
+struct MeshLodFile
+{
+	static const uint32_t kMagic = 0x8e8e54f2;
+	static const unsigned int kMaxLevels = 8;
+
+	struct Level
+	{
+		uint64_t offset; ///< Offset of the level's mesh file, 16 byte aligned
+		uint64_t size;
+
+		/// Largest deviation from level 0 relative to the diagonal of the bounds
+		float error;
+		uint32_t numTriangles;
+
+		/// Offset of the Cluster table relative to offset, 16 byte aligned
+		uint64_t clustersOffset;
+		uint32_t numClusters; ///< 0 if the level has no clusters
+		uint32_t reserved;
+	};
+
+	/// Consecutive triangles of an index buffer with bounds for culling
+	struct Cluster
+	{
+		/// Bounding sphere in model space
+		float center[3];
+		float radius;
+
+		/// Normal cone, see MeshOptimization::Cluster
+		float coneAxis[3];
+		float coneCutoff;
+
+		uint32_t indexSpec; ///< Index into MeshFile::indexSpecs
+		uint32_t firstIndex; ///< Relative to the index spec
+		uint32_t indexCount;
+		uint32_t reserved;
+
+		/// Check if no triangle of the cluster faces the viewer
+		/** @param eye Viewer position in model space with w = 1, or normalized
+				direction of view with w = 0 for parallel projections.
+			@param front Check if all triangles face the viewer instead, for
+				passes that cull front faces. */
+		bool IsCulledByCone(const float eye[4], bool front = false) const
+		{
+			const float sign = front ? -1.0f : 1.0f;
+			if(eye[3] == 0.0f)
+				return sign * (eye[0] * coneAxis[0] + eye[1] * coneAxis[1] + eye[2] * coneAxis[2]) > coneCutoff;
+			const float toCenter[3] = {center[0] - eye[0], center[1] - eye[1], center[2] - eye[2]};
+			const float distance = std::sqrt(toCenter[0] * toCenter[0] + toCenter[1] * toCenter[1] + toCenter[2] * toCenter[2]);
+			return sign * (toCenter[0] * coneAxis[0] + toCenter[1] * coneAxis[1] + toCenter[2] * coneAxis[2]) > coneCutoff * distance + radius;
+		}
+	};
+
+	uint32_t magic;
+	uint32_t numLevels;
+	Level levels[0];
+
+	/// Bytes up to the end of the level table
+	static size_t GetHeaderSize(unsigned int numLevels) {return 8 + numLevels * sizeof(Level);}
+
+	/// Check magic number and level table
+	/** @param size Bytes available, at least GetHeaderSize(kMaxLevels) or the
+			file size. */
+	static bool IsValidHeader(const void* data, size_t size)
+	{
+		if(size < GetHeaderSize(0))
+			return false;
+		const MeshLodFile& file = *static_cast<const MeshLodFile*>(data);
+		return file.magic == kMagic && file.numLevels > 0 && file.numLevels <= kMaxLevels && size >= GetHeaderSize(file.numLevels);
+	}
+};
+static_assert(sizeof(MeshLodFile) == 8, "Unexpected size of MeshLodFile");
+static_assert(sizeof(MeshLodFile::Level) == 40, "Unexpected size of MeshLodFile::Level");
+static_assert(sizeof(MeshLodFile::Cluster) == 48, "Unexpected size of MeshLodFile::Cluster");
+
+}
+}
+
+#endif // MOLECULAR_MESHLODFILE_H
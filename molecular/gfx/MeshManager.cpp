@@ -33,12 +33,25 @@ namespace gfx
 Hash MakeHash(const MeshLocator& locator)
 {
 	Hash hash = locator.meshFile;
-	for(auto& target: locator.morphTargets)
+	for(Hash target: locator.morphTargets)
+		hash = HashUtils::Combine(hash, target);
+	return hash;
+}
+
+unsigned int MeshLods::SelectLevel(float footprint, float maxError, unsigned int currentLevel) const
+{
+	if(levelCount == 0)
+		return kMaxLevels - 1;
+
+	unsigned int level = 0;
+	for(unsigned int i = 1; i < levelCount; ++i)
 	{
-		hash = HashUtils::Combine(hash, HashUtils::MakeHash(target.file));
-		hash = HashUtils::Combine(hash, HashUtils::MakeHash(reinterpret_cast<const char*>(&target.weight), sizeof(float)));
+		const float threshold = (i > currentLevel) ? maxError * kHysteresis : maxError;
+		if(errors[i] * footprint > threshold)
+			break;
+		level = i;
 	}
-	return hash;
+	return level;
 }
 
 }
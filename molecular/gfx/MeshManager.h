@@ -29,6 +29,8 @@ SOFTWARE.
 #include "AssetManager.h"
 #include "MeshLocator.h"
 
+#include <array>
+
 namespace molecular
 {
 
@@ -36,12 +38,42 @@ namespace gfx
 {
 
 /// Modified hashing function that hashes MeshLocator
-/** Includes the file name and morph targets with their respective weights. */
+/** Includes the file name and morph target files. */
 Hash MakeHash(const MeshLocator& locator);
 
 class DrawMeshData;
 
-typedef AssetManager<DrawMeshData*, 1, false, MeshLocator> MeshManager;
+/// Levels of detail of a mesh
+/** Asset type of the MeshManager, which loads and unloads levels
+	individually. Filled by MeshLoader. */
+struct MeshLods
+{
+	/// Levels beyond this are not loaded
+	static const unsigned int kMaxLevels = 4;
+
+	/// Fraction of the allowed error a coarser level has to stay below
+	/** Keeps meshes near a threshold from switching levels back and forth. */
+	static constexpr float kHysteresis = 0.75f;
+
+	/// Select level for a mesh of a given size on screen
+	/** Picks the coarsest level whose error projected to the screen is at
+		most maxError pixels. Levels coarser than currentLevel have to be
+		below maxError * kHysteresis. Returns the coarsest level while
+		levelCount is not known yet, so there is something to draw early.
+		@param footprint Size of the bounds on screen in pixels. */
+	unsigned int SelectLevel(float footprint, float maxError, unsigned int currentLevel) const;
+
+	/// Drawing functions per level, level 0 is the most detailed
+	std::array<DrawMeshData*, kMaxLevels> levels;
+
+	/// Levels in the mesh file up to kMaxLevels, 0 until known
+	unsigned int levelCount = 0;
+
+	/// Error per level relative to the bounds diagonal, see MeshLodFile
+	std::array<float, kMaxLevels> errors;
+};
+
+typedef AssetManager<MeshLods*, MeshLods::kMaxLevels, false, MeshLocator> MeshManager;
 
 } // gfx
 } // molecular
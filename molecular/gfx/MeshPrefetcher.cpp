@@ -0,0 +1,102 @@
+/*	MeshPrefetcher.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "MeshPrefetcher.h"
+#include "GfxUtils.h"
+
+#include <algorithm>
+
+namespace molecular
+{
+namespace gfx
+{
+
+void MeshPrefetcher::Update(const Matrix4& viewMatrix, const Matrix4& projectionMatrix, const Vector2& viewportSize)
+{
+	if(!mMeshBounds)
+		return;
+
+	const Vector3 position = Matrix4(viewMatrix.Inverse()).GetTranslation();
+	const Vector3 velocity = mHasPreviousPosition ? position - mPreviousPosition : Vector3(0, 0, 0);
+	mPreviousPosition = position;
+	mHasPreviousPosition = true;
+
+	// Where the camera will be if it keeps moving like this:
+	const Vector3 lookAhead = velocity * mLookAheadFrames;
+	const Matrix4 currentViewProjection = projectionMatrix * viewMatrix;
+	const Matrix4 predictedViewProjection = currentViewProjection * Matrix4::Translation(-lookAhead);
+	const util::Frustum current = ExpandedFrustum(currentViewProjection);
+	const util::Frustum predicted = ExpandedFrustum(predictedViewProjection);
+
+	mCandidates.clear();
+	for(unsigned int i = 0; i < mMeshBounds->count; ++i)
+	{
+		if(mMeshBounds->IsEmpty(i))
+			continue;
+		const util::AxisAlignedBox& bounds = mMeshBounds->GetBoundsByIndex(i);
+		if(current.Check(bounds) == util::Plane::kOutside && predicted.Check(bounds) == util::Plane::kOutside)
+			continue;
+		const float footprint = std::max(ScreenFootprint(currentViewProjection, bounds, viewportSize), ScreenFootprint(predictedViewProjection, bounds, viewportSize));
+		mCandidates.push_back(Candidate{mMeshBounds->hashes[i], (bounds.GetCenter() - position).Length(), footprint});
+	}
+	std::sort(mCandidates.begin(), mCandidates.end(), [](const Candidate& a, const Candidate& b){return a.distance < b.distance;});
+
+	// Finished loads free their slot. Those not requested again are cancelled:
+	mOutstanding.clear();
+	for(auto& candidate: mCandidates)
+	{
+		MeshLocator locator;
+		locator.meshFile = candidate.mesh;
+		MeshManager::Asset* asset = mMeshManager.GetAsset(locator);
+
+		// Level DrawMesh will select when the mesh comes into view. The
+		// coarsest one until the level count is known:
+		const MeshLods& lods = *asset->GetAsset();
+		const unsigned int level = lods.SelectLevel(candidate.footprint, mLodError, 0);
+		const MeshManager::Asset::State state = asset->GetState(level);
+		if(state == MeshManager::Asset::kLoaded || state == MeshManager::Asset::kFailed)
+			continue;
+		if(state == MeshManager::Asset::kNotLoaded && mOutstanding.size() >= mMaxOutstanding)
+			continue; // Over budget, maybe next frame
+
+		// Nearer is more important, always less than kMaxPriority:
+		asset->Use(level, kMaxPriority / (1.0f + candidate.distance));
+		mOutstanding.push_back(asset);
+	}
+}
+
+util::Frustum MeshPrefetcher::ExpandedFrustum(const Matrix4& viewProjectionMatrix) const
+{
+	util::Plane planes[6];
+	const util::Frustum frustum(viewProjectionMatrix);
+	for(int i = 0; i < 6; ++i)
+	{
+		planes[i] = frustum.GetPlanes()[i];
+		planes[i].SetDistance(planes[i].GetDistance() - mMargin);
+	}
+	return util::Frustum(planes);
+}
+
+}
+}
@@ -0,0 +1,119 @@
+/*	MeshPrefetcher.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef MOLECULAR_GFX_MESHPREFETCHER_H
+#define MOLECULAR_GFX_MESHPREFETCHER_H
+
+#include "MeshBoundsCollectionFile.h"
+#include "MeshManager.h"
+#include <molecular/util/Frustum.h>
+#include <molecular/util/Matrix4.h>
+#include <molecular/util/Vector2.h>
+#include <molecular/util/Vector3.h>
+
+#include <vector>
+
+namespace molecular
+{
+namespace gfx
+{
+
+/// Loads meshes before they come into view
+/** Tests all bounds of a MeshBoundsCollectionFile against the view frustum,
+	expanded by a margin and extrapolated along the camera movement, and
+	requests loading of meshes inside from the MeshManager. The level of
+	detail is selected like DrawMesh does, from the larger of the current and
+	the extrapolated size on screen. Nearer meshes are requested first.
+	Requests have lower priority than anything actually drawn, see
+	MeshPrefetcher::kMaxPriority. */
+class MeshPrefetcher
+{
+public:
+	/// Priorities of prefetch requests are below this
+	/** Draws pass their size on screen in pixels as priority, which is at
+		least this for anything visible. */
+	static constexpr float kMaxPriority = 1.0f;
+
+	explicit MeshPrefetcher(MeshManager& meshManager) : mMeshManager(meshManager) {}
+
+	/// Set bounds of all meshes that can be prefetched
+	/** nullptr disables prefetching. Data must stay valid while in use. */
+	void SetMeshBounds(const MeshBoundsCollectionFile* file) {mMeshBounds = file;}
+
+	/// Distance by which the view frustum is expanded on all sides
+	void SetMargin(float margin) {mMargin = margin;}
+
+	/// Number of frames camera movement is extrapolated
+	void SetLookAheadFrames(float frames) {mLookAheadFrames = frames;}
+
+	/// Maximum number of prefetch loads not finished yet
+	void SetMaxOutstanding(unsigned int count) {mMaxOutstanding = count;}
+
+	/// Largest simplification error in pixels, see DrawMesh::SetLodError()
+	void SetLodError(float pixels) {mLodError = pixels;}
+
+	/// Request meshes in or near the view
+	/** Call once per frame with the camera of the main view. Meshes still
+		needed have to be requested again every frame, otherwise the
+		MeshManager cancels their loads.
+		@param viewportSize Width and height of the main view in pixels. */
+	void Update(const Matrix4& viewMatrix, const Matrix4& projectionMatrix, const Vector2& viewportSize);
+
+	/// Number of prefetch loads not finished yet
+	size_t GetOutstandingCount() const {return mOutstanding.size();}
+
+private:
+	struct Candidate
+	{
+		Hash mesh;
+		float distance;
+
+		/// Larger of the current and the predicted size on screen
+		float footprint;
+	};
+
+	/// Frustum with all planes moved outwards by mMargin
+	util::Frustum ExpandedFrustum(const Matrix4& viewProjectionMatrix) const;
+
+	MeshManager& mMeshManager;
+	const MeshBoundsCollectionFile* mMeshBounds = nullptr;
+	float mMargin = 10.0f;
+	float mLookAheadFrames = 30.0f;
+	unsigned int mMaxOutstanding = 4;
+	float mLodError = 1.0f;
+
+	bool mHasPreviousPosition = false;
+	Vector3 mPreviousPosition;
+
+	/// Kept to avoid allocations every frame
+	std::vector<Candidate> mCandidates;
+
+	/// Assets requested by the prefetcher that are still loading
+	std::vector<MeshManager::Asset*> mOutstanding;
+};
+
+}
+}
+
+#endif // MOLECULAR_GFX_MESHPREFETCHER_H
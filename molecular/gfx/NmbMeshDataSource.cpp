@@ -26,6 +26,8 @@ SOFTWARE.
 #include "NmbMeshDataSource.h"
 #include <molecular/util/Logging.h>
 
+#include <stdexcept>
+
 namespace molecular
 {
 namespace gfx
@@ -45,25 +47,23 @@ NmbMeshDataSource::NmbMeshDataSource(util::NmbFile& file, const std::string& sub
 	{
 		if(!mSubmesh.empty() && mSubmesh != it.name)
 			continue;
-		SetNumVertices(it.vertexBuffers.at(0).values.size(), mesh);
+		SetNumVertices(it.vertexBuffers.at(0).elementCount, mesh);
 
 		for(auto& vertexBuffer: it.vertexBuffers)
 		{
+			if(vertexBuffer.values.size() != size_t(vertexBuffer.elementCount) * vertexBuffer.elementSize)
+				throw std::runtime_error("NMB vertex buffer \"" + vertexBuffer.name + "\" has wrong size");
+
 			VertexAttributeInfo info;
 			info.type = VertexAttributeInfo::kFloat;
 			info.components = vertexBuffer.elementSize;
-			LOG(DEBUG) << vertexBuffer.name;
-			if(vertexBuffer.name == "a2v.objCoord" || vertexBuffer.name == "a2v.worldCoord")
-				info.semantic = VertexAttributeInfo::kPosition;
-			else if(vertexBuffer.name == "a2v.objNormal" || vertexBuffer.name == "a2v.worldNormal")
-				info.semantic = VertexAttributeInfo::kNormal;
-			else if(vertexBuffer.name == "a2v.tex" || vertexBuffer.name == "a2v.diffuse" || vertexBuffer.name == "a2v.c_texCoord")
-				info.semantic = VertexAttributeInfo::kTextureCoords;
-			else
+			info.semantic = GetSemantic(vertexBuffer.name);
+			if(info.semantic == VertexAttributeInfo::kUnknown)
+				LOG(ERROR) << "Unknown NMB vertex buffer \"" << vertexBuffer.name << "\"";
+			else if(info.semantic == VertexAttributeInfo::kPosition && vertexBuffer.elementSize >= 3)
 			{
-				LOG(ERROR) << "Unbekannt: " << vertexBuffer.name;
-				info.semantic = VertexAttributeInfo::kUnknown;
-//				assert(false);
+				for(size_t i = 0; i < vertexBuffer.values.size(); i += vertexBuffer.elementSize)
+					mBounds.Stretch(Vector3(vertexBuffer.values[i], vertexBuffer.values[i + 1], vertexBuffer.values[i + 2]));
 			}
 
 			info.buffer = mVertexBuffers.size();
@@ -134,7 +134,18 @@ const void* NmbMeshDataSource::IndexBufferData(int buffer)
 
 util::AxisAlignedBox NmbMeshDataSource::GetBounds() const
 {
-	return util::AxisAlignedBox(); // TODO
+	return mBounds;
+}
+
+Hash NmbMeshDataSource::GetSemantic(const std::string& vertexBufferName)
+{
+	if(vertexBufferName == "a2v.objCoord" || vertexBufferName == "a2v.worldCoord")
+		return VertexAttributeInfo::kPosition;
+	else if(vertexBufferName == "a2v.objNormal" || vertexBufferName == "a2v.worldNormal")
+		return VertexAttributeInfo::kNormal;
+	else if(vertexBufferName == "a2v.tex" || vertexBufferName == "a2v.diffuse" || vertexBufferName == "a2v.c_texCoord")
+		return VertexAttributeInfo::kTextureCoords;
+	return VertexAttributeInfo::kUnknown;
 }
 
 }
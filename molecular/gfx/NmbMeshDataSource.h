@@ -34,11 +34,18 @@ namespace molecular
 namespace gfx
 {
 
+/// MeshDataSource for NVidia NMB files
+/** Slow path for loading NMB files at runtime. Convert them to compiled mesh
+	files with molecular-meshcook for production. */
 class NmbMeshDataSource : public MeshDataSource
 {
 public:
 	NmbMeshDataSource(util::NmbFile& file, const std::string &submesh = "");
 
+	/// Vertex attribute semantic from NMB vertex buffer name
+	/** @returns VertexAttributeInfo::kUnknown for unrecognized names. */
+	static Hash GetSemantic(const std::string& vertexBufferName);
+
 	int PrepareVertexData(LayoutHint layout = kLayoutAny);
 
 	int PrepareIndexData();
@@ -54,6 +61,7 @@ private:
 	std::string mSubmesh;
 	std::vector<const util::NmbFile::VertexBuffer*> mVertexBuffers;
 	std::vector<const util::NmbFile::IndexBuffer*> mIndexBuffers;
+	util::AxisAlignedBox mBounds;
 };
 
 }
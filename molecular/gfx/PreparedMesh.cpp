@@ -0,0 +1,353 @@
+/*	PreparedMesh.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PreparedMesh.h"
+#include <molecular/gfx/MeshDataSource.h>
+#include <molecular/meshfile/MeshFile.h>
+#include <molecular/util/Logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace molecular
+{
+namespace gfx
+{
+using namespace meshfile;
+
+namespace
+{
+
+size_t GetTypeSize(VertexAttributeInfo::Type type)
+{
+	switch(type)
+	{
+	case VertexAttributeInfo::kInt8:
+	case VertexAttributeInfo::kUInt8:
+		return 1;
+	case VertexAttributeInfo::kInt16:
+	case VertexAttributeInfo::kUInt16:
+	case VertexAttributeInfo::kHalf:
+		return 2;
+	case VertexAttributeInfo::kFloat:
+	case VertexAttributeInfo::kInt32:
+	case VertexAttributeInfo::kUInt32:
+		return 4;
+	}
+	return 0;
+}
+
+size_t GetIndexSize(IndexBufferInfo::Type type)
+{
+	switch(type)
+	{
+	case IndexBufferInfo::Type::kUInt8: return 1;
+	case IndexBufferInfo::Type::kUInt16: return 2;
+	case IndexBufferInfo::Type::kUInt32: return 4;
+	}
+	return 4;
+}
+
+/// Hash indices of all index buffers drawing a vertex data set, in order
+Hash HashIndices(const PreparedMesh& mesh, size_t set)
+{
+	Hash hash = 0;
+	for(auto& info: mesh.indexBufferInfos)
+	{
+		if(info.vertexDataSet != set)
+			continue;
+		const size_t size = size_t(info.count) * GetIndexSize(info.type);
+		const PreparedMesh::Buffer* buffer = info.buffer < mesh.indexBuffers.size() ? &mesh.indexBuffers[info.buffer] : nullptr;
+		if(!buffer || !buffer->data || info.offset + size > buffer->size)
+			hash = HashUtils::Combine(hash, info.count);
+		else
+			hash = HashUtils::Combine(hash, HashUtils::MakeHash(static_cast<const char*>(buffer->data) + info.offset, size));
+	}
+	return hash;
+}
+
+/// Copy buffer into storage of the prepared mesh
+PreparedMesh::Buffer Store(PreparedMesh& mesh, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	mesh.storage.emplace_back(bytes, bytes + size);
+	return PreparedMesh::Buffer{mesh.storage.back().data(), size};
+}
+
+/// Read three floats per vertex of an attribute
+/** @param outAttribute Set to the attribute read, if not nullptr.
+	@returns false if there is no float attribute with that semantic. */
+bool ReadFloat3(const PreparedMesh& mesh, size_t set, Hash semantic, std::vector<float>& out, const VertexAttributeInfo** outAttribute = nullptr)
+{
+	for(auto& attribute: mesh.vertexDataSets.at(set))
+	{
+		if(attribute.semantic != semantic || attribute.type != VertexAttributeInfo::kFloat || attribute.components < 3)
+			continue;
+		const PreparedMesh::Buffer& buffer = mesh.vertexBuffers.at(attribute.buffer);
+		const size_t numVertices = mesh.vertexCounts.at(set);
+		const size_t stride = attribute.stride ? attribute.stride : attribute.components * sizeof(float);
+		if(!buffer.data || (numVertices > 0 && attribute.offset + (numVertices - 1) * stride + 3 * sizeof(float) > buffer.size))
+			return false;
+
+		out.resize(numVertices * 3);
+		const uint8_t* data = static_cast<const uint8_t*>(buffer.data) + attribute.offset;
+		for(size_t v = 0; v < numVertices; ++v)
+			memcpy(&out[v * 3], data + v * stride, 3 * sizeof(float));
+		if(outAttribute)
+			*outAttribute = &attribute;
+		return true;
+	}
+	return false;
+}
+
+/// Interleave tightly packed attributes of one vertex data set
+/** @returns false if the attributes are not laid out as expected. */
+bool Interleave(PreparedMesh& mesh, MeshDataSource& source, unsigned int set, std::vector<bool>& bufferHandled)
+{
+	std::vector<VertexAttributeInfo>& attributes = mesh.vertexDataSets[set];
+	const size_t numVertices = source.GetNumVertices(set);
+	if(attributes.size() < 2 || numVertices == 0)
+		return false;
+
+	size_t stride = 0;
+	for(auto& attribute: attributes)
+	{
+		const size_t elementSize = GetTypeSize(attribute.type) * attribute.components;
+		if(attribute.stride != 0 || attribute.offset != 0 || elementSize == 0 || bufferHandled.at(attribute.buffer))
+			return false;
+		if(source.VertexBufferSize(attribute.buffer) != numVertices * elementSize)
+			return false;
+		stride += elementSize;
+	}
+
+	// Keep four byte alignment of each vertex:
+	stride = (stride + 3) & ~size_t(3);
+	mesh.storage.emplace_back(numVertices * stride, 0);
+	uint8_t* output = mesh.storage.back().data();
+	const uint32_t interleavedBuffer = attributes.front().buffer;
+	size_t offset = 0;
+	for(auto& attribute: attributes)
+	{
+		const size_t elementSize = GetTypeSize(attribute.type) * attribute.components;
+		const uint8_t* input = static_cast<const uint8_t*>(source.VertexBufferData(attribute.buffer));
+		for(size_t v = 0; v < numVertices; ++v)
+			memcpy(output + v * stride + offset, input + v * elementSize, elementSize);
+
+		bufferHandled[attribute.buffer] = true;
+		attribute.buffer = interleavedBuffer;
+		attribute.offset = uint32_t(offset);
+		attribute.stride = uint32_t(stride);
+		offset += elementSize;
+	}
+	mesh.vertexBuffers[interleavedBuffer] = PreparedMesh::Buffer{output, numVertices * stride};
+	return true;
+}
+
+}
+
+PreparedMesh PreparedMesh::FromSource(MeshDataSource& source)
+{
+	PreparedMesh mesh;
+	const unsigned int numVertexBuffers = source.PrepareVertexData();
+	const unsigned int numIndexBuffers = source.PrepareIndexData();
+	const unsigned int numVertexDataSets = source.GetNumVertexDataSets();
+
+	mesh.vertexDataSets.resize(numVertexDataSets);
+	mesh.vertexCounts.resize(numVertexDataSets);
+	for(unsigned int i = 0; i < numVertexDataSets; ++i)
+	{
+		mesh.vertexDataSets[i] = source.GetVertexBufferInfos(i);
+		mesh.vertexCounts[i] = static_cast<uint32_t>(source.GetNumVertices(i));
+	}
+	mesh.indexBufferInfos = source.GetIndexBufferInfos();
+
+	// Buffers merged by interleaving stay empty:
+	mesh.storage.reserve(numVertexBuffers + numIndexBuffers);
+	mesh.vertexBuffers.resize(numVertexBuffers);
+	std::vector<bool> bufferHandled(numVertexBuffers, false);
+	for(unsigned int i = 0; i < numVertexDataSets; ++i)
+		Interleave(mesh, source, i, bufferHandled);
+	for(unsigned int i = 0; i < numVertexBuffers; ++i)
+	{
+		if(!bufferHandled[i])
+			mesh.vertexBuffers[i] = Store(mesh, source.VertexBufferData(i), source.VertexBufferSize(i));
+	}
+
+	mesh.indexBuffers.resize(numIndexBuffers);
+	for(unsigned int i = 0; i < numIndexBuffers; ++i)
+		mesh.indexBuffers[i] = Store(mesh, source.IndexBufferData(i), source.IndexBufferSize(i));
+
+	mesh.bounds = source.GetBounds();
+	return mesh;
+}
+
+bool PreparedMesh::IsPositionStreamAttribute(Hash semantic)
+{
+	return semantic == VertexAttributeInfo::kPosition || semantic == "vertexPositionQuantizedAttr"_H;
+}
+
+std::vector<unsigned int> PreparedMesh::GetPositionStreamBuffers(const std::vector<VertexAttributeInfo>& attributes)
+{
+	std::vector<unsigned int> streamBuffers;
+	std::vector<unsigned int> otherBuffers;
+	for(auto& attribute: attributes)
+	{
+		if(!IsPositionStreamAttribute(attribute.semantic))
+			otherBuffers.push_back(attribute.buffer);
+	}
+	if(otherBuffers.empty())
+		return streamBuffers;
+	for(auto& attribute: attributes)
+	{
+		if(std::find(otherBuffers.begin(), otherBuffers.end(), attribute.buffer) == otherBuffers.end()
+				&& std::find(streamBuffers.begin(), streamBuffers.end(), attribute.buffer) == streamBuffers.end())
+			streamBuffers.push_back(attribute.buffer);
+	}
+	return streamBuffers;
+}
+
+PreparedMesh PreparedMesh::FromMeshFile(const MeshFile& file)
+{
+	if(file.magic != MeshFile::kMagic)
+		throw std::runtime_error("Mesh file magic number does not match");
+	if(file.version != MeshFile::kVersion)
+		throw std::runtime_error("Wrong mesh file version");
+	if(file.numVertexDataSets > 100)
+		throw std::runtime_error("Implausible number of vertex datasets");
+	if(file.numIndexSpecs > 100)
+		throw std::runtime_error("Implausible number of index specifications");
+	if(file.numBuffers > 100)
+		throw std::runtime_error("Implausible number of buffers");
+
+	PreparedMesh mesh;
+	mesh.vertexDataSets.resize(file.numVertexDataSets);
+	mesh.vertexCounts.resize(file.numVertexDataSets);
+	for(unsigned int i = 0; i < file.numVertexDataSets; ++i)
+	{
+		const MeshFile::VertexDataSet& vSet = file.GetVertexDataSet(i);
+		mesh.vertexCounts[i] = vSet.numVertices;
+		mesh.vertexDataSets[i].resize(vSet.numVertexSpecs);
+		for(unsigned int vSpec = 0; vSpec < vSet.numVertexSpecs; ++vSpec)
+			mesh.vertexDataSets[i][vSpec] = file.GetVertexSpec(i, vSpec);
+	}
+
+	mesh.indexBufferInfos.resize(file.numIndexSpecs);
+	for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+		mesh.indexBufferInfos[i] = file.GetIndexSpec(i);
+
+	/* Vertex and index buffers share indices, so each list has gaps where the
+		other kind of buffer is. */
+	mesh.vertexBuffers.resize(file.numBuffers);
+	mesh.indexBuffers.resize(file.numBuffers);
+	for(unsigned int i = 0; i < file.numBuffers; ++i)
+	{
+		const Buffer buffer{file.GetBufferData(i), file.GetBuffer(i).size};
+		if(file.GetBuffer(i).type == MeshFile::Buffer::Type::kVertex)
+			mesh.vertexBuffers[i] = buffer;
+		else if(file.GetBuffer(i).type == MeshFile::Buffer::Type::kIndex)
+			mesh.indexBuffers[i] = buffer;
+	}
+	mesh.bounds = util::AxisAlignedBox(file.boundsMin, file.boundsMax);
+	return mesh;
+}
+
+void PreparedMesh::AddMorphTarget(const MorphTargetData& target)
+{
+	MorphTarget morphTarget;
+	morphTarget.vertexDataSets.resize(vertexDataSets.size());
+	for(size_t set = 0; set < vertexDataSets.size() && set < target.vertexDataSets.size(); ++set)
+	{
+		const MorphTargetData::VertexDataSet& targetSet = target.vertexDataSets[set];
+		const size_t numVertices = vertexCounts.at(set);
+		std::vector<float> positions;
+		if(targetSet.positions.size() != numVertices * 3 || !ReadFloat3(*this, set, VertexAttributeInfo::kPosition, positions))
+			continue;
+		if(targetSet.indices != HashIndices(*this, set))
+		{
+			LOG(WARNING) << "Morph target ignored, its vertices are ordered differently than those of the base mesh";
+			continue;
+		}
+		const VertexAttributeInfo* normal = nullptr;
+		std::vector<float> normals;
+		if(targetSet.normals.size() != numVertices * 3 || !ReadFloat3(*this, set, VertexAttributeInfo::kNormal, normals, &normal))
+			normal = nullptr;
+
+		// Position deltas, followed by normal deltas if any:
+		const size_t components = normal ? 6 : 3;
+		std::vector<float> deltas(numVertices * components);
+		bool changed = false;
+		for(size_t v = 0; v < numVertices; ++v)
+		{
+			for(size_t c = 0; c < 3; ++c)
+			{
+				deltas[v * components + c] = targetSet.positions[v * 3 + c] - positions[v * 3 + c];
+				if(normal)
+					deltas[v * components + 3 + c] = targetSet.normals[v * 3 + c] - normals[v * 3 + c];
+			}
+			for(size_t c = 0; c < components; ++c)
+				changed = changed || deltas[v * components + c] != 0.0f;
+		}
+		if(!changed)
+			continue;
+
+		const uint32_t buffer = static_cast<uint32_t>(vertexBuffers.size());
+		vertexBuffers.push_back(Store(*this, deltas.data(), deltas.size() * sizeof(float)));
+		VertexAttributeInfo delta;
+		delta.type = VertexAttributeInfo::kFloat;
+		delta.components = 3;
+		delta.buffer = buffer;
+		delta.stride = static_cast<uint32_t>(components * sizeof(float));
+		delta.offset = 0;
+		delta.normalized = false;
+		delta.semantic = VertexAttributeInfo::kPosition;
+		morphTarget.vertexDataSets[set].push_back(delta);
+		if(normal)
+		{
+			delta.semantic = VertexAttributeInfo::kNormal;
+			delta.offset = 3 * sizeof(float);
+			morphTarget.vertexDataSets[set].push_back(delta);
+		}
+	}
+	morphTargets.push_back(std::move(morphTarget));
+}
+
+MorphTargetData MorphTargetData::FromPreparedMesh(const PreparedMesh& mesh)
+{
+	MorphTargetData data;
+	data.vertexDataSets.resize(mesh.vertexDataSets.size());
+	for(size_t set = 0; set < mesh.vertexDataSets.size(); ++set)
+	{
+		if(!ReadFloat3(mesh, set, VertexAttributeInfo::kPosition, data.vertexDataSets[set].positions))
+			data.vertexDataSets[set].positions.clear();
+		if(!ReadFloat3(mesh, set, VertexAttributeInfo::kNormal, data.vertexDataSets[set].normals))
+			data.vertexDataSets[set].normals.clear();
+		data.vertexDataSets[set].indices = HashIndices(mesh, set);
+	}
+	return data;
+}
+
+}
+}
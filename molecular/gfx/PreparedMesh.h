@@ -0,0 +1,152 @@
+/*	PreparedMesh.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_PREPAREDMESH_H
+#define MOLECULAR_PREPAREDMESH_H
+
+#include <molecular/gfx/MeshLodFile.h>
+#include <molecular/util/AxisAlignedBox.h>
+#include <molecular/util/BufferInfo.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace molecular
+{
+namespace meshfile
+{
+struct MeshFile;
+}
+
+namespace gfx
+{
+class MeshDataSource;
+struct PreparedMesh;
+
+/// Positions and normals of a morph target mesh
+/** Extracted from the target file once, so it does not have to stay in
+	memory while levels of the base mesh are loaded. */
+struct MorphTargetData
+{
+	struct VertexDataSet
+	{
+		/// Three floats per vertex
+		std::vector<float> positions;
+
+		/// Three floats per vertex, empty if the target has no float normals
+		std::vector<float> normals;
+
+		/// Hash of the indices drawing this vertex data set
+		/** Vertices only correspond to those of the base mesh if the indices
+			are equal, see PreparedMesh::AddMorphTarget(). */
+		Hash indices = 0;
+	};
+
+	/// Read float positions and normals of all vertex data sets
+	static MorphTargetData FromPreparedMesh(const PreparedMesh& mesh);
+
+	std::vector<VertexDataSet> vertexDataSets;
+};
+
+/// Mesh data parsed and laid out for upload
+/** Built in worker threads, then stored in the render thread with
+	DrawMeshData::Load(), which only has to create and fill the buffers.
+	Buffer indices match those referenced by the vertex attribute and index
+	buffer infos. */
+struct PreparedMesh
+{
+	struct Buffer
+	{
+		/// Points to storage or to the data the mesh was prepared from
+		const void* data = nullptr;
+		size_t size = 0;
+	};
+
+	/// Parse and interleave mesh from a MeshDataSource
+	/** Attributes of a vertex data set that are tightly packed in separate
+		buffers get interleaved into one buffer. All data is copied into
+		storage, so the source may be destroyed afterwards. */
+	static PreparedMesh FromSource(MeshDataSource& source);
+
+	/// Validate compiled mesh file
+	/** Throws std::runtime_error if the file is implausible. Buffers point
+		into the file, which must stay valid until the mesh is loaded. */
+	static PreparedMesh FromMeshFile(const meshfile::MeshFile& file);
+
+	/// Attribute belongs in the position stream
+	/** Depth-only passes bind only buffers holding nothing but these
+		attributes, if a vertex data set keeps its other attributes in
+		separate buffers. Written by molecular-meshcook --position-stream. */
+	static bool IsPositionStreamAttribute(Hash semantic);
+
+	/// Buffers of a vertex data set holding only position stream attributes
+	/** Empty unless the vertex data set has other attributes in other
+		buffers, so binding only these buffers saves vertex fetch bandwidth. */
+	static std::vector<unsigned int> GetPositionStreamBuffers(const std::vector<VertexAttributeInfo>& attributes);
+
+	/// Add differences to a morph target as vertex buffers
+	/** Appends an entry to morphTargets. Vertices are paired by index, so
+		vertex data sets whose vertex count or index data differ from the
+		target's get no deltas. This rejects simplified levels and targets
+		whose vertices were reordered differently by molecular-meshcook.
+		Vertex data sets the target leaves unchanged get no deltas either.
+		Only float positions and normals are morphed. */
+	void AddMorphTarget(const MorphTargetData& target);
+
+	/// Delta attributes of a morph target
+	struct MorphTarget
+	{
+		/// Attributes per vertex data set, empty where the target has no deltas
+		/** Semantics are VertexAttributeInfo::kPosition and kNormal of the
+			attributes the deltas apply to. */
+		std::vector<std::vector<VertexAttributeInfo>> vertexDataSets;
+	};
+
+	std::vector<std::vector<VertexAttributeInfo>> vertexDataSets;
+
+	/// Vertices per vertex data set
+	std::vector<uint32_t> vertexCounts;
+	std::vector<IndexBufferInfo> indexBufferInfos;
+
+	/// Entries with nullptr data are not created
+	std::vector<Buffer> vertexBuffers;
+	std::vector<Buffer> indexBuffers;
+
+	util::AxisAlignedBox bounds;
+
+	/// Culling clusters, empty if the mesh has none
+	std::vector<MeshLodFile::Cluster> clusters;
+
+	/// One per morph target of the MeshLocator, in order
+	std::vector<MorphTarget> morphTargets;
+
+	/// Owns buffer data not pointing into file data
+	std::vector<std::vector<uint8_t>> storage;
+};
+
+}
+}
+
+#endif // MOLECULAR_PREPAREDMESH_H
@@ -53,6 +53,11 @@ public:
 	template<class Iterator, typename ArraySizeFunc>
 	RenderCmdSink::Program* GetProgram(Iterator varsBegin, Iterator varsEnd, ArraySizeFunc&& arraySizeFunc);
 
+	/// Get cached program with the given inputs and outputs
+	/** @returns nullptr if no such program was generated yet. */
+	template<class Iterator>
+	RenderCmdSink::Program* FindProgram(Iterator varsBegin, Iterator varsEnd) const;
+
 private:
 	template<class Iterator>
 	static Hash CalculateHash(Iterator begin, Iterator end);
@@ -90,6 +95,15 @@ RenderCmdSink::Program* ProgramProvider::GetProgram(Iterator varsBegin, Iterator
 	}
 }
 
+template<class Iterator>
+RenderCmdSink::Program* ProgramProvider::FindProgram(Iterator varsBegin, Iterator varsEnd) const
+{
+	auto it = mGeneratedPrograms.find(CalculateHash(varsBegin, varsEnd));
+	if(it != mGeneratedPrograms.end())
+		return it->second;
+	return nullptr;
+}
+
 template<class Iterator>
 Hash ProgramProvider::CalculateHash(Iterator begin, Iterator end)
 {
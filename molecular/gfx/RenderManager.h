@@ -35,6 +35,7 @@ SOFTWARE.
 #include <molecular/programgenerator/ProgramGenerator.h>
 #include <molecular/gfx/ProgramProvider.h>
 #include <molecular/gfx/MeshLoader.h>
+#include <molecular/gfx/MeshPrefetcher.h>
 #include <molecular/gfx/MaterialManager.h>
 #include <molecular/util/ThreadSafeQueue.h>
 #include <molecular/programgenerator/ProgramFile.h>
@@ -86,11 +87,20 @@ public:
 	FileServer& GetFileServer() {return mFileServer;}
 	TextureManager& GetTextureManager() {return mTextureManager;}
 	MeshManager& GetMeshManager() {return mMeshManager;}
+
+	/// Loads meshes from the mesh bounds file ahead of need
+	/** Update() has to be called by the application with the camera. */
+	MeshPrefetcher& GetMeshPrefetcher() {return mMeshPrefetcher;}
 	programgenerator::ProgramGenerator& GetProgramGenerator() {return mProgramGenerator;}
 	ProgramProvider& GetProgramProvider() {return mProgramProvider;}
 	MaterialManager& GetMaterialManager() {return mMaterialManager;}
 
 	void SetMeshBoundsFileData(Blob&& fileData);
+
+	/// Use mesh bounds owned by someone else, e.g. from FileServer::MapFile()
+	/** Data must stay valid while this object is in use. */
+	void SetMeshBoundsFileData(const void* fileData);
+
 	const util::AxisAlignedBox& GetMeshFileBounds(Hash meshFile);
 
 private:
@@ -108,12 +118,14 @@ private:
 
 	MeshLoader<Self> mMeshLoader;
 	MeshManager mMeshManager;
+	MeshPrefetcher mMeshPrefetcher;
 	MaterialManager mMaterialManager;
 
 	programgenerator::ProgramGenerator mProgramGenerator;
 	ProgramProvider mProgramProvider;
 
 	Blob mMeshBoundsCollectionFileData;
+	const MeshBoundsCollectionFile* mMeshBoundsCollectionFile = nullptr;
 };
 
 template<class TFileServer, class TTaskQueue>
@@ -127,6 +139,7 @@ RenderManagerT<TFileServer, TTaskQueue>::RenderManagerT(RenderContext& context,
 	mTextureManager(mTextureLoader),
 	mMeshLoader(*this),
 	mMeshManager(mMeshLoader),
+	mMeshPrefetcher(mMeshManager),
 	mMaterialManager(*this),
 	mProgramProvider(mRenderer, mProgramGenerator)
 {
@@ -138,6 +151,7 @@ template<class TFileServer, class TTaskQueue>
 void RenderManagerT<TFileServer, TTaskQueue>::DrawOneFrame(RenderFunction& function, Scope& rootScope)
 {
 	mTextureManager.Update(mFramecounter);
+	mMeshManager.Update(mFramecounter);
 	// Execute one task from the render thread queue
 	mGlTaskQueue.RunOneTask();
 	mFramecounter++;
@@ -182,13 +196,23 @@ template<class TFileServer, class TTaskQueue>
 void RenderManagerT<TFileServer, TTaskQueue>::SetMeshBoundsFileData(Blob&& fileData)
 {
 	mMeshBoundsCollectionFileData = std::move(fileData);
+	mMeshBoundsCollectionFile = static_cast<const MeshBoundsCollectionFile*>(mMeshBoundsCollectionFileData.GetData());
+	mMeshPrefetcher.SetMeshBounds(mMeshBoundsCollectionFile);
+}
+
+template<class TFileServer, class TTaskQueue>
+void RenderManagerT<TFileServer, TTaskQueue>::SetMeshBoundsFileData(const void* fileData)
+{
+	mMeshBoundsCollectionFileData = Blob();
+	mMeshBoundsCollectionFile = static_cast<const MeshBoundsCollectionFile*>(fileData);
+	mMeshPrefetcher.SetMeshBounds(mMeshBoundsCollectionFile);
 }
 
 template<class TFileServer, class TTaskQueue>
 const util::AxisAlignedBox& RenderManagerT<TFileServer, TTaskQueue>::GetMeshFileBounds(Hash meshFile)
 {
-	if(mMeshBoundsCollectionFileData.GetData())
-		return static_cast<const MeshBoundsCollectionFile*>(mMeshBoundsCollectionFileData.GetData())->GetBounds(meshFile);
+	if(mMeshBoundsCollectionFile)
+		return mMeshBoundsCollectionFile->GetBounds(meshFile);
 	else
 		return util::AxisAlignedBox::kDefault;
 }
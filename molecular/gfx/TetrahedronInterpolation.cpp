@@ -41,21 +41,28 @@ const Matrix<3, 9> TetrahedronInterpolation::kZeros = Matrix<3, 9>::Zeros();
 
 void TetrahedronInterpolation::SetFileData(Blob&& fileData)
 {
+	SetFileData(fileData.GetData());
 	mFileData = std::move(fileData);
-	assert(mFileData.GetData());
-	const TetrahedronSpaceFile* file = static_cast<const TetrahedronSpaceFile*>(mFileData.GetData());
+}
+
+void TetrahedronInterpolation::SetFileData(const void* fileData)
+{
+	assert(fileData);
+	const TetrahedronSpaceFile* file = static_cast<const TetrahedronSpaceFile*>(fileData);
 	if(file->magic != TetrahedronSpaceFile::kMagic)
 		throw std::runtime_error("Not a tetrahedron space file");
 	if(file->version != TetrahedronSpaceFile::kVersion)
 		throw std::runtime_error("Wrong tetrahedron space file version");
+	mFileData = Blob();
+	mFile = file;
 }
 
 Matrix<3, 9> TetrahedronInterpolation::GetShCoefficients(const Vector3& position, int& tetIndex) const
 {
-	if(!mFileData.GetData())
+	if(!mFile)
 		return kZeros;
 	Vector4 weights = GetLightProbeInterpolationWeights(position, tetIndex);
-	const TetrahedronSpaceFile* file = static_cast<const TetrahedronSpaceFile*>(mFileData.GetData());
+	const TetrahedronSpaceFile* file = mFile;
 	if (tetIndex < 0 || static_cast<uint32_t>(tetIndex) >= file->numTetrahedrons)
 		return kZeros;
 	auto& tet = file->tetrahedra[tetIndex];
@@ -70,7 +77,7 @@ Matrix<3, 9> TetrahedronInterpolation::GetShCoefficients(const Vector3& position
 
 void TetrahedronInterpolation::GetTetrahedronCorners(int tetIndex, Vector3 outCorners[4], bool& outIsOuterCell) const
 {
-	if(!mFileData.GetData())
+	if(!mFile)
 	{
 		for(int i = 0; i < 4; i++)
 			outCorners[i] = Vector3(0, 0, 0);
@@ -78,7 +85,7 @@ void TetrahedronInterpolation::GetTetrahedronCorners(int tetIndex, Vector3 outCo
 		return;
 	}
 
-	const TetrahedronSpaceFile* file = static_cast<const TetrahedronSpaceFile*>(mFileData.GetData());
+	const TetrahedronSpaceFile* file = mFile;
 	if(tetIndex >= 0 && tetIndex < static_cast<int>(file->numTetrahedrons))
 	{
 		auto& tet = file->tetrahedra[tetIndex];
@@ -98,18 +105,18 @@ void TetrahedronInterpolation::GetTetrahedronCorners(int tetIndex, Vector3 outCo
 
 Vector4 TetrahedronInterpolation::GetCornerWeights(int tetIndex, const Vector3& position) const
 {
-	if(!mFileData.GetData())
+	if(!mFile)
 		return Vector4(0, 0, 0, 0);
 
-	const TetrahedronSpaceFile* file = static_cast<const TetrahedronSpaceFile*>(mFileData.GetData());
+	const TetrahedronSpaceFile* file = mFile;
 	const TetrahedronSpaceFile::Tetrahedron& tet = file->tetrahedra[tetIndex];
 	return GetBarycentricCoordinates(position, tet);
 }
 
 Vector4 TetrahedronInterpolation::GetLightProbeInterpolationWeights(const Vector3& position, int& tetIndex) const
 {
-	assert(mFileData.GetData());
-	const TetrahedronSpaceFile* file = static_cast<const TetrahedronSpaceFile*>(mFileData.GetData());
+	assert(mFile);
+	const TetrahedronSpaceFile* file = mFile;
 
 	// If we don't have an initial guess, always start from tetrahedron 0.
 	// Tetrahedron 0 is picked to be roughly in the center of the probe cloud,
@@ -144,7 +151,7 @@ Vector4 TetrahedronInterpolation::GetLightProbeInterpolationWeights(const Vector
 
 Vector4 TetrahedronInterpolation::GetBarycentricCoordinates(const Vector3& p, const TetrahedronSpaceFile::Tetrahedron& tet) const
 {
-	const TetrahedronSpaceFile* file = static_cast<const TetrahedronSpaceFile*>(mFileData.GetData());
+	const TetrahedronSpaceFile* file = mFile;
 	auto vertices = file->GetVertices();
 	if(tet.vertices[3] >= 0)
 	{
@@ -42,6 +42,10 @@ class TetrahedronInterpolation
 public:
 	void SetFileData(util::Blob&& fileData);
 
+	/// Use file data owned by someone else, e.g. from FileServer::MapFile()
+	/** Data must stay valid while this object is in use. */
+	void SetFileData(const void* fileData);
+
 	util::Matrix<3, 9> GetShCoefficients(const Vector3& position, int& tetIndex) const;
 
 	/** For debugging. */
@@ -54,6 +58,7 @@ private:
 	Vector4 GetBarycentricCoordinates(const Vector3& p, const TetrahedronSpaceFile::Tetrahedron& tet) const;
 
 	util::Blob mFileData;
+	const TetrahedronSpaceFile* mFile = nullptr;
 	static const util::Matrix<3, 9> kZeros;
 };
 
@@ -33,11 +33,17 @@ SOFTWARE.
 #include <molecular/util/Blob.h>
 #include <molecular/util/TaskDispatcher.h>
 #include <molecular/util/DdsFile.h>
-#include <molecular/util/TgaFile.h>
+#include <molecular/util/TextureDecoding.h>
+#include <molecular/util/TextureFileLayout.h>
 #include <molecular/util/StringUtils.h>
 #include <molecular/util/KtxFile.h>
 #include <molecular/util/FileTypeIdentification.h>
 
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #ifdef min
 #undef min
 #endif
@@ -62,22 +68,77 @@ public:
 	RenderCmdSink::Texture* Create() override;
 	void Destroy(RenderCmdSink::Texture*& asset) override;
 
-	/** @param asset Object to get the texture location from and load texture data to. */
+	/** DDS and KTX files supported by TextureFileLayout are streamed: Only
+		the requested mip levels are read, with range reads if the file is
+		not memory-mapped. Other files are loaded completely. TGA files are
+		decoded in the TaskQueue of the RenderManager, which leaves only the
+		upload for the GL task queue.
+		@param asset Object to get the texture location from and load texture data to. */
 	void StartLoad(TextureManager::Asset& asset, unsigned int minLevel, unsigned int maxLevel) override;
 
+	/// Release mip levels
+	/** Sampling starts at the next smaller level afterwards. Called by
+		TextureManager::Update() for the largest loaded levels. */
 	void Unload(RenderCmdSink::Texture*& asset, unsigned int minLevel, unsigned int maxLevel) override;
 
 private:
+	/// Loading state of one texture file
+	struct Stream
+	{
+		std::shared_ptr<const TextureFileLayout> layout;
+
+		/// Level ranges requested while the header is being read
+		std::vector<std::pair<unsigned int, unsigned int>> pendingLevels;
+
+		/// File has to be loaded completely
+		bool streamable = true;
+
+		/// Whole file is being loaded, which covers all levels
+		bool loadingWholeFile = false;
+	};
+
 	RenderManager& mRenderManager;
 
-	static void StoreTexture(TextureManager::Asset& target, Blob& blob, unsigned int minLevel, unsigned int maxLevel);
+	/// Only accessed in the render thread
+	std::unordered_map<Hash, Stream> mStreams;
+
+	/// Parse header and load the levels requested so far
+	void HandleHeader(TextureManager::Asset& target, const void* data, size_t size);
+
+	/// Read levels and enqueue upload in the GL task queue
+	/** Marks the levels failed if the read cannot be started. */
+	void LoadLevels(TextureManager::Asset& target, const std::shared_ptr<const TextureFileLayout>& layout, unsigned int minLevel, unsigned int maxLevel);
+
+	/// Load all levels of files that cannot be streamed
+	/** Marks all loading levels failed if the read cannot be started. */
+	void LoadWholeFile(TextureManager::Asset& target);
+
+	/// Mark levels not in the file as loaded after loading the whole file
+	void FinishWholeFile(TextureManager::Asset& target);
+
+	/// Upload consecutive levels
+	/** @param data Contents of the file starting at level firstLevel. */
+	static void StoreLevels(TextureManager::Asset& target, const TextureFileLayout& layout, unsigned int firstLevel, unsigned int lastLevel, const void* data, size_t size);
+
+	/// Sample from the largest loaded level
+	static void UpdateBaseLevel(TextureManager::Asset& target);
+
+	/// Upload DDS or KTX file
+	/** TGA files are rejected, DecodeTgaTexture() decodes them outside the
+		GL thread.
+		@param data File contents from a Blob or a memory-mapped package file. */
+	static void StoreTexture(TextureManager::Asset& target, const void* data, size_t size, unsigned int minLevel, unsigned int maxLevel);
 
-	static void StoreTgaTexture(TextureManager::Asset& target, Blob& blob, unsigned int minLevel, unsigned int maxLevel);
+	/// Decode TGA in the calling thread and enqueue upload in the GL task queue
+	void DecodeTgaTexture(TextureManager::Asset& target, const void* data, size_t size);
 
-	static void StoreKtxTexture(TextureManager::Asset& target, Blob& blob, unsigned int minLevel, unsigned int maxLevel);
+	/// Upload all levels, generate missing mip levels on the GPU
+	static void StoreDecodedTexture(TextureManager::Asset& target, const DecodedTexture& texture);
+
+	static void StoreKtxTexture(TextureManager::Asset& target, const void* data, size_t size, unsigned int minLevel, unsigned int maxLevel);
 
 	/// Stores loaded DDS texture into video memory
-	static void StoreDdsTexture(TextureManager::Asset& target, Blob& blob, unsigned int minLevel, unsigned int maxLevel);
+	static void StoreDdsTexture(TextureManager::Asset& target, const void* data, size_t size, unsigned int minLevel, unsigned int maxLevel);
 };
 
 /*****************************************************************************/
@@ -103,41 +164,259 @@ void TextureLoader<TRenderManager>::StartLoad(TextureManager::Asset& asset, unsi
 		maxLevel = 9999;
 	}
 
-	Hash file = asset.GetLocation();
-
+	const Hash file = asset.GetLocation();
 	try
 	{
-		auto store = std::bind(StoreTexture, std::ref(asset), std::placeholders::_1, minLevel, maxLevel);
-		mRenderManager.GetFileServer().ReadFile(file, store, mRenderManager.GetGlTaskQueue());
+		Stream& stream = mStreams[file];
+		if(stream.loadingWholeFile)
+			return; // Covers the requested levels
+		if(!stream.streamable)
+		{
+			LoadWholeFile(asset);
+			return;
+		}
+		if(stream.layout)
+		{
+			LoadLevels(asset, stream.layout, minLevel, maxLevel);
+			return;
+		}
+
+		stream.pendingLevels.emplace_back(minLevel, maxLevel);
+		if(stream.pendingLevels.size() > 1)
+			return; // Header is already being read
+
+		TextureManager::Asset* target = &asset;
+		size_t size = 0;
+		if(const void* data = mRenderManager.GetFileServer().MapFile(file, size))
+			HandleHeader(asset, data, size);
+		else if(mRenderManager.GetFileServer().GetFileSize(file, size) && size > 0)
+		{
+			auto handleHeader = [this, target](Blob& blob){HandleHeader(*target, blob.GetData(), blob.GetSize());};
+			const size_t headerSize = std::min(size, TextureFileLayout::kMaxHeaderSize);
+			mRenderManager.GetFileServer().ReadFileRange(file, 0, headerSize, handleHeader, mRenderManager.GetGlTaskQueue());
+		}
+		else
+			LoadWholeFile(asset);
 	}
 	catch(std::exception& e)
 	{
 		LOG(ERROR) << "Error loading " << file << ": " << e.what();
-		asset.SetState(0, TextureManager::Asset::kFailed); // TODO: Set all levels
+		mStreams.erase(file);
+		for(unsigned int i = minLevel; i <= std::min(maxLevel, kLodLevels - 1); ++i)
+			asset.SetState(i, TextureManager::Asset::kFailed);
 	}
 }
 
 template<class TRenderManager>
-void TextureLoader<TRenderManager>::Unload(RenderCmdSink::Texture*& /*asset*/, unsigned int /*minLevel*/, unsigned int /*maxLevel*/)
+void TextureLoader<TRenderManager>::Unload(RenderCmdSink::Texture*& asset, unsigned int minLevel, unsigned int maxLevel)
 {
-	// TODO
+	asset->SetParameter(RenderCmdSink::Texture::kBaseLevel, int(maxLevel + 1));
+	for(unsigned int i = minLevel; i <= maxLevel; ++i)
+		asset->ReleaseLevel(int(i));
 }
 
 template<class TRenderManager>
-void TextureLoader<TRenderManager>::StoreTexture(TextureManager::Asset& target, Blob& blob, unsigned int minLevel, unsigned int maxLevel)
+void TextureLoader<TRenderManager>::HandleHeader(TextureManager::Asset& target, const void* data, size_t size)
+{
+	Stream& stream = mStreams[target.GetLocation()];
+	try
+	{
+		auto layout = std::make_shared<TextureFileLayout>();
+		if(!TextureFileLayout::FromHeader(data, size, *layout) || layout->levels.empty()
+				|| PixelFormatConversion::ToPixelFormat(0, 0, layout->glInternalFormat) == PF_NONE)
+		{
+			LoadWholeFile(target);
+			return;
+		}
+
+		stream.layout = layout;
+		for(auto& levels: stream.pendingLevels)
+			LoadLevels(target, stream.layout, levels.first, levels.second);
+		stream.pendingLevels.clear();
+	}
+	catch(std::exception& e)
+	{
+		LOG(ERROR) << "Error loading " << target.GetLocation() << ": " << e.what();
+		for(auto& levels: stream.pendingLevels)
+		{
+			for(unsigned int i = levels.first; i <= std::min(levels.second, kLodLevels - 1); ++i)
+				target.SetState(i, TextureManager::Asset::kFailed);
+		}
+		stream.pendingLevels.clear();
+	}
+}
+
+template<class TRenderManager>
+void TextureLoader<TRenderManager>::LoadLevels(TextureManager::Asset& target, const std::shared_ptr<const TextureFileLayout>& layout, unsigned int minLevel, unsigned int maxLevel)
+{
+	const unsigned int levelCount = static_cast<unsigned int>(layout->levels.size());
+	const unsigned int lastLevel = std::min(maxLevel, levelCount - 1);
+
+	// Levels the file does not have count as loaded:
+	for(unsigned int i = std::max(minLevel, levelCount); i <= std::min(maxLevel, kLodLevels - 1); ++i)
+		target.SetState(i, TextureManager::Asset::kLoaded);
+
+	if(minLevel >= levelCount)
+	{
+		// Load smallest level instead, so there is something to draw:
+		minLevel = levelCount - 1;
+		if(target.GetState(minLevel) != TextureManager::Asset::kNotLoaded)
+			return;
+		target.SetState(minLevel, TextureManager::Asset::kLoading);
+	}
+
+	const Hash file = target.GetLocation();
+	try
+	{
+		const size_t offset = layout->GetRangeOffset(minLevel);
+		const size_t size = layout->GetRangeSize(minLevel, lastLevel);
+		TextureManager::Asset* asset = &target;
+		size_t fileSize = 0;
+		if(const void* data = mRenderManager.GetFileServer().MapFile(file, fileSize))
+		{
+			if(offset + size > fileSize)
+				throw std::runtime_error("Texture file is truncated");
+			const uint8_t* levelData = static_cast<const uint8_t*>(data) + offset;
+			mRenderManager.GetGlTaskQueue().EnqueueTask([=](){StoreLevels(*asset, *layout, minLevel, lastLevel, levelData, size);});
+		}
+		else
+		{
+			auto store = [=](Blob& blob){StoreLevels(*asset, *layout, minLevel, lastLevel, blob.GetData(), blob.GetSize());};
+			mRenderManager.GetFileServer().ReadFileRange(file, offset, size, store, mRenderManager.GetGlTaskQueue());
+		}
+	}
+	catch(std::exception& e)
+	{
+		LOG(ERROR) << "Error reading " << file << ": " << e.what();
+		for(unsigned int i = minLevel; i <= std::min(lastLevel, kLodLevels - 1); ++i)
+			target.SetState(i, TextureManager::Asset::kFailed);
+	}
+}
+
+template<class TRenderManager>
+void TextureLoader<TRenderManager>::LoadWholeFile(TextureManager::Asset& target)
+{
+	const Hash file = target.GetLocation();
+	Stream& stream = mStreams[file];
+	stream.pendingLevels.clear();
+	stream.streamable = false;
+	stream.loadingWholeFile = true;
+
+	TextureManager::Asset* asset = &target;
+	try
+	{
+		size_t size = 0;
+		if(const void* data = mRenderManager.GetFileServer().MapFile(file, size))
+		{
+			// Parse in place, no copy:
+			if(FileTypeIdentification::IsTga(data, size))
+				mRenderManager.GetTaskQueue().EnqueueTask([=](){DecodeTgaTexture(*asset, data, size);});
+			else
+				mRenderManager.GetGlTaskQueue().EnqueueTask([=](){StoreTexture(*asset, data, size, 0, 9999); FinishWholeFile(*asset);});
+		}
+		else
+		{
+			auto store = [this, asset](Blob& blob)
+			{
+				if(FileTypeIdentification::IsTga(blob.GetData(), blob.GetSize()))
+					DecodeTgaTexture(*asset, blob.GetData(), blob.GetSize());
+				else
+				{
+					// Hand over to the GL thread without copying:
+					std::shared_ptr<Blob> contents = std::make_shared<Blob>(std::move(blob));
+					mRenderManager.GetGlTaskQueue().EnqueueTask([=](){StoreTexture(*asset, contents->GetData(), contents->GetSize(), 0, 9999); FinishWholeFile(*asset);});
+				}
+			};
+			mRenderManager.GetFileServer().ReadFile(file, store, mRenderManager.GetTaskQueue());
+		}
+	}
+	catch(std::exception& e)
+	{
+		// Pending levels were cleared above, so fail everything still loading:
+		LOG(ERROR) << "Error reading " << file << ": " << e.what();
+		for(unsigned int i = 0; i < +kLodLevels; ++i)
+		{
+			if(target.GetState(i) == TextureManager::Asset::kLoading)
+				target.SetState(i, TextureManager::Asset::kFailed);
+		}
+		stream.loadingWholeFile = false;
+	}
+}
+
+template<class TRenderManager>
+void TextureLoader<TRenderManager>::FinishWholeFile(TextureManager::Asset& target)
+{
+	mStreams[target.GetLocation()].loadingWholeFile = false;
+	for(unsigned int i = 0; i < +kLodLevels; ++i)
+	{
+		if(target.GetState(i) == TextureManager::Asset::kLoading)
+			target.SetState(i, TextureManager::Asset::kLoaded);
+	}
+}
+
+template<class TRenderManager>
+void TextureLoader<TRenderManager>::StoreLevels(TextureManager::Asset& target, const TextureFileLayout& layout, unsigned int firstLevel, unsigned int lastLevel, const void* data, size_t size)
+{
+	try
+	{
+		if(size < layout.GetRangeSize(firstLevel, lastLevel))
+			throw std::runtime_error("Texture level data is incomplete");
+
+		const PixelFormat format = PixelFormatConversion::ToPixelFormat(0, 0, layout.glInternalFormat);
+		const uint8_t* levelData = static_cast<const uint8_t*>(data) - layout.GetRangeOffset(firstLevel);
+		for(unsigned int i = firstLevel; i <= lastLevel; ++i)
+		{
+			// Skip levels cancelled while loading, smaller ones are still wanted:
+			if(i < +kLodLevels && !target.IsWanted(i))
+			{
+				target.SetState(i, TextureManager::Asset::kNotLoaded);
+				continue;
+			}
+
+			const TextureFileLayout::Level& level = layout.levels[i];
+			target.GetAsset()->Store(level.width, level.height, levelData + level.offset, format, int(i), level.size);
+			if(i < +kLodLevels)
+			{
+				target.SetState(i, TextureManager::Asset::kLoaded);
+				target.SetSize(i, level.size);
+			}
+		}
+		UpdateBaseLevel(target);
+	}
+	catch(std::exception& e)
+	{
+		LOG(ERROR) << "Error storing texture " << target.GetLocation() << ": " << e.what();
+		for(unsigned int i = firstLevel; i <= std::min(lastLevel, kLodLevels - 1); ++i)
+			target.SetState(i, TextureManager::Asset::kFailed);
+	}
+}
+
+template<class TRenderManager>
+void TextureLoader<TRenderManager>::UpdateBaseLevel(TextureManager::Asset& target)
+{
+	for(unsigned int i = 0; i < +kLodLevels; ++i)
+	{
+		if(target.GetState(i) == TextureManager::Asset::kLoaded)
+		{
+			target.GetAsset()->SetParameter(RenderCmdSink::Texture::kBaseLevel, int(i));
+			return;
+		}
+	}
+}
+
+template<class TRenderManager>
+void TextureLoader<TRenderManager>::StoreTexture(TextureManager::Asset& target, const void* data, size_t size, unsigned int minLevel, unsigned int maxLevel)
 {
 	try
 	{
-		auto data = blob.GetData();
-		auto size = blob.GetSize();
 		if(!data)
 			throw std::runtime_error("No texture data to store");
 		else if(FileTypeIdentification::IsDds(data, size))
-			StoreDdsTexture(target, blob, minLevel, maxLevel);
+			StoreDdsTexture(target, data, size, minLevel, maxLevel);
 		else if(FileTypeIdentification::IsKtx(data, size))
-			StoreKtxTexture(target, blob, minLevel, maxLevel);
+			StoreKtxTexture(target, data, size, minLevel, maxLevel);
 		else if(FileTypeIdentification::IsTga(data, size))
-			StoreTgaTexture(target, blob, minLevel, maxLevel);
+			throw std::runtime_error("TGA textures must be decoded with DecodeTgaTexture");
 		else
 			throw std::runtime_error("Unknown file type");
 	}
@@ -150,33 +429,47 @@ void TextureLoader<TRenderManager>::StoreTexture(TextureManager::Asset& target,
 }
 
 template<class TRenderManager>
-void TextureLoader<TRenderManager>::StoreTgaTexture(TextureManager::Asset& target, Blob& blob, unsigned int /*minLevel*/, unsigned int /*maxLevel*/)
+void TextureLoader<TRenderManager>::DecodeTgaTexture(TextureManager::Asset& target, const void* data, size_t size)
+{
+	TextureManager::Asset* asset = &target;
+	try
+	{
+		std::shared_ptr<DecodedTexture> texture = std::make_shared<DecodedTexture>(TextureDecoding::DecodeTga(data, size));
+		mRenderManager.GetGlTaskQueue().EnqueueTask([this, asset, texture](){StoreDecodedTexture(*asset, *texture); FinishWholeFile(*asset);});
+	}
+	catch(std::exception& e)
+	{
+		LOG(ERROR) << e.what();
+		mRenderManager.GetGlTaskQueue().EnqueueTask([this, asset]()
+		{
+			for(unsigned int i = 0; i < +kLodLevels; ++i)
+				asset->SetState(i, TextureManager::Asset::kFailed);
+			FinishWholeFile(*asset);
+		});
+	}
+}
+
+template<class TRenderManager>
+void TextureLoader<TRenderManager>::StoreDecodedTexture(TextureManager::Asset& target, const DecodedTexture& texture)
 {
-	TgaFile2 file(blob.GetData(), blob.GetSize());
-	const uint8_t* imageData = static_cast<const uint8_t*>(file.GetImageData());
-	std::vector<uint8_t> rotatedData;
-	if(file.IsUpsideDown())
+	for(size_t i = 0; i < texture.levels.size(); ++i)
 	{
-		rotatedData.resize(file.GetImageSize());
-		// TODO: Do in separate task
-		const uint8_t* inputData = static_cast<const uint8_t*>(file.GetImageData());
-		// Read image bottom-up
-		size_t lineSize = file.GetWidth() * file.GetBytesPerPixel();
-		unsigned int height = file.GetHeight();
-		for(size_t line = 0; line < height; ++line)
-			memcpy(rotatedData.data() + (height - line - 1) * lineSize, inputData + line * lineSize, lineSize);
-		imageData = rotatedData.data();
+		const DecodedTexture::Level& level = texture.levels[i];
+		target.GetAsset()->Store(level.width, level.height, texture.GetLevelData(i), texture.format, int(i), level.size);
+		if(i < +kLodLevels)
+			target.SetSize(unsigned(i), level.size);
 	}
-	target.GetAsset()->Store(file.GetWidth(), file.GetHeight(), imageData, file.GetFormat());
-	target.GetAsset()->GenerateMipmaps();
+	if(texture.levels.size() == 1)
+		target.GetAsset()->GenerateMipmaps();
 	for(unsigned int i = 0; i < +kLodLevels; ++i)
 		target.SetState(i, TextureManager::Asset::kLoaded);
+	UpdateBaseLevel(target);
 }
 
 template<class TRenderManager>
-void TextureLoader<TRenderManager>::StoreKtxTexture(TextureManager::Asset& target, Blob& blob, unsigned int minLevel, unsigned int maxLevel)
+void TextureLoader<TRenderManager>::StoreKtxTexture(TextureManager::Asset& target, const void* data, size_t size, unsigned int minLevel, unsigned int maxLevel)
 {
-	KtxFile ktxFile(blob.GetData(), blob.GetSize());
+	KtxFile ktxFile(data, size);
 	unsigned int width = ktxFile.GetPixelWidth();
 	unsigned int height = ktxFile.GetPixelHeight();
 	auto glType = ktxFile.GetGlType();
@@ -189,26 +482,34 @@ void TextureLoader<TRenderManager>::StoreKtxTexture(TextureManager::Asset& targe
 		auto mipLevel = ktxFile.GetImageData(i);
 		target.GetAsset()->Store(width, height, mipLevel.first, format, i, mipLevel.second);
 		if(i < +kLodLevels)
+		{
 			target.SetState(i, TextureManager::Asset::kLoaded);
+			target.SetSize(i, mipLevel.second);
+		}
 		width /= 2;
 		height /= 2;
 	}
+	UpdateBaseLevel(target);
 }
 
 template<class TRenderManager>
-void TextureLoader<TRenderManager>::StoreDdsTexture(TextureManager::Asset& target, Blob& blob, unsigned int minLevel, unsigned int maxLevel)
+void TextureLoader<TRenderManager>::StoreDdsTexture(TextureManager::Asset& target, const void* data, size_t size, unsigned int minLevel, unsigned int maxLevel)
 {
-	util::DdsFile file(blob.GetData(), blob.GetSize());
+	util::DdsFile file(data, size);
 	unsigned int levelsToLoad = std::min(maxLevel + 1, file.GetNumMipmapLevels());
 	for(unsigned int i = minLevel; i < levelsToLoad; ++i)
 	{
 		unsigned int width = 0, height = 0;
-		size_t size = 0;
-		const void* pointer = file.GetSingleImage(0, i, width, height, size);
-		target.GetAsset()->Store(width, height, pointer, file.GetFormat(), i, size);
+		size_t imageSize = 0;
+		const void* pointer = file.GetSingleImage(0, i, width, height, imageSize);
+		target.GetAsset()->Store(width, height, pointer, file.GetFormat(), i, imageSize);
 		if(i < +kLodLevels)
+		{
 			target.SetState(i, TextureManager::Asset::kLoaded);
+			target.SetSize(i, imageSize);
+		}
 	}
+	UpdateBaseLevel(target);
 }
 
 }
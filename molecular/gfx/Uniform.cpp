@@ -25,6 +25,7 @@ SOFTWARE.
 
 #include "Uniform.h"
 
+#include <algorithm>
 #include <assert.h>
 
 namespace molecular
@@ -43,11 +44,12 @@ TextureUniform::TextureUniform(Hash textureName, TextureManager& textureManager)
 
 }
 
-void TextureUniform::Apply(GlCommandSink::Program* program, Hash name) const
+void TextureUniform::Apply(GlCommandSink::Program* program, Hash name, float screenFootprint) const
 {
 	assert(program);
 	assert(mAsset);
-	auto texture = mAsset->Use();
+	const float priority = screenFootprint > 0.0f ? screenFootprint : +TextureManager::kDefaultPriority;
+	auto texture = mAsset->Use(GetLodLevel(screenFootprint), priority);
 	program->SetUniform(name, &texture);
 }
 
@@ -56,6 +58,26 @@ void TextureUniform::SetParameter(GlCommandSink::Texture::Parameter param, GlCom
 	mAsset->GetAsset()->SetParameter(param, value);
 }
 
+unsigned int TextureUniform::GetLodLevel(float screenFootprint) const
+{
+	if(screenFootprint <= 0.0f)
+		return 0;
+
+	const unsigned int smallestLevel = TextureManager::kLodLevels - 1;
+	const RenderCmdSink::Texture* texture = mAsset->GetAsset();
+	unsigned int extent = std::max(texture->GetWidth(), texture->GetHeight());
+	if(extent == 0)
+		return smallestLevel; // Size is known when the first level is loaded
+
+	unsigned int level = 0;
+	while(level < smallestLevel && extent / 2 >= screenFootprint)
+	{
+		extent /= 2;
+		++level;
+	}
+	return level;
+}
+
 Attribute::Attribute() :
 	mComponents(0),
 	mOffset(0),
@@ -84,7 +106,7 @@ Attribute::Attribute(RenderCmdSink::VertexBuffer* buffer, int components, Vertex
 
 }
 
-void Attribute::Apply(RenderCmdSink::Program* program, Hash name) const
+void Attribute::Apply(RenderCmdSink::Program* program, Hash name, float /*screenFootprint*/) const
 {
 //	std::cerr << "program->SetAttribute(..., " << mComponents << ", " << mType << ", " << mStride << ", " << mOffset <<")" << std::endl;
 	assert(program);
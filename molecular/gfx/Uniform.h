@@ -44,7 +44,9 @@ public:
 	virtual ~Variable();
 
 	/// Feed to program
-	virtual void Apply(RenderCmdSink::Program* program, Hash name) const = 0;
+	/** @param screenFootprint Size on screen of what is drawn, in pixels. 0
+			means unknown. */
+	virtual void Apply(RenderCmdSink::Program* program, Hash name, float screenFootprint) const = 0;
 
 	virtual unsigned int GetArraySize() const {return 0;}
 };
@@ -61,7 +63,7 @@ public:
 		mValues[0] = value;
 	}
 
-	void Apply(RenderCmdSink::Program* program, Hash name) const override
+	void Apply(RenderCmdSink::Program* program, Hash name, float /*screenFootprint*/) const override
 	{
 		assert(program);
 		program->SetUniform(name, mValues, arraySize);
@@ -92,11 +94,17 @@ public:
 	TextureUniform() = default;
 	explicit TextureUniform(Hash textureName, TextureManager& textureManager);
 
-	void Apply(RenderCmdSink::Program* program, Hash name) const override;
+	/** Requests the mip levels needed for the screen footprint from the
+		TextureManager, prioritized by that footprint. An unknown footprint
+		requests full resolution. */
+	void Apply(RenderCmdSink::Program* program, Hash name, float screenFootprint) const override;
 
 	void SetParameter(GlCommandSink::Texture::Parameter param, GlCommandSink::Texture::ParamValue value);
 
 private:
+	/// Smallest level that still has at least one texel per pixel
+	unsigned int GetLodLevel(float screenFootprint) const;
+
 	TextureManager::Asset* mAsset = nullptr;
 };
 
@@ -114,7 +122,7 @@ public:
 	/// Construct from buffer and individual infos
 	Attribute(RenderCmdSink::VertexBuffer* buffer, int components, VertexAttributeInfo::Type type = VertexAttributeInfo::kFloat, int stride = 0, int offset = 0);
 
-	void Apply(RenderCmdSink::Program* program, Hash name) const override;
+	void Apply(RenderCmdSink::Program* program, Hash name, float screenFootprint) const override;
 
 private:
 	RenderCmdSink::VertexBuffer* mBuffer;
@@ -137,7 +145,7 @@ class Output : public Variable
 {
 public:
 	/** This is never called. */
-	void Apply(RenderCmdSink::Program* /*program*/, Hash /*name*/) const override {}
+	void Apply(RenderCmdSink::Program* /*program*/, Hash /*name*/, float /*screenFootprint*/) const override {}
 };
 
 }
@@ -30,13 +30,19 @@ SOFTWARE.
 #include <molecular/gfx/MeshManager.h>
 #include "DrawMeshData.h"
 
+#include <limits>
+#include <string>
+#include <vector>
+
 namespace molecular
 {
 namespace gfx
 {
 
 /// Draws a mesh by specifying a mesh filename
-/** Meshes (in the form of DrawMeshData objects) are loaded on demand. */
+/** Meshes (in the form of DrawMeshData objects) are loaded on demand. The
+	level of detail is selected by the size on screen, see MeshLods. Until
+	the selected level is loaded, the nearest loaded level is drawn. */
 template<class TRenderManager>
 class DrawMesh : public RenderFunction
 {
@@ -47,16 +53,34 @@ public:
 		RenderFunction(renderManager),
 		mRenderManager(renderManager)
 	{
-
+		SetPickingId(0);
 	}
 
 	util::AxisAlignedBox GetBounds() const override {return mBounds;}
 	bool BoundsChangedSince(int framecounter) const override {return mLastBoundsChange > framecounter;}
 
 	void SetMeshFile(Hash mesh);
-	void AddMorphTarget(const std::string& targetFile, float weight = 1.0);
+
+	/// Add morph target blended onto the mesh
+	/** Targets are mesh files with the same vertices in the same order as the
+		base mesh. molecular-meshcook keeps the order of equal topologies
+		with --overdraw 0 and --cluster-size 0, so cook base and targets like
+		that. Other targets are ignored. The base mesh and the deltas to all
+		targets are loaded once per set of targets, see MeshLoader. */
+	void AddMorphTarget(Hash targetFile, float weight = 1.0f);
+
+	/// Add morph target by file name
+	void AddMorphTarget(const std::string& targetFile, float weight = 1.0f) {AddMorphTarget(HashUtils::MakeHash(targetFile), weight);}
+
+	/// Change weight of a morph target without reloading
+	/** @param index In order of AddMorphTarget() calls. */
+	void SetMorphTargetWeight(unsigned int index, float weight) {mMorphWeights.at(index) = weight;}
+
 	void ClearMorphTargets();
-	void SetPickingId(unsigned int id) {mPickingId = id;}
+	void SetPickingId(unsigned int id) {SetUniform("pickingColor"_H, id);}
+
+	/// Largest simplification error in pixels to accept for a coarser level
+	void SetLodError(float pixels) {mLodError = pixels;}
 
 protected:
 	void HandleExecute(Scope& scope) override;
@@ -64,11 +88,19 @@ protected:
 private:
 	void DataChanged();
 
+	/// Loaded level nearest to mLodLevel, coarser ones first
+	/** @returns -1 if no level is loaded. */
+	int FindLoadedLevel() const;
+
 	MeshLocator mLocator;
+
+	/// One per MeshLocator::morphTargets
+	std::vector<float> mMorphWeights;
 	MeshManager::Asset* mAsset = nullptr;
 	util::AxisAlignedBox mBounds;
 	int mLastBoundsChange = 0;
-	unsigned int mPickingId = 0;
+	unsigned int mLodLevel = 0;
+	float mLodError = 1.0f;
 	RenderManager& mRenderManager;
 };
 
@@ -84,21 +116,51 @@ void DrawMesh<TRenderManager>::HandleExecute(Scope& scope)
 
 	if(mAsset)
 	{
-		DrawMeshData* data = mAsset->Use();
+		// Meshes larger on screen are loaded first:
+		const float footprint = DrawMeshData::GetScreenFootprint(scope, mBounds);
+		const float priority = footprint > 0.0f ? footprint : +MeshManager::kDefaultPriority;
+
+		// Full detail if the size on screen is not known:
+		const MeshLods& lods = *mAsset->GetAsset();
+		mLodLevel = lods.SelectLevel(footprint > 0.0f ? footprint : std::numeric_limits<float>::max(), mLodError, mLodLevel);
+		mAsset->Use(mLodLevel, priority);
+
+		const int level = FindLoadedLevel();
+		if(level < 0)
+			return;
+		if(unsigned(level) != mLodLevel)
+			mAsset->Use(level, priority); // Keep fallback from being unloaded
+		DrawMeshData* data = lods.levels[level];
 		if(mBounds.IsNull())
 		{
 			mBounds = data->GetBounds();
 //			mLastBoundsChange = mRenderManager.GetFramecounter();
 		}
-		scope.Set("pickingColor"_H, Uniform<unsigned int>(mPickingId));
+		data->SetMorphWeights(mMorphWeights.data(), mMorphWeights.size());
 		data->Execute(scope);
+		data->SetMorphWeights(nullptr, 0);
+	}
+}
+
+template<class TRenderManager>
+int DrawMesh<TRenderManager>::FindLoadedLevel() const
+{
+	for(unsigned int distance = 0; distance < MeshLods::kMaxLevels; ++distance)
+	{
+		const unsigned int coarser = mLodLevel + distance;
+		if(coarser < MeshLods::kMaxLevels && mAsset->GetState(coarser) == MeshManager::Asset::kLoaded)
+			return coarser;
+		if(distance <= mLodLevel && mAsset->GetState(mLodLevel - distance) == MeshManager::Asset::kLoaded)
+			return mLodLevel - distance;
 	}
+	return -1;
 }
 
 template<class TRenderManager>
 void DrawMesh<TRenderManager>::SetMeshFile(Hash mesh)
 {
 	mAsset = nullptr;
+	mLodLevel = 0;
 
 	mLocator.meshFile = mesh;
 	mBounds = mRenderManager.GetMeshFileBounds(mesh);
@@ -106,21 +168,21 @@ void DrawMesh<TRenderManager>::SetMeshFile(Hash mesh)
 }
 
 template<class TRenderManager>
-void DrawMesh<TRenderManager>::AddMorphTarget(const std::string& targetFile, float weight)
+void DrawMesh<TRenderManager>::AddMorphTarget(Hash targetFile, float weight)
 {
 	mAsset = nullptr;
-
-	MeshLocator::MorphTarget target;
-	target.file = targetFile;
-	target.weight = weight;
-	mLocator.morphTargets.push_back(target);
+	mLodLevel = 0;
+	mLocator.morphTargets.push_back(targetFile);
+	mMorphWeights.push_back(weight);
 }
 
 template<class TRenderManager>
 void DrawMesh<TRenderManager>::ClearMorphTargets()
 {
 	mAsset = nullptr;
+	mLodLevel = 0;
 	mLocator.morphTargets.clear();
+	mMorphWeights.clear();
 }
 
 }
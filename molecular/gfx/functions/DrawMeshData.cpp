@@ -25,9 +25,14 @@ SOFTWARE.
 
 #include "DrawMeshData.h"
 #include <molecular/gfx/DefaultProgramData.h>
+#include <molecular/gfx/GfxUtils.h>
 #include <molecular/gfx/MeshDataSource.h>
 #include <molecular/gfx/Material.h>
 #include <molecular/meshfile/MeshFile.h>
+#include <molecular/util/Frustum.h>
+
+#include <algorithm>
+#include <cmath>
 
 namespace molecular
 {
@@ -35,13 +40,55 @@ namespace gfx
 {
 using namespace meshfile;
 
+struct DrawMeshData::ClusterView
+{
+	ClusterView(const Matrix4& modelViewProjection, bool cullFront);
+
+	util::Frustum frustum;
+
+	/// Position with w = 1, or direction of view with w = 0
+	/** @see MeshLodFile::Cluster::IsCulledByCone */
+	float eye[4];
+
+	/// Front faces are culled instead of back faces
+	bool front;
+};
+
+DrawMeshData::ClusterView::ClusterView(const Matrix4& modelViewProjection, bool cullFront) :
+	frustum(modelViewProjection),
+	front(cullFront)
+{
+	// All view rays meet in the eye, at infinity for parallel projections:
+	const Vector4 point = Matrix4(modelViewProjection.Inverse()) * Vector4(0, 0, 1, 0);
+	const float length = std::sqrt(point[0] * point[0] + point[1] * point[1] + point[2] * point[2]);
+	if(std::abs(point[3]) > 1e-5f * length)
+	{
+		for(int i = 0; i < 3; ++i)
+			eye[i] = point[i] / point[3];
+		eye[3] = 1;
+	}
+	else
+	{
+		for(int i = 0; i < 3; ++i)
+			eye[i] = length > 0.0f ? point[i] / length : 0.0f;
+		eye[3] = 0;
+	}
+}
+
+static size_t GetIndexSize(IndexBufferInfo::Type type)
+{
+	switch(type)
+	{
+	case IndexBufferInfo::Type::kUInt8: return 1;
+	case IndexBufferInfo::Type::kUInt16: return 2;
+	case IndexBufferInfo::Type::kUInt32: return 4;
+	}
+	return 4;
+}
+
 DrawMeshData::~DrawMeshData()
 {
 	Unload();
-	for(auto buffer: mVertexBuffers)
-		mRenderer.DestroyVertexBuffer(buffer);
-	for(auto buffer: mIndexBuffers)
-		mRenderer.DestroyIndexBuffer(buffer);
 }
 
 void DrawMeshData::HandleExecute(Scope& scope)
@@ -49,120 +96,129 @@ void DrawMeshData::HandleExecute(Scope& scope)
 	if(mMeshes.empty())
 		return; // No meshes loaded, do nothing
 
+	// Textures from materials get streamed in as needed for this size:
+	mScreenFootprint = GetScreenFootprint(scope, mBounds);
+	const bool depthOnly = IsDepthOnly(scope);
+	Matrix4 modelViewProjection;
+	if(mHasClusters && !HasActiveMorphWeights(mMorphWeights, mMorphWeightCount) && GetModelViewProjection(scope, modelViewProjection))
+	{
+		const ClusterView view(modelViewProjection, mRenderer.GetCullMode() == RenderCmdSink::kFront);
+		DrawMeshes(scope, &view, depthOnly);
+	}
+	else
+		DrawMeshes(scope, nullptr, depthOnly);
+}
+
+void DrawMeshData::DrawMeshes(Scope& scope, const ClusterView* view, bool depthOnly)
+{
 	for(auto& mesh: mMeshes)
 	{
 		Scope meshScope(scope);
 		if(mesh.material)
 			meshScope.SetSibling(*mesh.material);
 
-		auto& attributes = mVertexDataSets.at(mesh.info.vertexDataSet).attributes;
-		BindAttributesAndDraw(mesh, attributes, scope);
+		BindAttributesAndDraw(mesh, mVertexDataSets.at(mesh.info.vertexDataSet), scope, view, depthOnly);
 	}
 }
 
 void DrawMeshData::Load(MeshDataSource& source)
 {
-	unsigned int numVertexBuffers = source.PrepareVertexData();
-	unsigned int numIndexBuffers = source.PrepareIndexData();
-	unsigned int numVertexDataSets = source.GetNumVertexDataSets();
+	Load(PreparedMesh::FromSource(source));
+}
 
-	mVertexDataSets.resize(numVertexDataSets);
-	for(unsigned int i = 0; i < numVertexDataSets; ++i)
-	{
-		mVertexDataSets[i].attributes = source.GetVertexBufferInfos(i);
-	}
+void DrawMeshData::Load(const MeshFile& file)
+{
+	Load(PreparedMesh::FromMeshFile(file));
+}
 
-	for(auto& info: source.GetIndexBufferInfos())
+void DrawMeshData::Load(const PreparedMesh& mesh)
+{
+	Unload();
+	mVertexDataSets.resize(mesh.vertexDataSets.size());
+	for(size_t i = 0; i < mesh.vertexDataSets.size(); ++i)
+		mVertexDataSets[i].attributes = mesh.vertexDataSets[i];
+
+	mMeshes.resize(mesh.indexBufferInfos.size());
+	for(size_t i = 0; i < mesh.indexBufferInfos.size(); ++i)
 	{
-		Mesh mesh;
-		mesh.info = info;
+		const IndexBufferInfo& info = mesh.indexBufferInfos[i];
+		mMeshes[i].info = info;
 		if(info.material[0] == 0)
-			mesh.material = nullptr;
+			mMeshes[i].material = nullptr;
 		else
-			mesh.material = mMaterialManager.GetMaterial(info.material);
-		mMeshes.push_back(mesh);
+			mMeshes[i].material = mMaterialManager.GetMaterial(info.material);
+		mMeshes[i].clusters.clear();
 	}
 
-	mVertexBuffers.resize(numVertexBuffers);
-	for(unsigned int i = 0; i < numVertexBuffers; ++i)
+	mHasClusters = false;
+	for(auto& cluster: mesh.clusters)
 	{
-		mVertexBuffers[i] = mRenderer.CreateVertexBuffer();
-		mVertexBuffers[i]->Store(source.VertexBufferData(i), source.VertexBufferSize(i));
+		if(cluster.indexSpec >= mMeshes.size() || cluster.firstIndex + uint64_t(cluster.indexCount) > mMeshes[cluster.indexSpec].info.count)
+			throw std::runtime_error("Mesh cluster exceeds index buffer");
+		mMeshes[cluster.indexSpec].clusters.push_back(cluster);
+		mHasClusters = true;
 	}
-
-	mIndexBuffers.resize(numIndexBuffers);
-	for(unsigned int i = 0; i < numIndexBuffers; ++i)
+	for(auto& mesh: mMeshes)
 	{
-		mIndexBuffers[i] = mRenderer.CreateIndexBuffer();
-		mIndexBuffers[i]->Store(source.IndexBufferData(i), source.IndexBufferSize(i));
+		mesh.drawOffsets.reserve(mesh.clusters.size());
+		mesh.drawCounts.reserve(mesh.clusters.size());
 	}
-	mBounds = source.GetBounds();
-}
-
-void DrawMeshData::Load(const MeshFile& file)
-{
-	if(file.magic != MeshFile::kMagic)
-		throw std::runtime_error("Mesh file magic number does not match");
-	if(file.version != MeshFile::kVersion)
-		throw std::runtime_error("Wrong mesh file version");
-	if(file.numVertexDataSets > 100)
-		throw std::runtime_error("Implausible number of vertex datasets");
-	if(file.numIndexSpecs > 100)
-		throw std::runtime_error("Implausible number of index specifications");
-	if(file.numBuffers > 100)
-		throw std::runtime_error("Implausible number of buffers");
 
-	mVertexDataSets.resize(file.numVertexDataSets);
-	for(unsigned int i = 0; i < file.numVertexDataSets; ++i)
+	mVertexBuffers.resize(mesh.vertexBuffers.size());
+	for(size_t i = 0; i < mesh.vertexBuffers.size(); ++i)
 	{
-		const MeshFile::VertexDataSet& vSet = file.GetVertexDataSet(i);
-		mVertexDataSets[i].attributes.resize(vSet.numVertexSpecs);
-		for(unsigned int vSpec = 0; vSpec < vSet.numVertexSpecs; ++vSpec)
-			mVertexDataSets[i].attributes[vSpec] = file.GetVertexSpec(i, vSpec);
+		if(mesh.vertexBuffers[i].data)
+			mVertexBuffers[i] = mRenderer.StoreVertexData(mesh.vertexBuffers[i].data, mesh.vertexBuffers[i].size);
 	}
 
-	mMeshes.resize(file.numIndexSpecs);
-	for(unsigned int i = 0; i < file.numIndexSpecs; ++i)
+	mIndexBuffers.resize(mesh.indexBuffers.size());
+	for(size_t i = 0; i < mesh.indexBuffers.size(); ++i)
 	{
-		const IndexBufferInfo& info = file.GetIndexSpec(i);
-		mMeshes[i].info = info;
-		if(info.material[0] == 0)
-			mMeshes[i].material = nullptr;
-		else
-			mMeshes[i].material = mMaterialManager.GetMaterial(info.material);
+		if(mesh.indexBuffers[i].data)
+			mIndexBuffers[i] = mRenderer.StoreIndexData(mesh.indexBuffers[i].data, mesh.indexBuffers[i].size);
 	}
-
-	mVertexBuffers.resize(file.numBuffers);
-	mIndexBuffers.resize(file.numBuffers);
-	for(unsigned int i = 0; i < file.numBuffers; ++i)
+	if(!mIndexBuffers.empty())
 	{
-		/* TODO: mVertexBuffers and mIndexBuffers combined contain twice as
-			many buffers as necessary, but they are referenced correctly. */
-		if(file.GetBuffer(i).type == MeshFile::Buffer::Type::kVertex)
-		{
-			mVertexBuffers[i] = mRenderer.CreateVertexBuffer();
-			mVertexBuffers[i]->Store(file.GetBufferData(i), file.GetBuffer(i).size);
-		}
-		else if(file.GetBuffer(i).type == MeshFile::Buffer::Type::kIndex)
-		{
-			mIndexBuffers[i] = mRenderer.CreateIndexBuffer();
-			mIndexBuffers[i]->Store(file.GetBufferData(i), file.GetBuffer(i).size);
-		}
+		for(auto& mesh: mMeshes)
+			mesh.info.offset += static_cast<uint32_t>(mIndexBuffers.at(mesh.info.buffer).offset);
 	}
-	mBounds = util::AxisAlignedBox(file.boundsMin, file.boundsMax);
+	mBounds = mesh.bounds;
+	CreateAttributeScopes();
+	CreateMorphTargetScopes(mesh);
 }
 
 void DrawMeshData::Unload()
 {
 	mMeshes.clear();
+	mHasClusters = false;
+	mMorphTargets.clear();
+	mVertexDataSets.clear();
+	for(auto& range: mIndexBuffers)
+	{
+		if(range.buffer)
+			mRenderer.FreeIndexData(range);
+	}
 	mIndexBuffers.clear();
+	for(auto& range: mVertexBuffers)
+	{
+		if(range.buffer)
+			mRenderer.FreeVertexData(range);
+	}
 	mVertexBuffers.clear();
 
 	// Reset bounding box?
 }
 
-void DrawMeshData::Draw(Mesh& mesh, const Scope& scope)
+void DrawMeshData::Draw(Mesh& mesh, const Scope& scope, const ClusterView* view)
 {
+	const bool culling = view && !mesh.clusters.empty() && !mIndexBuffers.empty();
+	if(culling)
+	{
+		CullClusters(mesh, *view);
+		if(mesh.drawCounts.empty())
+			return; // Nothing visible
+	}
+
 	bool add = false;
 	bool mix = false;
 	if(scope.Has("blendMode"_H))
@@ -181,11 +237,13 @@ void DrawMeshData::Draw(Mesh& mesh, const Scope& scope)
 			mRenderer.SetBlending(true, RenderCmdSink::kSrcAlpha, RenderCmdSink::kOneMinusSrcAlpha);
 	}
 
-	PrepareProgram(scope);
+	PrepareProgram(scope, mScreenFootprint);
 	if(mIndexBuffers.empty())
 		mRenderer.Draw(mesh.info.mode, mesh.info.count);
+	else if(culling && !(mesh.drawCounts.size() == 1 && mesh.drawCounts.front() == mesh.info.count))
+		mRenderer.Draw(mIndexBuffers.at(mesh.info.buffer).buffer, mesh.info, mesh.drawOffsets.data(), mesh.drawCounts.data(), static_cast<unsigned int>(mesh.drawCounts.size()));
 	else
-		mRenderer.Draw(mIndexBuffers.at(mesh.info.buffer), mesh.info);
+		mRenderer.Draw(mIndexBuffers.at(mesh.info.buffer).buffer, mesh.info);
 
 	if(add || mix)
 	{
@@ -194,13 +252,174 @@ void DrawMeshData::Draw(Mesh& mesh, const Scope& scope)
 	}
 }
 
-void DrawMeshData::BindAttributesAndDraw(Mesh& mesh, const std::vector<VertexAttributeInfo>& attributes, const Scope& parentScope)
+void DrawMeshData::CullClusters(Mesh& mesh, const ClusterView& view)
+{
+	const size_t indexSize = GetIndexSize(mesh.info.type);
+	mesh.drawOffsets.clear();
+	mesh.drawCounts.clear();
+	for(auto& cluster: mesh.clusters)
+	{
+		const Vector3 center(cluster.center[0], cluster.center[1], cluster.center[2]);
+		if(view.frustum.Check(center, cluster.radius) == util::Plane::kOutside || cluster.IsCulledByCone(view.eye, view.front))
+			continue;
+
+		const uint32_t offset = static_cast<uint32_t>(mesh.info.offset + cluster.firstIndex * indexSize);
+		if(!mesh.drawCounts.empty() && mesh.drawOffsets.back() + mesh.drawCounts.back() * indexSize == offset)
+			mesh.drawCounts.back() += cluster.indexCount; // Adjacent to previous cluster
+		else
+		{
+			mesh.drawOffsets.push_back(offset);
+			mesh.drawCounts.push_back(cluster.indexCount);
+		}
+	}
+}
+
+void DrawMeshData::BindAttributesAndDraw(Mesh& mesh, VertexDataSet& vertexDataSet, const Scope& parentScope, const ClusterView* view, bool depthOnly)
+{
+	Scope& scope = vertexDataSet.GetAttributeScope(depthOnly);
+	if(mMorphWeights)
+		scope.SetParent(BindMorphTargets(mesh.info.vertexDataSet, parentScope));
+	else
+		scope.SetParent(parentScope);
+	Draw(mesh, scope, view);
+}
+
+const Scope& DrawMeshData::BindMorphTargets(unsigned int vertexDataSet, const Scope& parentScope)
+{
+	const unsigned int kSlots = DefaultProgramData::kMaxActiveMorphTargets;
+
+	// Targets with the largest weights, sorted by decreasing magnitude:
+	size_t targets[kSlots];
+	unsigned int count = 0;
+	for(size_t i = 0; i < std::min(mMorphWeightCount, mMorphTargets.size()); ++i)
+	{
+		const float magnitude = std::abs(mMorphWeights[i]);
+		if(magnitude == 0.0f || vertexDataSet >= mMorphTargets[i].slotScopes.size() || mMorphTargets[i].slotScopes[vertexDataSet].empty())
+			continue;
+		unsigned int slot = std::min(count, kSlots - 1);
+		if(count == kSlots && magnitude <= std::abs(mMorphWeights[targets[slot]]))
+			continue;
+		for(; slot > 0 && magnitude > std::abs(mMorphWeights[targets[slot - 1]]); --slot)
+			targets[slot] = targets[slot - 1];
+		targets[slot] = i;
+		count = std::min(count + 1, kSlots);
+	}
+	if(count == 0)
+		return parentScope;
+
+	Vector4 weights(0, 0, 0, 0);
+	mMorphWeightsScope.SetParent(parentScope);
+	const Scope* parent = &mMorphWeightsScope;
+	for(unsigned int slot = 0; slot < count; ++slot)
+	{
+		weights[slot] = mMorphWeights[targets[slot]];
+		Scope& scope = *mMorphTargets[targets[slot]].slotScopes[vertexDataSet][slot];
+		scope.SetParent(*parent);
+		parent = &scope;
+	}
+	mMorphWeightsScope.Set("morphWeights"_H, Uniform<Vector4>(weights));
+	return *parent;
+}
+
+bool DrawMeshData::HasActiveMorphWeights(const float* weights, size_t count)
+{
+	if(!weights)
+		return false;
+	return std::any_of(weights, weights + count, [](float weight){return weight != 0.0f;});
+}
+
+bool DrawMeshData::IsDepthOnly(const Scope& scope)
+{
+	return !scope.Has("fragmentColor"_H);
+}
+
+bool DrawMeshData::GetModelViewProjection(const Scope& scope, Matrix4& outMatrix)
+{
+	if(!scope.Has("projectionMatrix"_H) || !scope.Has("viewMatrix"_H))
+		return false;
+
+	outMatrix = *scope.Get<Uniform<Matrix4>>("projectionMatrix"_H) * *scope.Get<Uniform<Matrix4>>("viewMatrix"_H);
+	if(scope.Has("modelMatrix"_H))
+		outMatrix = outMatrix * *scope.Get<Uniform<Matrix4>>("modelMatrix"_H);
+	return true;
+}
+
+float DrawMeshData::GetScreenFootprint(const Scope& scope, const util::AxisAlignedBox& bounds)
+{
+	Matrix4 modelViewProjection;
+	if(bounds.IsNull() || !scope.Has("viewportSite"_H) || !GetModelViewProjection(scope, modelViewProjection))
+		return 0.0f;
+
+	return ScreenFootprint(modelViewProjection, bounds, *scope.Get<Uniform<Vector2>>("viewportSite"_H));
+}
+
+void DrawMeshData::CreateMorphTargetScopes(const PreparedMesh& mesh)
+{
+	static const Hash kPositionDeltas[] = {"morphPositionDelta0Attr"_H, "morphPositionDelta1Attr"_H, "morphPositionDelta2Attr"_H, "morphPositionDelta3Attr"_H};
+	static const Hash kNormalDeltas[] = {"morphNormalDelta0Attr"_H, "morphNormalDelta1Attr"_H, "morphNormalDelta2Attr"_H, "morphNormalDelta3Attr"_H};
+	static_assert(sizeof(kPositionDeltas) / sizeof(Hash) == DefaultProgramData::kMaxActiveMorphTargets, "Attribute names do not match slots");
+
+	mMorphTargets.clear();
+	mMorphTargets.resize(mesh.morphTargets.size());
+	for(size_t i = 0; i < mesh.morphTargets.size(); ++i)
+	{
+		const PreparedMesh::MorphTarget& target = mesh.morphTargets[i];
+		mMorphTargets[i].slotScopes.resize(target.vertexDataSets.size());
+		for(size_t set = 0; set < target.vertexDataSets.size(); ++set)
+		{
+			if(target.vertexDataSets[set].empty())
+				continue;
+			for(unsigned int slot = 0; slot < DefaultProgramData::kMaxActiveMorphTargets; ++slot)
+			{
+				std::unique_ptr<Scope> scope(new Scope);
+				for(auto& delta: target.vertexDataSets[set])
+				{
+					const Hash name = (delta.semantic == VertexAttributeInfo::kPosition) ? kPositionDeltas[slot] : kNormalDeltas[slot];
+					scope->Set(name, MakeAttribute(delta));
+				}
+				mMorphTargets[i].slotScopes[set].push_back(std::move(scope));
+			}
+		}
+	}
+}
+
+void DrawMeshData::CreateAttributeScopes()
 {
-	Scope scope(parentScope);
-	for(auto& it: attributes)
-		scope.Set(it.semantic, Attribute(mVertexBuffers.at(it.buffer), it));
+	for(auto& vertexDataSet: mVertexDataSets)
+	{
+		const std::vector<unsigned int> streamBuffers = PreparedMesh::GetPositionStreamBuffers(vertexDataSet.attributes);
+		const bool hasStream = !streamBuffers.empty();
 
-	Draw(mesh, scope);
+		vertexDataSet.attributeScope.reset(new Scope);
+		vertexDataSet.depthAttributeScope.reset(hasStream ? new Scope : nullptr);
+		for(auto& it: vertexDataSet.attributes)
+		{
+			const bool inStream = hasStream && std::find(streamBuffers.begin(), streamBuffers.end(), it.buffer) != streamBuffers.end();
+			vertexDataSet.attributeScope->Set(it.semantic, MakeAttribute(it));
+			if(inStream)
+				vertexDataSet.depthAttributeScope->Set(it.semantic, MakeAttribute(it));
+
+			// Quantized positions span the bounds, see DefaultProgramData:
+			if(it.semantic == "vertexPositionQuantizedAttr"_H)
+			{
+				vertexDataSet.attributeScope->Set("vertexPositionScale"_H, Uniform<Vector3>(mBounds.GetSize()));
+				vertexDataSet.attributeScope->Set("vertexPositionOffset"_H, Uniform<Vector3>(mBounds.GetMin()));
+				if(inStream)
+				{
+					vertexDataSet.depthAttributeScope->Set("vertexPositionScale"_H, Uniform<Vector3>(mBounds.GetSize()));
+					vertexDataSet.depthAttributeScope->Set("vertexPositionOffset"_H, Uniform<Vector3>(mBounds.GetMin()));
+				}
+			}
+		}
+	}
+}
+
+Attribute DrawMeshData::MakeAttribute(const VertexAttributeInfo& info) const
+{
+	const RenderCmdSink::BufferRange<RenderCmdSink::VertexBuffer>& range = mVertexBuffers.at(info.buffer);
+	VertexAttributeInfo pooled = info;
+	pooled.offset += static_cast<uint32_t>(range.offset);
+	return Attribute(range.buffer, pooled);
 }
 
 }
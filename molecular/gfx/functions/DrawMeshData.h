@@ -27,9 +27,12 @@ SOFTWARE.
 #define MOLECULAR_DRAWMESHDATA_H
 
 #include "DrawingFunction.h"
+#include <molecular/gfx/DefaultProgramData.h>
 #include <molecular/gfx/ProgramProvider.h>
 #include <molecular/gfx/Material.h>
 #include <molecular/gfx/MaterialManager.h>
+#include <molecular/gfx/PreparedMesh.h>
+#include <molecular/util/Matrix4.h>
 
 namespace molecular
 {
@@ -44,8 +47,7 @@ class MeshDataSource;
 
 /// RenderFunction that draws a group of meshes
 /** @note Do not use this class directly! Use DrawMesh instead, which automatically instantiates
-		DrawMeshData when necessary.
-	@todo LOD */
+		DrawMeshData when necessary. DrawMesh holds one per level of detail. */
 class DrawMeshData : public DrawingFunction
 {
 public:
@@ -73,17 +75,52 @@ public:
 	util::AxisAlignedBox GetBounds() const override {return mBounds;}
 
 	/// Store mesh data in Renderer
-	/** Called by MeshLoader::StoreNmbMesh, MeshLoader::StoreObjMesh or
-		MeshLoader::StoreXmlMesh.
+	/** Parses and stores in the calling thread.
 		@deprecated Load compiled meshes! */
 	void Load(MeshDataSource& source);
 
 	/// Store mesh data in Renderer
-	/** Called by MeshLoader::StoreCompiledMesh. */
+	/** Validates and stores in the calling thread. */
 	void Load(const meshfile::MeshFile& file);
 
+	/// Store mesh data prepared in a worker thread in Renderer
+	/** Called by MeshLoader::StoreMesh. Only fills buffers, which are ranges
+		of buffers shared with other meshes, see
+		RenderCmdSink::StoreVertexData(). Buffer data of the PreparedMesh is
+		not referenced afterwards. */
+	void Load(const PreparedMesh& mesh);
+
+	/// Release mesh data
+	/** Frees the buffer ranges for other meshes. */
 	void Unload();
 
+	/// Set weights of the morph targets for the next Execute()
+	/** Up to DefaultProgramData::kMaxActiveMorphTargets targets with the
+		largest non-zero weights get blended in the vertex shader. The array
+		has to stay valid until then. Reset with nullptr afterwards.
+		@param weights One per morph target of the MeshLocator. */
+	void SetMorphWeights(const float* weights, size_t count) {mMorphWeights = weights; mMorphWeightCount = count;}
+
+	/// Whether any of the morph weights is non-zero
+	/** Morphed vertices leave the bounding spheres and normal cones of the
+		clusters, so clusters are not culled then. */
+	static bool HasActiveMorphWeights(const float* weights, size_t count);
+
+	/// Whether the scope is of a pass that writes depth only
+	/** Shadow passes and the like request no fragmentColor, see
+		CascadedShadowMapping. */
+	static bool IsDepthOnly(const Scope& scope);
+
+	/// Attribute variables bound when drawing a vertex data set
+	/** Depth-only passes get only the position stream, if the vertex data
+		set has one. Throws if the vertex data set does not exist. */
+	const Scope& GetAttributeScope(unsigned int vertexDataSet, bool depthOnly) const {return mVertexDataSets.at(vertexDataSet).GetAttributeScope(depthOnly);}
+
+	/// Size of bounds on screen in pixels
+	/** Uses projectionMatrix, viewMatrix, modelMatrix and viewportSite from
+		the scope. @returns 0 if bounds or scope variables are missing. */
+	static float GetScreenFootprint(const Scope& scope, const util::AxisAlignedBox& bounds);
+
 protected:
 	/** Draws meshes if they are loaded. Does nothing otherwise. */
 	void HandleExecute(Scope& scope) override;
@@ -92,6 +129,19 @@ private:
 	struct VertexDataSet
 	{
 		std::vector<VertexAttributeInfo> attributes;
+
+		/// Attribute variables pointing to mVertexBuffers
+		/** Created once after loading so drawing does not allocate. Parent is
+			set before each draw. unique_ptr because Scope's copy constructor
+			creates a child scope. */
+		std::unique_ptr<Scope> attributeScope;
+
+		/// Attributes of the position stream for depth-only passes
+		/** nullptr if the vertex data set has no separate position stream.
+			@see PreparedMesh::IsPositionStreamAttribute */
+		std::unique_ptr<Scope> depthAttributeScope;
+
+		Scope& GetAttributeScope(bool depthOnly) const {return (depthOnly && depthAttributeScope) ? *depthAttributeScope : *attributeScope;}
 	};
 
 	struct Mesh
@@ -100,12 +150,57 @@ private:
 		/** References one entry from mVertexDataSets. */
 		IndexBufferInfo info;
 		Material* material;
+
+		/// Culling clusters, empty if the mesh is drawn as a whole
+		std::vector<MeshLodFile::Cluster> clusters;
+
+		/// Index ranges of visible clusters, kept to avoid allocations
+		std::vector<uint32_t> drawOffsets;
+		std::vector<uint32_t> drawCounts;
+	};
+
+	/// Viewer in model space for culling clusters
+	struct ClusterView;
+
+	/** @param depthOnly Bind only position streams where available. */
+	void DrawMeshes(Scope& scope, const ClusterView* view, bool depthOnly);
+
+	/// Draw mesh
+	/** @param view Culls clusters if not nullptr. */
+	void Draw(Mesh& mesh, const Scope& scope, const ClusterView* view);
+
+	/// Fill Mesh::drawOffsets and Mesh::drawCounts with visible clusters
+	void CullClusters(Mesh& mesh, const ClusterView& view);
+
+	/// Delta attributes of a morph target
+	struct MorphTarget
+	{
+		/// Per vertex data set, one scope per slot
+		/** Slots bind the deltas as morphPositionDelta0Attr and so on, see
+			DefaultProgramData. Empty where the target has no deltas. */
+		std::vector<std::vector<std::unique_ptr<Scope>>> slotScopes;
 	};
 
-	void Draw(Mesh& mesh, const Scope& scope);
+	/// Chain deltas of the targets with the largest weights to parentScope
+	/** @returns parentScope if no morph target applies. */
+	const Scope& BindMorphTargets(unsigned int vertexDataSet, const Scope& parentScope);
+
+	/// Fill MorphTarget::slotScopes of all morph targets
+	void CreateMorphTargetScopes(const PreparedMesh& mesh);
 
 	/// Binds alls attributes and calls Draw
-	void BindAttributesAndDraw(Mesh& mesh, const std::vector<VertexAttributeInfo>& attributes, const Scope& parentScope);
+	void BindAttributesAndDraw(Mesh& mesh, VertexDataSet& vertexDataSet, const Scope& parentScope, const ClusterView* view, bool depthOnly);
+
+	/// Product of projectionMatrix, viewMatrix and modelMatrix from the scope
+	/** @returns false if projectionMatrix or viewMatrix are missing. */
+	static bool GetModelViewProjection(const Scope& scope, util::Matrix4& outMatrix);
+
+	/// Fill VertexDataSet::attributeScope of all vertex data sets
+	void CreateAttributeScopes();
+
+	/// Attribute with info's offset shifted into the pooled buffer
+	Attribute MakeAttribute(const VertexAttributeInfo& info) const;
+
 
 	MaterialManager& mMaterialManager;
 
@@ -113,14 +208,30 @@ private:
 	/** Can reference one or more entries from mVertexBuffers */
 	std::vector<VertexDataSet> mVertexDataSets;
 
-	/// Handles to vertex data on GPU
-	std::vector<RenderCmdSink::VertexBuffer*> mVertexBuffers;
+	/// Vertex data on GPU, buffer nullptr where the mesh has none
+	std::vector<RenderCmdSink::BufferRange<RenderCmdSink::VertexBuffer>> mVertexBuffers;
 
-	/// Handles to index data on GPU
-	std::vector<RenderCmdSink::IndexBuffer*> mIndexBuffers;
+	/// Index data on GPU, buffer nullptr where the mesh has none
+	/** Offsets are already added to Mesh::info. */
+	std::vector<RenderCmdSink::BufferRange<RenderCmdSink::IndexBuffer>> mIndexBuffers;
 
 	std::vector<Mesh> mMeshes;
 	util::AxisAlignedBox mBounds;
+
+	/// Any of mMeshes has clusters
+	bool mHasClusters = false;
+
+	/// Size on screen during HandleExecute(), passed to material textures
+	float mScreenFootprint = 0.0f;
+
+	std::vector<MorphTarget> mMorphTargets;
+
+	/// Holds morphWeights, parent of the bound delta scopes
+	Scope mMorphWeightsScope;
+
+	/// Set with SetMorphWeights()
+	const float* mMorphWeights = nullptr;
+	size_t mMorphWeightCount = 0;
 };
 
 }
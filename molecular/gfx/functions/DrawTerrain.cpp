@@ -81,8 +81,8 @@ void DrawTerrain::HandleExecute(Scope& scope)
 			*start = IntVector2(x, y);
 			*dbgPatchCounter = (patch % 10);
 			patch++;
-			start.Apply(program, "terrainStart"_H);
-			dbgPatchCounter.Apply(program, "dbgPatchCounter"_H);
+			start.Apply(program, "terrainStart"_H, 0.0f);
+			dbgPatchCounter.Apply(program, "dbgPatchCounter"_H, 0.0f);
 			mRenderer.Draw(mPatchIndices[lodLevel], mPatchInfos[lodLevel]);
 		}
 	}
@@ -128,23 +128,51 @@ void DrawTerrain::SetHeightmapData(unsigned int width, unsigned int height, cons
 
 
 	std::vector<uint8_t> normalMap(width * height * components);
+	GenerateNormalMap(width, height, data, mHeightScale, sampleDistanceX, sampleDistanceY, normalMap.data());
+
+	// Extend size to multiples of 4:
+	unsigned int evenWidth = width;
+	while(evenWidth % 4)
+		evenWidth++;
+	unsigned int evenHeight = height;
+	while(evenHeight % 4)
+		evenHeight++;
+
+	// Allocate larger images:
+	mHeightmap->Store(evenWidth, evenHeight, nullptr, PF_L_FLOAT32);
+	mNormalMap->Store(evenWidth, evenHeight, nullptr, PF_R8G8B8);
+
+	// Store data as subimages:
+	mHeightmap->Store(0, 0, width, height, data, PF_L_FLOAT32);
+	mHeightmap->SetParameter(RenderCmdSink::Texture::kMinFilter, RenderCmdSink::Texture::kNearest);
+	mHeightmap->SetParameter(RenderCmdSink::Texture::kMagFilter, RenderCmdSink::Texture::kNearest);
+
+	mNormalMap->Store(0, 0, width, height, &normalMap[0], PF_R8G8B8A8);
+	mNormalMap->SetParameter(RenderCmdSink::Texture::kMinFilter, RenderCmdSink::Texture::kNearest);
+	mNormalMap->SetParameter(RenderCmdSink::Texture::kMagFilter, RenderCmdSink::Texture::kNearest);
+
+//	BoundsChanged();
+}
+
+void DrawTerrain::GenerateNormalMap(unsigned int width, unsigned int height, const float* data, float heightScale, float sampleDistanceX, float sampleDistanceY, uint8_t* out)
+{
 	for(unsigned int y = 0; y < height; ++y)
 	{
 		for(unsigned int x = 0; x < width; ++x)
 		{
-			float center = data[y * width + x] * mHeightScale;
+			float center = data[y * width + x] * heightScale;
 			float west = center;
 			if(x > 0)
-				west = data[y * width + (x-1)] * mHeightScale;
+				west = data[y * width + (x-1)] * heightScale;
 			float north = center;
 			if(y > 0)
-				north = data[(y-1) * width + x] * mHeightScale;
+				north = data[(y-1) * width + x] * heightScale;
 			float east = center;
 			if(x < width-1)
-				east = data[y * width + x +1] * mHeightScale;
+				east = data[y * width + x +1] * heightScale;
 			float south = center;
 			if(y < height-1)
-				south = data[(y+1) * width + x] * mHeightScale;
+				south = data[(y+1) * width + x] * heightScale;
 
 			Vector3 eastNormal(east - center, sampleDistanceX, 0);
 			Vector3 westNormal(center - west, sampleDistanceX, 0);
@@ -153,34 +181,12 @@ void DrawTerrain::SetHeightmapData(unsigned int width, unsigned int height, cons
 			Vector3 normal = eastNormal.Normalized() + westNormal.Normalized() + northNormal.Normalized() + southNormal.Normalized();
 			normal *= 0.25;
 			normal *= Vector3(-1,1,-1); // ?
-			uint8_t* pixel = &normalMap[(y*width + x) * components];
+			uint8_t* pixel = &out[(y*width + x) * 4];
 			pixel[0] = uint8_t(normal[0] * 127 + 128);
 			pixel[1] = uint8_t(normal[1] * 127 + 128);
 			pixel[2] = uint8_t(normal[2] * 127 + 128);
 		}
 	}
-	// Extend size to multiples of 4:
-	unsigned int evenWidth = width;
-	while(evenWidth % 4)
-		evenWidth++;
-	unsigned int evenHeight = height;
-	while(evenHeight % 4)
-		evenHeight++;
-
-	// Allocate larger images:
-	mHeightmap->Store(evenWidth, evenHeight, nullptr, PF_L_FLOAT32);
-	mNormalMap->Store(evenWidth, evenHeight, nullptr, PF_R8G8B8);
-
-	// Store data as subimages:
-	mHeightmap->Store(0, 0, width, height, data, PF_L_FLOAT32);
-	mHeightmap->SetParameter(RenderCmdSink::Texture::kMinFilter, RenderCmdSink::Texture::kNearest);
-	mHeightmap->SetParameter(RenderCmdSink::Texture::kMagFilter, RenderCmdSink::Texture::kNearest);
-
-	mNormalMap->Store(0, 0, width, height, &normalMap[0], PF_R8G8B8A8);
-	mNormalMap->SetParameter(RenderCmdSink::Texture::kMinFilter, RenderCmdSink::Texture::kNearest);
-	mNormalMap->SetParameter(RenderCmdSink::Texture::kMagFilter, RenderCmdSink::Texture::kNearest);
-
-//	BoundsChanged();
 }
 
 void DrawTerrain::SetTestData(unsigned int width, unsigned int height)
@@ -69,6 +69,11 @@ public:
 	void SetLodFactor(float factor) {mLodFactor = factor;}
 	void SetPickingId(unsigned int id) {mPickingId = id;}
 
+	/// Calculate RGBA8 normal map from heightmap
+	/** Does not touch the GPU.
+		@param out Output buffer of width * height * 4 bytes. Alpha channel is left untouched. */
+	static void GenerateNormalMap(unsigned int width, unsigned int height, const float* data, float heightScale, float sampleDistanceX, float sampleDistanceY, uint8_t* out);
+
 protected:
 	void HandleExecute(Scope& scope) override;
 
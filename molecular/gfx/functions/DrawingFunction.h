@@ -27,7 +27,8 @@ SOFTWARE.
 #define MOLECLUAR_DRAWINGFUNCTION_H
 
 #include <molecular/gfx/RenderFunction.h>
-#include <molecular/util/IteratorAdapters.h>
+
+#include <vector>
 
 namespace molecular
 {
@@ -49,8 +50,10 @@ public:
 	bool BoundsChangedSince(int framecounter) const override {return mLastBoundsChange > framecounter;}
 
 protected:
-	/** The return value is usually ignored. */
-	RenderCmdSink::Program* PrepareProgram(const Scope& scope)
+	/** The return value is usually ignored.
+		@param screenFootprint Size on screen of what is drawn, in pixels, see
+			Variable::Apply(). 0 means unknown. */
+	RenderCmdSink::Program* PrepareProgram(const Scope& scope, float screenFootprint = 0.0f)
 	{
 		auto getArraySize = [&](Hash hash)
 		{
@@ -58,15 +61,15 @@ protected:
 			return scope.Get<Variable>(hash).GetArraySize();
 		};
 
-		auto scopeMap = scope.ToMap();
-		auto program = mProgramProvider.GetProgram(util::MakePairFirstIterator(scopeMap.begin()), util::MakePairFirstIterator(scopeMap.end()), getArraySize);
+		scope.GetKeys(mScopeKeys, mUnsetScopeKeys);
+		auto program = mProgramProvider.GetProgram(mScopeKeys.begin(), mScopeKeys.end(), getArraySize);
 		assert(program);
 		mRenderer.UseProgram(program);
 
 		for(auto input: program->GetInputs())
 		{
 			assert(scope.Has(input));
-			scope.Get<Variable>(input).Apply(program, input);
+			scope.Get<Variable>(input).Apply(program, input, screenFootprint);
 		}
 		return program;
 	}
@@ -76,6 +79,10 @@ protected:
 
 private:
 	int mLastBoundsChange = 0;
+
+	/// Kept between PrepareProgram() calls to avoid allocations
+	std::vector<Hash> mScopeKeys;
+	std::vector<Hash> mUnsetScopeKeys;
 };
 
 }
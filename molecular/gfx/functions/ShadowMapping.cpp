@@ -59,6 +59,9 @@ void ShadowMapping::HandleExecute(Scope& scope)
 		Uniform<Matrix4>& viewMatrix = shadowMappingScope.Bind<Uniform<Matrix4>>("viewMatrix"_H);
 		Uniform<Matrix4>& projMatrix = shadowMappingScope.Bind<Uniform<Matrix4>>("projectionMatrix"_H);
 
+		// Depth only, see CascadedShadowMapping:
+		shadowMappingScope.Unset("fragmentColor"_H);
+
 		if(scope.Has("lightDirection0"_H))
 		{
 			const Vector3 lightDirection0 = *scope.Get<Uniform<Vector3>>("lightDirection0"_H);
@@ -80,7 +83,7 @@ void ShadowMapping::HandleExecute(Scope& scope)
 		mRenderer.SetRasterizationState(false, RenderCmdSink::kFront);
 #endif
 		if(mCallee)
-			mCallee->Execute(scope);
+			mCallee->Execute(shadowMappingScope);
 
 #if !SHADOW_TEST
 		mRenderer.SetTarget(oldTarget);
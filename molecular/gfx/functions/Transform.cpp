@@ -36,10 +36,13 @@ void Transform::HandleExecute(Scope& scope)
 {
 	if(mCallee)
 	{
-		Uniform<Matrix4>& modelMatrix = scope.Bind<Uniform<Matrix4>>("modelMatrix"_H);
+		Matrix4 modelMatrix = mTransform;
+		if(scope.Has("modelMatrix"_H))
+			modelMatrix = *scope.Get<Uniform<Matrix4>>("modelMatrix"_H) * mTransform;
 
-		*modelMatrix *= mTransform;
-		mCallee->Execute(scope);
+		mScope.SetParent(scope);
+		mScope.Set("modelMatrix"_H, Uniform<Matrix4>(modelMatrix));
+		mCallee->Execute(mScope);
 	}
 }
 
@@ -59,6 +59,11 @@ protected:
 private:
 	Matrix4 mTransform;
 	int mBoundsChangedFramecounter;
+
+	/// Holds modelMatrix for the callee
+	/** Parent is set before each call, so binding the variable does not
+		allocate every frame. */
+	Scope mScope;
 };
 
 }
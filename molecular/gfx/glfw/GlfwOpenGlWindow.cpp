@@ -32,7 +32,7 @@ namespace molecular
 namespace gfx
 {
 
-GlfwOpenGlWindow::GlfwOpenGlWindow(const char* title)
+GlfwOpenGlWindow::GlfwOpenGlWindow(const char* title, bool visible)
 {
 	if(glfwInit() == GLFW_FALSE)
 	{
@@ -58,6 +58,7 @@ GlfwOpenGlWindow::GlfwOpenGlWindow(const char* title)
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_SRGB_CAPABLE, GL_TRUE);
+	glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
 	mWindow = glfwCreateWindow(1024, 768, title, nullptr, nullptr);
 	if(!mWindow)
@@ -37,7 +37,8 @@ namespace gfx
 class GlfwOpenGlWindow
 {
 public:
-	explicit GlfwOpenGlWindow(const char* title = "molecular");
+	/** @param visible Create hidden window for offscreen rendering if false. */
+	explicit GlfwOpenGlWindow(const char* title = "molecular", bool visible = true);
 
 	~GlfwOpenGlWindow();
 
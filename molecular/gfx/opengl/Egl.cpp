@@ -27,7 +27,7 @@ SOFTWARE.
 #include "Egl.h"
 #include <cassert>
 
-#if defined(OPENGL_ES3) && !defined(__APPLE__)
+#if (defined(OPENGL_ES3) || OpenGL_EGL_FOUND) && !defined(__APPLE__)
 #include <EGL/egl.h>
 
 namespace molecular
@@ -37,9 +37,11 @@ namespace gfx
 namespace Egl
 {
 ProcAddress GetProcAddress(const char* procname) {return eglGetProcAddress(procname);}
+bool IsContextCurrent() {return eglGetCurrentContext() != EGL_NO_CONTEXT;}
 }
 }
 }
 #else
 molecular::gfx::Egl::ProcAddress molecular::gfx::Egl::GetProcAddress(const char*) {assert(false); return nullptr;}
+bool molecular::gfx::Egl::IsContextCurrent() {return false;}
 #endif
@@ -37,6 +37,9 @@ namespace Egl
 {
 	typedef void (*ProcAddress)(void);
 	ProcAddress GetProcAddress(const char* procname);
+
+	/// Check if an EGL context is current on the calling thread
+	bool IsContextCurrent();
 }
 
 }
@@ -0,0 +1,247 @@
+/*	EglOffscreenContext.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "OpenGlPrerequisites.h"
+#include "EglOffscreenContext.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace molecular
+{
+namespace gfx
+{
+
+/// Check if extension is in space-separated extension string
+static bool HasExtension(const char* extensions, const char* extension)
+{
+	if(!extensions)
+		return false;
+	const size_t length = strlen(extension);
+	for(const char* it = strstr(extensions, extension); it; it = strstr(it + length, extension))
+	{
+		if((it == extensions || it[-1] == ' ') && (it[length] == ' ' || it[length] == 0))
+			return true;
+	}
+	return false;
+}
+
+static EGLDisplay GetDisplay()
+{
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if(HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless") && HasExtension(clientExtensions, "EGL_EXT_platform_base"))
+	{
+		auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+		if(getPlatformDisplay)
+		{
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			if(display != EGL_NO_DISPLAY)
+				return display;
+		}
+	}
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+EglOffscreenContext::EglOffscreenContext(int width, int height) :
+	mWidth(width),
+	mHeight(height)
+{
+	EGLDisplay display = GetDisplay();
+	if(display == EGL_NO_DISPLAY)
+		throw std::runtime_error("No EGL display available");
+
+	EGLint major = 0, minor = 0;
+	if(!eglInitialize(display, &major, &minor))
+		throw std::runtime_error("eglInitialize failed");
+	mDisplay = display;
+
+	try
+	{
+		Init();
+	}
+	catch(...)
+	{
+		// The destructor is not called if the constructor throws:
+		Release();
+		throw;
+	}
+}
+
+EglOffscreenContext::~EglOffscreenContext()
+{
+	Release();
+}
+
+util::IntVector4 EglOffscreenContext::GetViewport(int eye)
+{
+	assert(eye == 0);
+	static_cast<void>(eye);
+	return {0, 0, mWidth, mHeight};
+}
+
+intptr_t EglOffscreenContext::GetRenderTarget(int eye)
+{
+	assert(eye == 0);
+	static_cast<void>(eye);
+	return mFramebuffer;
+}
+
+void EglOffscreenContext::MakeCurrent()
+{
+	EGLSurface surface = mSurface ? mSurface : EGL_NO_SURFACE;
+	if(!eglMakeCurrent(mDisplay, surface, surface, mContext))
+		throw std::runtime_error("eglMakeCurrent failed");
+}
+
+void EglOffscreenContext::ReadPixels(void* out)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, out);
+}
+
+void EglOffscreenContext::Init()
+{
+	EGLDisplay display = mDisplay;
+
+#ifdef OPENGL_ES3
+	const EGLint renderableType = EGL_OPENGL_ES3_BIT;
+	const EGLenum api = EGL_OPENGL_ES_API;
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_NONE
+	};
+#else
+	const EGLint renderableType = EGL_OPENGL_BIT;
+	const EGLenum api = EGL_OPENGL_API;
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 2,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+#endif
+
+	if(!eglBindAPI(api))
+		throw std::runtime_error("eglBindAPI failed");
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_RENDERABLE_TYPE, renderableType,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint numConfigs = 0;
+	if(!eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) || numConfigs == 0)
+	{
+		// Surfaceless platforms may not offer pbuffer configs:
+		const EGLint surfacelessConfigAttributes[] = {
+			EGL_RENDERABLE_TYPE, renderableType,
+			EGL_NONE
+		};
+		if(!eglChooseConfig(display, surfacelessConfigAttributes, &config, 1, &numConfigs) || numConfigs == 0)
+			throw std::runtime_error("No suitable EGL config found");
+	}
+
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if(context == EGL_NO_CONTEXT)
+		throw std::runtime_error("eglCreateContext failed");
+	mContext = context;
+
+	const EGLint pbufferAttributes[] = {
+		EGL_WIDTH, mWidth,
+		EGL_HEIGHT, mHeight,
+		EGL_NONE
+	};
+	EGLSurface surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+	if(surface == EGL_NO_SURFACE)
+	{
+		if(!HasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+			throw std::runtime_error("Neither pbuffers nor surfaceless contexts supported");
+	}
+	else
+		mSurface = surface;
+
+	MakeCurrent();
+	if(!mSurface)
+		CreateFramebuffer();
+}
+
+void EglOffscreenContext::Release()
+{
+	// GL objects only exist if the context was made current:
+	if(mFramebuffer)
+		glDeleteFramebuffers(1, &mFramebuffer);
+	if(mDepthRenderbuffer)
+		glDeleteRenderbuffers(1, &mDepthRenderbuffer);
+	if(mColorRenderbuffer)
+		glDeleteRenderbuffers(1, &mColorRenderbuffer);
+	mFramebuffer = mDepthRenderbuffer = mColorRenderbuffer = 0;
+
+	if(mContext)
+	{
+		eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if(mSurface)
+			eglDestroySurface(mDisplay, mSurface);
+		eglDestroyContext(mDisplay, mContext);
+	}
+	if(mDisplay)
+		eglTerminate(mDisplay);
+	mSurface = mContext = mDisplay = nullptr;
+}
+
+void EglOffscreenContext::CreateFramebuffer()
+{
+	glGenRenderbuffers(1, &mColorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, mColorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, mWidth, mHeight);
+
+	glGenRenderbuffers(1, &mDepthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, mDepthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mWidth, mHeight);
+
+	glGenFramebuffers(1, &mFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColorRenderbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthRenderbuffer);
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw std::runtime_error("Offscreen framebuffer incomplete");
+}
+
+}
+}
@@ -0,0 +1,89 @@
+/*	EglOffscreenContext.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_GFX_EGLOFFSCREENCONTEXT_H
+#define MOLECULAR_GFX_EGLOFFSCREENCONTEXT_H
+
+#include <molecular/gfx/RenderContext.h>
+#include <molecular/util/NonCopyable.h>
+
+namespace molecular
+{
+namespace gfx
+{
+
+/// RenderContext without window system
+/** Uses EGL_MESA_platform_surfaceless where available, the default EGL display otherwise.
+	Renders to a pbuffer, or to a framebuffer object if the platform has no pbuffer support.
+	Works without X11 and without GPU, e.g. with Mesa llvmpipe. The context is current on the
+	constructing thread afterwards.
+
+	Construct before RenderCmdSink::Init() is called. Throws std::runtime_error on failure. */
+class EglOffscreenContext : public RenderContext, NonCopyable
+{
+public:
+	EglOffscreenContext(int width, int height);
+	~EglOffscreenContext() override;
+
+	util::IntVector4 GetViewport(int eye) override;
+	intptr_t GetRenderTarget(int eye) override;
+
+	/// Make context current on the calling thread
+	void MakeCurrent();
+
+	/// Wait for rendering to finish and read back RGBA8 image
+	/** @param out Buffer of at least width * height * 4 bytes. Lines are stored bottom-up. */
+	void ReadPixels(void* out);
+
+	int GetWidth() const {return mWidth;}
+	int GetHeight() const {return mHeight;}
+
+private:
+	/// Create context and surface on mDisplay
+	void Init();
+
+	/// Destroy everything created so far, also after Init() failed halfway
+	void Release();
+
+	void CreateFramebuffer();
+
+	// EGL handles, void* to keep EGL headers out of here:
+	void* mDisplay = nullptr;
+	void* mContext = nullptr;
+	void* mSurface = nullptr;
+
+	/// Default render target if there is no pbuffer, 0 otherwise
+	unsigned int mFramebuffer = 0;
+	unsigned int mColorRenderbuffer = 0;
+	unsigned int mDepthRenderbuffer = 0;
+
+	int mWidth;
+	int mHeight;
+};
+
+}
+}
+
+#endif // MOLECULAR_GFX_EGLOFFSCREENCONTEXT_H
@@ -29,6 +29,7 @@ SOFTWARE.
 
 #include <molecular/util/Logging.h>
 
+#include <algorithm>
 #include <cassert>
 #include <string>
 
@@ -41,6 +42,18 @@ using namespace std::string_literals;
 
 GlFunctions GlCommandSink::gl;
 GlCommandSink::GlslVersion GlCommandSink::glslVersion = GlCommandSink::GlslVersion::UNKNOWN;
+const size_t GlCommandSink::kPoolPageSize;
+const GLsizei GlCommandSink::kBufferNameBatch;
+
+GlCommandSink::~GlCommandSink()
+{
+	for(auto& page: mVertexPool)
+		delete page.buffer;
+	for(auto& page: mIndexPool)
+		delete page.buffer;
+	if(!mBufferNames.empty())
+		gl.DeleteBuffers(mBufferNames.size(), mBufferNames.data());
+}
 
 void GlCommandSink::Init()
 {
@@ -115,6 +128,14 @@ void GlCommandSink::VertexBuffer::Store(const void* data, size_t size, bool stre
 	CheckError("glBufferData", __LINE__, __FILE__);
 }
 
+void GlCommandSink::VertexBuffer::Store(size_t offset, const void* data, size_t size)
+{
+	gl.BindBuffer(gl.ARRAY_BUFFER, mBuffer);
+	CheckError("glBindBuffer", __LINE__, __FILE__);
+	gl.BufferSubData(gl.ARRAY_BUFFER, offset, size, data);
+	CheckError("glBufferSubData", __LINE__, __FILE__);
+}
+
 void GlCommandSink::IndexBuffer::Store(const void* data, size_t size)
 {
 	gl.BindBuffer(gl.ELEMENT_ARRAY_BUFFER, mBuffer);
@@ -123,6 +144,94 @@ void GlCommandSink::IndexBuffer::Store(const void* data, size_t size)
 	CheckError("glBufferData", __LINE__, __FILE__);
 }
 
+void GlCommandSink::IndexBuffer::Store(size_t offset, const void* data, size_t size)
+{
+	gl.BindBuffer(gl.ELEMENT_ARRAY_BUFFER, mBuffer);
+	CheckError("glBindBuffer", __LINE__, __FILE__);
+	gl.BufferSubData(gl.ELEMENT_ARRAY_BUFFER, offset, size, data);
+	CheckError("glBufferSubData", __LINE__, __FILE__);
+}
+
+GlCommandSink::BufferRange<GlCommandSink::VertexBuffer> GlCommandSink::StoreVertexData(const void* data, size_t size)
+{
+	return StoreInPool(mVertexPool, data, size);
+}
+
+void GlCommandSink::FreeVertexData(const BufferRange<VertexBuffer>& range)
+{
+	FreeInPool(mVertexPool, range);
+}
+
+GlCommandSink::BufferRange<GlCommandSink::IndexBuffer> GlCommandSink::StoreIndexData(const void* data, size_t size)
+{
+	return StoreInPool(mIndexPool, data, size);
+}
+
+void GlCommandSink::FreeIndexData(const BufferRange<IndexBuffer>& range)
+{
+	FreeInPool(mIndexPool, range);
+}
+
+GLuint GlCommandSink::GenBuffer()
+{
+	if(mBufferNames.empty())
+	{
+		mBufferNames.resize(kBufferNameBatch);
+		gl.GenBuffers(kBufferNameBatch, mBufferNames.data());
+		CheckError("glGenBuffers", __LINE__, __FILE__);
+	}
+	const GLuint name = mBufferNames.back();
+	mBufferNames.pop_back();
+	return name;
+}
+
+template<class TBuffer>
+GlCommandSink::BufferRange<TBuffer> GlCommandSink::StoreInPool(std::vector<PoolPage<TBuffer>>& pool, const void* data, size_t size)
+{
+	const size_t kAlignment = 16; // Enough for any attribute or index type
+	BufferRange<TBuffer> range;
+	for(auto& page: pool)
+	{
+		range.offset = page.allocator.Allocate(size, kAlignment);
+		if(range.offset != RangeAllocator::kInvalid)
+		{
+			range.buffer = page.buffer;
+			break;
+		}
+	}
+
+	if(!range.buffer)
+	{
+		const size_t capacity = std::max(size, kPoolPageSize);
+		pool.push_back(PoolPage<TBuffer>{new TBuffer(GenBuffer()), RangeAllocator(capacity)});
+		pool.back().buffer->Store(nullptr, capacity);
+		range.buffer = pool.back().buffer;
+		range.offset = pool.back().allocator.Allocate(size, kAlignment);
+	}
+	range.buffer->Store(range.offset, data, size);
+	return range;
+}
+
+template<class TBuffer>
+void GlCommandSink::FreeInPool(std::vector<PoolPage<TBuffer>>& pool, const BufferRange<TBuffer>& range)
+{
+	for(auto it = pool.begin(); it != pool.end(); ++it)
+	{
+		if(it->buffer != range.buffer)
+			continue;
+		it->allocator.Free(range.offset);
+
+		// Keep one regular page around to avoid reallocating it all the time:
+		if(it->allocator.IsEmpty() && (pool.size() > 1 || it->allocator.GetCapacity() != kPoolPageSize))
+		{
+			delete it->buffer;
+			pool.erase(it);
+		}
+		return;
+	}
+	LOG(ERROR) << "FreeInPool: Buffer not in pool";
+}
+
 GlCommandSink::Texture* GlCommandSink::CreateTexture() {return new Texture;}
 
 void GlCommandSink::DestroyTexture(Texture* texture) {delete texture;}
@@ -304,6 +413,7 @@ void GlCommandSink::SetRasterizationState(bool rasterizerDiscard, CullMode cullM
 	else
 		glDisable(gl.RASTERIZER_DISCARD);
 	glCullFace(cullMode);
+	mCullMode = cullMode;
 }
 
 void GlCommandSink::Draw(IndexBuffer* buffer, const IndexBufferInfo& info)
@@ -350,6 +460,31 @@ void GlCommandSink::Draw(IndexBuffer* buffer, const IndexBufferInfo& info)
 */
 }
 
+void GlCommandSink::Draw(IndexBuffer* buffer, const IndexBufferInfo& info, const uint32_t* offsets, const uint32_t* counts, unsigned int rangeCount)
+{
+	assert(buffer);
+	gl.BindBuffer(gl.ELEMENT_ARRAY_BUFFER, buffer->mBuffer);
+	CheckError("glBindBuffer", __LINE__, __FILE__);
+	if(gl.HasMultiDrawElements())
+	{
+		mMultiDrawCounts.resize(rangeCount);
+		mMultiDrawOffsets.resize(rangeCount);
+		for(unsigned int i = 0; i < rangeCount; ++i)
+		{
+			mMultiDrawCounts[i] = counts[i];
+			mMultiDrawOffsets[i] = reinterpret_cast<const GLvoid*>(uintptr_t(offsets[i]));
+		}
+		gl.MultiDrawElements(ToGlEnum(info.mode), mMultiDrawCounts.data(), ToGlEnum(info.type), mMultiDrawOffsets.data(), rangeCount);
+		CheckError("glMultiDrawElements", __LINE__, __FILE__);
+	}
+	else
+	{
+		for(unsigned int i = 0; i < rangeCount; ++i)
+			gl.DrawElements(ToGlEnum(info.mode), counts[i], ToGlEnum(info.type), reinterpret_cast<const GLvoid*>(uintptr_t(offsets[i])));
+		CheckError("glDrawElements", __LINE__, __FILE__);
+	}
+}
+
 void GlCommandSink::Draw(TransformFeedback* transformFeedback, IndexBufferInfo::Mode mode)
 {
 	if(gl.HasDrawTransformFeedback())
@@ -436,14 +571,24 @@ void GlCommandSink::Texture::Store(unsigned int width, unsigned int height, cons
 		// Uncompressed
 		GLenum glFormat = PixelFormatConversion::ToGlFormat(format);
 		GLenum type = PixelFormatConversion::ToGlType(format);
-		if(width == mWidth && height == mHeight && mDepth == 0 && data)
+		const bool levelStored = mipmapLevel < 32 && (mStoredLevels & (1u << mipmapLevel));
+		const bool sameSize = width == std::max(mWidth >> mipmapLevel, 1u) && height == std::max(mHeight >> mipmapLevel, 1u);
+		if(levelStored && sameSize && mDepth == 0 && data)
 			gl.TexSubImage2D(GL_TEXTURE_2D, mipmapLevel, 0, 0, width, height, glFormat, type, data);
 		else
 			gl.TexImage2D(GL_TEXTURE_2D, mipmapLevel, intFormat, width, height, 0, glFormat, type, data);
 		CheckError("glTexImage2D", __LINE__, __FILE__);
 	}
-	mWidth = width;
-	mHeight = height;
+	if(mDepth != 0 || (mipmapLevel == 0 && (width != mWidth || height != mHeight)))
+		mStoredLevels = 0; // Other levels belong to a previous image
+	if(mipmapLevel == 0 || !(mStoredLevels & 1u))
+	{
+		// Estimate level 0 size if only smaller levels are stored:
+		mWidth = width << mipmapLevel;
+		mHeight = height << mipmapLevel;
+	}
+	if(mipmapLevel < 32)
+		mStoredLevels |= 1u << mipmapLevel;
 	mDepth = 0;
 }
 
@@ -459,6 +604,7 @@ void GlCommandSink::Texture::Store(unsigned int width, unsigned int height, unsi
 	mWidth = width;
 	mHeight = height;
 	mDepth = depth;
+	mStoredLevels = 0;
 }
 
 void GlCommandSink::Texture::Store(unsigned int offsetX, unsigned int offsetY, unsigned int width, unsigned int height, const void* data, PixelFormat format, int mipmapLevel, size_t dataSize)
@@ -481,6 +627,16 @@ void GlCommandSink::Texture::Store(unsigned int offsetX, unsigned int offsetY, u
 	}
 }
 
+void GlCommandSink::Texture::ReleaseLevel(int mipmapLevel)
+{
+	gl.BindTexture(GL_TEXTURE_2D, mTexture);
+	CheckError("glBindTexture", __LINE__, __FILE__);
+	gl.TexImage2D(GL_TEXTURE_2D, mipmapLevel, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	CheckError("glTexImage2D", __LINE__, __FILE__);
+	if(mipmapLevel < 32)
+		mStoredLevels &= ~(1u << mipmapLevel);
+}
+
 void GlCommandSink::Texture::SetParameter(Parameter param, ParamValue value)
 {
 	if(mDepth > 0)
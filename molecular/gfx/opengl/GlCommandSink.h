@@ -33,6 +33,7 @@ SOFTWARE.
 #include <molecular/util/NonCopyable.h>
 #include <molecular/util/PixelFormat.h>
 #include <molecular/util/Logging.h>
+#include <molecular/util/RangeAllocator.h>
 #include "GlConstantString.h"
 #include <molecular/util/Vector.h>
 
@@ -66,6 +67,8 @@ private:
 	};
 
 public:
+	~GlCommandSink();
+
 	/// Initialise
 	/** This must be called in the renderer thread. */
 	void Init();
@@ -78,16 +81,14 @@ public:
 	public:
 		void Store(const void* data, size_t size, bool stream = false);
 
+		/// Update part of the stored data
+		void Store(size_t offset, const void* data, size_t size);
+
 	private:
 		VertexBuffer(GLuint buffer) : Buffer(buffer) {}
 	};
 
-	VertexBuffer* CreateVertexBuffer()
-	{
-		GLuint buffer;
-		gl.GenBuffers(1, &buffer);
-		return new VertexBuffer(buffer);
-	}
+	VertexBuffer* CreateVertexBuffer() {return new VertexBuffer(GenBuffer());}
 	void DestroyVertexBuffer(VertexBuffer* buffer) {delete buffer;}
 
 	/// Buffer storing index data
@@ -97,19 +98,47 @@ public:
 	public:
 		void Store(const void* data, size_t size);
 
+		/// Update part of the stored data
+		void Store(size_t offset, const void* data, size_t size);
+
 	private:
 		IndexBuffer(GLuint buffer) : Buffer(buffer) {}
 	};
 
 	/// Create IndexBuffer
-	IndexBuffer* CreateIndexBuffer()
-	{
-		GLuint buffer;
-		gl.GenBuffers(1, &buffer);
-		return new IndexBuffer(buffer);
-	}
+	IndexBuffer* CreateIndexBuffer() {return new IndexBuffer(GenBuffer());}
 	void DestroyIndexBuffer(IndexBuffer* buffer) {delete buffer;}
 
+	/// Part of a buffer shared with other data
+	/** @see StoreVertexData */
+	template<class TBuffer>
+	struct BufferRange
+	{
+		TBuffer* buffer = nullptr;
+
+		/// Start of the data in the buffer in bytes
+		size_t offset = 0;
+	};
+
+	/// Store vertex data in a pooled buffer
+	/** Data of many meshes shares a few large buffers, which saves buffer
+		objects and rebinds. Attribute offsets into the data have to be
+		shifted by the returned offset. Data larger than a pool page gets a
+		page of its own. Release with FreeVertexData(). */
+	BufferRange<VertexBuffer> StoreVertexData(const void* data, size_t size);
+
+	/// Release range returned by StoreVertexData()
+	/** Merges free space, empty pages are deleted. */
+	void FreeVertexData(const BufferRange<VertexBuffer>& range);
+
+	/// Store index data in a pooled buffer
+	/** Index buffer offsets into the data have to be shifted by the returned
+		offset. @see StoreVertexData */
+	BufferRange<IndexBuffer> StoreIndexData(const void* data, size_t size);
+
+	/// Release range returned by StoreIndexData()
+	void FreeIndexData(const BufferRange<IndexBuffer>& range);
+
 	class Texture;
 
 	Texture* CreateTexture();
@@ -161,6 +190,12 @@ public:
 		@see UseProgram */
 	void Draw(IndexBuffer* buffer, const IndexBufferInfo& info);
 
+	/// Draw multiple ranges of indices
+	/** Uses glMultiDrawElements if available.
+		@param offsets Byte offsets into the buffer.
+		@param counts Number of indices of each range. */
+	void Draw(IndexBuffer* buffer, const IndexBufferInfo& info, const uint32_t* offsets, const uint32_t* counts, unsigned int rangeCount);
+
 	void Draw(TransformFeedback* transformFeedback, IndexBufferInfo::Mode mode);
 
 	/// Draw vertices without indices
@@ -201,6 +236,9 @@ public:
 
 	void SetRasterizationState(bool rasterizerDiscard, CullMode cullMode = kBack);
 
+	/// Faces culled as set with SetRasterizationState()
+	CullMode GetCullMode() const {return mCullMode;}
+
 	static inline void CheckError(const char* function, int line, const char* file)
 	{
 #if 1 //ndef NDEBUG
@@ -226,6 +264,29 @@ public:
 	static GlslVersion glslVersion;
 
 private:
+	/// Large buffer sub-allocated by StoreVertexData() or StoreIndexData()
+	template<class TBuffer>
+	struct PoolPage
+	{
+		TBuffer* buffer;
+		RangeAllocator allocator;
+	};
+
+	/// Size of regular pool pages in bytes
+	static const size_t kPoolPageSize = 4 * 1024 * 1024;
+
+	/// Buffer names generated with one call, see GenBuffer()
+	static const GLsizei kBufferNameBatch = 32;
+
+	/// Buffer name from a batch generated in advance
+	GLuint GenBuffer();
+
+	template<class TBuffer>
+	BufferRange<TBuffer> StoreInPool(std::vector<PoolPage<TBuffer>>& pool, const void* data, size_t size);
+
+	template<class TBuffer>
+	void FreeInPool(std::vector<PoolPage<TBuffer>>& pool, const BufferRange<TBuffer>& range);
+
 	static GLenum ToGlEnum(VertexAttributeInfo::Type type);
 	static GLenum ToGlEnum(IndexBufferInfo::Type type);
 	static GLenum ToGlEnum(IndexBufferInfo::Mode mode);
@@ -233,6 +294,17 @@ private:
 	RenderTarget* mCurrentTarget = nullptr;
 	GLuint mBaseTargetFramebuffer = 0;
 	IntVector4 mBaseTargetViewport = {0, 0, 640, 480};
+	CullMode mCullMode = kBack;
+
+	/// Parameters for glMultiDrawElements, kept to avoid allocations
+	std::vector<GLsizei> mMultiDrawCounts;
+	std::vector<const GLvoid*> mMultiDrawOffsets;
+
+	/// Unused names from the last GenBuffers() call
+	std::vector<GLuint> mBufferNames;
+
+	std::vector<PoolPage<VertexBuffer>> mVertexPool;
+	std::vector<PoolPage<IndexBuffer>> mIndexPool;
 };
 
 /******************************* Nested classes ******************************/
@@ -254,6 +326,12 @@ public:
 
 	/// Updates a portion of the image
 	void Store(unsigned int offsetX, unsigned int offsetY, unsigned int width, unsigned int height, const void* data, PixelFormat format, int mipmapLevel = 0, size_t dataSize = 0);
+
+	/// Free memory of a mip level
+	/** The level must be outside of kBaseLevel and kMaxLevel afterwards,
+		otherwise the texture is incomplete. */
+	void ReleaseLevel(int mipmapLevel);
+
 	void GenerateMipmaps() {gl.BindTexture(GL_TEXTURE_2D, mTexture); gl.GenerateMipmap(GL_TEXTURE_2D);}
 
 	enum Parameter
@@ -292,12 +370,14 @@ public:
 	void SetParameter(Parameter param, ParamValue value);
 	void SetParameter(Parameter param, int value);
 
+	/// Width of mip level 0, even if only smaller levels were stored
 	unsigned int GetWidth() const {return mWidth;}
+	/// Height of mip level 0, even if only smaller levels were stored
 	unsigned int GetHeight() const {return mHeight;}
 	unsigned int GetDepth() const {return mDepth;}
 
 private:
-	Texture() : mWidth(0), mHeight(0), mDepth(0)
+	Texture() : mWidth(0), mHeight(0), mDepth(0), mStoredLevels(0)
 	{
 		gl.GenTextures(1, &mTexture);
 		GlCommandSink::CheckError("glGenTextures", __LINE__, __FILE__);
@@ -306,6 +386,9 @@ private:
 
 	GLuint mTexture;
 	unsigned int mWidth, mHeight, mDepth;
+
+	/// Bit mask of 2D mip levels with storage
+	uint32_t mStoredLevels;
 };
 
 /// Allows for rendering to textures
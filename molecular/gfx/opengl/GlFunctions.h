@@ -132,6 +132,7 @@ class GlFunctions :
 #else // Linux
 
 #include "Glx.h"
+#include "Egl.h"
 #include "GlFunctionsGles2Native.h"
 
 namespace molecular
@@ -139,16 +140,18 @@ namespace molecular
 namespace gfx
 {
 
+/** Uses EGL instead of GLX if an EGL context is current, e.g. an EglOffscreenContext. */
 struct GlFunctionsInitializerGlx
 {
 	template<class T>
 	static void Init(T& procAddress, const char* name, bool optional = false, const char* secondaryName = nullptr)
 	{
-		procAddress = T(Glx::GetProcAddress(name));
+		const bool egl = Egl::IsContextCurrent();
+		procAddress = T(egl ? Egl::GetProcAddress(name) : Glx::GetProcAddress(name));
 		if (!procAddress)
 		{
 			if (secondaryName)
-				procAddress = T(Glx::GetProcAddress(secondaryName));
+				procAddress = T(egl ? Egl::GetProcAddress(secondaryName) : Glx::GetProcAddress(secondaryName));
 			if (!procAddress && !optional)
 				throw std::runtime_error(std::string(name) + " not available");
 		}
@@ -48,6 +48,7 @@ public:
 	GLenum CheckFramebufferStatus(GLenum target) {return glCheckFramebufferStatus(target);}
 	void CompileShader(GLuint shader) {glCompileShader(shader);}
 	void BufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage) {glBufferData(target, size, data, usage);}
+	void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data) {glBufferSubData(target, offset, size, data);}
 	void CompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data) {glCompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);}
 	GLuint CreateProgram() {return glCreateProgram();}
 	GLuint CreateShader(GLenum type) {return glCreateShader(type);}
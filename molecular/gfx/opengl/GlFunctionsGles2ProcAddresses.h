@@ -55,6 +55,7 @@ public:
 	GLenum CheckFramebufferStatus(GLenum target) {return mCheckFramebufferStatus(target);}
 	void CompileShader(GLuint shader) {mCompileShader(shader);}
 	void BufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage) {mBufferData(target, size, data, usage);}
+	void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data) {mBufferSubData(target, offset, size, data);}
 	void CompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data) {mCompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);}
 	GLuint CreateProgram() {return mCreateProgram();}
 	GLuint CreateShader(GLenum type) {return mCreateShader(type);}
@@ -110,6 +111,7 @@ private:
 	using CheckFramebufferStatusType = GLenum (*)(GLenum target);
 	using CompileShaderType = void (*)(GLuint shader);
 	using BufferDataType = void (*)(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage);
+	using BufferSubDataType = void (*)(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data);
 	using CompressedTexImage2DType = void (*)(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data);
 	using CreateProgramType = GLuint (*)();
 	using CreateShaderType = GLuint (*)(GLenum type);
@@ -164,6 +166,7 @@ private:
 	CheckFramebufferStatusType mCheckFramebufferStatus = nullptr;
 	CompileShaderType mCompileShader = nullptr;
 	BufferDataType mBufferData = nullptr;
+	BufferSubDataType mBufferSubData = nullptr;
 	CompressedTexImage2DType mCompressedTexImage2D = nullptr;
 	CreateProgramType mCreateProgram = nullptr;
 	CreateShaderType mCreateShader = nullptr;
@@ -258,6 +261,7 @@ void GlFunctionsGles2ProcAddresses<TInitializer>::Init()
 	I::Init(mCheckFramebufferStatus, "glCheckFramebufferStatus");
 	I::Init(mCompileShader, "glCompileShader");
 	I::Init(mBufferData, "glBufferData");
+	I::Init(mBufferSubData, "glBufferSubData");
 	I::Init(mCompressedTexImage2D, "glCompressedTexImage2D");
 	I::Init(mCreateProgram, "glCreateProgram");
 	I::Init(mCreateShader, "glCreateShader");
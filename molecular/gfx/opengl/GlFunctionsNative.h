@@ -85,6 +85,7 @@ public:
 	inline void VertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer) { glVertexAttribIPointer(index, size, type, stride, pointer); }
 
 	inline void DrawTransformFeedback(GLenum mode, GLuint tf) { glDrawTransformFeedback(mode, tf); }
+	inline void MultiDrawElements(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount) { glMultiDrawElements(mode, count, type, indices, drawcount); }
 	inline void PrimitiveRestartIndex(GLuint index) { glPrimitiveRestartIndex(index); }
 
 	/** @todo Check on Apple GLES3 */
@@ -93,6 +94,9 @@ public:
 	/** @todo Check on Apple GLES3 */
 	bool HasDrawTransformFeedback() const { return true; }
 
+	/** @todo Check on Apple GLES3 */
+	bool HasMultiDrawElements() const { return true; }
+
 	/** @todo Check on Apple GLES3 */
 	bool HasPrimitiveRestartIndex() const { return true; }
 };
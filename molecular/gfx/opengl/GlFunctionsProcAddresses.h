@@ -94,10 +94,12 @@ public:
 
 	// Extensions:
 	inline void DrawTransformFeedback(GLenum mode, GLuint tf) {assert(mDrawTransformFeedback); mDrawTransformFeedback(mode, tf);}
+	inline void MultiDrawElements(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount) {assert(mMultiDrawElements); mMultiDrawElements(mode, count, type, indices, drawcount);}
 	inline void PrimitiveRestartIndex(GLuint index) {assert(mPrimitiveRestartIndex); mPrimitiveRestartIndex(index);}
 
 	bool HasBindFragDataLocation() { return mBindFragDataLocation != nullptr; }
 	bool HasDrawTransformFeedback() {return mDrawTransformFeedback != nullptr;}
+	bool HasMultiDrawElements() {return mMultiDrawElements != nullptr;}
 	bool HasPrimitiveRestartIndex() { return mPrimitiveRestartIndex != nullptr; }
 
 protected:
@@ -148,6 +150,7 @@ protected:
 
 	// Extensions:
 	typedef void (GL_APIENTRY *DrawTransformFeedbackType) (GLenum, GLuint);
+	using MultiDrawElementsType = void (GL_APIENTRY*)(GLenum, const GLsizei*, GLenum, const void* const*, GLsizei);
 	using PrimitiveRestartIndexType = void (GL_APIENTRY*)(GLuint);
 
 	BeginQueryType mBeginQuery = nullptr;
@@ -198,6 +201,7 @@ protected:
 
 	// Extensions:
 	DrawTransformFeedbackType mDrawTransformFeedback = nullptr;
+	MultiDrawElementsType mMultiDrawElements = nullptr;
 	PrimitiveRestartIndexType mPrimitiveRestartIndex = nullptr;
 };
 
@@ -253,6 +257,7 @@ void GlFunctionsProcAddresses<TInitializer>::Init()
 
 	// Extensions:
 	I::Init(mDrawTransformFeedback, "glDrawTransformFeedback", true);
+	I::Init(mMultiDrawElements, "glMultiDrawElements", true, "glMultiDrawElementsEXT");
 	I::Init(mPrimitiveRestartIndex, "glPrimitiveRestartIndex", true);
 }
 
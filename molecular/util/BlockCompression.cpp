@@ -0,0 +1,285 @@
+/*	BlockCompression.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace molecular
+{
+namespace util
+{
+namespace BlockCompression
+{
+
+namespace
+{
+
+const size_t kMinMatch = 4;
+const unsigned int kHashBits = 12;
+
+/// Inputs and sequences at the end are left as literals
+const size_t kLastLiterals = 5;
+
+inline uint32_t Read32(const uint8_t* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+inline uint32_t HashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+/// Write length beyond the 15 that fit into the token nibble
+inline uint8_t* WriteLengthExtension(uint8_t* op, size_t length)
+{
+	for(length -= 15; length >= 255; length -= 255)
+		*op++ = 255;
+	*op++ = uint8_t(length);
+	return op;
+}
+
+inline uint8_t* WriteSequence(uint8_t* op, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+	uint8_t* token = op++;
+	*token = uint8_t(std::min<size_t>(literalLength, 15) << 4);
+	if(literalLength >= 15)
+		op = WriteLengthExtension(op, literalLength);
+	memcpy(op, literals, literalLength);
+	op += literalLength;
+	if(matchLength == 0)
+		return op; // Last sequence
+
+	*op++ = uint8_t(offset);
+	*op++ = uint8_t(offset >> 8);
+	const size_t matchCode = matchLength - kMinMatch;
+	*token |= uint8_t(std::min<size_t>(matchCode, 15));
+	if(matchCode >= 15)
+		op = WriteLengthExtension(op, matchCode);
+	return op;
+}
+
+/// Read length extension bytes
+inline size_t ReadLengthExtension(const uint8_t*& ip, const uint8_t* end)
+{
+	size_t length = 0;
+	uint8_t byte;
+	do
+	{
+		if(ip >= end)
+			throw std::runtime_error("Compressed block truncated");
+		byte = *ip++;
+		length += byte;
+	}
+	while(byte == 255);
+	return length;
+}
+
+}
+
+size_t CompressBlock(const void* data, size_t size, void* out)
+{
+	const uint8_t* in = static_cast<const uint8_t*>(data);
+	uint8_t* op = static_cast<uint8_t*>(out);
+	size_t anchor = 0;
+
+	if(size > kLastLiterals + kMinMatch)
+	{
+		uint32_t table[1 << kHashBits] = {};
+		const size_t matchLimit = size - kLastLiterals;
+		size_t ip = 0;
+		while(ip + kMinMatch <= matchLimit)
+		{
+			const uint32_t sequence = Read32(in + ip);
+			uint32_t& slot = table[HashSequence(sequence)];
+			const size_t candidate = slot;
+			slot = uint32_t(ip);
+			if(candidate < ip && ip - candidate <= 0xffff && Read32(in + candidate) == sequence)
+			{
+				size_t matchLength = kMinMatch;
+				while(ip + matchLength < matchLimit && in[candidate + matchLength] == in[ip + matchLength])
+					++matchLength;
+				op = WriteSequence(op, in + anchor, ip - anchor, ip - candidate, matchLength);
+				ip += matchLength;
+				anchor = ip;
+			}
+			else
+				++ip;
+		}
+	}
+
+	op = WriteSequence(op, in + anchor, size - anchor, 0, 0);
+	return op - static_cast<uint8_t*>(out);
+}
+
+void DecompressBlock(const void* data, size_t size, void* out, size_t outSize)
+{
+	const uint8_t* ip = static_cast<const uint8_t*>(data);
+	const uint8_t* const inEnd = ip + size;
+	uint8_t* op = static_cast<uint8_t*>(out);
+	uint8_t* const outBegin = op;
+	uint8_t* const outEnd = op + outSize;
+
+	while(ip < inEnd)
+	{
+		const uint8_t token = *ip++;
+		size_t literalLength = token >> 4;
+		if(literalLength == 15)
+			literalLength += ReadLengthExtension(ip, inEnd);
+		if(literalLength > size_t(inEnd - ip) || literalLength > size_t(outEnd - op))
+			throw std::runtime_error("Compressed block literals out of bounds");
+		memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+		if(ip == inEnd)
+			break; // Last sequence has no match
+
+		if(inEnd - ip < 2)
+			throw std::runtime_error("Compressed block truncated");
+		const size_t offset = ip[0] | size_t(ip[1]) << 8;
+		ip += 2;
+		size_t matchLength = token & 15;
+		if(matchLength == 15)
+			matchLength += ReadLengthExtension(ip, inEnd);
+		matchLength += kMinMatch;
+		if(offset == 0 || offset > size_t(op - outBegin) || matchLength > size_t(outEnd - op))
+			throw std::runtime_error("Compressed block match out of bounds");
+
+		const uint8_t* match = op - offset;
+		if(offset >= matchLength)
+		{
+			memcpy(op, match, matchLength);
+			op += matchLength;
+		}
+		else
+		{
+			// Overlapping copy repeats the last offset bytes
+			for(size_t i = 0; i < matchLength; ++i)
+				*op++ = *match++;
+		}
+	}
+
+	if(op != outEnd)
+		throw std::runtime_error("Compressed block has wrong size");
+}
+
+std::vector<uint8_t> Compress(const void* data, size_t size, uint32_t blockSize)
+{
+	if(blockSize == 0)
+		throw std::runtime_error("Block size must not be zero");
+
+	const uint8_t* in = static_cast<const uint8_t*>(data);
+	const size_t blockCount = (size + blockSize - 1) / blockSize;
+	if(blockCount > 0xffffffff)
+		throw std::runtime_error("Too many blocks");
+	const size_t headerSize = sizeof(BlockCompressedFile) + blockCount * sizeof(uint32_t);
+	std::vector<uint8_t> output(headerSize);
+	std::vector<uint32_t> blockEnds(blockCount);
+	std::vector<uint8_t> blockBuffer(GetMaxCompressedBlockSize(blockSize));
+	for(size_t block = 0; block < blockCount; ++block)
+	{
+		const size_t begin = block * blockSize;
+		const size_t uncompressedSize = std::min<size_t>(blockSize, size - begin);
+		const size_t compressedSize = CompressBlock(in + begin, uncompressedSize, blockBuffer.data());
+		if(compressedSize < uncompressedSize)
+			output.insert(output.end(), blockBuffer.data(), blockBuffer.data() + compressedSize);
+		else
+			output.insert(output.end(), in + begin, in + begin + uncompressedSize); // Store raw
+		if(output.size() - headerSize > 0xffffffff)
+			throw std::runtime_error("Compressed data too large");
+		blockEnds[block] = uint32_t(output.size() - headerSize);
+	}
+
+	BlockCompressedFile header;
+	header.magic = BlockCompressedFile::kMagic;
+	header.blockSize = blockSize;
+	header.blockCount = uint32_t(blockCount);
+	header.reserved = 0;
+	header.size = size;
+	memcpy(output.data(), &header, sizeof(header));
+	if(blockCount > 0)
+		memcpy(output.data() + sizeof(header), blockEnds.data(), blockCount * sizeof(uint32_t));
+	return output;
+}
+
+bool IsCompressed(const void* data, size_t size)
+{
+	return size >= sizeof(BlockCompressedFile) && Read32(static_cast<const uint8_t*>(data)) == BlockCompressedFile::kMagic;
+}
+
+const BlockCompressedFile& GetHeader(const void* data, size_t size)
+{
+	if(!IsCompressed(data, size))
+		throw std::runtime_error("Not a block compressed file");
+	const BlockCompressedFile& file = *static_cast<const BlockCompressedFile*>(data);
+	if(file.blockSize == 0)
+		throw std::runtime_error("Block size is zero");
+	if((file.size + file.blockSize - 1) / file.blockSize != file.blockCount)
+		throw std::runtime_error("Block count does not match size");
+
+	const size_t headerSize = sizeof(BlockCompressedFile) + size_t(file.blockCount) * sizeof(uint32_t);
+	if(headerSize > size)
+		throw std::runtime_error("Block table exceeds file size");
+	uint32_t previousEnd = 0;
+	for(uint32_t i = 0; i < file.blockCount; ++i)
+	{
+		if(file.blockEnds[i] < previousEnd)
+			throw std::runtime_error("Block table not ascending");
+		previousEnd = file.blockEnds[i];
+	}
+	if(headerSize + previousEnd > size)
+		throw std::runtime_error("Blocks exceed file size");
+	return file;
+}
+
+void DecompressBlock(const BlockCompressedFile& file, uint32_t block, void* out)
+{
+	const uint8_t* blocks = reinterpret_cast<const uint8_t*>(file.blockEnds + file.blockCount);
+	const uint32_t begin = block == 0 ? 0 : file.blockEnds[block - 1];
+	const uint32_t compressedSize = file.blockEnds[block] - begin;
+	const uint64_t outOffset = uint64_t(block) * file.blockSize;
+	const size_t uncompressedSize = size_t(std::min<uint64_t>(file.blockSize, file.size - outOffset));
+	uint8_t* output = static_cast<uint8_t*>(out) + outOffset;
+	if(compressedSize == uncompressedSize)
+		memcpy(output, blocks + begin, uncompressedSize);
+	else
+		DecompressBlock(blocks + begin, compressedSize, output, uncompressedSize);
+}
+
+void Decompress(const void* data, size_t size, void* out)
+{
+	const BlockCompressedFile& file = GetHeader(data, size);
+	for(uint32_t i = 0; i < file.blockCount; ++i)
+		DecompressBlock(file, i, out);
+}
+
+}
+}
+}
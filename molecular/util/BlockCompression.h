@@ -0,0 +1,103 @@
+/*	BlockCompression.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_BLOCKCOMPRESSION_H
+#define MOLECULAR_BLOCKCOMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace molecular
+{
+namespace util
+{
+
+/// Header of a file compressed with BlockCompression::Compress()
+/** Followed by blockCount block end offsets, then the compressed blocks.
+	Each block decompresses to blockSize bytes, except for the last one.
+	Blocks are independent of each other, so they can be decompressed in
+	parallel. A block whose compressed size equals its uncompressed size is
+	stored raw. */
+struct BlockCompressedFile
+{
+	const static uint32_t kMagic = 0xb10c1200;
+	uint32_t magic;
+	uint32_t blockSize;
+	uint32_t blockCount;
+	uint32_t reserved;
+	uint64_t size; ///< Uncompressed size
+	uint32_t blockEnds[0]; ///< Relative to the end of this array
+};
+static_assert(sizeof(BlockCompressedFile) == 24, "Unexpected size of BlockCompressedFile");
+
+/// LZ77 compression in independent blocks
+/** The block format is byte oriented and similar to LZ4: Each sequence
+	consists of a token with literal and match length nibbles, optional
+	length extension bytes, the literals and a 16 bit match offset. Favours
+	decompression speed over ratio. */
+namespace BlockCompression
+{
+
+const uint32_t kDefaultBlockSize = 64 * 1024;
+
+/// Upper bound of the output of CompressBlock()
+inline size_t GetMaxCompressedBlockSize(size_t size) {return size + size / 255 + 16;}
+
+/// Compress single block
+/** @param out Buffer of at least GetMaxCompressedBlockSize(size) bytes.
+	@returns Compressed size. */
+size_t CompressBlock(const void* data, size_t size, void* out);
+
+/// Decompress single block
+/** Throws std::runtime_error if the input is corrupt or does not decompress
+	to exactly outSize bytes. */
+void DecompressBlock(const void* data, size_t size, void* out, size_t outSize);
+
+/// Compress data to a BlockCompressedFile
+std::vector<uint8_t> Compress(const void* data, size_t size, uint32_t blockSize = kDefaultBlockSize);
+
+/// Checks if data starts with a BlockCompressedFile header
+bool IsCompressed(const void* data, size_t size);
+
+/// Validate BlockCompressedFile and get its header
+/** Throws std::runtime_error if the header or block table is corrupt. */
+const BlockCompressedFile& GetHeader(const void* data, size_t size);
+
+/// Decompress one block of a BlockCompressedFile
+/** Safe to call concurrently for different blocks.
+	@param out Output buffer for the whole file. */
+void DecompressBlock(const BlockCompressedFile& file, uint32_t block, void* out);
+
+/// Decompress all blocks of a BlockCompressedFile in the calling thread
+/** @param out Buffer of GetHeader(data, size).size bytes. */
+void Decompress(const void* data, size_t size, void* out);
+
+}
+
+}
+}
+
+#endif // MOLECULAR_BLOCKCOMPRESSION_H
@@ -28,30 +28,64 @@ SOFTWARE.
 
 #include <molecular/Config.h>
 #include <molecular/util/Blob.h>
+#include <molecular/util/BlobFunctionTask.h>
+#include <molecular/util/BlockCompression.h>
 #include <molecular/util/FileStreamStorage.h>
 #include <molecular/util/SyncFileLoad.h>
 #include <molecular/util/StringStore.h>
 #include <molecular/util/Hash.h>
+#include <molecular/util/MappedFile.h>
 #include <molecular/util/PackageFile.h>
 #include <molecular/util/Logging.h>
 #include <molecular/util/StringUtils.h>
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
 #include <functional>
 #include <cassert>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace molecular
 {
 namespace util
 {
 
+/// Single FileLoader request covering one or more files of a batch read
+/** @see FileServer::PlanReads() */
+struct CoalescedRead
+{
+	/// Part of the read that belongs to one requested file
+	struct Part
+	{
+		size_t index; ///< Index in the list of requested files
+		size_t offset; ///< Offset relative to the start of the read
+		size_t size; ///< Unused with wholeFile
+	};
+
+	std::string path;
+	size_t offset;
+	size_t size; ///< Unused with wholeFile. Zero for empty package entries
+	std::vector<Part> parts;
+	bool mayBeCompressed; ///< Parts may be BlockCompressedFiles
+	bool wholeFile; ///< Plain file, read entirely
+};
+
 /** Supports PAK-like archive files and plain files. */
 template<class TFileLoader>
 class FileServer
 {
 public:
 	static const size_t kMaxPathLength = 256;
+	/// Default for the largest gap between package entries that are read at once
+	static const size_t kDefaultMaxReadGap = 64 * 1024;
+	/// Default for the largest single read issued by ReadFiles()
+	static const size_t kDefaultMaxReadSize = 4 * 1024 * 1024;
+	/// Least number of uncompressed bytes per parallel decompression task
+	static const uint32_t kMinDecompressionTaskSize = 256 * 1024;
 
 	using FileLoader = TFileLoader;
 
@@ -62,8 +96,11 @@ public:
 	{
 		try
 		{
-			Blob contentsFile = SyncFileLoad((mRoot + "contents.mss").c_str(), fileLoader, backgroundQueue);
-			mDirectoryContents.LoadFromFile(contentsFile.GetData(), contentsFile.GetSize());
+			if(!MapDirectoryContents())
+			{
+				Blob contentsFile = SyncFileLoad((mRoot + "contents.mss").c_str(), fileLoader, backgroundQueue);
+				mDirectoryContents.LoadFromFile(contentsFile.GetData(), contentsFile.GetSize());
+			}
 		}
 		catch(std::exception&)
 		{
@@ -81,21 +118,55 @@ public:
 		}
 	}
 
+	/// Index contents of a package file
+	/** The package file gets memory-mapped if possible, so MapFile() can hand
+		out its contents without copying. Otherwise, header and entries are
+		read through the FileLoader. */
 	template<class TQueue>
 	void AddPackageFile(const std::string& path, TQueue& backgroundQueue)
 	{
+		std::unique_ptr<MappedFile> mapping;
+		try
+		{
+			mapping.reset(new MappedFile(path.c_str()));
+		}
+		catch(std::exception& e)
+		{
+			LOG(WARNING) << e.what() << ", reading package file through the file loader";
+		}
+
 		try
 		{
-			const size_t headerSize = sizeof(PackageFile);
+			if(mapping)
+			{
+				mPackageFileDirectory.AddMappedFile(path, *mapping);
+				// Entries are requested in no particular order, so avoid large readahead:
+				mapping->Advise(MappedFile::Advice::kRandom);
+				mMappedPackageFiles.push_back(std::move(mapping));
+				LOG(INFO) << "Package file " << path << " mapped.";
+				return;
+			}
+
+			const size_t headerSize = sizeof(HashedPackageFile);
 			Blob headerData = SyncFileLoad(path.c_str(), mFileLoader, backgroundQueue, 0, headerSize);
 			const PackageFile* header = static_cast<const PackageFile*>(headerData.GetData());
-			if(header->magic != PackageFile::kMagic)
+			size_t entriesOffset = sizeof(PackageFile);
+			size_t numEntries = header->count;
+			uint32_t flags = 0;
+			if(header->magic == HashedPackageFile::kMagic)
+			{
+				const HashedPackageFile* hashedHeader = static_cast<const HashedPackageFile*>(headerData.GetData());
+				entriesOffset = sizeof(HashedPackageFile);
+				numEntries = hashedHeader->tableSize;
+				flags = hashedHeader->flags;
+			}
+			else if(header->magic != PackageFile::kMagic)
 				throw std::runtime_error("File is not a package file.");
-			const size_t entriesSize = header->count * sizeof(PackageFile::Entry);
-			Blob entryData = SyncFileLoad(path.c_str(), mFileLoader, backgroundQueue, headerSize, entriesSize);
+			const size_t entriesSize = numEntries * sizeof(PackageFile::Entry);
+			Blob entryData = SyncFileLoad(path.c_str(), mFileLoader, backgroundQueue, entriesOffset, entriesSize);
 			const PackageFile::Entry* entriesBegin = static_cast<const PackageFile::Entry*>(entryData.GetData());
-			mPackageFileDirectory.Populate(path, entriesBegin, entriesBegin + header->count);
-			LOG(INFO) << "Package file " + path + " loaded. " << header->count << " files.";
+			mPackageFileDirectory.Populate(path, entriesBegin, entriesBegin + numEntries, nullptr, flags);
+			LOG(INFO) << "Package file " << path << " loaded. " << header->count << " files.";
 		}
 		catch(std::exception& e)
 		{
@@ -114,10 +185,23 @@ public:
 		mDirectoryContents.LoadFromText(files.data(), files.size());
 	}
 
+	/// Decompress compressed package entries on this queue
+	/** Blocks of compressed entries read with ReadFile() without FinishFlag
+		are decompressed in parallel on this queue before the handler gets
+		called. Otherwise, and without a decompression queue, entries are
+		decompressed in the thread that calls the handler. The queue must
+		outlive this FileServer. */
+	template<class TQueue>
+	void SetDecompressionQueue(TQueue& queue)
+	{
+		mEnqueueDecompression = [&queue](std::function<void ()>&& task){queue.EnqueueTask(std::move(task));};
+	}
+
 	/// Read entire file and pass contents to handler
 	/** Without FinishFlag.
 		@param file Path to file
-		@param handler Function to call when file is loaded.
+		@param handler Function to call when file is loaded. Gets an empty
+			Blob if a package entry cannot be decompressed.
 		@param handlerQueue Queue to run handler in. */
 	template<class TQueue>
 	void ReadFile(
@@ -125,9 +209,19 @@ public:
 			std::function<void (Blob&)> handler,
 			TQueue& handlerQueue) const
 	{
-		char path[kMaxPathLength];
+		char pathBuffer[kMaxPathLength];
 		size_t offset = 0, size = 0;
-		GetFileLocation(file, path, offset, size);
+		bool mayBeCompressed = false;
+		const char* path = GetFileLocation(file, pathBuffer, offset, size, mayBeCompressed);
+		if(path != pathBuffer && size == 0)
+		{
+			// Empty package entry, a FileLoader would read the whole package
+			Blob empty;
+			handlerQueue.EnqueueTask(new BlobFunctionTask<TQueue>(handler, empty));
+			return;
+		}
+		if(mayBeCompressed)
+			handler = MakeDecompressingHandler(std::move(handler), handlerQueue);
 		mFileLoader.ReadFile(path, handler, handlerQueue, offset, size);
 	}
 
@@ -143,37 +237,444 @@ public:
 			TQueue& handlerQueue,
 			typename TQueue::FinishFlag& finishFlag) const
 	{
-		char path[kMaxPathLength];
+		char pathBuffer[kMaxPathLength];
 		size_t offset = 0, size = 0;
-		GetFileLocation(file, path, offset, size);
+		bool mayBeCompressed = false;
+		const char* path = GetFileLocation(file, pathBuffer, offset, size, mayBeCompressed);
+		if(path != pathBuffer && size == 0)
+		{
+			Blob empty;
+			handlerQueue.EnqueueTask(new BlobFunctionTask<TQueue>(handler, empty), finishFlag);
+			return;
+		}
+		if(mayBeCompressed)
+		{
+			// The finish flag must cover decompression, so no parallel tasks here
+			handler = [handler](Blob& blob){DecompressOrClear(blob); handler(blob);};
+		}
 		mFileLoader.ReadFile(path, handler, handlerQueue, finishFlag, offset, size);
 	}
 
 	template<class TQueue>
 	Blob ReadFileSync(Hash file, TQueue& backgroundQueue) const
 	{
-		char path[kMaxPathLength];
+		char pathBuffer[kMaxPathLength];
 		size_t offset = 0, size = 0;
-		GetFileLocation(file, path, offset, size);
-		return SyncFileLoad(path, mFileLoader, backgroundQueue, offset, size);
+		bool mayBeCompressed = false;
+		const char* path = GetFileLocation(file, pathBuffer, offset, size, mayBeCompressed);
+		if(path != pathBuffer && size == 0)
+			return Blob(); // Empty package entry
+		Blob blob = SyncFileLoad(path, mFileLoader, backgroundQueue, offset, size);
+		if(mayBeCompressed)
+			DecompressIfCompressed(blob);
+		return blob;
+	}
+
+	/// Get size of a file
+	/** Plain files are looked up in the file system.
+		@returns false if the size is not known without reading the file,
+			which is the case for package entries that may be compressed.
+			Throws if the file does not exist. */
+	bool GetFileSize(Hash file, size_t& outSize) const
+	{
+		char pathBuffer[kMaxPathLength];
+		size_t offset = 0, size = 0;
+		bool mayBeCompressed = false;
+		const char* path = GetFileLocation(file, pathBuffer, offset, size, mayBeCompressed);
+		if(mayBeCompressed)
+			return false;
+		if(path == pathBuffer)
+			size = FileReadStorage(path).GetSize();
+		outSize = size;
+		return true;
+	}
+
+	/// Read part of a file and pass it to handler
+	/** Package entries that may be compressed are read and decompressed
+		completely before the part is cut out. The handler gets an empty Blob
+		if the range exceeds the decompressed file or decompression fails.
+		@param size Number of bytes to read, must not be zero. */
+	template<class TQueue>
+	void ReadFileRange(
+			Hash file,
+			size_t offset,
+			size_t size,
+			std::function<void (Blob&)> handler,
+			TQueue& handlerQueue) const
+	{
+		assert(size > 0);
+		char pathBuffer[kMaxPathLength];
+		size_t fileOffset = 0, fileSize = 0;
+		bool mayBeCompressed = false;
+		const char* path = GetFileLocation(file, pathBuffer, fileOffset, fileSize, mayBeCompressed);
+		if(mayBeCompressed)
+		{
+			auto extract = [handler, offset, size](Blob& blob)
+			{
+				DecompressOrClear(blob);
+				Blob part;
+				if(offset + size <= blob.GetSize())
+				{
+					part = Blob(size);
+					memcpy(part.GetData(), static_cast<const uint8_t*>(blob.GetData()) + offset, size);
+				}
+				handler(part);
+			};
+			mFileLoader.ReadFile(path, extract, handlerQueue, fileOffset, fileSize);
+		}
+		else
+		{
+			if(path != pathBuffer && offset + size > fileSize)
+				throw std::runtime_error("Range exceeds package file entry");
+			mFileLoader.ReadFile(path, handler, handlerQueue, fileOffset + offset, size);
+		}
+	}
+
+	/// Get file contents from a memory-mapped package file without copying
+	/** Starts readahead of the file's pages. The data stays valid as long as
+		this FileServer exists.
+		@returns nullptr if the file is not part of a memory-mapped package
+			file or is compressed. */
+	const void* MapFile(Hash file, size_t& outSize) const
+	{
+		if(mDirectoryContents.FindString(file))
+			return nullptr; // Plain files take precedence, see GetFileLocation()
+
+		PackageFileDirectory::Entry entry;
+		if(!mPackageFileDirectory.FindEntry(file, entry) || !entry.mapping)
+			return nullptr;
+
+		const uint8_t* data = static_cast<const uint8_t*>(entry.mapping->GetData()) + entry.offset;
+		if(entry.mayBeCompressed && BlockCompression::IsCompressed(data, entry.size))
+			return nullptr;
+
+		entry.mapping->Advise(MappedFile::Advice::kWillNeed, entry.offset, entry.size);
+		outSize = entry.size;
+		return data;
+	}
+
+	/// Read many files with as few FileLoader requests as possible
+	/** Entries of the same package file are sorted by offset and merged into
+		larger sequential reads, see PlanReads(). The results are then split
+		into one Blob per file. Throws before issuing any read if one of the
+		files does not exist. Compressed package entries are decompressed in
+		handlerQueue.
+		@param handler Called in handlerQueue with the index of the file in
+			files and its contents. Called for every file, with an empty Blob
+			if its data could not be read or decompressed. */
+	template<class TQueue>
+	void ReadFiles(
+			const Hash* files,
+			size_t count,
+			std::function<void (size_t, Blob&)> handler,
+			TQueue& handlerQueue,
+			size_t maxGap = kDefaultMaxReadGap,
+			size_t maxReadSize = kDefaultMaxReadSize) const
+	{
+		for(auto& read: PlanReads(files, count, maxGap, maxReadSize))
+		{
+			auto splitHandler = MakeSplitHandler(std::move(read.parts), handler, read.mayBeCompressed, read.wholeFile);
+			if(IsEmptyRead(read))
+			{
+				Blob empty;
+				handlerQueue.EnqueueTask(new BlobFunctionTask<TQueue>(splitHandler, empty));
+			}
+			else
+				mFileLoader.ReadFile(read.path.c_str(), splitHandler, handlerQueue, read.offset, read.size);
+		}
+	}
+
+	/// Read many files with as few FileLoader requests as possible
+	/** With FinishFlag. The flag is passed to every FileLoader request. */
+	template<class TQueue>
+	void ReadFiles(
+			const Hash* files,
+			size_t count,
+			std::function<void (size_t, Blob&)> handler,
+			TQueue& handlerQueue,
+			typename TQueue::FinishFlag& finishFlag,
+			size_t maxGap = kDefaultMaxReadGap,
+			size_t maxReadSize = kDefaultMaxReadSize) const
+	{
+		for(auto& read: PlanReads(files, count, maxGap, maxReadSize))
+		{
+			auto splitHandler = MakeSplitHandler(std::move(read.parts), handler, read.mayBeCompressed, read.wholeFile);
+			if(IsEmptyRead(read))
+			{
+				Blob empty;
+				handlerQueue.EnqueueTask(new BlobFunctionTask<TQueue>(splitHandler, empty), finishFlag);
+			}
+			else
+				mFileLoader.ReadFile(read.path.c_str(), splitHandler, handlerQueue, finishFlag, read.offset, read.size);
+		}
+	}
+
+	/// Group files into FileLoader requests
+	/** Package entries of the same package file whose gap is at most maxGap
+		bytes are merged, as long as the merged read does not exceed
+		maxReadSize. Bytes in gaps are read and discarded, which is cheaper
+		than an additional seek on spinning disks and network storage. Plain
+		files always get a read of their own. Reads of empty package entries
+		have size zero and are not passed to the FileLoader, which would read
+		the whole package file.
+		@returns Reads ordered by package file and offset, preceded by reads
+			of plain files. */
+	std::vector<CoalescedRead> PlanReads(const Hash* files, size_t count, size_t maxGap = kDefaultMaxReadGap, size_t maxReadSize = kDefaultMaxReadSize) const
+	{
+		struct Location
+		{
+			const char* package;
+			size_t offset;
+			size_t size;
+			size_t index;
+			bool mayBeCompressed;
+		};
+
+		std::vector<CoalescedRead> reads;
+		std::vector<Location> packaged;
+		packaged.reserve(count);
+		char pathBuffer[kMaxPathLength];
+		for(size_t i = 0; i < count; ++i)
+		{
+			size_t offset = 0, size = 0;
+			bool mayBeCompressed = false;
+			const char* path = GetFileLocation(files[i], pathBuffer, offset, size, mayBeCompressed);
+			if(path == pathBuffer)
+				reads.push_back(CoalescedRead{path, 0, 0, {CoalescedRead::Part{i, 0, 0}}, false, true});
+			else
+				packaged.push_back(Location{path, offset, size, i, mayBeCompressed});
+		}
+
+		// Paths of package entries point into PackageFileDirectory, so equal
+		// packages have equal pointers:
+		std::sort(packaged.begin(), packaged.end(), [](const Location& a, const Location& b){
+			return std::less<const char*>()(a.package, b.package) || (a.package == b.package && a.offset < b.offset);
+		});
+
+		const char* currentPackage = nullptr;
+		for(auto& location: packaged)
+		{
+			if(location.package == currentPackage)
+			{
+				CoalescedRead& read = reads.back();
+				const size_t readEnd = read.offset + read.size;
+				const size_t newEnd = location.size > 0 ? std::max(readEnd, location.offset + location.size) : readEnd;
+				if(location.offset <= readEnd + maxGap && newEnd - read.offset <= maxReadSize)
+				{
+					read.size = newEnd - read.offset;
+					read.parts.push_back(CoalescedRead::Part{location.index, location.offset - read.offset, location.size});
+					continue;
+				}
+			}
+			currentPackage = location.package;
+			reads.push_back(CoalescedRead{location.package, location.offset, location.size, {CoalescedRead::Part{location.index, 0, location.size}}, location.mayBeCompressed, false});
+		}
+		return reads;
 	}
 
 
 private:
-	void GetFileLocation(Hash file, char outPath[kMaxPathLength], size_t& outOffset, size_t& outSize) const
+	/// Use contents.mss in place if it is in the perfect hash format
+	/** @returns false if the file is in another format or cannot be mapped. */
+	bool MapDirectoryContents()
+	{
+		try
+		{
+			std::unique_ptr<MappedFile> mapping(new MappedFile((mRoot + "contents.mss").c_str()));
+			const void* data = mapping->GetData();
+			const size_t size = mapping->GetSize();
+			if(size < sizeof(uint32_t) || *static_cast<const uint32_t*>(data) != PerfectHashStringStoreFile::kMagic)
+				return false;
+			mDirectoryContents.LoadFromMappedFile(data, size);
+			mContentsMapping = std::move(mapping);
+			return true;
+		}
+		catch(std::exception&)
+		{
+			return false;
+		}
+	}
+
+	/// Read of package entries that are all empty
+	/** A FileLoader would read the whole package file for a size of zero. */
+	static bool IsEmptyRead(const CoalescedRead& read)
+	{
+		return !read.wholeFile && read.size == 0;
+	}
+
+	/// Create FileLoader handler that splits a coalesced read into files
+	static std::function<void (Blob&)> MakeSplitHandler(std::vector<CoalescedRead::Part> parts, std::function<void (size_t, Blob&)> handler, bool mayBeCompressed, bool wholeFile)
+	{
+		return [parts, handler, mayBeCompressed, wholeFile](Blob& blob)
+		{
+			if(parts.size() == 1 && parts.front().offset == 0 && (wholeFile || parts.front().size == blob.GetSize()))
+			{
+				// Nothing to split
+				if(mayBeCompressed)
+					DecompressOrClear(blob);
+				handler(parts.front().index, blob);
+				return;
+			}
+
+			const uint8_t* data = static_cast<const uint8_t*>(blob.GetData());
+			for(auto& part: parts)
+			{
+				// Every file gets its handler called, empty if its data is missing:
+				Blob fileBlob;
+				if(part.size > 0 && part.offset + part.size <= blob.GetSize())
+				{
+					fileBlob = Blob(part.size);
+					memcpy(fileBlob.GetData(), data + part.offset, part.size);
+					if(mayBeCompressed)
+						DecompressOrClear(fileBlob);
+				}
+				else if(part.size > 0)
+					LOG(ERROR) << "Coalesced read returned less data than requested";
+				handler(part.index, fileBlob);
+			}
+		};
+	}
+
+	/// Replace BlockCompressedFile contents with decompressed data
+	static void DecompressIfCompressed(Blob& blob)
+	{
+		if(!BlockCompression::IsCompressed(blob.GetData(), blob.GetSize()))
+			return;
+		Blob output(size_t(BlockCompression::GetHeader(blob.GetData(), blob.GetSize()).size));
+		BlockCompression::Decompress(blob.GetData(), blob.GetSize(), output.GetData());
+		blob = std::move(output);
+	}
+
+	/// DecompressIfCompressed(), but empty the Blob instead of throwing
+	/** For handlers, which are called even if decompression fails. */
+	static void DecompressOrClear(Blob& blob)
+	{
+		try
+		{
+			DecompressIfCompressed(blob);
+		}
+		catch(std::exception& e)
+		{
+			LOG(ERROR) << "Decompression failed: " << e.what();
+			blob = Blob();
+		}
+	}
+
+	/// Wrap handler to decompress BlockCompressedFiles before calling it
+	/** Decompresses in parallel if there is a decompression queue. */
+	template<class TQueue>
+	std::function<void (Blob&)> MakeDecompressingHandler(std::function<void (Blob&)> handler, TQueue& handlerQueue) const
+	{
+		auto enqueue = mEnqueueDecompression;
+		return [handler, &handlerQueue, enqueue](Blob& blob)
+		{
+			if(!BlockCompression::IsCompressed(blob.GetData(), blob.GetSize()))
+				handler(blob);
+			else if(!enqueue)
+			{
+				DecompressOrClear(blob);
+				handler(blob);
+			}
+			else
+				DecompressInParallel(std::move(blob), handler, handlerQueue, enqueue);
+		};
+	}
+
+	/// Decompress blocks on the decompression queue, then call handler in handlerQueue
+	/** The handler gets an empty Blob if decompression fails. */
+	template<class TQueue>
+	static void DecompressInParallel(Blob&& input, const std::function<void (Blob&)>& handler, TQueue& handlerQueue, const std::function<void (std::function<void ()>&&)>& enqueue)
+	{
+		struct Job
+		{
+			Job(Blob&& in, const std::function<void (Blob&)>& h) : input(std::move(in)), handler(h) {}
+			Blob input;
+			Blob output;
+			std::function<void (Blob&)> handler;
+			std::atomic<uint32_t> remainingTasks{0};
+			std::atomic<bool> failed{false};
+		};
+
+		std::shared_ptr<Job> job = std::make_shared<Job>(std::move(input), handler);
+		const BlockCompressedFile* file = nullptr;
+		try
+		{
+			file = &BlockCompression::GetHeader(job->input.GetData(), job->input.GetSize());
+		}
+		catch(std::exception& e)
+		{
+			LOG(ERROR) << "Decompression failed: " << e.what();
+			Blob empty;
+			handler(empty);
+			return;
+		}
+		job->output = Blob(size_t(file->size));
+
+		// Tasks of at least kMinDecompressionTaskSize bytes keep the overhead low:
+		const uint32_t blocksPerTask = std::max<uint32_t>(1, kMinDecompressionTaskSize / file->blockSize);
+		const uint32_t taskCount = (file->blockCount + blocksPerTask - 1) / blocksPerTask;
+		if(taskCount == 0)
+		{
+			handler(job->output);
+			return;
+		}
+
+		job->remainingTasks = taskCount;
+		for(uint32_t task = 0; task < taskCount; ++task)
+		{
+			const uint32_t begin = task * blocksPerTask;
+			const uint32_t end = std::min(begin + blocksPerTask, file->blockCount);
+			enqueue([job, file, begin, end, &handlerQueue]()
+			{
+				try
+				{
+					for(uint32_t block = begin; block < end; ++block)
+						BlockCompression::DecompressBlock(*file, block, job->output.GetData());
+				}
+				catch(std::exception& e)
+				{
+					LOG(ERROR) << "Decompression failed: " << e.what();
+					job->failed = true;
+				}
+
+				if(--job->remainingTasks == 0)
+				{
+					handlerQueue.EnqueueTask([job]()
+					{
+						if(job->failed)
+						{
+							Blob empty;
+							job->handler(empty);
+						}
+						else
+							job->handler(job->output);
+					});
+				}
+			});
+		}
+	}
+
+	/// Find plain file or package file entry
+	/** @param pathBuffer Used for assembling paths of plain files.
+		@returns Path of the plain file or package file. */
+	const char* GetFileLocation(Hash file, char pathBuffer[kMaxPathLength], size_t& outOffset, size_t& outSize, bool& outMayBeCompressed) const
 	{
+		PackageFileDirectory::Entry entry;
+		outMayBeCompressed = false;
 		if(const char* path = mDirectoryContents.FindString(file))
 		{
-			strncpy(outPath, mRoot.c_str(), kMaxPathLength);
-			strncpy(outPath + mRoot.size(), path, kMaxPathLength - mRoot.size());
+			strncpy(pathBuffer, mRoot.c_str(), kMaxPathLength);
+			strncpy(pathBuffer + mRoot.size(), path, kMaxPathLength - mRoot.size());
 			outOffset = 0;
 			outSize = 0;
+			return pathBuffer;
 		}
-		else if(auto entry = mPackageFileDirectory.FindEntry(file))
+		else if(mPackageFileDirectory.FindEntry(file, entry))
 		{
-			strncpy(outPath, entry->file.c_str(), kMaxPathLength);
-			outOffset = entry->offset;
-			outSize = entry->size;
+			outOffset = entry.offset;
+			outSize = entry.size;
+			outMayBeCompressed = entry.mayBeCompressed;
+			return entry.file;
 		}
 		else
 			throw std::runtime_error("File not found");
@@ -183,6 +684,11 @@ private:
 	std::string mRoot;
 	StringStore mDirectoryContents;
 	PackageFileDirectory mPackageFileDirectory;
+	std::vector<std::unique_ptr<MappedFile>> mMappedPackageFiles;
+	/// Mapping of contents.mss if it is in the perfect hash format
+	std::unique_ptr<MappedFile> mContentsMapping;
+	/// Enqueues a task in the decompression queue, empty if there is none
+	std::function<void (std::function<void ()>&&)> mEnqueueDecompression;
 };
 
 }
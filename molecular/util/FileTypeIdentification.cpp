@@ -75,6 +75,11 @@ bool IsCompiledMesh(const void* data, size_t size)
 	return HasMagicNumber(data, size, 0x8e8e54f1);
 }
 
+bool IsMeshLodChain(const void* data, size_t size)
+{
+	return HasMagicNumber(data, size, 0x8e8e54f2);
+}
+
 bool IsNmb(const void* data, size_t size)
 {
 	return HasMagicNumber(data, size, 1);
@@ -104,17 +109,17 @@ bool IsHashSet(const void* data, size_t size)
 
 bool IsStringStore(const void* data, size_t size)
 {
-	return HasMagicNumber(data, size, 0x807a0fc0);
+	return HasMagicNumber(data, size, 0x807a0fc0) || HasMagicNumber(data, size, 0x807a0fc1);
 }
 
 bool IsPackage(const void *data, size_t size)
 {
-	return HasMagicNumber(data, size, 0x506ac4a6);
+	return HasMagicNumber(data, size, 0x506ac4a6) || HasMagicNumber(data, size, 0x506ac4a7);
 }
 
 bool IsMeshBoundsCollection(const void* data, size_t size)
 {
-	return HasMagicNumber(data, size, 0x505eb0f1);
+	return HasMagicNumber(data, size, 0x505eb0f1) || HasMagicNumber(data, size, 0x505eb0f2);
 }
 
 FileType Identify(const void* data, size_t size)
@@ -50,6 +50,10 @@ bool IsDds(const void* data, size_t size); ///< Checks if given file is a Direct
 bool IsKtx(const void* data, size_t size); ///< Checks if given file is a Khronos texture file
 bool IsCompiledMesh(const void* data, size_t size);
 
+/// Chain of compiled meshes
+/** @see MeshLodFile */
+bool IsMeshLodChain(const void* data, size_t size);
+
 /// NVidia Mesh Binary (probably)
 /** @see NmbFile */
 bool IsNmb(const void* data, size_t size);
@@ -0,0 +1,353 @@
+/*	Logging.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace molecular
+{
+namespace util
+{
+
+namespace
+{
+
+const size_t kMaxMessageSize = 4096;
+const size_t kRingBufferSize = 64 * 1024;
+const int kMaxNesting = 4;
+const int64_t kRateLimitWindowMs = 1000;
+
+/// Fixed size buffer for formatting a single message
+/** Output beyond the capacity is discarded. One byte is reserved for the
+	newline. */
+class MessageBuffer : public std::streambuf
+{
+public:
+	MessageBuffer() {Reset();}
+
+	void Reset() {setp(mData, mData + kMaxMessageSize - 1);}
+
+	/// Terminate message with newline
+	void Finish()
+	{
+		*pptr() = '\n';
+		pbump(1);
+	}
+
+	const char* GetData() const {return pbase();}
+	size_t GetSize() const {return pptr() - pbase();}
+
+protected:
+	int_type overflow(int_type) override {return traits_type::eof();}
+
+private:
+	char mData[kMaxMessageSize];
+};
+
+/// Single producer, single consumer ring buffer of complete log lines
+class RingBuffer : NonCopyable
+{
+public:
+	/// Called by the producer thread
+	/** @returns false if there is not enough space. */
+	bool Push(const char* data, size_t size)
+	{
+		const size_t write = mWrite.load(std::memory_order_relaxed);
+		const size_t read = mRead.load(std::memory_order_acquire);
+		if(kRingBufferSize - (write - read) < size)
+			return false;
+
+		const size_t offset = write % kRingBufferSize;
+		const size_t first = std::min(size, kRingBufferSize - offset);
+		memcpy(mData + offset, data, first);
+		memcpy(mData, data + first, size - first);
+		mWrite.store(write + size, std::memory_order_release);
+		return true;
+	}
+
+	/// Called by the consumer
+	/** @returns true if there was anything to write. */
+	bool Drain(FILE* file)
+	{
+		const size_t read = mRead.load(std::memory_order_relaxed);
+		const size_t write = mWrite.load(std::memory_order_acquire);
+		if(read == write)
+			return false;
+
+		const size_t offset = read % kRingBufferSize;
+		const size_t size = write - read;
+		const size_t first = std::min(size, kRingBufferSize - offset);
+		fwrite(mData + offset, 1, first, file);
+		fwrite(mData, 1, size - first, file);
+		mRead.store(write, std::memory_order_release);
+		return true;
+	}
+
+private:
+	char mData[kRingBufferSize];
+
+	/// Total bytes written, only ever increasing
+	std::atomic<size_t> mWrite{0};
+
+	/// Total bytes read, only ever increasing
+	std::atomic<size_t> mRead{0};
+};
+
+/// Owns all ring buffers and the writer thread
+class Backend : NonCopyable
+{
+public:
+	Backend();
+	~Backend();
+
+	/// Create ring buffer for the calling thread
+	RingBuffer* Register();
+
+	/// Write out and destroy ring buffer of a finishing thread
+	void Unregister(RingBuffer* ringBuffer);
+
+	/// Write everything to stderr
+	/** @returns true if there was anything to write. */
+	bool Drain();
+
+private:
+	void Run();
+
+	std::vector<std::unique_ptr<RingBuffer>> mRingBuffers;
+	std::mutex mRingBuffersMutex;
+	std::mutex mDrainMutex;
+	std::atomic<bool> mRunning{true};
+	std::thread mThread;
+};
+
+enum BackendState
+{
+	kNotCreated,
+	kAlive,
+	kDestroyed
+};
+std::atomic<int> gBackendState{kNotCreated};
+
+Backend::Backend()
+{
+	mThread = std::thread(&Backend::Run, this);
+	gBackendState = kAlive;
+}
+
+Backend::~Backend()
+{
+	mRunning = false;
+	mThread.join();
+	gBackendState = kDestroyed;
+	Drain();
+}
+
+RingBuffer* Backend::Register()
+{
+	std::lock_guard<std::mutex> lock(mRingBuffersMutex);
+	mRingBuffers.emplace_back(new RingBuffer);
+	return mRingBuffers.back().get();
+}
+
+void Backend::Unregister(RingBuffer* ringBuffer)
+{
+	std::lock_guard<std::mutex> drainLock(mDrainMutex);
+	std::lock_guard<std::mutex> lock(mRingBuffersMutex);
+	auto it = std::find_if(mRingBuffers.begin(), mRingBuffers.end(), [ringBuffer](const std::unique_ptr<RingBuffer>& p){return p.get() == ringBuffer;});
+	if(it == mRingBuffers.end())
+		return;
+	if((*it)->Drain(stderr))
+		fflush(stderr);
+	mRingBuffers.erase(it);
+}
+
+bool Backend::Drain()
+{
+	std::lock_guard<std::mutex> drainLock(mDrainMutex);
+	std::lock_guard<std::mutex> lock(mRingBuffersMutex);
+	bool written = false;
+	for(auto& ringBuffer: mRingBuffers)
+		written |= ringBuffer->Drain(stderr);
+	if(written)
+		fflush(stderr);
+	return written;
+}
+
+void Backend::Run()
+{
+	while(mRunning)
+	{
+		if(!Drain())
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+}
+
+Backend& GetBackend()
+{
+	static Backend backend;
+	return backend;
+}
+
+/// Formatting state of one nesting level of LOG statements
+struct MessageLevel
+{
+	MessageBuffer buffer;
+	std::ostream stream{&buffer};
+	std::ios_base::fmtflags defaultFlags = stream.flags();
+};
+
+/// Set when the calling thread's ThreadState has been destroyed
+/** Trivially destructible, so it can still be read from static and other
+	thread_local destructors. */
+thread_local bool tThreadStateDestroyed = false;
+
+/// Formatting state of a thread
+struct ThreadState
+{
+	~ThreadState()
+	{
+		tThreadStateDestroyed = true;
+		if(ringBuffer && gBackendState == kAlive)
+			GetBackend().Unregister(ringBuffer);
+		ringBuffer = nullptr;
+	}
+
+	MessageLevel levels[kMaxNesting];
+
+	/// Number of Log objects currently formatting on this thread
+	int depth = 0;
+
+	RingBuffer* ringBuffer = nullptr;
+};
+
+thread_local ThreadState tThreadState;
+
+void Submit(const char* data, size_t size, bool flush)
+{
+	if(gBackendState == kDestroyed || tThreadStateDestroyed)
+	{
+		// Logging from static or thread_local destructors
+		if(gBackendState == kAlive)
+			GetBackend().Drain(); // Keep order with queued messages
+		fwrite(data, 1, size, stderr);
+		return;
+	}
+
+	Backend& backend = GetBackend();
+	ThreadState& state = tThreadState;
+	if(!state.ringBuffer)
+		state.ringBuffer = backend.Register();
+	while(!state.ringBuffer->Push(data, size))
+		std::this_thread::yield(); // Wait for writer thread to make space
+	if(flush)
+		backend.Drain();
+}
+
+}
+
+struct Log::OwnBuffer
+{
+	MessageLevel level;
+};
+
+bool LogSite::Allow(unsigned int& suppressed)
+{
+	suppressed = 0;
+	if(MOLECULAR_LOG_RATE_LIMIT == 0)
+		return true;
+
+	const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	int64_t windowStart = mWindowStart.load(std::memory_order_relaxed);
+	if(now - windowStart >= kRateLimitWindowMs && mWindowStart.compare_exchange_strong(windowStart, now))
+	{
+		mCount = 0;
+		suppressed = mSuppressed.exchange(0);
+	}
+
+	if(mCount.fetch_add(1, std::memory_order_relaxed) < MOLECULAR_LOG_RATE_LIMIT)
+		return true;
+	mSuppressed.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+Log::Log(LogSeverity severity, const char* severityName, LogSite& site) :
+	mSeverity(severity)
+{
+	// Errors are never dropped, a FATAL one usually explains the abort that follows
+	if(severity < LogSeverity::kERROR && !site.Allow(mSuppressed))
+		return;
+
+	MessageLevel* levelPointer = nullptr;
+	if(tThreadStateDestroyed)
+	{
+		mOwnBuffer.reset(new OwnBuffer);
+		levelPointer = &mOwnBuffer->level;
+	}
+	else
+	{
+		ThreadState& state = tThreadState;
+		if(state.depth == kMaxNesting)
+			return;
+		levelPointer = &state.levels[state.depth++];
+	}
+
+	MessageLevel& level = *levelPointer;
+	level.buffer.Reset();
+	level.stream.clear();
+	level.stream.flags(level.defaultFlags);
+	mStream = &level.stream;
+	*mStream << severityName << ": ";
+}
+
+Log::~Log()
+{
+	if(!mStream)
+		return;
+
+	// Log objects on one thread are destroyed in reverse order of creation
+	MessageLevel& level = mOwnBuffer ? mOwnBuffer->level : tThreadState.levels[--tThreadState.depth];
+	if(mSuppressed)
+		level.stream << " (" << mSuppressed << " similar messages suppressed)";
+	level.buffer.Finish();
+	Submit(level.buffer.GetData(), level.buffer.GetSize(), mSeverity == LogSeverity::kFATAL);
+}
+
+void FlushLog()
+{
+	if(gBackendState == kAlive)
+		GetBackend().Drain();
+}
+
+}
+}
@@ -26,37 +26,119 @@ SOFTWARE.
 #ifndef MOLECULAR_UTIL_LOGGING_H
 #define MOLECULAR_UTIL_LOGGING_H
 
-#include <iostream>
+#include <molecular/util/NonCopyable.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+/// Messages with lower severity are removed at compile time
+/** 0 = DEBUG, 1 = INFO, 2 = WARNING, 3 = ERROR, 4 = FATAL. */
+#ifndef MOLECULAR_LOG_MIN_SEVERITY
+#ifdef NDEBUG
+#define MOLECULAR_LOG_MIN_SEVERITY 1
+#else
+#define MOLECULAR_LOG_MIN_SEVERITY 0
+#endif
+#endif
+
+/// Maximum number of messages per second from one LOG statement
+/** 0 disables rate limiting. ERROR and FATAL messages are never
+	suppressed. */
+#ifndef MOLECULAR_LOG_RATE_LIMIT
+#define MOLECULAR_LOG_RATE_LIMIT 20
+#endif
 
 namespace molecular
 {
 namespace util
 {
 
-/// Automatic newlines for log messages
-/** Based on an answer by user7860670 to https://stackoverflow.com/questions/51802549 */
-struct Log
+/** Enumerators match the LOG(x) argument. */
+enum class LogSeverity
 {
-	Log(const char* severity)
-	{
-		std::cerr << severity << ": ";
-	}
+	kDEBUG,
+	kINFO,
+	kWARNING,
+	kERROR,
+	kFATAL
+};
 
-	~Log() { std::cerr << std::endl; }
+/// State of a single LOG statement for rate limiting
+class LogSite
+{
+public:
+	/// Count message and check if it may be written
+	/** @param[out] suppressed Messages suppressed since the last one written. */
+	bool Allow(unsigned int& suppressed);
+
+private:
+	std::atomic<int64_t> mWindowStart{0};
+	std::atomic<unsigned int> mCount{0};
+	std::atomic<unsigned int> mSuppressed{0};
 };
 
+/// Single log message with automatic newline
+/** Formats into a per-thread buffer without heap allocation. Each nesting
+	level (a LOG inside an expression streamed into another LOG) gets its own
+	buffer; messages nested deeper than four levels are dropped. The destructor
+	hands the message over to a per-thread lock-free ring buffer, which a
+	background thread writes to stderr. FATAL messages are flushed
+	immediately. Messages longer than 4 KiB are truncated. Messages logged
+	after the thread's buffers were destroyed, e.g. from static or
+	thread_local destructors, are formatted on the heap and written to stderr
+	directly.
+	Based on an answer by user7860670 to https://stackoverflow.com/questions/51802549 */
+class Log : NonCopyable
+{
+public:
+	Log(LogSeverity severity, const char* severityName, LogSite& site);
+	~Log();
+
+	/// Stream to format into, nullptr if the message is suppressed
+	std::ostream* GetStream() {return mStream;}
+
+private:
+	struct OwnBuffer;
+
+	std::ostream* mStream = nullptr;
+	LogSeverity mSeverity;
+	unsigned int mSuppressed = 0;
 
+	/// Used instead of the thread's buffers when they are gone
+	std::unique_ptr<OwnBuffer> mOwnBuffer;
+};
 
 template<typename T> Log &&
 operator <<(Log && wrap, T const & whatever)
 {
-	std::cerr << whatever;
+	if(std::ostream* stream = wrap.GetStream())
+		*stream << whatever;
 	return std::move(wrap);
 }
 
+/// Turns a streamed Log expression into void for the LOG macro
+struct LogVoidify
+{
+	void operator&(Log&&) {}
+};
+
+/// Write all pending log messages
+/** Blocks until done. */
+void FlushLog();
+
 }
 }
 
-#define LOG(x) molecular::util::Log(#x)
+/// Creates a static LogSite for every LOG statement
+#define MOLECULAR_LOG_SITE ([]() -> molecular::util::LogSite& {static molecular::util::LogSite site; return site;}())
+
+/// Expression form of LOG, so an unbraced if/else around it stays unambiguous
+/** "&" binds weaker than "<<" and stronger than "?:", so the whole streamed
+	message is evaluated only if the severity passes. */
+#define LOG(x) \
+	!(static_cast<int>(molecular::util::LogSeverity::k##x) >= MOLECULAR_LOG_MIN_SEVERITY) ? (void)0 \
+	: molecular::util::LogVoidify() & molecular::util::Log(molecular::util::LogSeverity::k##x, #x, MOLECULAR_LOG_SITE)
 
 #endif // MOLECULAR_UTIL_LOGGING_H
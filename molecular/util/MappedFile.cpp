@@ -0,0 +1,140 @@
+/*	MappedFile.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace molecular
+{
+namespace util
+{
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const char* path)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error(std::string("Cannot open ") + path);
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		throw std::runtime_error(std::string("Cannot map empty file ") + path);
+	}
+
+	mMappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if(!mMappingHandle)
+		throw std::runtime_error(std::string("Cannot map ") + path);
+
+	mData = MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if(!mData)
+	{
+		CloseHandle(mMappingHandle);
+		throw std::runtime_error(std::string("Cannot map ") + path);
+	}
+	mSize = static_cast<size_t>(size.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+	UnmapViewOfFile(mData);
+	CloseHandle(mMappingHandle);
+}
+
+void MappedFile::Advise(Advice, size_t, size_t) const
+{
+}
+
+#else
+
+MappedFile::MappedFile(const char* path)
+{
+	int file = open(path, O_RDONLY);
+	if(file < 0)
+		throw std::runtime_error(std::string("Cannot open ") + path);
+
+	struct stat status;
+	if(fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		close(file);
+		throw std::runtime_error(std::string("Cannot map empty file ") + path);
+	}
+
+	void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+	if(data == MAP_FAILED)
+		throw std::runtime_error(std::string("Cannot map ") + path);
+	mData = data;
+	mSize = status.st_size;
+}
+
+MappedFile::~MappedFile()
+{
+	munmap(mData, mSize);
+}
+
+void MappedFile::Advise(Advice advice, size_t offset, size_t size) const
+{
+	if(offset >= mSize)
+		return;
+	if(size == 0 || offset + size > mSize)
+		size = mSize - offset;
+
+	// madvise needs a page aligned address:
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t alignedOffset = offset - offset % pageSize;
+	size += offset - alignedOffset;
+
+	int posixAdvice = MADV_NORMAL;
+	switch(advice)
+	{
+	case Advice::kNormal: posixAdvice = MADV_NORMAL; break;
+	case Advice::kSequential: posixAdvice = MADV_SEQUENTIAL; break;
+	case Advice::kRandom: posixAdvice = MADV_RANDOM; break;
+	case Advice::kWillNeed: posixAdvice = MADV_WILLNEED; break;
+	case Advice::kDontNeed: posixAdvice = MADV_DONTNEED; break;
+	}
+	madvise(static_cast<char*>(mData) + alignedOffset, size, posixAdvice);
+}
+
+#endif
+
+}
+}
@@ -0,0 +1,78 @@
+/*	MappedFile.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_UTIL_MAPPEDFILE_H
+#define MOLECULAR_UTIL_MAPPEDFILE_H
+
+#include <molecular/util/NonCopyable.h>
+
+#include <cstddef>
+
+namespace molecular
+{
+namespace util
+{
+
+/// Read-only memory mapping of an entire file
+/** Used for package files, so their contents can be parsed in place instead
+	of being read into freshly allocated Blobs. */
+class MappedFile : NonCopyable
+{
+public:
+	/// Expected access pattern
+	enum class Advice
+	{
+		kNormal,
+		kSequential,
+		kRandom,
+		kWillNeed, ///< Start readahead
+		kDontNeed ///< Pages may be dropped from memory
+	};
+
+	/// Map file
+	/** Throws std::runtime_error on failure. */
+	explicit MappedFile(const char* path);
+	~MappedFile();
+
+	const void* GetData() const {return mData;}
+	size_t GetSize() const {return mSize;}
+
+	/// Hint the operating system about the access pattern of a range
+	/** Does nothing on platforms without madvise.
+		@param size Size of the range, 0 means until the end of the file. */
+	void Advise(Advice advice, size_t offset = 0, size_t size = 0) const;
+
+private:
+	void* mData = nullptr;
+	size_t mSize = 0;
+#ifdef _WIN32
+	void* mMappingHandle = nullptr;
+#endif
+};
+
+}
+}
+
+#endif // MOLECULAR_UTIL_MAPPEDFILE_H
@@ -0,0 +1,657 @@
+/*	MeshOptimization.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "MeshOptimization.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace molecular
+{
+namespace util
+{
+namespace MeshOptimization
+{
+
+Statistics Analyze(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+	Statistics statistics;
+	if(indices.size() < 3)
+		return statistics;
+
+	// Vertex is in the cache if it missed during the last cacheSize misses:
+	const uint64_t kNever = ~uint64_t(0);
+	std::vector<uint64_t> missTime(vertexCount, kNever);
+	std::vector<bool> used(vertexCount, false);
+	uint64_t misses = 0;
+	size_t usedCount = 0;
+	for(uint32_t index: indices)
+	{
+		if(index >= vertexCount)
+			throw std::runtime_error("Vertex index out of range");
+		if(missTime[index] == kNever || misses - missTime[index] >= cacheSize)
+			missTime[index] = misses++;
+		if(!used[index])
+		{
+			used[index] = true;
+			usedCount++;
+		}
+	}
+	statistics.acmr = float(misses) / float(indices.size() / 3);
+	statistics.atvr = float(misses) / float(usedCount);
+	return statistics;
+}
+
+std::vector<uint32_t> StripToList(const std::vector<uint32_t>& strip)
+{
+	std::vector<uint32_t> list;
+	if(strip.size() < 3)
+		return list;
+
+	list.reserve((strip.size() - 2) * 3);
+	for(size_t i = 2; i < strip.size(); ++i)
+	{
+		const uint32_t a = strip[i - 2], b = strip[i - 1], c = strip[i];
+		if(a == b || b == c || a == c)
+			continue;
+
+		// Every other triangle has its first two vertices swapped:
+		if(i % 2 == 0)
+			list.insert(list.end(), {a, b, c});
+		else
+			list.insert(list.end(), {b, a, c});
+	}
+	return list;
+}
+
+namespace
+{
+/// Vertex to triangle adjacency in compressed form
+struct Adjacency
+{
+	Adjacency(const std::vector<uint32_t>& indices, size_t vertexCount) :
+		offsets(vertexCount + 1, 0),
+		triangles(indices.size())
+	{
+		for(uint32_t index: indices)
+		{
+			if(index >= vertexCount)
+				throw std::runtime_error("Vertex index out of range");
+			offsets[index + 1]++;
+		}
+		for(size_t i = 0; i < vertexCount; ++i)
+			offsets[i + 1] += offsets[i];
+
+		std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+		for(size_t i = 0; i < indices.size(); ++i)
+			triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<size_t> offsets;
+	std::vector<uint32_t> triangles;
+};
+
+/// Pop dead-end stack or find next vertex with live triangles
+int64_t SkipDeadEnd(const std::vector<unsigned int>& liveTriangles, std::vector<uint32_t>& deadEnds, size_t& cursor)
+{
+	while(!deadEnds.empty())
+	{
+		const uint32_t vertex = deadEnds.back();
+		deadEnds.pop_back();
+		if(liveTriangles[vertex] > 0)
+			return vertex;
+	}
+	for(; cursor < liveTriangles.size(); ++cursor)
+	{
+		if(liveTriangles[cursor] > 0)
+			return static_cast<int64_t>(cursor);
+	}
+	return -1;
+}
+}
+
+std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned int cacheSize, std::vector<size_t>* outClusters)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if(outClusters)
+		outClusters->clear();
+	if(triangleCount == 0 || vertexCount == 0)
+		return indices;
+
+	const Adjacency adjacency(indices, vertexCount);
+	std::vector<unsigned int> liveTriangles(vertexCount);
+	for(size_t i = 0; i < vertexCount; ++i)
+		liveTriangles[i] = static_cast<unsigned int>(adjacency.offsets[i + 1] - adjacency.offsets[i]);
+
+	std::vector<uint64_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+
+	uint64_t timestamp = cacheSize + 1;
+	size_t cursor = 0;
+	int64_t fanning = SkipDeadEnd(liveTriangles, deadEnds, cursor);
+	if(outClusters)
+		outClusters->push_back(0);
+	while(fanning >= 0)
+	{
+		candidates.clear();
+		for(size_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; ++i)
+		{
+			const uint32_t triangle = adjacency.triangles[i];
+			if(emitted[triangle])
+				continue;
+			for(size_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+				if(timestamp - cacheTime[vertex] > cacheSize)
+					cacheTime[vertex] = timestamp++;
+			}
+			emitted[triangle] = true;
+		}
+
+		// Prefer candidates that will still be in the cache after their remaining triangles:
+		int64_t next = -1;
+		int64_t bestPriority = -1;
+		for(uint32_t vertex: candidates)
+		{
+			if(liveTriangles[vertex] == 0)
+				continue;
+			int64_t priority = 0;
+			if(timestamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+				priority = static_cast<int64_t>(timestamp - cacheTime[vertex]);
+			if(priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+		if(next < 0)
+		{
+			next = SkipDeadEnd(liveTriangles, deadEnds, cursor);
+			if(next >= 0 && outClusters && outClusters->back() != output.size() / 3)
+				outClusters->push_back(output.size() / 3);
+		}
+		fanning = next;
+	}
+	return output;
+}
+
+std::vector<uint32_t> OptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<size_t>& clusters, const void* positions, size_t stride, size_t vertexCount)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if(clusters.size() < 2)
+		return indices;
+
+	auto position = [&](uint32_t vertex)
+	{
+		if(vertex >= vertexCount)
+			throw std::runtime_error("Vertex index out of range");
+		float p[3];
+		memcpy(p, static_cast<const uint8_t*>(positions) + vertex * stride, sizeof(p));
+		return std::array<float, 3>{{p[0], p[1], p[2]}};
+	};
+
+	struct Cluster
+	{
+		size_t begin;
+		size_t end;
+		float centroid[3];
+		float normal[3];
+		float sortKey;
+	};
+
+	// Area weighted centroids and normals:
+	std::vector<Cluster> sorted(clusters.size());
+	float meshCentroid[3] = {0, 0, 0};
+	float meshArea = 0;
+	for(size_t c = 0; c < clusters.size(); ++c)
+	{
+		Cluster& cluster = sorted[c];
+		cluster.begin = clusters[c];
+		cluster.end = (c + 1 < clusters.size()) ? clusters[c + 1] : triangleCount;
+		float area = 0;
+		for(int k = 0; k < 3; ++k)
+			cluster.centroid[k] = cluster.normal[k] = 0;
+		for(size_t t = cluster.begin; t < cluster.end; ++t)
+		{
+			const auto p0 = position(indices[t * 3]);
+			const auto p1 = position(indices[t * 3 + 1]);
+			const auto p2 = position(indices[t * 3 + 2]);
+			const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+			const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+			const float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+			const float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5f;
+			for(int k = 0; k < 3; ++k)
+			{
+				cluster.normal[k] += n[k];
+				cluster.centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * triangleArea;
+			}
+			area += triangleArea;
+		}
+		for(int k = 0; k < 3; ++k)
+			meshCentroid[k] += cluster.centroid[k];
+		meshArea += area;
+		if(area > 0)
+		{
+			for(int k = 0; k < 3; ++k)
+				cluster.centroid[k] /= area;
+		}
+	}
+	if(meshArea <= 0)
+		return indices;
+	for(int k = 0; k < 3; ++k)
+		meshCentroid[k] /= meshArea;
+
+	// Outwards facing first:
+	for(auto& cluster: sorted)
+	{
+		cluster.sortKey = 0;
+		for(int k = 0; k < 3; ++k)
+			cluster.sortKey += (cluster.centroid[k] - meshCentroid[k]) * cluster.normal[k];
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b){return a.sortKey > b.sortKey;});
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for(auto& cluster: sorted)
+		output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+	return output;
+}
+
+std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	const uint32_t kUnused = ~uint32_t(0);
+	std::vector<uint32_t> remap(vertexCount, kUnused);
+	uint32_t next = 0;
+	for(uint32_t& index: indices)
+	{
+		if(index >= vertexCount)
+			throw std::runtime_error("Vertex index out of range");
+		if(remap[index] == kUnused)
+			remap[index] = next++;
+		index = remap[index];
+	}
+	for(uint32_t& newIndex: remap)
+	{
+		if(newIndex == kUnused)
+			newIndex = next++;
+	}
+	return remap;
+}
+
+namespace
+{
+/// Sum of squared distances to planes
+/** Symmetric 4x4 matrix, upper triangle stored. */
+struct Quadric
+{
+	void AddPlane(double a, double b, double c, double d)
+	{
+		const double plane[4] = {a, b, c, d};
+		for(int i = 0, k = 0; i < 4; ++i)
+		{
+			for(int j = i; j < 4; ++j)
+				m[k++] += plane[i] * plane[j];
+		}
+	}
+
+	Quadric& operator+=(const Quadric& other)
+	{
+		for(int i = 0; i < 10; ++i)
+			m[i] += other.m[i];
+		return *this;
+	}
+
+	double Evaluate(const std::array<float, 3>& p) const
+	{
+		const double x = p[0], y = p[1], z = p[2];
+		return m[0]*x*x + 2*m[1]*x*y + 2*m[2]*x*z + 2*m[3]*x
+				+ m[4]*y*y + 2*m[5]*y*z + 2*m[6]*y
+				+ m[7]*z*z + 2*m[8]*z
+				+ m[9];
+	}
+
+	double m[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+};
+
+/// Moving vertex from onto vertex to
+struct Collapse
+{
+	double cost;
+	uint32_t from;
+	uint32_t to;
+	uint32_t version; ///< Collapse is stale if the version of from changed
+
+	bool operator>(const Collapse& other) const {return cost > other.cost;}
+};
+
+std::array<double, 3> Normal(const std::array<float, 3>& a, const std::array<float, 3>& b, const std::array<float, 3>& c)
+{
+	const double u[3] = {double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2]};
+	const double v[3] = {double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2]};
+	return {{u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]}};
+}
+}
+
+std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const void* positions, size_t stride, size_t vertexCount, size_t targetIndexCount, float* outError)
+{
+	if(indices.size() % 3 != 0)
+		throw std::runtime_error("Index count is not a multiple of 3");
+	const uint32_t kNone = ~uint32_t(0);
+	const size_t triangleCount = indices.size() / 3;
+
+	std::vector<std::array<float, 3>> points(vertexCount);
+	for(size_t i = 0; i < vertexCount; ++i)
+		memcpy(points[i].data(), static_cast<const uint8_t*>(positions) + i * stride, sizeof(float) * 3);
+
+	// Vertices at the same position only differ in other attributes and move together:
+	std::vector<uint32_t> canonical(vertexCount);
+	std::map<std::array<float, 3>, uint32_t> firstAtPosition;
+	for(uint32_t i = 0; i < vertexCount; ++i)
+		canonical[i] = firstAtPosition.insert(std::make_pair(points[i], i)).first->second;
+
+	// Corners refer to canonical vertices, result to the actual ones:
+	std::vector<uint32_t> result(indices);
+	std::vector<uint32_t> corners(indices.size());
+	std::vector<uint32_t> firstIndex(vertexCount, kNone);
+	std::vector<bool> locked(vertexCount, false);
+	for(size_t i = 0; i < indices.size(); ++i)
+	{
+		if(indices[i] >= vertexCount)
+			throw std::runtime_error("Vertex index out of range");
+		const uint32_t vertex = corners[i] = canonical[indices[i]];
+		if(firstIndex[vertex] == kNone)
+			firstIndex[vertex] = indices[i];
+		else if(firstIndex[vertex] != indices[i])
+			locked[vertex] = true; // Attribute seam
+	}
+
+	std::vector<bool> dead(triangleCount, false);
+	size_t liveTriangles = 0;
+	std::unordered_map<uint64_t, unsigned int> edgeTriangles;
+	std::vector<Quadric> quadrics(vertexCount);
+	std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+	for(size_t t = 0; t < triangleCount; ++t)
+	{
+		const uint32_t* c = &corners[t * 3];
+		if(c[0] == c[1] || c[1] == c[2] || c[0] == c[2])
+		{
+			dead[t] = true;
+			continue;
+		}
+		liveTriangles++;
+
+		for(int k = 0; k < 3; ++k)
+		{
+			const uint32_t a = c[k], b = c[(k + 1) % 3];
+			edgeTriangles[(uint64_t(std::min(a, b)) << 32) | std::max(a, b)]++;
+			vertexTriangles[c[k]].push_back(static_cast<uint32_t>(t));
+		}
+
+		const std::array<double, 3> normal = Normal(points[c[0]], points[c[1]], points[c[2]]);
+		const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if(length == 0.0)
+			continue;
+		const double a = normal[0] / length, b = normal[1] / length, cc = normal[2] / length;
+		const double d = -(a * points[c[0]][0] + b * points[c[0]][1] + cc * points[c[0]][2]);
+		for(int k = 0; k < 3; ++k)
+			quadrics[c[k]].AddPlane(a, b, cc, d);
+	}
+
+	// Borders and non-manifold edges stay:
+	for(auto& edge: edgeTriangles)
+	{
+		if(edge.second != 2)
+		{
+			locked[edge.first >> 32] = true;
+			locked[edge.first & 0xffffffff] = true;
+		}
+	}
+
+	auto neighbors = [&](uint32_t vertex)
+	{
+		std::vector<uint32_t> result;
+		for(uint32_t t: vertexTriangles[vertex])
+		{
+			if(dead[t])
+				continue;
+			for(int k = 0; k < 3; ++k)
+			{
+				if(corners[t * 3 + k] != vertex)
+					result.push_back(corners[t * 3 + k]);
+			}
+		}
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	};
+
+	std::vector<uint32_t> version(vertexCount, 0);
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+	auto queueBestCollapse = [&](uint32_t from)
+	{
+		version[from]++;
+		if(locked[from] || canonical[from] != from)
+			return;
+		Collapse best = {std::numeric_limits<double>::max(), from, kNone, version[from]};
+		for(uint32_t to: neighbors(from))
+		{
+			Quadric quadric = quadrics[from];
+			quadric += quadrics[to];
+			const double cost = quadric.Evaluate(points[to]);
+			if(cost < best.cost)
+			{
+				best.cost = cost;
+				best.to = to;
+			}
+		}
+		if(best.to != kNone)
+			queue.push(best);
+	};
+
+	for(uint32_t i = 0; i < vertexCount; ++i)
+	{
+		if(!vertexTriangles[i].empty())
+			queueBestCollapse(i);
+	}
+
+	double maxCost = 0;
+	while(liveTriangles * 3 > targetIndexCount && !queue.empty())
+	{
+		const Collapse collapse = queue.top();
+		queue.pop();
+		const uint32_t from = collapse.from, to = collapse.to;
+		if(collapse.version != version[from])
+			continue;
+
+		// Triangles on the edge vanish, the others must keep their orientation:
+		size_t collapsingTriangles = 0;
+		uint32_t toIndex = kNone;
+		bool flips = false;
+		for(uint32_t t: vertexTriangles[from])
+		{
+			if(dead[t])
+				continue;
+			const uint32_t* c = &corners[t * 3];
+			if(c[0] == to || c[1] == to || c[2] == to)
+			{
+				collapsingTriangles++;
+				for(int k = 0; k < 3; ++k)
+				{
+					if(c[k] == to)
+						toIndex = result[t * 3 + k];
+				}
+				continue;
+			}
+			std::array<std::array<float, 3>, 3> moved = {{points[c[0]], points[c[1]], points[c[2]]}};
+			for(int k = 0; k < 3; ++k)
+			{
+				if(c[k] == from)
+					moved[k] = points[to];
+			}
+			const std::array<double, 3> before = Normal(points[c[0]], points[c[1]], points[c[2]]);
+			const std::array<double, 3> after = Normal(moved[0], moved[1], moved[2]);
+			flips |= (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0);
+		}
+
+		// Link condition: Only the vertices opposite of the edge may be shared:
+		const std::vector<uint32_t> fromNeighbors = neighbors(from), toNeighbors = neighbors(to);
+		std::vector<uint32_t> shared;
+		std::set_intersection(fromNeighbors.begin(), fromNeighbors.end(), toNeighbors.begin(), toNeighbors.end(), std::back_inserter(shared));
+		if(flips || shared.size() != collapsingTriangles || toIndex == kNone)
+			continue;
+
+		for(uint32_t t: vertexTriangles[from])
+		{
+			if(dead[t])
+				continue;
+			uint32_t* c = &corners[t * 3];
+			if(c[0] == to || c[1] == to || c[2] == to)
+			{
+				dead[t] = true;
+				liveTriangles--;
+				continue;
+			}
+			for(int k = 0; k < 3; ++k)
+			{
+				if(c[k] == from)
+				{
+					c[k] = to;
+					result[t * 3 + k] = toIndex;
+				}
+			}
+			vertexTriangles[to].push_back(t);
+		}
+		vertexTriangles[from].clear();
+		version[from]++;
+		quadrics[to] += quadrics[from];
+		maxCost = std::max(maxCost, collapse.cost);
+
+		queueBestCollapse(to);
+		for(uint32_t neighbor: neighbors(to))
+			queueBestCollapse(neighbor);
+	}
+
+	std::vector<uint32_t> simplified;
+	simplified.reserve(liveTriangles * 3);
+	for(size_t t = 0; t < triangleCount; ++t)
+	{
+		if(!dead[t])
+			simplified.insert(simplified.end(), result.begin() + t * 3, result.begin() + t * 3 + 3);
+	}
+	if(outError)
+		*outError = float(std::sqrt(std::max(maxCost, 0.0)));
+	return simplified;
+}
+
+std::vector<Cluster> BuildClusters(const std::vector<uint32_t>& indices, const void* positions, size_t stride, size_t vertexCount, unsigned int maxTriangles)
+{
+	if(indices.size() % 3 != 0 || maxTriangles == 0)
+		throw std::runtime_error("Invalid cluster parameters");
+	auto position = [&](uint32_t vertex)
+	{
+		if(vertex >= vertexCount)
+			throw std::runtime_error("Vertex index out of range");
+		std::array<float, 3> p;
+		memcpy(p.data(), static_cast<const uint8_t*>(positions) + vertex * stride, sizeof(float) * 3);
+		return p;
+	};
+
+	std::vector<Cluster> clusters;
+	for(size_t first = 0; first < indices.size(); first += maxTriangles * 3)
+	{
+		Cluster cluster;
+		cluster.firstIndex = first;
+		cluster.indexCount = std::min<size_t>(maxTriangles * 3, indices.size() - first);
+
+		// Sphere around the center of the bounding box:
+		float min[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+		float max[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+		for(size_t i = first; i < first + cluster.indexCount; ++i)
+		{
+			const std::array<float, 3> p = position(indices[i]);
+			for(int k = 0; k < 3; ++k)
+			{
+				min[k] = std::min(min[k], p[k]);
+				max[k] = std::max(max[k], p[k]);
+			}
+		}
+		float radiusSquared = 0;
+		for(int k = 0; k < 3; ++k)
+			cluster.center[k] = (min[k] + max[k]) * 0.5f;
+		for(size_t i = first; i < first + cluster.indexCount; ++i)
+		{
+			const std::array<float, 3> p = position(indices[i]);
+			const float dx = p[0] - cluster.center[0], dy = p[1] - cluster.center[1], dz = p[2] - cluster.center[2];
+			radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+		}
+		cluster.radius = std::sqrt(radiusSquared);
+
+		// Cone around the average normal:
+		std::vector<std::array<double, 3>> normals;
+		double axis[3] = {0, 0, 0};
+		for(size_t i = first; i < first + cluster.indexCount; i += 3)
+		{
+			std::array<double, 3> normal = Normal(position(indices[i]), position(indices[i + 1]), position(indices[i + 2]));
+			const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if(length == 0.0)
+				continue; // Degenerate triangles are not rasterized
+			for(int k = 0; k < 3; ++k)
+			{
+				normal[k] /= length;
+				axis[k] += normal[k];
+			}
+			normals.push_back(normal);
+		}
+		const double axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		double minDot = axisLength > 0.0 ? 1.0 : -1.0;
+		for(int k = 0; k < 3; ++k)
+			cluster.coneAxis[k] = axisLength > 0.0 ? float(axis[k] / axisLength) : 0.0f;
+		for(auto& normal: normals)
+			minDot = std::min(minDot, normal[0] * cluster.coneAxis[0] + normal[1] * cluster.coneAxis[1] + normal[2] * cluster.coneAxis[2]);
+		cluster.coneCutoff = minDot <= 0.0 ? 1.0f : float(std::sqrt(1.0 - minDot * minDot));
+		clusters.push_back(cluster);
+	}
+	return clusters;
+}
+
+}
+}
+}
@@ -0,0 +1,131 @@
+/*	MeshOptimization.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef MOLECULAR_MESHOPTIMIZATION_H
+#define MOLECULAR_MESHOPTIMIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace molecular
+{
+namespace util
+{
+
+/// Reordering of triangle meshes for faster drawing
+/** Operates on triangle lists with 32 bit indices. Used by the mesh cooker,
+	meshes are loaded as they are. */
+namespace MeshOptimization
+{
+
+/// Post-transform vertex cache size assumed by default
+const unsigned int kDefaultCacheSize = 16;
+
+/// Cache efficiency of a triangle list
+struct Statistics
+{
+	/// Average cache miss ratio: Transformed vertices per triangle
+	/** 0.5 is optimal for large regular meshes, 3 is the worst case. */
+	float acmr = 0;
+
+	/// Average transform to vertex ratio: Transformed vertices per vertex
+	/** 1 is optimal. */
+	float atvr = 0;
+};
+
+/// Simulate a FIFO vertex cache
+Statistics Analyze(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned int cacheSize = kDefaultCacheSize);
+
+/// Convert triangle strip to triangle list
+/** Keeps the winding of every triangle and drops degenerate triangles, which
+	strips use to join separate strips. */
+std::vector<uint32_t> StripToList(const std::vector<uint32_t>& strip);
+
+/// Reorder triangles for post-transform vertex cache hits
+/** Tipsify algorithm from Sander, Nehab, Barczak: "Fast Triangle Reordering
+	for Vertex Locality and Reduced Overdraw", 2007. Runs in linear time.
+	@param outClusters If not nullptr, receives the first triangle of each
+		cluster. A new cluster starts wherever the algorithm had to jump to an
+		unconnected part of the mesh. */
+std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned int cacheSize = kDefaultCacheSize, std::vector<size_t>* outClusters = nullptr);
+
+/// Sort clusters of triangles to reduce overdraw
+/** Clusters facing away from the center of the mesh are likely to occlude
+	the others, so they are drawn first. Triangle order within clusters is
+	kept, so the vertex cache efficiency stays the same.
+	@param clusters First triangle of each cluster, as from OptimizeVertexCache().
+	@param positions Three floats per vertex, stride bytes apart. */
+std::vector<uint32_t> OptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<size_t>& clusters, const void* positions, size_t stride, size_t vertexCount);
+
+/// Renumber vertices in the order they are first used
+/** Improves locality of vertex fetches. Changes indices accordingly.
+	@returns New index for each old vertex index. Unused vertices are moved to
+		the end. */
+std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+
+/// Reduce number of triangles by collapsing edges
+/** Garland, Heckbert: "Surface Simplification Using Quadric Error Metrics",
+	1997, restricted to collapses onto existing vertices so the vertex data
+	stays valid. Vertices at the same position count as one. Vertices on
+	borders and attribute seams are kept in place. Collapses that flip
+	triangles or make the mesh non-manifold are skipped, so the target may
+	not be reached.
+	@param positions Three floats per vertex, stride bytes apart.
+	@param targetIndexCount Stop when there are at most that many indices.
+	@param outError If not nullptr, receives the largest distance of the
+		simplified surface to the original one, estimated from the quadrics.
+	@returns Triangle list referencing the same vertices. */
+std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const void* positions, size_t stride, size_t vertexCount, size_t targetIndexCount, float* outError = nullptr);
+
+/// Consecutive triangles with bounds for culling
+struct Cluster
+{
+	size_t firstIndex;
+	size_t indexCount;
+
+	/// Bounding sphere
+	float center[3];
+	float radius;
+
+	/// Normal cone
+	/** All triangle normals are within asin(coneCutoff) of coneAxis.
+		coneCutoff is 1 if the normals spread too far for the cone to be of
+		use. */
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+/// Split triangle list into clusters for culling
+/** Splits in the given order, which is spatially coherent after
+	OptimizeVertexCache(). Normals follow counter-clockwise winding.
+	@param positions Three floats per vertex, stride bytes apart. */
+std::vector<Cluster> BuildClusters(const std::vector<uint32_t>& indices, const void* positions, size_t stride, size_t vertexCount, unsigned int maxTriangles = 128);
+
+}
+
+}
+}
+
+#endif // MOLECULAR_MESHOPTIMIZATION_H
@@ -0,0 +1,170 @@
+/*	PackageFile.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PackageFile.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+
+namespace molecular
+{
+namespace util
+{
+
+void PackageFileDirectory::AddMappedFile(const std::string& filename, const MappedFile& mapping)
+{
+	const size_t size = mapping.GetSize();
+	const uint32_t magic = size >= sizeof(uint32_t) ? *static_cast<const uint32_t*>(mapping.GetData()) : 0;
+	const PackageFile::Entry* entries = nullptr;
+	size_t numEntries = 0;
+	const HashedPackageFile* hashedFile = nullptr;
+	if(magic == PackageFile::kMagic && size >= sizeof(PackageFile))
+	{
+		const PackageFile* file = static_cast<const PackageFile*>(mapping.GetData());
+		entries = file->entries;
+		numEntries = file->count;
+		if(sizeof(PackageFile) + numEntries * sizeof(PackageFile::Entry) > size)
+			throw std::runtime_error("Entries exceed file size");
+	}
+	else if(magic == HashedPackageFile::kMagic && size >= sizeof(HashedPackageFile))
+	{
+		hashedFile = static_cast<const HashedPackageFile*>(mapping.GetData());
+		entries = hashedFile->entries;
+		numEntries = hashedFile->tableSize;
+		if(numEntries == 0 || (numEntries & (numEntries - 1)) != 0)
+			throw std::runtime_error("Hash table size is not a power of two");
+		if(sizeof(HashedPackageFile) + numEntries * sizeof(PackageFile::Entry) > size)
+			throw std::runtime_error("Entries exceed file size");
+	}
+	else
+		throw std::runtime_error("File is not a package file");
+
+	for(size_t i = 0; i < numEntries; ++i)
+	{
+		if(entries[i].offset + entries[i].size > size)
+			throw std::runtime_error("Entry exceeds file size");
+	}
+
+	if(hashedFile)
+		mHashedPackages.push_back(AddPackage(filename, &mapping, hashedFile, hashedFile->flags));
+	else
+		Populate(filename, entries, entries + numEntries, &mapping);
+}
+
+PackageFileDirectory::Entry PackageFileDirectory::GetEntry(Hash name) const
+{
+	Entry entry;
+	if(!FindEntry(name, entry))
+		throw std::out_of_range("File not found in package files");
+	return entry;
+}
+
+bool PackageFileDirectory::FindEntry(Hash name, Entry& outEntry) const noexcept
+{
+	uint32_t package = kEmpty;
+	if(!mSlots.empty())
+	{
+		const size_t mask = mSlots.size() - 1;
+		for(size_t slot = name & mask; mSlots[slot].package != kEmpty; slot = (slot + 1) & mask)
+		{
+			const Slot& candidate = mSlots[slot];
+			if(candidate.name == name)
+			{
+				package = candidate.package;
+				outEntry.offset = candidate.offset;
+				outEntry.size = candidate.size;
+				break;
+			}
+		}
+	}
+
+	// HashedPackageFiles added after the package found above override it:
+	for(auto it = mHashedPackages.rbegin(); it != mHashedPackages.rend(); ++it)
+	{
+		if(package != kEmpty && *it < package)
+			break;
+		if(const PackageFile::Entry* entry = mPackages[*it].hashedFile->Find(name))
+		{
+			package = *it;
+			outEntry.offset = entry->offset;
+			outEntry.size = entry->size;
+			break;
+		}
+	}
+
+	if(package == kEmpty)
+		return false;
+	outEntry.file = mPackages[package].file.c_str();
+	outEntry.mapping = mPackages[package].mapping;
+	outEntry.mayBeCompressed = (mPackages[package].flags & HashedPackageFile::kCompressedEntries) != 0;
+	return true;
+}
+
+uint32_t PackageFileDirectory::AddPackage(const std::string& filename, const MappedFile* mapping, const HashedPackageFile* hashedFile, uint32_t flags)
+{
+	Package package;
+	package.file = filename;
+	package.mapping = mapping;
+	package.hashedFile = hashedFile;
+	package.flags = flags;
+	mPackages.push_back(std::move(package));
+	return static_cast<uint32_t>(mPackages.size() - 1);
+}
+
+void PackageFileDirectory::Insert(Hash name, uint32_t package, uint64_t offset, uint64_t size)
+{
+	if((mSlotCount + 1) * 2 > mSlots.size())
+		Grow();
+
+	const size_t mask = mSlots.size() - 1;
+	size_t slot = name & mask;
+	while(mSlots[slot].package != kEmpty && mSlots[slot].name != name)
+		slot = (slot + 1) & mask;
+	if(mSlots[slot].package == kEmpty)
+		mSlotCount++;
+	mSlots[slot].name = name;
+	mSlots[slot].package = package;
+	mSlots[slot].offset = offset;
+	mSlots[slot].size = size;
+}
+
+void PackageFileDirectory::Grow()
+{
+	std::vector<Slot> oldSlots(std::max<size_t>(mSlots.size() * 2, 64));
+	oldSlots.swap(mSlots);
+	const size_t mask = mSlots.size() - 1;
+	for(auto& oldSlot: oldSlots)
+	{
+		if(oldSlot.package == kEmpty)
+			continue;
+		size_t slot = oldSlot.name & mask;
+		while(mSlots[slot].package != kEmpty)
+			slot = (slot + 1) & mask;
+		mSlots[slot] = oldSlot;
+	}
+}
+
+}
+}
@@ -27,7 +27,10 @@ SOFTWARE.
 #define MOLECULAR_PACKAGEFILE_H
 
 #include <cstdint>
-#include <unordered_map>
+#include <deque>
+#include <iterator>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include <molecular/util/Hash.h>
 
@@ -35,6 +38,7 @@ namespace molecular
 {
 namespace util
 {
+class MappedFile;
 
 /// PAK-like file structure
 struct PackageFile
@@ -54,60 +58,197 @@ struct PackageFile
 static_assert(sizeof(PackageFile) == 8, "Unexpected size of PackageFile");
 static_assert(sizeof(PackageFile::Entry) == 16, "Unexpected size of PackageFile::Entry");
 
+/// PAK-like file structure with hash table as directory
+/** Entries are stored in an open-addressing hash table with tableSize slots,
+	tableSize being a power of two. An entry lives in slot name & (tableSize - 1)
+	or, on collision, in one of the following slots. Empty slots have offset 0,
+	which no file can have because the header is there. Lookups work directly
+	on the file contents without building an index. With kCompressedEntries
+	set in flags, entries can be stored as BlockCompressedFile. */
+struct HashedPackageFile
+{
+	const static uint32_t kMagic = 0x506ac4a7;
+	/// Flag: Entries may be compressed, see BlockCompression
+	const static uint32_t kCompressedEntries = 1;
+
+	uint32_t magic;
+	uint32_t count; ///< Number of files
+	uint32_t tableSize; ///< Number of entries
+	uint32_t flags;
+	PackageFile::Entry entries[0];
+
+	/// Number of slots for a given number of files
+	/** Keeps the load factor at or below 0.5. */
+	static uint32_t GetTableSize(uint32_t count)
+	{
+		uint32_t tableSize = 1;
+		while(tableSize < count * 2)
+			tableSize *= 2;
+		return tableSize;
+	}
+
+	/// Arrange entries in hash table slots
+	/** @param begin Iterator to PackageFile::Entry. Entries must have unique
+			names and non-zero offsets. */
+	template<class TIterator>
+	static std::vector<PackageFile::Entry> BuildTable(TIterator begin, TIterator end);
+
+	/// Find entry
+	/** @returns nullptr if there is no file with that name. */
+	const PackageFile::Entry* Find(Hash name) const noexcept
+	{
+		const uint32_t mask = tableSize - 1;
+		uint32_t slot = name & mask;
+		for(uint32_t i = 0; i < tableSize; ++i, slot = (slot + 1) & mask)
+		{
+			const PackageFile::Entry& entry = entries[slot];
+			if(entry.offset == 0)
+				return nullptr;
+			if(entry.name == name)
+				return &entry;
+		}
+		return nullptr;
+	}
+};
+static_assert(sizeof(HashedPackageFile) == 16, "Unexpected size of HashedPackageFile");
+
 /// Indexes multiple package files
+/** Files from package files added later override those added earlier.
+	Entries of PackageFiles are copied into an open-addressing hash table,
+	HashedPackageFiles that are memory-mapped are searched in place. Package
+	file paths are stored once per package file. */
 class PackageFileDirectory
 {
 public:
 	struct Entry
 	{
-		Entry(const std::string& file, size_t offset, size_t size) : file(file), offset(offset), size(size) {}
-		Entry() = default;
-		std::string file;
-		size_t offset;
-		size_t size;
+		/// Path of the package file
+		/** Valid as long as the PackageFileDirectory exists. */
+		const char* file = nullptr;
+		size_t offset = 0;
+		size_t size = 0;
+
+		/// Memory mapping of the package file, nullptr if not mapped
+		const MappedFile* mapping = nullptr;
+
+		/// Entry may be a BlockCompressedFile
+		/** Check with BlockCompression::IsCompressed(). */
+		bool mayBeCompressed = false;
 	};
 
 	/// Index contents of package file
 	template<class TStorage>
-	void ReadFromFile(TStorage& storage, const std::string& filename)
-	{
-		PackageFile header;
-		storage.Read(&header, sizeof(PackageFile));
-		if(header.magic != PackageFile::kMagic)
-			throw std::runtime_error("File is not a package file");
-		std::vector<PackageFile::Entry> entries(header.count);
-		storage.Read(entries.data(), sizeof(PackageFile::Entry) * header.count);
-		for(auto& entry: entries)
-		{
-			mEntries[entry.name] = Entry(filename, entry.offset, entry.size);
-		}
-	}
+	void ReadFromFile(TStorage& storage, const std::string& filename);
 
 	/// Add index entries
-	/** @param begin Iterator to PackageFile::Entry */
+	/** @param begin Iterator to PackageFile::Entry
+		@param mapping Memory mapping of the package file, if any.
+		@param flags HashedPackageFile::flags */
 	template<class TIterator>
-	void Populate(const std::string& filename, TIterator begin, TIterator end)
+	void Populate(const std::string& filename, TIterator begin, TIterator end, const MappedFile* mapping = nullptr, uint32_t flags = 0);
+
+	/// Add memory-mapped PackageFile or HashedPackageFile
+	/** Throws std::runtime_error if the file is not a valid package file. The
+		mapping must stay valid while this object exists. */
+	void AddMappedFile(const std::string& filename, const MappedFile& mapping);
+
+	/** Throws std::out_of_range if there is no such file. */
+	Entry GetEntry(Hash name) const;
+	Entry GetEntry(const char* name) const {return GetEntry(HashUtils::MakeHash(name));}
+
+	/// Find entry
+	/** @returns false if there is no file with that name. */
+	bool FindEntry(Hash name, Entry& outEntry) const noexcept;
+
+private:
+	static const uint32_t kEmpty = 0xffffffff;
+
+	struct Slot
+	{
+		Hash name = 0;
+		uint32_t package = kEmpty; ///< Index into mPackages
+		uint64_t offset = 0;
+		uint64_t size = 0;
+	};
+
+	struct Package
+	{
+		std::string file;
+		const MappedFile* mapping = nullptr;
+
+		/// Points into mapping if it is a HashedPackageFile
+		const HashedPackageFile* hashedFile = nullptr;
+
+		uint32_t flags = 0;
+	};
+
+	uint32_t AddPackage(const std::string& filename, const MappedFile* mapping, const HashedPackageFile* hashedFile = nullptr, uint32_t flags = 0);
+	void Insert(Hash name, uint32_t package, uint64_t offset, uint64_t size);
+	void Grow();
+
+	/// Deque so file names do not move
+	std::deque<Package> mPackages;
+
+	/// Indices of packages with hashedFile, in order of addition
+	std::vector<uint32_t> mHashedPackages;
+
+	std::vector<Slot> mSlots;
+	size_t mSlotCount = 0;
+};
+
+/*****************************************************************************/
+
+template<class TIterator>
+std::vector<PackageFile::Entry> HashedPackageFile::BuildTable(TIterator begin, TIterator end)
+{
+	const uint32_t tableSize = GetTableSize(static_cast<uint32_t>(std::distance(begin, end)));
+	const uint32_t mask = tableSize - 1;
+	std::vector<PackageFile::Entry> table(tableSize, PackageFile::Entry{0, 0, 0});
+	for(TIterator it = begin; it != end; ++it)
 	{
-		for(TIterator it = begin; it != end; ++it)
-			mEntries[it->name] = Entry(filename, it->offset, it->size);
+		uint32_t slot = it->name & mask;
+		while(table[slot].offset != 0)
+			slot = (slot + 1) & mask;
+		table[slot] = *it;
 	}
+	return table;
+}
 
-	Entry GetEntry(Hash name) const {return mEntries.at(name);}
-	Entry GetEntry(const char* name) const {return mEntries.at(HashUtils::MakeHash(name));}
-	const Entry* FindEntry(Hash name) const noexcept
+template<class TStorage>
+void PackageFileDirectory::ReadFromFile(TStorage& storage, const std::string& filename)
+{
+	PackageFile header;
+	storage.Read(&header, sizeof(PackageFile));
+	if(header.magic == PackageFile::kMagic)
+	{
+		std::vector<PackageFile::Entry> entries(header.count);
+		storage.Read(entries.data(), sizeof(PackageFile::Entry) * header.count);
+		Populate(filename, entries.begin(), entries.end());
+	}
+	else if(header.magic == HashedPackageFile::kMagic)
 	{
-		auto it = mEntries.find(name);
-		if(it == mEntries.end())
-			return nullptr;
-		else
-			return &(it->second);
+		uint32_t tableSizeAndFlags[2];
+		storage.Read(tableSizeAndFlags, sizeof(tableSizeAndFlags));
+		std::vector<PackageFile::Entry> entries(tableSizeAndFlags[0]);
+		storage.Read(entries.data(), sizeof(PackageFile::Entry) * entries.size());
+		Populate(filename, entries.begin(), entries.end(), nullptr, tableSizeAndFlags[1]);
 	}
+	else
+		throw std::runtime_error("File is not a package file");
+}
 
-private:
-	std::unordered_map<Hash, Entry> mEntries;
-};
+template<class TIterator>
+void PackageFileDirectory::Populate(const std::string& filename, TIterator begin, TIterator end, const MappedFile* mapping, uint32_t flags)
+{
+	const uint32_t package = AddPackage(filename, mapping, nullptr, flags);
+	for(TIterator it = begin; it != end; ++it)
+	{
+		if(it->offset != 0) // Skip empty HashedPackageFile slots
+			Insert(it->name, package, it->offset, it->size);
+	}
+}
 
 }
 }
 
-#endif // PACKAGEFILE_H
+#endif // MOLECULAR_PACKAGEFILE_H
@@ -0,0 +1,121 @@
+/*	PackageFileWriter.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PackageFileWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace molecular
+{
+namespace util
+{
+
+PackageFileWriter::PackageFileWriter(uint32_t alignment, uint32_t flags) :
+	mAlignment(alignment),
+	mFlags(flags)
+{
+	if(alignment == 0 || (alignment & (alignment - 1)) != 0)
+		throw std::runtime_error("Package file alignment must be a power of two");
+}
+
+size_t PackageFileWriter::AddFile(Hash name, uint64_t size, uint64_t payloadOffset)
+{
+	if(size > std::numeric_limits<uint32_t>::max())
+		throw std::runtime_error("File too large for package file");
+	if(payloadOffset > size)
+		throw std::runtime_error("Payload offset beyond end of file");
+
+	auto it = std::lower_bound(mSortedNames.begin(), mSortedNames.end(), name);
+	if(it != mSortedNames.end() && *it == name)
+		throw std::runtime_error("Duplicate file in package file");
+	mSortedNames.insert(it, name);
+
+	mFiles.push_back(File{name, size, payloadOffset});
+	mOffsets.clear();
+	return mFiles.size() - 1;
+}
+
+uint64_t PackageFileWriter::GetOffset(size_t index) const
+{
+	UpdateLayout();
+	return mOffsets.at(index);
+}
+
+uint64_t PackageFileWriter::GetPackageSize() const
+{
+	if(mFiles.empty())
+		return GetDataBegin();
+	return GetOffset(mFiles.size() - 1) + mFiles.back().size;
+}
+
+std::vector<uint8_t> PackageFileWriter::GetDirectory() const
+{
+	UpdateLayout();
+	std::vector<PackageFile::Entry> entries;
+	entries.reserve(mFiles.size());
+	for(size_t i = 0; i < mFiles.size(); ++i)
+		entries.push_back(PackageFile::Entry{mFiles[i].name, uint32_t(mFiles[i].size), mOffsets[i]});
+	const std::vector<PackageFile::Entry> table = HashedPackageFile::BuildTable(entries.begin(), entries.end());
+
+	HashedPackageFile header;
+	header.magic = HashedPackageFile::kMagic;
+	header.count = uint32_t(mFiles.size());
+	header.tableSize = uint32_t(table.size());
+	header.flags = mFlags;
+
+	std::vector<uint8_t> directory(sizeof(HashedPackageFile) + table.size() * sizeof(PackageFile::Entry));
+	memcpy(directory.data(), &header, sizeof(HashedPackageFile));
+	memcpy(directory.data() + sizeof(HashedPackageFile), table.data(), table.size() * sizeof(PackageFile::Entry));
+	return directory;
+}
+
+uint64_t PackageFileWriter::GetDataBegin() const
+{
+	const uint32_t tableSize = HashedPackageFile::GetTableSize(uint32_t(mFiles.size()));
+	return sizeof(HashedPackageFile) + uint64_t(tableSize) * sizeof(PackageFile::Entry);
+}
+
+void PackageFileWriter::UpdateLayout() const
+{
+	if(mOffsets.size() == mFiles.size())
+		return;
+
+	// Table size depends on the number of files, so offsets are only known
+	// when all files have been added.
+	mOffsets.resize(mFiles.size());
+	uint64_t position = GetDataBegin();
+	const uint64_t mask = mAlignment - 1;
+	for(size_t i = 0; i < mFiles.size(); ++i)
+	{
+		const uint64_t payload = (position + mFiles[i].payloadOffset + mask) & ~mask;
+		mOffsets[i] = payload - mFiles[i].payloadOffset;
+		position = mOffsets[i] + mFiles[i].size;
+	}
+}
+
+}
+}
@@ -0,0 +1,138 @@
+/*	PackageFileWriter.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_PACKAGEFILEWRITER_H
+#define MOLECULAR_PACKAGEFILEWRITER_H
+
+#include <molecular/util/Hash.h>
+#include <molecular/util/PackageFile.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace molecular
+{
+namespace util
+{
+
+/// Lays out and writes HashedPackageFiles for fast loading
+/** Files are stored in the order they are added, which should be the order
+	in which they are requested at runtime, so loading reads the package
+	sequentially. The payload of each file starts at a multiple of the
+	alignment. With the default of one page, memory-mapped payloads can be
+	uploaded without touching more pages than necessary, and pread() with
+	O_DIRECT can read them into aligned buffers. */
+class PackageFileWriter
+{
+public:
+	static const uint32_t kDefaultAlignment = 4096;
+
+	/** @param alignment Power of two.
+		@param flags HashedPackageFile flags, e.g. kCompressedEntries if
+			files are added as BlockCompressedFiles. */
+	explicit PackageFileWriter(uint32_t alignment = kDefaultAlignment, uint32_t flags = 0);
+
+	/// Append file to the layout
+	/** Throws std::runtime_error if a file with the same name was already added.
+		@param payloadOffset Offset of the part of the file that gets aligned,
+			e.g. the first mip level after a texture file header.
+		@returns Index of the file. */
+	size_t AddFile(Hash name, uint64_t size, uint64_t payloadOffset = 0);
+
+	size_t GetFileCount() const {return mFiles.size();}
+
+	/// Offset of a file within the package
+	uint64_t GetOffset(size_t index) const;
+
+	/// Size of the complete package file
+	uint64_t GetPackageSize() const;
+
+	/// Header and directory hash table
+	std::vector<uint8_t> GetDirectory() const;
+
+	/// Write complete package file
+	/** @param getContents Functor taking a file index and returning its
+			contents as std::vector<uint8_t>. Called once per file in order.
+		@param storage Storage with a Write(const void*, size_t) method. */
+	template<class TStorage, class TContentsFunc>
+	void Write(TStorage& storage, TContentsFunc&& getContents) const;
+
+private:
+	struct File
+	{
+		Hash name;
+		uint64_t size;
+		uint64_t payloadOffset;
+	};
+
+	/// Offset of first file
+	uint64_t GetDataBegin() const;
+
+	void UpdateLayout() const;
+
+	uint32_t mAlignment;
+	uint32_t mFlags;
+	std::vector<File> mFiles;
+	std::vector<Hash> mSortedNames;
+
+	/// Cached offsets, updated on demand
+	mutable std::vector<uint64_t> mOffsets;
+};
+
+/*****************************************************************************/
+
+template<class TStorage, class TContentsFunc>
+void PackageFileWriter::Write(TStorage& storage, TContentsFunc&& getContents) const
+{
+	const std::vector<uint8_t> directory = GetDirectory();
+	storage.Write(directory.data(), directory.size());
+	uint64_t position = directory.size();
+
+	const std::vector<uint8_t> padding(mAlignment, 0);
+	for(size_t i = 0; i < mFiles.size(); ++i)
+	{
+		const uint64_t offset = GetOffset(i);
+		while(position < offset)
+		{
+			const size_t paddingSize = size_t(std::min<uint64_t>(offset - position, padding.size()));
+			storage.Write(padding.data(), paddingSize);
+			position += paddingSize;
+		}
+
+		const std::vector<uint8_t> contents = getContents(i);
+		if(contents.size() != mFiles[i].size)
+			throw std::runtime_error("File size changed while writing package");
+		storage.Write(contents.data(), contents.size());
+		position += contents.size();
+	}
+}
+
+}
+}
+
+#endif // MOLECULAR_PACKAGEFILEWRITER_H
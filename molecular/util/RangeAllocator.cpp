@@ -0,0 +1,111 @@
+/*	RangeAllocator.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "RangeAllocator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace molecular
+{
+namespace util
+{
+
+const size_t RangeAllocator::kInvalid;
+
+RangeAllocator::RangeAllocator(size_t capacity) :
+	mCapacity(capacity)
+{
+	if(capacity > 0)
+		mFree[0] = capacity;
+}
+
+size_t RangeAllocator::Allocate(size_t size, size_t alignment)
+{
+	if(size == 0)
+		size = 1; // Distinct offsets for every allocation
+
+	for(auto it = mFree.begin(); it != mFree.end(); ++it)
+	{
+		const size_t begin = it->first;
+		const size_t end = begin + it->second;
+		const size_t offset = (begin + alignment - 1) / alignment * alignment;
+		if(offset + size > end)
+			continue;
+
+		// Split off padding before and rest after the allocation:
+		mFree.erase(it);
+		if(offset > begin)
+			mFree[begin] = offset - begin;
+		if(offset + size < end)
+			mFree[offset + size] = end - offset - size;
+		mAllocated[offset] = size;
+		mUsed += size;
+		return offset;
+	}
+	return kInvalid;
+}
+
+void RangeAllocator::Free(size_t offset)
+{
+	auto allocation = mAllocated.find(offset);
+	if(allocation == mAllocated.end())
+		throw std::invalid_argument("No allocation at offset");
+	size_t begin = offset;
+	size_t size = allocation->second;
+	mUsed -= size;
+	mAllocated.erase(allocation);
+
+	// Merge with neighbours:
+	auto next = mFree.lower_bound(begin);
+	if(next != mFree.end() && next->first == begin + size)
+	{
+		size += next->second;
+		next = mFree.erase(next);
+	}
+	if(next != mFree.begin())
+	{
+		auto previous = std::prev(next);
+		if(previous->first + previous->second == begin)
+		{
+			begin = previous->first;
+			size += previous->second;
+			mFree.erase(previous);
+		}
+	}
+	mFree[begin] = size;
+}
+
+size_t RangeAllocator::GetLargestFreeRange() const
+{
+	size_t largest = 0;
+	for(auto& range: mFree)
+		largest = std::max(largest, range.second);
+	return largest;
+}
+
+}
+}
@@ -0,0 +1,87 @@
+/*	RangeAllocator.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_RANGEALLOCATOR_H
+#define MOLECULAR_RANGEALLOCATOR_H
+
+#include <cstddef>
+#include <map>
+
+namespace molecular
+{
+namespace util
+{
+
+/// Sub-allocates ranges from a fixed size block, e.g. a GPU buffer
+/** First fit by address, so allocations stay packed towards the beginning.
+	Freed ranges are merged with free neighbours right away, so the free
+	list never holds adjacent ranges. Only bookkeeping, does not touch the
+	block itself. */
+class RangeAllocator
+{
+public:
+	/// Returned by Allocate() if there is no space
+	static const size_t kInvalid = static_cast<size_t>(-1);
+
+	explicit RangeAllocator(size_t capacity);
+
+	/// Reserve a range
+	/** @param alignment Power of two the offset is a multiple of.
+		@returns Offset of the range, or kInvalid if no free range is large
+			enough. */
+	size_t Allocate(size_t size, size_t alignment = 1);
+
+	/// Release a range returned by Allocate()
+	/** Throws std::invalid_argument if there is no allocation at offset. */
+	void Free(size_t offset);
+
+	size_t GetCapacity() const {return mCapacity;}
+
+	/// Bytes in allocated ranges
+	size_t GetUsed() const {return mUsed;}
+
+	bool IsEmpty() const {return mAllocated.empty();}
+
+	/// Size of the largest range Allocate() can return without alignment
+	size_t GetLargestFreeRange() const;
+
+	/// Number of free ranges, a measure of fragmentation
+	size_t GetFreeRangeCount() const {return mFree.size();}
+
+private:
+	size_t mCapacity;
+	size_t mUsed = 0;
+
+	/// Offset to size
+	std::map<size_t, size_t> mFree;
+
+	/// Offset to size
+	std::map<size_t, size_t> mAllocated;
+};
+
+}
+}
+
+#endif // MOLECULAR_RANGEALLOCATOR_H
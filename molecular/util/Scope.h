@@ -51,6 +51,11 @@ public:
 
 	void SetSibling(const Scope& sibling);
 
+	/// Replace parent
+	/** Allows keeping a Scope with long-lived variables around and hooking it
+		into a different parent every frame, instead of constructing it anew. */
+	void SetParent(const Scope& parent);
+
 	/// Create a variable and get a writable reference
 	template<class SubType>
 	SubType& Bind(Hash key);
@@ -77,7 +82,15 @@ public:
 	/// Get all variables from this scope and its parents
 	std::map<Hash, BaseType*> ToMap() const;
 
+	/// Get sorted keys of all variables from this scope and its parents
+	/** Same keys as ToMap(), but fills vectors that keep their capacity, so
+		it does not allocate when called every frame.
+		@param unsetKeys Scratch space for keys unset in child scopes. */
+	void GetKeys(std::vector<Hash>& outKeys, std::vector<Hash>& unsetKeys) const;
+
 private:
+	void AddKeys(std::vector<Hash>& keys, std::vector<Hash>& unsetKeys) const;
+
 	std::vector<Hash> mKeys;
 	std::vector<std::unique_ptr<BaseType>> mValues;
 	const Scope* mParent = nullptr;
@@ -90,6 +103,12 @@ void Scope<BaseType>::SetSibling(const Scope& sibling)
 	mSibling = &sibling;
 }
 
+template<class BaseType>
+void Scope<BaseType>::SetParent(const Scope& parent)
+{
+	mParent = &parent;
+}
+
 template<class BaseType>
 template<class SubType>
 SubType& Scope<BaseType>::Bind(Hash key)
@@ -169,12 +188,7 @@ bool Scope<BaseType>::Has(Hash key) const
 {
 	auto it = std::find(mKeys.begin(), mKeys.end(), key);
 	if(it != mKeys.end())
-	{
-		if(*it)
-			return true;
-		else
-			return false;
-	}
+		return mValues[std::distance(mKeys.begin(), it)] != nullptr; // nullptr if Unset()
 	if(mSibling && mSibling->Has(key))
 		return true;
 	else if(mParent)
@@ -204,6 +218,39 @@ std::map<Hash, BaseType*> Scope<BaseType>::ToMap() const
 	return out;
 }
 
+template<class BaseType>
+void Scope<BaseType>::GetKeys(std::vector<Hash>& outKeys, std::vector<Hash>& unsetKeys) const
+{
+	outKeys.clear();
+	unsetKeys.clear();
+	AddKeys(outKeys, unsetKeys);
+	std::sort(outKeys.begin(), outKeys.end());
+}
+
+template<class BaseType>
+void Scope<BaseType>::AddKeys(std::vector<Hash>& keys, std::vector<Hash>& unsetKeys) const
+{
+	for(size_t i = 0; i < mKeys.size(); ++i)
+	{
+		const Hash key = mKeys[i];
+		if(std::find(keys.begin(), keys.end(), key) != keys.end() || std::find(unsetKeys.begin(), unsetKeys.end(), key) != unsetKeys.end())
+			continue; // Already decided by a child scope
+		if(mValues[i])
+			keys.push_back(key);
+		else
+			unsetKeys.push_back(key);
+	}
+	if(mSibling)
+	{
+		// Like in ToMap(), keys unset in the sibling stay visible from the parent:
+		const size_t unsetCount = unsetKeys.size();
+		mSibling->AddKeys(keys, unsetKeys);
+		unsetKeys.resize(unsetCount);
+	}
+	if(mParent)
+		mParent->AddKeys(keys, unsetKeys);
+}
+
 }
 }
 
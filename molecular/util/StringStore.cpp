@@ -27,6 +27,10 @@ SOFTWARE.
 
 #include <molecular/util/Hash.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
 #include <stdexcept>
 
 namespace molecular
@@ -39,10 +43,59 @@ StringStore::StringStore(const void* fileData, size_t fileSize)
 	LoadFromFile(fileData, fileSize);
 }
 
+/// Check PerfectHashStringStoreFile header, sizes and all offsets
+/** After this, FindString() only reads inside the file and returns strings
+	terminated inside the string list. */
+static const PerfectHashStringStoreFile* CheckPerfectHashFile(const void* fileData, size_t fileSize)
+{
+	if(fileSize < sizeof(PerfectHashStringStoreFile))
+		throw std::runtime_error("String map file truncated");
+	const PerfectHashStringStoreFile* file = static_cast<const PerfectHashStringStoreFile*>(fileData);
+	if(file->magic != PerfectHashStringStoreFile::kMagic)
+		throw std::runtime_error("Unrecognized string map file");
+	if(file->bucketCount == 0)
+		throw std::runtime_error("String map file has no buckets");
+	if(file->GetSize() > fileSize)
+		throw std::runtime_error("String map file truncated");
+
+	for(uint32_t i = 0; i < file->bucketCount; ++i)
+	{
+		// Negative displacements are direct indices, positive ones are reduced modulo count:
+		const int32_t displacement = file->displacements[i];
+		if(displacement < 0 && uint32_t(-(displacement + 1)) >= file->count)
+			throw std::runtime_error("String map file has invalid displacement");
+	}
+
+	if(file->count == 0)
+		return file;
+	// Every string ends before the end of the list if the list itself ends with 0:
+	const char* stringList = file->GetStringList();
+	if(file->stringListSize == 0 || stringList[file->stringListSize - 1] != 0)
+		throw std::runtime_error("String map file has unterminated string list");
+	const StringStoreFile::Entry* entries = file->GetEntries();
+	for(uint32_t i = 0; i < file->count; ++i)
+	{
+		if(entries[i].second >= file->stringListSize)
+			throw std::runtime_error("String map file has invalid string offset");
+	}
+	return file;
+}
+
 void StringStore::LoadFromFile(const void* fileData, size_t fileSize)
 {
 	if(fileSize < sizeof(StringStoreFile))
 		throw std::runtime_error("String map file truncated");
+	if(static_cast<const PerfectHashStringStoreFile*>(fileData)->magic == PerfectHashStringStoreFile::kMagic)
+	{
+		const size_t size = size_t(CheckPerfectHashFile(fileData, fileSize)->GetSize());
+		mOffsets.clear();
+		mStringList.clear();
+		mMappedFile = nullptr;
+		mFileCopy.resize((size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+		memcpy(mFileCopy.data(), fileData, size);
+		return;
+	}
+
 	const StringStoreFile* file = static_cast<const StringStoreFile*>(fileData);
 	if(file->magic != StringStoreFile::kMagic)
 		throw std::runtime_error("Unrecognized string map file");
@@ -55,10 +108,22 @@ void StringStore::LoadFromFile(const void* fileData, size_t fileSize)
 	mOffsets.insert(file->entries, file->entries + file->count);
 	const char* stringList = static_cast<const char*>(fileData) + headerAndEntriesSize;
 	mStringList.assign(stringList, file->stringListSize);
+	mMappedFile = nullptr;
+	mFileCopy.clear();
+}
+
+void StringStore::LoadFromMappedFile(const void* fileData, size_t fileSize)
+{
+	mMappedFile = CheckPerfectHashFile(fileData, fileSize);
+	mFileCopy.clear();
+	mOffsets.clear();
+	mStringList.clear();
 }
 
 void StringStore::LoadFromText(const char* text, size_t size)
 {
+	mMappedFile = nullptr;
+	mFileCopy.clear();
 	const char* delimiters = ";\r\n";
 	mStringList.reserve(size + 1);
 	mStringList.assign(text, size);
@@ -86,6 +151,12 @@ void StringStore::LoadFromText(const char* text, size_t size)
 
 const char* StringStore::GetString(uint32_t hash) const
 {
+	if(auto file = GetFile())
+	{
+		if(const char* string = file->FindString(hash))
+			return string;
+		throw std::runtime_error("Entry not found in StringStore");
+	}
 	auto it = mOffsets.find(hash);
 	if(it == mOffsets.end())
 		throw std::runtime_error("Entry not found in StringStore");
@@ -94,11 +165,102 @@ const char* StringStore::GetString(uint32_t hash) const
 
 const char* StringStore::FindString(uint32_t hash) const noexcept
 {
+	if(auto file = GetFile())
+		return file->FindString(hash);
 	auto it = mOffsets.find(hash);
 	if(it == mOffsets.end())
 		return nullptr;
 	return &mStringList.at(it->second);
 }
 
+std::vector<uint8_t> StringStore::ToPerfectHashFile() const
+{
+	// Gather entries and string list from either source:
+	std::vector<StringStoreFile::Entry> entries;
+	const char* stringList = mStringList.data();
+	uint32_t stringListSize = static_cast<uint32_t>(mStringList.size());
+	if(auto file = GetFile())
+	{
+		entries.assign(file->GetEntries(), file->GetEntries() + file->count);
+		stringList = file->GetStringList();
+		stringListSize = file->stringListSize;
+	}
+	else
+		entries.assign(mOffsets.begin(), mOffsets.end());
+
+	const uint32_t count = static_cast<uint32_t>(entries.size());
+	const uint32_t bucketCount = std::max<uint32_t>(1, (count + 3) / 4);
+	std::vector<std::vector<uint32_t>> buckets(bucketCount);
+	for(uint32_t i = 0; i < count; ++i)
+		buckets[PerfectHashStringStoreFile::Mix(entries[i].first, 0) % bucketCount].push_back(i);
+
+	// Place large buckets first, while there are many free slots:
+	std::vector<uint32_t> order(bucketCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){return buckets[a].size() > buckets[b].size();});
+
+	std::vector<int32_t> displacements(bucketCount, 0);
+	std::vector<int32_t> slotEntries(count, -1);
+	std::vector<uint32_t> slots;
+	size_t nextFreeSlot = 0;
+	for(uint32_t bucketIndex: order)
+	{
+		const std::vector<uint32_t>& bucket = buckets[bucketIndex];
+		if(bucket.empty())
+			break;
+		else if(bucket.size() == 1)
+		{
+			// Single entries go directly to free slots:
+			while(slotEntries[nextFreeSlot] >= 0)
+				++nextFreeSlot;
+			slotEntries[nextFreeSlot] = bucket.front();
+			displacements[bucketIndex] = -static_cast<int32_t>(nextFreeSlot) - 1;
+			continue;
+		}
+
+		for(int32_t displacement = 1; ; ++displacement)
+		{
+			if(displacement == std::numeric_limits<int32_t>::max())
+				throw std::runtime_error("No perfect hash found");
+
+			slots.clear();
+			for(uint32_t entry: bucket)
+			{
+				const uint32_t slot = PerfectHashStringStoreFile::Mix(entries[entry].first, displacement) % count;
+				if(slotEntries[slot] >= 0 || std::find(slots.begin(), slots.end(), slot) != slots.end())
+					break;
+				slots.push_back(slot);
+			}
+			if(slots.size() == bucket.size())
+			{
+				for(size_t i = 0; i < slots.size(); ++i)
+					slotEntries[slots[i]] = bucket[i];
+				displacements[bucketIndex] = displacement;
+				break;
+			}
+		}
+	}
+
+	PerfectHashStringStoreFile header;
+	header.magic = PerfectHashStringStoreFile::kMagic;
+	header.count = count;
+	header.stringListSize = stringListSize;
+	header.bucketCount = bucketCount;
+
+	std::vector<uint8_t> out(size_t(header.GetSize()));
+	uint8_t* pointer = out.data();
+	memcpy(pointer, &header, sizeof(header));
+	pointer += sizeof(header);
+	memcpy(pointer, displacements.data(), bucketCount * sizeof(int32_t));
+	pointer += bucketCount * sizeof(int32_t);
+	for(uint32_t slot = 0; slot < count; ++slot)
+	{
+		memcpy(pointer, &entries[slotEntries[slot]], sizeof(StringStoreFile::Entry));
+		pointer += sizeof(StringStoreFile::Entry);
+	}
+	memcpy(pointer, stringList, stringListSize);
+	return out;
+}
+
 }
 }
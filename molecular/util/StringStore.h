@@ -30,6 +30,7 @@ SOFTWARE.
 #include <algorithm>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 namespace molecular
 {
@@ -58,6 +59,65 @@ struct StringStoreFile
 
 static_assert(sizeof(StringStoreFile) == 16, "Unexpected size of HashToStringMapFile");
 
+/// Structure for files mapping hashes to strings with a minimal perfect hash
+/** Hash and displace scheme: A hash goes to bucket Mix(hash, 0) % bucketCount.
+	If the bucket's displacement d is negative, the entry is at index -d - 1,
+	otherwise at Mix(hash, d) % count. Lookups need neither preprocessing nor
+	allocations, so the file can be used directly from a memory mapping.
+	@see StringStore::ToPerfectHashFile() */
+struct PerfectHashStringStoreFile
+{
+	static const uint32_t kMagic = 0x807a0fc1;
+	uint32_t magic;
+	uint32_t count;
+	uint32_t stringListSize;
+	uint32_t bucketCount;
+	int32_t displacements[0];
+	// Entries (StringStoreFile::Entry) start after displacements, string list after entries
+
+	static uint32_t Mix(uint32_t hash, uint32_t seed)
+	{
+		hash ^= seed * 0x9e3779b9;
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6b;
+		hash ^= hash >> 13;
+		hash *= 0xc2b2ae35;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	const StringStoreFile::Entry* GetEntries() const
+	{
+		return reinterpret_cast<const StringStoreFile::Entry*>(displacements + bucketCount);
+	}
+
+	const char* GetStringList() const
+	{
+		return reinterpret_cast<const char*>(GetEntries() + count);
+	}
+
+	/// Total file size calculated from the header
+	/** 64 bit, so that header values cannot overflow it. */
+	uint64_t GetSize() const
+	{
+		return sizeof(PerfectHashStringStoreFile) + uint64_t(bucketCount) * sizeof(int32_t) + uint64_t(count) * sizeof(StringStoreFile::Entry) + stringListSize;
+	}
+
+	const char* FindString(uint32_t hash) const noexcept
+	{
+		if(count == 0)
+			return nullptr;
+		const int32_t displacement = displacements[Mix(hash, 0) % bucketCount];
+		const uint32_t index = displacement < 0 ? uint32_t(-displacement - 1) : Mix(hash, displacement) % count;
+		const StringStoreFile::Entry& entry = GetEntries()[index];
+		if(entry.first != hash)
+			return nullptr;
+		return GetStringList() + entry.second;
+	}
+};
+
+static_assert(sizeof(PerfectHashStringStoreFile) == 16, "Unexpected size of PerfectHashStringStoreFile");
+
 /// Maps hashes to strings
 class StringStore
 {
@@ -71,9 +131,18 @@ public:
 	StringStore() = default;
 
 	/// Load from file data
-	/** @see StringStoreFile */
+	/** Data is copied.
+		@see StringStoreFile
+		@see PerfectHashStringStoreFile */
 	void LoadFromFile(const void* fileData, size_t fileSize);
 
+	/// Use PerfectHashStringStoreFile data in place
+	/** Nothing is copied, but sizes, displacements and string offsets are
+		checked once, so lookups cannot read outside the data. Throws if the
+		data is invalid. Data must stay valid while this object is in use,
+		e.g. by being memory-mapped. */
+	void LoadFromMappedFile(const void* fileData, size_t fileSize);
+
 	void LoadFromText(const char* text, size_t size);
 
 	/// Get string corresponding to the given hash
@@ -83,9 +152,13 @@ public:
 	const char* FindString(uint32_t hash) const noexcept;
 
 	/// Get number of stored strings
-	size_t GetStringCount() const {return mOffsets.size();}
+	size_t GetStringCount() const {return GetFile() ? GetFile()->count : mOffsets.size();}
+
+	/// Create PerfectHashStringStoreFile contents
+	std::vector<uint8_t> ToPerfectHashFile() const;
 
 	/// Begin iterator
+	/** Iterators do not cover data from PerfectHashStringStoreFiles. */
 	std::unordered_map<uint32_t, uint32_t>::const_iterator begin() const {return mOffsets.begin();}
 
 	/// End iterator
@@ -94,6 +167,17 @@ public:
 private:
 	std::unordered_map<uint32_t, uint32_t> mOffsets;
 	std::string mStringList;
+
+	const PerfectHashStringStoreFile* GetFile() const
+	{
+		return mFileCopy.empty() ? mMappedFile : reinterpret_cast<const PerfectHashStringStoreFile*>(mFileCopy.data());
+	}
+
+	/// External perfect hash file data
+	const PerfectHashStringStoreFile* mMappedFile = nullptr;
+
+	/// Copy of perfect hash file data, uint32_t for alignment
+	std::vector<uint32_t> mFileCopy;
 };
 
 }
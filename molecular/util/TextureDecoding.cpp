@@ -0,0 +1,181 @@
+/*	TextureDecoding.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "TextureDecoding.h"
+#include "TgaFile.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace molecular
+{
+namespace util
+{
+namespace TextureDecoding
+{
+
+DecodedTexture DecodeTga(const void* data, size_t size, bool generateMipmaps)
+{
+	TgaFile2 file(data, size);
+	const unsigned int width = file.GetWidth();
+	const unsigned int height = file.GetHeight();
+	if(width == 0 || height == 0)
+		throw std::runtime_error("TGA image is empty");
+
+	DecodedTexture texture;
+	texture.format = file.GetFormat();
+	if(texture.format == PF_NONE)
+		throw std::runtime_error("Unsupported TGA pixel format");
+
+	unsigned int bytesPerPixel = file.GetBytesPerPixel();
+	if(texture.format == PF_B8G8R8)
+	{
+		std::vector<uint8_t> decoded(file.GetImageSize());
+		file.CopyImageDataTopDown(decoded.data());
+		texture.data.resize(size_t(width) * height * 4);
+		ExpandTo32Bit(decoded.data(), size_t(width) * height, texture.data.data());
+		texture.format = PF_B8G8R8A8;
+		bytesPerPixel = 4;
+	}
+	else
+	{
+		texture.data.resize(file.GetImageSize());
+		file.CopyImageDataTopDown(texture.data.data());
+	}
+
+	texture.levels.push_back(DecodedTexture::Level{width, height, 0, texture.data.size()});
+	if(generateMipmaps && bytesPerPixel == 4)
+		GenerateMipLevels(texture, bytesPerPixel);
+	return texture;
+}
+
+void ExpandTo32Bit(const uint8_t* in, size_t pixelCount, uint8_t* out, uint8_t alpha)
+{
+	for(size_t i = 0; i < pixelCount; ++i)
+	{
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		out[3] = alpha;
+		in += 3;
+		out += 4;
+	}
+}
+
+/// Source pixels and weights along one axis for an output pixel of Downsample()
+/** Odd sizes get three taps per output pixel, weighted so that every source
+	pixel contributes equally, including the last one.
+	@returns Number of taps. */
+static unsigned int GetDownsampleTaps(unsigned int i, unsigned int size, unsigned int outIndices[3], unsigned int outWeights[3])
+{
+	if(size == 1)
+	{
+		outIndices[0] = 0;
+		outWeights[0] = 1;
+		return 1;
+	}
+	else if(size % 2 == 0)
+	{
+		outIndices[0] = 2 * i;
+		outIndices[1] = 2 * i + 1;
+		outWeights[0] = outWeights[1] = 1;
+		return 2;
+	}
+
+	// Each output pixel covers size / outSize source pixels:
+	const unsigned int outSize = size / 2;
+	outIndices[0] = 2 * i;
+	outIndices[1] = 2 * i + 1;
+	outIndices[2] = 2 * i + 2;
+	outWeights[0] = outSize - i;
+	outWeights[1] = outSize;
+	outWeights[2] = i + 1;
+	return 3;
+}
+
+void Downsample(const uint8_t* in, unsigned int width, unsigned int height, unsigned int bytesPerPixel, uint8_t* out)
+{
+	const unsigned int outWidth = std::max(1u, width / 2);
+	const unsigned int outHeight = std::max(1u, height / 2);
+	const size_t lineSize = size_t(width) * bytesPerPixel;
+	unsigned int ys[3], yWeights[3], xs[3], xWeights[3];
+	for(unsigned int y = 0; y < outHeight; ++y)
+	{
+		const unsigned int yTaps = GetDownsampleTaps(y, height, ys, yWeights);
+		for(unsigned int x = 0; x < outWidth; ++x)
+		{
+			const unsigned int xTaps = GetDownsampleTaps(x, width, xs, xWeights);
+			uint64_t weightSum = 0;
+			for(unsigned int ty = 0; ty < yTaps; ++ty)
+			{
+				for(unsigned int tx = 0; tx < xTaps; ++tx)
+					weightSum += uint64_t(yWeights[ty]) * xWeights[tx];
+			}
+			for(unsigned int c = 0; c < bytesPerPixel; ++c)
+			{
+				uint64_t sum = 0;
+				for(unsigned int ty = 0; ty < yTaps; ++ty)
+				{
+					const uint8_t* line = in + ys[ty] * lineSize + c;
+					for(unsigned int tx = 0; tx < xTaps; ++tx)
+						sum += uint64_t(yWeights[ty]) * xWeights[tx] * line[size_t(xs[tx]) * bytesPerPixel];
+				}
+				*out++ = uint8_t((sum + weightSum / 2) / weightSum);
+			}
+		}
+	}
+}
+
+void GenerateMipLevels(DecodedTexture& texture, unsigned int bytesPerPixel)
+{
+	if(texture.levels.size() != 1)
+		throw std::runtime_error("Texture must have exactly one level");
+
+	// Reserve everything up front, so the loop does not reallocate:
+	size_t totalSize = 0;
+	for(unsigned int w = texture.levels[0].width, h = texture.levels[0].height; ; w = std::max(1u, w / 2), h = std::max(1u, h / 2))
+	{
+		totalSize += size_t(w) * h * bytesPerPixel;
+		if(w == 1 && h == 1)
+			break;
+	}
+	texture.data.resize(totalSize);
+
+	while(texture.levels.back().width > 1 || texture.levels.back().height > 1)
+	{
+		const DecodedTexture::Level& previous = texture.levels.back();
+		DecodedTexture::Level level;
+		level.width = std::max(1u, previous.width / 2);
+		level.height = std::max(1u, previous.height / 2);
+		level.offset = previous.offset + previous.size;
+		level.size = size_t(level.width) * level.height * bytesPerPixel;
+		Downsample(texture.data.data() + previous.offset, previous.width, previous.height, bytesPerPixel, texture.data.data() + level.offset);
+		texture.levels.push_back(level);
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,91 @@
+/*	TextureDecoding.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_TEXTUREDECODING_H
+#define MOLECULAR_TEXTUREDECODING_H
+
+#include <molecular/util/PixelFormat.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace molecular
+{
+namespace util
+{
+
+/// Uncompressed texture with mip levels, ready for upload
+struct DecodedTexture
+{
+	struct Level
+	{
+		unsigned int width;
+		unsigned int height;
+		size_t offset; ///< Offset in data
+		size_t size;
+	};
+
+	PixelFormat format = PF_NONE;
+	std::vector<Level> levels;
+	std::vector<uint8_t> data;
+
+	const void* GetLevelData(size_t level) const {return data.data() + levels[level].offset;}
+};
+
+/// Decoding of image files into upload-ready textures
+/** Meant to run in worker threads, so the render thread only has to upload. */
+namespace TextureDecoding
+{
+
+/// Decode TGA file
+/** Decodes raw and RLE images with the first line at the top. 24 bit BGR
+	gets expanded to BGRA, which GPUs use natively, so the driver does not
+	have to convert on upload. Throws std::runtime_error on unsupported or
+	corrupt files.
+	@param generateMipmaps Build full mip chain for four byte formats. Other
+		formats keep a single level, because their lines are not four byte
+		aligned in smaller levels. */
+DecodedTexture DecodeTga(const void* data, size_t size, bool generateMipmaps = true);
+
+/// Expand 24 bit pixels to 32 bit with the given alpha value
+void ExpandTo32Bit(const uint8_t* in, size_t pixelCount, uint8_t* out, uint8_t alpha = 0xff);
+
+/// Half the size of an image with a box filter
+/** Along odd sizes, each output pixel averages three source pixels with
+	weights that give every source pixel the same share, so the last row or
+	column is not dropped.
+	@param out Buffer for max(1, width / 2) * max(1, height / 2) pixels. */
+void Downsample(const uint8_t* in, unsigned int width, unsigned int height, unsigned int bytesPerPixel, uint8_t* out);
+
+/// Append all smaller mip levels to a texture with one level
+void GenerateMipLevels(DecodedTexture& texture, unsigned int bytesPerPixel);
+
+}
+
+}
+}
+
+#endif // MOLECULAR_TEXTUREDECODING_H
@@ -0,0 +1,194 @@
+/*	TextureFileLayout.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "TextureFileLayout.h"
+#include <molecular/util/GlConstants.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace molecular
+{
+namespace util
+{
+
+namespace
+{
+
+uint32_t ReadUInt32(const uint8_t* data)
+{
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+constexpr uint32_t MakeFourCc(char a, char b, char c, char d)
+{
+	return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+/// Bytes per 4x4 block of supported compressed formats, 0 if unsupported
+size_t GetBlockSize(uint32_t glInternalFormat)
+{
+	using Gl = GlConstants;
+	switch(glInternalFormat)
+	{
+	case Gl::COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case Gl::COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case Gl::COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case Gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case Gl::ETC1_RGB8_OES:
+	case Gl::COMPRESSED_RGB8_ETC2:
+	case Gl::COMPRESSED_SRGB8_ETC2:
+		return 8;
+	case Gl::COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case Gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case Gl::COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case Gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+	case Gl::COMPRESSED_RGBA8_ETC2_EAC:
+	case Gl::COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+		return 16;
+	}
+	return 0;
+}
+
+}
+
+bool TextureFileLayout::FromHeader(const void* data, size_t size, TextureFileLayout& outLayout)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	return FromDds(bytes, size, outLayout) || FromKtx(bytes, size, outLayout);
+}
+
+bool TextureFileLayout::FromDds(const uint8_t* data, size_t size, TextureFileLayout& outLayout)
+{
+	const size_t kHeaderSize = 128; // Including magic number
+	const size_t kDx10HeaderSize = 20;
+	const uint32_t kCaps2Cubemap = 0x200;
+	const uint32_t kCaps2Volume = 0x200000;
+	const uint32_t kPixelFormatFourCc = 0x4;
+
+	if(size < kHeaderSize || ReadUInt32(data) != MakeFourCc('D', 'D', 'S', ' '))
+		return false;
+
+	const uint8_t* header = data + 4;
+	const unsigned int height = ReadUInt32(header + 8);
+	const unsigned int width = ReadUInt32(header + 12);
+	const unsigned int mipMapCount = std::max(ReadUInt32(header + 24), 1u);
+	const uint32_t pixelFormatFlags = ReadUInt32(header + 76);
+	const uint32_t fourCc = ReadUInt32(header + 80);
+	const uint32_t caps2 = ReadUInt32(header + 108);
+	if((caps2 & (kCaps2Cubemap | kCaps2Volume)) || !(pixelFormatFlags & kPixelFormatFourCc))
+		return false;
+
+	using Gl = GlConstants;
+	uint32_t glInternalFormat = 0;
+	size_t dataOffset = kHeaderSize;
+	if(fourCc == MakeFourCc('D', 'X', '1', '0'))
+	{
+		if(size < kHeaderSize + kDx10HeaderSize)
+			return false;
+		const uint8_t* dx10Header = data + kHeaderSize;
+		const uint32_t kResourceDimensionTexture2D = 3;
+		const uint32_t kMiscTextureCube = 0x4;
+		if(ReadUInt32(dx10Header + 4) != kResourceDimensionTexture2D || (ReadUInt32(dx10Header + 8) & kMiscTextureCube) || ReadUInt32(dx10Header + 12) > 1)
+			return false;
+		switch(ReadUInt32(dx10Header)) // DXGI_FORMAT
+		{
+		case 71: glInternalFormat = Gl::COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+		case 72: glInternalFormat = Gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT; break;
+		case 74: glInternalFormat = Gl::COMPRESSED_RGBA_S3TC_DXT3_EXT; break;
+		case 75: glInternalFormat = Gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT; break;
+		case 77: glInternalFormat = Gl::COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+		case 78: glInternalFormat = Gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; break;
+		default: return false;
+		}
+		dataOffset += kDx10HeaderSize;
+	}
+	else if(fourCc == MakeFourCc('D', 'X', 'T', '1'))
+		glInternalFormat = Gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+	else if(fourCc == MakeFourCc('D', 'X', 'T', '3'))
+		glInternalFormat = Gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+	else if(fourCc == MakeFourCc('D', 'X', 'T', '5'))
+		glInternalFormat = Gl::COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+	else
+		return false;
+
+	if(width == 0 || height == 0)
+		return false;
+	outLayout.glInternalFormat = glInternalFormat;
+	outLayout.AddBlockCompressedLevels(width, height, mipMapCount, dataOffset, GetBlockSize(glInternalFormat), 0);
+	return true;
+}
+
+bool TextureFileLayout::FromKtx(const uint8_t* data, size_t size, TextureFileLayout& outLayout)
+{
+	const uint8_t kIdentifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+	const size_t kHeaderSize = 64;
+	const uint32_t kEndianness = 0x04030201;
+
+	if(size < kHeaderSize || memcmp(data, kIdentifier, sizeof(kIdentifier)) != 0)
+		return false;
+	if(ReadUInt32(data + 12) != kEndianness)
+		return false; // Byte-swapped files are not supported
+
+	const uint32_t glType = ReadUInt32(data + 16);
+	const uint32_t glInternalFormat = ReadUInt32(data + 28);
+	const unsigned int width = ReadUInt32(data + 36);
+	const unsigned int height = ReadUInt32(data + 40);
+	const uint32_t depth = ReadUInt32(data + 44);
+	const uint32_t arrayElements = ReadUInt32(data + 48);
+	const uint32_t faces = ReadUInt32(data + 52);
+	const unsigned int mipmapLevels = std::max(ReadUInt32(data + 56), 1u);
+	const uint32_t keyValueDataSize = ReadUInt32(data + 60);
+
+	const size_t blockSize = GetBlockSize(glInternalFormat);
+	if(glType != 0 || blockSize == 0 || depth != 0 || arrayElements != 0 || faces != 1 || width == 0 || height == 0)
+		return false;
+
+	outLayout.glInternalFormat = glInternalFormat;
+	// Each level is preceded by its size, block sizes need no padding:
+	outLayout.AddBlockCompressedLevels(width, height, mipmapLevels, kHeaderSize + keyValueDataSize, blockSize, sizeof(uint32_t));
+	return true;
+}
+
+void TextureFileLayout::AddBlockCompressedLevels(unsigned int width, unsigned int height, unsigned int count, size_t offset, size_t blockSize, size_t levelPrefix)
+{
+	levels.clear();
+	for(unsigned int i = 0; i < count && i < 32; ++i)
+	{
+		const size_t levelSize = std::max((width + 3) / 4, 1u) * std::max((height + 3) / 4, 1u) * blockSize;
+		offset += levelPrefix;
+		levels.push_back(Level{width, height, offset, levelSize});
+		offset += levelSize;
+		if(width == 1 && height == 1)
+			break;
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+}
+
+}
+}
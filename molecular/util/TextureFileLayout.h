@@ -0,0 +1,85 @@
+/*	TextureFileLayout.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_TEXTUREFILELAYOUT_H
+#define MOLECULAR_TEXTUREFILELAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace molecular
+{
+namespace util
+{
+
+/// Location of mip levels inside DDS and KTX files
+/** Computed from the file header alone, so individual levels can be read
+	with range reads instead of loading the whole file. Only single 2D images
+	in block-compressed formats are supported, which covers what the asset
+	pipeline produces. Levels are stored from largest to smallest in both
+	formats, so a range of consecutive levels is one consecutive range of
+	bytes. */
+struct TextureFileLayout
+{
+	struct Level
+	{
+		unsigned int width;
+		unsigned int height;
+		size_t offset; ///< Offset of the level data in the file
+		size_t size;
+	};
+
+	/// Header bytes needed by FromHeader(), less if the file is smaller
+	static const size_t kMaxHeaderSize = 148;
+
+	/// Parse DDS or KTX header
+	/** @param size Bytes available, at most kMaxHeaderSize are looked at.
+		@returns false if the file is not a DDS or KTX file or if it is not
+			supported. */
+	static bool FromHeader(const void* data, size_t size, TextureFileLayout& outLayout);
+
+	/// Range covering levels first to last inclusive
+	size_t GetRangeOffset(unsigned int first) const {return levels.at(first).offset;}
+	size_t GetRangeSize(unsigned int first, unsigned int last) const {return levels.at(last).offset + levels.at(last).size - levels.at(first).offset;}
+
+	/// Compressed GL internal format, see GlConstants
+	uint32_t glInternalFormat = 0;
+
+	/// Level 0 is the largest
+	std::vector<Level> levels;
+
+private:
+	static bool FromDds(const uint8_t* data, size_t size, TextureFileLayout& outLayout);
+	static bool FromKtx(const uint8_t* data, size_t size, TextureFileLayout& outLayout);
+
+	/// Fill levels for 4x4 block compression
+	void AddBlockCompressedLevels(unsigned int width, unsigned int height, unsigned int count, size_t offset, size_t blockSize, size_t levelPrefix);
+};
+
+}
+}
+
+#endif // MOLECULAR_TEXTUREFILELAYOUT_H
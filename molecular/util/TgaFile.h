@@ -29,6 +29,8 @@ SOFTWARE.
 #include <stdexcept>
 #include <molecular/util/PixelFormat.h>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
 
 namespace molecular
 {
@@ -36,7 +38,7 @@ namespace util
 {
 
 /// Interface to TGA files
-/** Indexed and/or RLE images not supported. Does not copy any data. */
+/** Indexed images not supported. Does not copy any data. */
 class TgaFile2
 {
 public:
@@ -61,7 +63,8 @@ public:
 
 	/** @param data File contents. Must be valid while this object is in use. */
 	TgaFile2(const void* data, size_t size) :
-		mData(data)
+		mData(data),
+		mSize(size)
 	{
 		if(size < sizeof(Header))
 			throw std::runtime_error("TGA file too short");
@@ -71,11 +74,11 @@ public:
 		{
 		case kRgb:
 		case kMono:
+		case kRgbRle:
+		case kMonoRle:
 			break;
 		case kIndexed: throw std::runtime_error("Unsupported TGA format: Indexed");
 		case kIndexedRle: throw std::runtime_error("Unsupported TGA format: Indexed RLE");
-		case kRgbRle: throw std::runtime_error("Unsupported TGA format: RGB RLE");
-		case kMonoRle: throw std::runtime_error("Unsupported TGA format: Mono RLE");
 		default:
 			{
 				std::ostringstream oss;
@@ -84,7 +87,12 @@ public:
 			}
 		}
 
-		if(header->idLength + header->paletteEntrySize + GetImageSize() > size)
+		if(GetBytesPerPixel() == 0)
+			throw std::runtime_error("Unsupported TGA pixel size");
+
+		// Size of RLE data is only known after decoding:
+		const size_t minDataSize = IsRle() ? 0 : GetImageSize();
+		if(sizeof(Header) + header->idLength + header->paletteEntrySize + minDataSize > size)
 			throw std::runtime_error("TGA file too short");
 	}
 
@@ -103,27 +111,37 @@ public:
 	PixelFormat GetFormat() const
 	{
 		const Header* header = static_cast<const Header*>(mData);
-		if(header->imageType == kRgb && header->bitsPerPixel == 24)
+		const bool rgb = header->imageType == kRgb || header->imageType == kRgbRle;
+		const bool mono = header->imageType == kMono || header->imageType == kMonoRle;
+		if(rgb && header->bitsPerPixel == 24)
 			return PF_B8G8R8;
-		else if(header->imageType == kRgb && header->bitsPerPixel == 32)
+		else if(rgb && header->bitsPerPixel == 32)
 			return PF_B8G8R8A8;
-		else if(header->imageType == kMono && header->bitsPerPixel == 8)
+		else if(mono && header->bitsPerPixel == 8)
 			return PF_L8;
-		else if(header->imageType == kMono && header->bitsPerPixel == 16)
+		else if(mono && header->bitsPerPixel == 16)
 			return PF_L8A8; // Oder andersrum?
 		return PF_NONE;
 	}
 
+	/// Pointer to raw or RLE encoded image data
 	const void* GetImageData() const
 	{
 		const Header* header = static_cast<const Header*>(mData);
 		return static_cast<const uint8_t*>(mData) + header->idLength + header->paletteEntrySize + sizeof(Header);
 	}
 
+	/// Size of decoded image data
 	size_t GetImageSize() const
 	{
 		const Header* header = static_cast<const Header*>(mData);
-		return GetWidth() * GetHeight() * (header->bitsPerPixel / 8);
+		return size_t(GetWidth()) * GetHeight() * (header->bitsPerPixel / 8);
+	}
+
+	bool IsRle() const
+	{
+		const uint8_t type = static_cast<const Header*>(mData)->imageType;
+		return type == kRgbRle || type == kMonoRle;
 	}
 
 	bool IsUpsideDown() const
@@ -137,7 +155,95 @@ public:
 		return static_cast<const Header*>(mData)->bitsPerPixel / 8;
 	}
 
+	/// Copy image data to output buffer with the first line at the top
+	/** Flips lines if IsUpsideDown() returns true. Decodes RLE images.
+		@param out Buffer of at least GetImageSize() bytes. */
+	void CopyImageDataTopDown(void* out) const
+	{
+		if(IsRle())
+		{
+			DecodeRleTopDown(static_cast<uint8_t*>(out));
+			return;
+		}
+
+		const uint8_t* input = static_cast<const uint8_t*>(GetImageData());
+		uint8_t* output = static_cast<uint8_t*>(out);
+		if(!IsUpsideDown())
+		{
+			memcpy(output, input, GetImageSize());
+			return;
+		}
+
+		// Read image bottom-up
+		const size_t lineSize = GetWidth() * GetBytesPerPixel();
+		const unsigned int height = GetHeight();
+		for(size_t line = 0; line < height; ++line)
+			memcpy(output + (height - line - 1) * lineSize, input + line * lineSize, lineSize);
+	}
+
 private:
+	/// Decode RLE packets directly into the flipped line
+	/** Packets may span lines. Throws if the data ends early. */
+	void DecodeRleTopDown(uint8_t* output) const
+	{
+		const uint8_t* input = static_cast<const uint8_t*>(GetImageData());
+		const uint8_t* const inputEnd = static_cast<const uint8_t*>(mData) + mSize;
+		const unsigned int bytesPerPixel = GetBytesPerPixel();
+		const size_t width = GetWidth();
+		const size_t height = GetHeight();
+		const bool upsideDown = IsUpsideDown();
+		if(width == 0)
+			return;
+
+		size_t line = 0, x = 0;
+		while(line < height)
+		{
+			if(input >= inputEnd)
+				throw std::runtime_error("TGA RLE data truncated");
+			const uint8_t packetHeader = *input++;
+			size_t count = (packetHeader & 0x7f) + 1;
+			const bool run = (packetHeader & 0x80) != 0;
+			const size_t packetDataSize = run ? bytesPerPixel : count * bytesPerPixel;
+			if(size_t(inputEnd - input) < packetDataSize)
+				throw std::runtime_error("TGA RLE data truncated");
+
+			while(count > 0 && line < height)
+			{
+				const size_t pixels = std::min(count, width - x);
+				uint8_t* dest = output + ((upsideDown ? height - line - 1 : line) * width + x) * bytesPerPixel;
+				if(!run)
+				{
+					memcpy(dest, input, pixels * bytesPerPixel);
+					input += pixels * bytesPerPixel;
+				}
+				else if(bytesPerPixel == 4)
+				{
+					uint32_t pixel;
+					memcpy(&pixel, input, 4);
+					for(size_t i = 0; i < pixels; ++i)
+						memcpy(dest + i * 4, &pixel, 4);
+				}
+				else
+				{
+					for(size_t i = 0; i < pixels; ++i)
+						memcpy(dest + i * bytesPerPixel, input, bytesPerPixel);
+				}
+
+				count -= pixels;
+				x += pixels;
+				if(x == width)
+				{
+					x = 0;
+					++line;
+				}
+			}
+			if(run)
+				input += bytesPerPixel;
+			else
+				input += count * bytesPerPixel; // Pixels beyond the image
+		}
+	}
+
 	enum
 	{
 		kNoData = 0,
@@ -150,6 +256,7 @@ private:
 	};
 
 	const void* mData;
+	size_t mSize;
 };
 
 }
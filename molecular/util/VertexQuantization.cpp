@@ -0,0 +1,143 @@
+/*	VertexQuantization.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace molecular
+{
+namespace util
+{
+namespace VertexQuantization
+{
+
+uint16_t ToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint16_t sign = (bits >> 16) & 0x8000;
+	const uint32_t floatExponent = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	if(floatExponent == 0xff)
+		return sign | 0x7c00 | (mantissa ? 0x200 : 0); // Infinity or NaN
+
+	const int exponent = int(floatExponent) - 127 + 15;
+	if(exponent >= 31)
+		return sign | 0x7c00; // Overflow to infinity
+
+	uint32_t half;
+	uint32_t rest;
+	uint32_t halfway;
+	if(exponent <= 0)
+	{
+		// Subnormal or zero:
+		if(exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		const int shift = 14 - exponent;
+		half = mantissa >> shift;
+		rest = mantissa & ((1u << shift) - 1);
+		halfway = 1u << (shift - 1);
+	}
+	else
+	{
+		half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+		rest = mantissa & 0x1fff;
+		halfway = 0x1000;
+	}
+
+	// A carry into the exponent is correct, up to infinity:
+	if(rest > halfway || (rest == halfway && (half & 1)))
+		half++;
+	return sign | static_cast<uint16_t>(half);
+}
+
+float FromHalf(uint16_t half)
+{
+	const bool negative = (half & 0x8000) != 0;
+	const int exponent = (half >> 10) & 0x1f;
+	const int mantissa = half & 0x3ff;
+	float value;
+	if(exponent == 0)
+		value = std::ldexp(float(mantissa), -24);
+	else if(exponent == 31)
+		value = mantissa ? NAN : INFINITY;
+	else
+		value = std::ldexp(float(mantissa | 0x400), exponent - 25);
+	return negative ? -value : value;
+}
+
+uint16_t ToUnorm16(float value, float min, float extent)
+{
+	if(!(extent > 0.0f))
+		return 0;
+	const float normalized = std::min(std::max((value - min) / extent, 0.0f), 1.0f);
+	return static_cast<uint16_t>(std::lround(normalized * 65535.0f));
+}
+
+void EncodeOctahedral(const float vector[3], int16_t out[2])
+{
+	const float length = std::abs(vector[0]) + std::abs(vector[1]) + std::abs(vector[2]);
+	if(length == 0.0f)
+	{
+		out[0] = out[1] = 0;
+		return;
+	}
+
+	float x = vector[0] / length;
+	float y = vector[1] / length;
+	if(vector[2] < 0.0f)
+	{
+		// Fold lower hemisphere over the diagonals:
+		const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+	out[0] = static_cast<int16_t>(std::lround(std::min(std::max(x, -1.0f), 1.0f) * 32767.0f));
+	out[1] = static_cast<int16_t>(std::lround(std::min(std::max(y, -1.0f), 1.0f) * 32767.0f));
+}
+
+void DecodeOctahedral(const int16_t encoded[2], float out[3])
+{
+	// Same as the vertex shader, see DefaultProgramData:
+	float x = std::max(encoded[0] / 32767.0f, -1.0f);
+	float y = std::max(encoded[1] / 32767.0f, -1.0f);
+	const float z = 1.0f - std::abs(x) - std::abs(y);
+	const float t = std::max(-z, 0.0f);
+	x += (x >= 0.0f) ? -t : t;
+	y += (y >= 0.0f) ? -t : t;
+	const float length = std::sqrt(x * x + y * y + z * z);
+	out[0] = x / length;
+	out[1] = y / length;
+	out[2] = z / length;
+}
+
+}
+}
+}
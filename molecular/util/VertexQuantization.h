@@ -0,0 +1,64 @@
+/*	VertexQuantization.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef MOLECULAR_VERTEXQUANTIZATION_H
+#define MOLECULAR_VERTEXQUANTIZATION_H
+
+#include <cstdint>
+
+namespace molecular
+{
+namespace util
+{
+
+/// Compact encodings of vertex attributes
+/** Decoded by the GPU's attribute fetch (normalized integers, half floats)
+	plus a few instructions in the vertex shader, see DefaultProgramData. */
+namespace VertexQuantization
+{
+
+/// Convert to IEEE 754 half precision, rounding to nearest even
+uint16_t ToHalf(float value);
+
+/// Convert from IEEE 754 half precision
+float FromHalf(uint16_t half);
+
+/// Map value from min to min + extent to the full 16 bit unsigned range
+/** Values outside are clamped. */
+uint16_t ToUnorm16(float value, float min, float extent);
+
+/// Encode unit vector with octahedral mapping
+/** Two normalized 16 bit integers, mean angular error well below 0.01
+	degrees. Zero vectors encode as +Z. */
+void EncodeOctahedral(const float vector[3], int16_t out[2]);
+
+/// Decode octahedral mapping to unit vector
+void DecodeOctahedral(const int16_t encoded[2], float out[3]);
+
+}
+
+}
+}
+
+#endif // MOLECULAR_VERTEXQUANTIZATION_H
@@ -0,0 +1,70 @@
+/*	AllocationCounter.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+/// Allocations of this thread, incremented by the operator new replacements below
+thread_local size_t gAllocationCount = 0;
+
+void* Allocate(size_t size)
+{
+	++gAllocationCount;
+	if(void* pointer = std::malloc(size ? size : 1))
+		return pointer;
+	throw std::bad_alloc();
+}
+}
+
+void* operator new(size_t size) {return Allocate(size);}
+void* operator new[](size_t size) {return Allocate(size);}
+void operator delete(void* pointer) noexcept {std::free(pointer);}
+void operator delete[](void* pointer) noexcept {std::free(pointer);}
+void operator delete(void* pointer, size_t) noexcept {std::free(pointer);}
+void operator delete[](void* pointer, size_t) noexcept {std::free(pointer);}
+
+namespace molecular
+{
+
+AllocationCounter::AllocationCounter() :
+	mStart(gAllocationCount)
+{
+}
+
+size_t AllocationCounter::GetCount() const
+{
+	return gAllocationCount - mStart;
+}
+
+void AllocationCounter::Reset()
+{
+	mStart = gAllocationCount;
+}
+
+}
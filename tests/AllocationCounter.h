@@ -0,0 +1,54 @@
+/*	AllocationCounter.h
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MOLECULAR_ALLOCATIONCOUNTER_H
+#define MOLECULAR_ALLOCATIONCOUNTER_H
+
+#include <cstddef>
+
+namespace molecular
+{
+
+/// Counts heap allocations of the calling thread while in scope
+/** Works by replacing the global operator new in AllocationCounter.cpp, so
+	it is only available in the test executable. Typical use is constructing
+	one right before a warm frame and checking GetCount() afterwards. */
+class AllocationCounter
+{
+public:
+	AllocationCounter();
+
+	/// Number of allocations since construction or the last Reset()
+	size_t GetCount() const;
+
+	void Reset();
+
+private:
+	size_t mStart;
+};
+
+}
+
+#endif // MOLECULAR_ALLOCATIONCOUNTER_H
@@ -0,0 +1,293 @@
+/*	TestAllocationsPerFrame.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include "AllocationCounter.h"
+#include <molecular/Config.h>
+#include <molecular/gfx/DrawText.h>
+#include <molecular/gfx/Scope.h>
+#include <molecular/util/FontAtlasDescriptionFile.h>
+#include <molecular/util/ManualTaskQueue.h>
+#if OpenGL_EGL_FOUND
+#include <molecular/gfx/RenderManager.h>
+#include <molecular/gfx/functions/DrawMeshData.h>
+#include <molecular/gfx/functions/FlatScene.h>
+#include <molecular/gfx/functions/Transform.h>
+#include <molecular/gfx/opengl/EglOffscreenContext.h>
+#include <molecular/util/DummyFileLoader.h>
+#include <molecular/util/FileServer.h>
+#include <molecular/util/TaskDispatcher.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+using namespace molecular;
+using gfx::Attribute;
+using gfx::Scope;
+using gfx::Uniform;
+
+namespace
+{
+struct NullMutex
+{
+	void Lock() {}
+	void Unlock() {}
+};
+}
+
+TEST_CASE("TestAllocationsPerFrameScope")
+{
+	const int kObjects = 100;
+
+	// Variables set once, like ViewSetup's projection and view matrices:
+	Scope rootScope;
+	rootScope.Set("projectionMatrix"_H, Uniform<Matrix4>(Matrix4::Identity()));
+	rootScope.Set("viewMatrix"_H, Uniform<Matrix4>(Matrix4::Identity()));
+
+	// Long-lived scopes, like RenderFunction::mObjectScope and DrawMeshData's attribute scopes:
+	std::vector<std::unique_ptr<Scope>> objectScopes;
+	std::vector<std::unique_ptr<Scope>> attributeScopes;
+	for(int i = 0; i < kObjects; ++i)
+	{
+		objectScopes.emplace_back(new Scope);
+		objectScopes.back()->Set("diffuseColor"_H, Uniform<Vector3>(Vector3(1, 0, 0)));
+		attributeScopes.emplace_back(new Scope);
+		attributeScopes.back()->Set("vertexPositionAttr"_H, Attribute(nullptr, 3));
+		attributeScopes.back()->Set("vertexNormalAttr"_H, Attribute(nullptr, 3));
+	}
+
+	SECTION("Attribute scopes")
+	{
+		AllocationCounter counter;
+		for(auto& attributeScope: attributeScopes)
+		{
+			attributeScope->SetParent(rootScope);
+			CHECK(attributeScope->Has("projectionMatrix"_H));
+		}
+		CHECK(counter.GetCount() == 0);
+	}
+
+	SECTION("Transform and DrawMesh")
+	{
+		// Long-lived scopes, like Transform::mScope:
+		std::vector<std::unique_ptr<Scope>> transformScopes;
+		for(int i = 0; i < kObjects; ++i)
+			transformScopes.emplace_back(new Scope);
+
+		for(int frame = 0; frame < 2; ++frame)
+		{
+			// The first frame creates the variables:
+			AllocationCounter counter;
+			for(int i = 0; i < kObjects; ++i)
+			{
+				// RenderFunction::Execute:
+				Scope scope(rootScope);
+				scope.SetSibling(*objectScopes[i]);
+
+				// Transform::HandleExecute:
+				transformScopes[i]->SetParent(scope);
+				transformScopes[i]->Set("modelMatrix"_H, Uniform<Matrix4>(Matrix4::Identity()));
+
+				// DrawMeshData::BindAttributesAndDraw:
+				attributeScopes[i]->SetParent(*transformScopes[i]);
+				CHECK(attributeScopes[i]->Has("modelMatrix"_H));
+			}
+			if(frame > 0)
+				CHECK(counter.GetCount() == 0);
+		}
+	}
+
+	SECTION("Program keys")
+	{
+		// DrawingFunction::PrepareProgram:
+		std::vector<Hash> keys, unsetKeys;
+		Scope scope(rootScope);
+		scope.SetSibling(*objectScopes[0]);
+		attributeScopes[0]->SetParent(scope);
+		attributeScopes[0]->GetKeys(keys, unsetKeys);
+
+		AllocationCounter counter;
+		attributeScopes[0]->GetKeys(keys, unsetKeys);
+		CHECK(counter.GetCount() == 0);
+
+		std::vector<Hash> mapKeys;
+		for(auto& it: attributeScopes[0]->ToMap())
+			mapKeys.push_back(it.first);
+		CHECK(keys == mapKeys);
+
+		Scope unsetScope(*attributeScopes[0]);
+		unsetScope.Unset("diffuseColor"_H);
+		unsetScope.GetKeys(keys, unsetKeys);
+		CHECK(keys.size() == mapKeys.size() - 1);
+		CHECK(std::find(keys.begin(), keys.end(), "diffuseColor"_H) == keys.end());
+
+		// Unsetting in a sibling does not hide the parent's variable:
+		Scope unsetSibling;
+		unsetSibling.Unset("diffuseColor"_H);
+		Scope siblingScope(*attributeScopes[0]);
+		siblingScope.SetSibling(unsetSibling);
+		siblingScope.GetKeys(keys, unsetKeys);
+		CHECK(siblingScope.Has("diffuseColor"_H));
+		CHECK(keys == mapKeys);
+		std::vector<Hash> siblingMapKeys;
+		for(auto& it: siblingScope.ToMap())
+			siblingMapKeys.push_back(it.first);
+		CHECK(keys == siblingMapKeys);
+	}
+}
+
+#if OpenGL_EGL_FOUND
+TEST_CASE("TestAllocationsPerFrameRenderFunctions")
+{
+	using RenderManager = gfx::RenderManagerT<util::FileServer<util::DummyFileLoader>, util::TaskDispatcher>;
+	const int kObjects = 100;
+
+	std::unique_ptr<gfx::EglOffscreenContext> context;
+	try
+	{
+		context.reset(new gfx::EglOffscreenContext(64, 64));
+	}
+	catch(const std::exception& e)
+	{
+		WARN("No offscreen context: " << e.what());
+		return;
+	}
+	util::TaskDispatcher dispatcher;
+	util::DummyFileLoader fileLoader;
+	util::FileServer<util::DummyFileLoader> fileServer(fileLoader, ".", dispatcher);
+	gfx::RenderCmdSink commandSink;
+	RenderManager manager(*context, fileServer, dispatcher, commandSink);
+
+	// Triangle, stored once per object:
+	const float vertices[] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+	const uint16_t indices[] = {0, 1, 2};
+	VertexAttributeInfo position;
+	position.type = VertexAttributeInfo::kFloat;
+	position.semantic = VertexAttributeInfo::kPosition;
+	position.components = 3;
+	position.stride = 3 * sizeof(float);
+	position.offset = 0;
+	position.buffer = 0;
+	IndexBufferInfo info;
+	info.type = IndexBufferInfo::Type::kUInt16;
+	info.mode = IndexBufferInfo::Mode::kTriangles;
+	info.buffer = 0;
+	info.offset = 0;
+	info.count = 3;
+	info.vertexDataSet = 0;
+	info.material[0] = 0;
+	gfx::PreparedMesh mesh;
+	mesh.vertexDataSets.push_back({position});
+	mesh.vertexCounts.push_back(3);
+	mesh.vertexBuffers.push_back(gfx::PreparedMesh::Buffer{vertices, sizeof(vertices)});
+	mesh.indexBufferInfos.push_back(info);
+	mesh.indexBuffers.push_back(gfx::PreparedMesh::Buffer{indices, sizeof(indices)});
+	mesh.bounds = util::AxisAlignedBox(0, 0, 0, 1, 1, 0);
+
+	// FlatScene -> Transform -> DrawMeshData, as built by DrawMesh:
+	gfx::FlatScene scene(manager);
+	std::vector<std::unique_ptr<gfx::DrawMeshData>> meshes;
+	std::vector<std::unique_ptr<gfx::Transform>> transforms;
+	for(int i = 0; i < kObjects; ++i)
+	{
+		meshes.emplace_back(new gfx::DrawMeshData(manager));
+		meshes.back()->Load(mesh);
+		transforms.emplace_back(new gfx::Transform(manager));
+		transforms.back()->SetTransform(Matrix4::Translation(float(i % 10), float(i / 10), 0));
+		transforms.back()->SetCallee(meshes.back().get());
+		scene.Insert(transforms.back().get());
+	}
+
+	// Variables ViewSetup and SetupLight provide:
+	Scope rootScope;
+	rootScope.Set("gl_Position"_H, gfx::Output());
+	rootScope.Set("fragmentColor"_H, gfx::Output());
+	rootScope.Set("viewportSite"_H, Uniform<Vector2>(Vector2(64, 64)));
+	rootScope.Set("viewMatrix"_H, Uniform<Matrix4>(Matrix4::Translation(-5, -5, -20)));
+	rootScope.Set("projectionMatrix"_H, Uniform<Matrix4>(Matrix4::ProjectionPerspective(1.0f, 1.0f, 0.1f, 100.0f)));
+	rootScope.Set("blendMode"_H, Uniform<Hash>("none"_H));
+	rootScope.Set("diffuseColor"_H, Uniform<Vector3>(Vector3(1, 0, 0)));
+
+	// Warm-up frame generates the program and grows kept buffers:
+	manager.DrawOneFrame(scene, rootScope);
+
+	AllocationCounter counter;
+	for(int frame = 0; frame < 3; ++frame)
+		manager.DrawOneFrame(scene, rootScope);
+	CHECK(counter.GetCount() == 0);
+}
+#endif
+
+TEST_CASE("TestAllocationsPerFrameDrawText")
+{
+	using Font = util::FontAtlasDescriptionFile;
+	std::vector<uint8_t> fontData(sizeof(Font) + sizeof(Font::GlyphInfo), 0);
+	Font& font = *reinterpret_cast<Font*>(fontData.data());
+	font.magic = Font::kMagic;
+	font.height = 16;
+	font.asciiOffsets['a'] = sizeof(Font);
+	Font::GlyphInfo& glyph = *reinterpret_cast<Font::GlyphInfo*>(fontData.data() + sizeof(Font));
+	glyph.width = 8;
+	glyph.height = 16;
+	glyph.advanceX = 8;
+
+	const std::string text = "aaaa\naaaa";
+	std::vector<Vector3> positions;
+	std::vector<Vector2> texCoords;
+	gfx::DrawText(text, Vector3(0, 0, 0), 16, font, positions, texCoords);
+	REQUIRE(positions.size() == 8 * 6);
+
+	// Reusing the vectors in a warm frame must not allocate:
+	AllocationCounter counter;
+	positions.clear();
+	texCoords.clear();
+	gfx::DrawText(text, Vector3(0, 0, 0), 16, font, positions, texCoords);
+	CHECK(positions.size() == 8 * 6);
+	CHECK(counter.GetCount() == 0);
+}
+
+TEST_CASE("TestAllocationsPerFrameManualTaskQueue")
+{
+	const int kTasks = 256;
+	util::ManualTaskQueue<NullMutex> queue;
+	int counter = 0;
+
+	// Warm up internal queue storage:
+	for(int i = 0; i < kTasks; ++i)
+		queue.EnqueueTask([&counter](){++counter;});
+	for(int i = 0; i < kTasks; ++i)
+		queue.RunOneTask();
+
+	// FunctionTask per task, small lambdas fit into std::function:
+	AllocationCounter allocationCounter;
+	for(int i = 0; i < kTasks; ++i)
+		queue.EnqueueTask([&counter](){++counter;});
+	for(int i = 0; i < kTasks; ++i)
+		queue.RunOneTask();
+	CHECK(counter == 2 * kTasks);
+	CHECK(allocationCounter.GetCount() <= 2 * kTasks);
+}
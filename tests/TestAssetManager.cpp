@@ -0,0 +1,172 @@
+/*	TestAssetManager.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <catch.hpp>
+#include <molecular/gfx/AssetManager.h>
+#include <molecular/util/DummyFileLoader.h>
+#include <molecular/util/FileServer.h>
+#include <molecular/util/ManualTaskQueue.h>
+#include <molecular/util/TaskDispatcher.h>
+
+using namespace molecular;
+using namespace molecular::gfx;
+
+namespace
+{
+typedef AssetManager<int, 1, false, Hash> TestManager;
+
+/// Records StartLoad calls without loading anything
+class RecordingLoader : public TestManager::Loader
+{
+public:
+	int Create() override {return 0;}
+	void Destroy(int&) override {}
+	void StartLoad(TestManager::Asset& asset, unsigned int, unsigned int) override {started.push_back(&asset);}
+	void Unload(int&, unsigned int, unsigned int) override {}
+
+	std::vector<TestManager::Asset*> started;
+};
+
+using HandlerQueue = ManualTaskQueue<TaskDispatcher::Mutex>;
+
+/// Reads the asset file, but leaves read errors to AssetManager
+class ReadingLoader : public TestManager::Loader
+{
+public:
+	ReadingLoader(FileServer<DummyFileLoader>& fileServer, HandlerQueue& queue) :
+		mFileServer(fileServer),
+		mQueue(queue)
+	{}
+
+	int Create() override {return 0;}
+	void Destroy(int&) override {}
+	void StartLoad(TestManager::Asset& asset, unsigned int, unsigned int) override
+	{
+		started++;
+		TestManager::Asset* target = &asset;
+		mFileServer.ReadFile(asset.GetLocation(), [target](Blob&){target->SetState(0, TestManager::Asset::kLoaded);}, mQueue);
+	}
+	void Unload(int&, unsigned int, unsigned int) override {}
+
+	int started = 0;
+
+private:
+	FileServer<DummyFileLoader>& mFileServer;
+	HandlerQueue& mQueue;
+};
+}
+
+TEST_CASE("TestAssetManagerPriority")
+{
+	RecordingLoader loader;
+	TestManager manager(loader);
+	manager.SetMaxLoadsInFlight(2);
+	TestManager::Asset* small = manager.GetAsset(1);
+	TestManager::Asset* large = manager.GetAsset(2);
+	TestManager::Asset* medium = manager.GetAsset(3);
+
+	small->Use(0, 10);
+	large->Use(0, 1000);
+	medium->Use(0, 100);
+	CHECK(loader.started.empty());
+
+	manager.Update(1);
+	REQUIRE(loader.started.size() == 2);
+	CHECK(loader.started[0] == large);
+	CHECK(loader.started[1] == medium);
+	CHECK(manager.GetQueuedLoadCount() == 1);
+
+	// Slot becomes free when a load finishes:
+	large->SetState(0, TestManager::Asset::kLoaded);
+	small->Use(0, 10);
+	manager.Update(2);
+	REQUIRE(loader.started.size() == 3);
+	CHECK(loader.started[2] == small);
+}
+
+TEST_CASE("TestAssetManagerCancel")
+{
+	RecordingLoader loader;
+	TestManager manager(loader);
+	manager.SetMaxLoadsInFlight(1);
+	manager.SetCancelAfterFrames(2);
+	TestManager::Asset* first = manager.GetAsset(1);
+	TestManager::Asset* second = manager.GetAsset(2);
+
+	first->Use(0, 2);
+	second->Use(0, 1);
+	manager.Update(1);
+	REQUIRE(loader.started.size() == 1);
+	CHECK(second->GetState(0) == TestManager::Asset::kLoading);
+
+	// second is not used anymore and gets dropped from the queue:
+	for(int frame = 2; frame < 6; ++frame)
+	{
+		first->Use(0, 2);
+		manager.Update(frame);
+	}
+	CHECK(manager.GetQueuedLoadCount() == 0);
+	CHECK(second->GetState(0) == TestManager::Asset::kNotLoaded);
+	CHECK_FALSE(second->IsWanted(0));
+	CHECK(first->IsWanted(0));
+	CHECK(loader.started.size() == 1);
+}
+
+TEST_CASE("TestAssetManagerFailedRead")
+{
+	TaskDispatcher dispatcher;
+	DummyFileLoader fileLoader;
+	FileServer<DummyFileLoader> fileServer(fileLoader, "nonexistent-directory", dispatcher);
+	// Listed, but not on disk:
+	fileServer.SetFileList("missing1.bin;missing2.bin;missing3.bin");
+
+	HandlerQueue queue;
+	ReadingLoader loader(fileServer, queue);
+	TestManager manager(loader);
+	manager.SetMaxLoadsInFlight(1);
+	TestManager::Asset* first = manager.GetAsset("missing1.bin"_H);
+	TestManager::Asset* second = manager.GetAsset("missing2.bin"_H);
+	TestManager::Asset* third = manager.GetAsset("missing3.bin"_H);
+
+	first->Use(0, 3);
+	second->Use(0, 2);
+	third->Use(0, 1);
+	manager.Update(1);
+	CHECK(loader.started == 1);
+	CHECK(first->GetState(0) == TestManager::Asset::kFailed);
+	CHECK(second->GetState(0) == TestManager::Asset::kLoading);
+
+	// Failed loads give their slot to the next ones:
+	for(int frame = 2; frame < 4; ++frame)
+	{
+		first->Use(0, 3);
+		second->Use(0, 2);
+		third->Use(0, 1);
+		manager.Update(frame);
+	}
+	CHECK(loader.started == 3);
+	CHECK(second->GetState(0) == TestManager::Asset::kFailed);
+	CHECK(third->GetState(0) == TestManager::Asset::kFailed);
+	CHECK(manager.GetQueuedLoadCount() == 0);
+}
@@ -0,0 +1,101 @@
+/*	TestBlockCompression.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/util/BlockCompression.h>
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace molecular;
+using namespace molecular::util;
+
+static std::vector<uint8_t> RoundTrip(const std::vector<uint8_t>& data, uint32_t blockSize)
+{
+	const std::vector<uint8_t> compressed = BlockCompression::Compress(data.data(), data.size(), blockSize);
+	REQUIRE(BlockCompression::IsCompressed(compressed.data(), compressed.size()));
+	const BlockCompressedFile& file = BlockCompression::GetHeader(compressed.data(), compressed.size());
+	REQUIRE(file.size == data.size());
+	std::vector<uint8_t> output(file.size);
+
+	// Blocks in any order, as done by parallel tasks:
+	for(uint32_t i = file.blockCount; i > 0; --i)
+		BlockCompression::DecompressBlock(file, i - 1, output.data());
+	return output;
+}
+
+TEST_CASE("TestBlockCompression")
+{
+	std::vector<uint8_t> text;
+	const char* line = "Lorem ipsum dolor sit amet, consectetur adipiscing elit. ";
+	for(int i = 0; i < 2000; ++i)
+	{
+		text.insert(text.end(), line, line + strlen(line));
+		text.push_back(uint8_t('0' + i % 10));
+	}
+
+	std::vector<uint8_t> noise(100000);
+	uint32_t state = 1;
+	for(auto& byte: noise)
+	{
+		state = state * 1664525 + 1013904223;
+		byte = uint8_t(state >> 24);
+	}
+
+	CHECK(RoundTrip(text, 4096) == text);
+	CHECK(RoundTrip(text, BlockCompression::kDefaultBlockSize) == text);
+	CHECK(RoundTrip(noise, 4096) == noise); // Stored raw
+	CHECK(RoundTrip(std::vector<uint8_t>(), 4096).empty());
+	CHECK(RoundTrip(std::vector<uint8_t>(7, 'x'), 4096) == std::vector<uint8_t>(7, 'x'));
+
+	const std::vector<uint8_t> compressed = BlockCompression::Compress(text.data(), text.size());
+	CHECK(compressed.size() < text.size() / 4);
+	CHECK_FALSE(BlockCompression::IsCompressed(text.data(), text.size()));
+	CHECK_THROWS_AS(BlockCompression::GetHeader(compressed.data(), compressed.size() - 1), std::runtime_error);
+}
+
+TEST_CASE("TestBlockCompressionCorrupt")
+{
+	std::vector<uint8_t> data(10000);
+	for(size_t i = 0; i < data.size(); ++i)
+		data[i] = uint8_t(i % 251 + i / 1000);
+	const std::vector<uint8_t> compressed = BlockCompression::Compress(data.data(), data.size(), 4096);
+	const size_t payload = sizeof(BlockCompressedFile) + 3 * sizeof(uint32_t);
+
+	// Corrupted blocks must be detected or decompress without writing out of bounds:
+	for(size_t i = payload; i < compressed.size(); i += 7)
+	{
+		std::vector<uint8_t> corrupt = compressed;
+		corrupt[i] ^= 0x5a;
+		std::vector<uint8_t> output(data.size());
+		try
+		{
+			BlockCompression::Decompress(corrupt.data(), corrupt.size(), output.data());
+		}
+		catch(std::runtime_error&)
+		{
+		}
+	}
+}
@@ -0,0 +1,150 @@
+/*	TestDrawMeshData.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/Config.h>
+#include <molecular/gfx/functions/DrawMeshData.h>
+#if OpenGL_EGL_FOUND
+#include <molecular/gfx/RenderManager.h>
+#include <molecular/gfx/opengl/EglOffscreenContext.h>
+#include <molecular/util/DummyFileLoader.h>
+#include <molecular/util/FileServer.h>
+#include <molecular/util/TaskDispatcher.h>
+
+#include <memory>
+#endif
+
+using namespace molecular;
+using namespace molecular::gfx;
+
+TEST_CASE("TestDrawMeshDataMorphWeightsDisableClusterCulling")
+{
+	CHECK_FALSE(DrawMeshData::HasActiveMorphWeights(nullptr, 0));
+
+	const float resting[] = {0.0f, 0.0f, 0.0f};
+	CHECK_FALSE(DrawMeshData::HasActiveMorphWeights(resting, 3));
+
+	const float morphed[] = {0.0f, 0.0f, -0.5f};
+	CHECK(DrawMeshData::HasActiveMorphWeights(morphed, 3));
+	CHECK_FALSE(DrawMeshData::HasActiveMorphWeights(morphed, 2)); // Only weights of the MeshLocator's targets count
+}
+
+TEST_CASE("TestDrawMeshDataDepthOnly")
+{
+	gfx::Scope scope;
+	scope.Set("gl_Position"_H, Output());
+	scope.Set("fragmentColor"_H, Output());
+	CHECK_FALSE(DrawMeshData::IsDepthOnly(scope));
+
+	// As in ShadowMapping and CascadedShadowMapping:
+	gfx::Scope shadowScope(scope);
+	shadowScope.Unset("fragmentColor"_H);
+	CHECK(DrawMeshData::IsDepthOnly(shadowScope));
+}
+
+#if OpenGL_EGL_FOUND
+TEST_CASE("TestDrawMeshDataPositionStream")
+{
+	using RenderManager = RenderManagerT<util::FileServer<util::DummyFileLoader>, util::TaskDispatcher>;
+
+	std::unique_ptr<EglOffscreenContext> context;
+	try
+	{
+		context.reset(new EglOffscreenContext(64, 64));
+	}
+	catch(const std::exception& e)
+	{
+		WARN("No offscreen context: " << e.what());
+		return;
+	}
+	util::TaskDispatcher dispatcher;
+	util::DummyFileLoader fileLoader;
+	util::FileServer<util::DummyFileLoader> fileServer(fileLoader, ".", dispatcher);
+	RenderCmdSink commandSink;
+	RenderManager manager(*context, fileServer, dispatcher, commandSink);
+
+	// Triangle with positions in buffer 0 and normals in buffer 1, as written by molecular-meshcook --position-stream:
+	const float positions[] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+	const float normals[] = {0, 0, 1, 0, 0, 1, 0, 0, 1};
+	const uint16_t indices[] = {0, 1, 2};
+	VertexAttributeInfo position;
+	position.type = VertexAttributeInfo::kFloat;
+	position.semantic = VertexAttributeInfo::kPosition;
+	position.components = 3;
+	position.stride = 3 * sizeof(float);
+	position.offset = 0;
+	position.buffer = 0;
+	VertexAttributeInfo normal = position;
+	normal.semantic = VertexAttributeInfo::kNormal;
+	normal.buffer = 1;
+	IndexBufferInfo info;
+	info.type = IndexBufferInfo::Type::kUInt16;
+	info.mode = IndexBufferInfo::Mode::kTriangles;
+	info.buffer = 2;
+	info.offset = 0;
+	info.count = 3;
+	info.vertexDataSet = 0;
+	info.material[0] = 0;
+	PreparedMesh mesh;
+	mesh.vertexDataSets.push_back({position, normal});
+	mesh.vertexCounts.push_back(3);
+	mesh.vertexBuffers.push_back(PreparedMesh::Buffer{positions, sizeof(positions)});
+	mesh.vertexBuffers.push_back(PreparedMesh::Buffer{normals, sizeof(normals)});
+	mesh.vertexBuffers.push_back(PreparedMesh::Buffer{});
+	mesh.indexBufferInfos.push_back(info);
+	mesh.indexBuffers.resize(3);
+	mesh.indexBuffers[2] = PreparedMesh::Buffer{indices, sizeof(indices)};
+	mesh.bounds = util::AxisAlignedBox(0, 0, 0, 1, 1, 0);
+
+	SECTION("Separate stream")
+	{
+		DrawMeshData drawMeshData(manager);
+		drawMeshData.Load(mesh);
+		const gfx::Scope& depthScope = drawMeshData.GetAttributeScope(0, true);
+		CHECK(depthScope.Has(VertexAttributeInfo::kPosition));
+		CHECK_FALSE(depthScope.Has(VertexAttributeInfo::kNormal));
+		const gfx::Scope& colorScope = drawMeshData.GetAttributeScope(0, false);
+		CHECK(colorScope.Has(VertexAttributeInfo::kPosition));
+		CHECK(colorScope.Has(VertexAttributeInfo::kNormal));
+	}
+
+	SECTION("Interleaved")
+	{
+		// Positions and normals share buffer 0:
+		const float interleaved[] = {0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 1, 0, 0, 0, 1};
+		mesh.vertexDataSets[0][0].stride = 6 * sizeof(float);
+		mesh.vertexDataSets[0][1].stride = 6 * sizeof(float);
+		mesh.vertexDataSets[0][1].offset = 3 * sizeof(float);
+		mesh.vertexDataSets[0][1].buffer = 0;
+		mesh.vertexBuffers[0] = PreparedMesh::Buffer{interleaved, sizeof(interleaved)};
+		mesh.vertexBuffers[1] = PreparedMesh::Buffer{};
+
+		DrawMeshData drawMeshData(manager);
+		drawMeshData.Load(mesh);
+		CHECK(&drawMeshData.GetAttributeScope(0, true) == &drawMeshData.GetAttributeScope(0, false));
+		CHECK(drawMeshData.GetAttributeScope(0, true).Has(VertexAttributeInfo::kNormal));
+	}
+}
+#endif
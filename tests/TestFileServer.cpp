@@ -0,0 +1,244 @@
+/*	TestFileServer.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/util/DummyFileLoader.h>
+#include <molecular/util/FileServer.h>
+#include <molecular/util/ManualTaskQueue.h>
+#include <molecular/util/PackageFile.h>
+#include <molecular/util/TaskDispatcher.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace molecular;
+using namespace molecular::util;
+
+namespace
+{
+using HandlerQueue = ManualTaskQueue<TaskDispatcher::Mutex>;
+
+const char* const kPackagePath = "TestFileServer.pak";
+const char* const kPlainPath = "TestFileServer.txt";
+const size_t kDataBegin = 256;
+const size_t kDataSize = 4096;
+
+/// Package entries: adjacent, overlapping, distant and empty ones
+const PackageFile::Entry kEntries[] = {
+	{1, 100, kDataBegin},
+	{2, 50, kDataBegin + 100}, // Adjacent to 1
+	{3, 20, kDataBegin + 120}, // Within 2
+	{4, 10, kDataBegin + 1000}, // 850 bytes after 2
+	{5, 0, kDataBegin + 200}, // Empty, between 2 and 4
+	{6, 0, kDataBegin + 3000} // Empty, far behind 4
+};
+const size_t kEntryCount = sizeof(kEntries) / sizeof(kEntries[0]);
+
+/// Writes package and plain file, removes them again
+struct TestFiles
+{
+	TestFiles()
+	{
+		std::vector<uint8_t> contents(kDataBegin + kDataSize);
+		PackageFile& header = *reinterpret_cast<PackageFile*>(contents.data());
+		header.magic = PackageFile::kMagic;
+		header.count = kEntryCount;
+		memcpy(header.entries, kEntries, sizeof(kEntries));
+		for(size_t i = 0; i < kDataSize; ++i)
+			contents[kDataBegin + i] = uint8_t(i * 7);
+		Write(kPackagePath, contents.data(), contents.size());
+		Write(kPlainPath, "plain", 5);
+	}
+
+	~TestFiles()
+	{
+		remove(kPackagePath);
+		remove(kPlainPath);
+	}
+
+	static void Write(const char* path, const void* data, size_t size)
+	{
+		FILE* file = fopen(path, "wb");
+		REQUIRE(file);
+		fwrite(data, 1, size, file);
+		fclose(file);
+	}
+};
+
+/// Checks that blob holds the package bytes of the entry
+bool HasEntryContents(const Blob& blob, const PackageFile::Entry& entry)
+{
+	if(blob.GetSize() != entry.size)
+		return false;
+	const uint8_t* data = static_cast<const uint8_t*>(blob.GetData());
+	for(size_t i = 0; i < entry.size; ++i)
+	{
+		if(data[i] != uint8_t((entry.offset - kDataBegin + i) * 7))
+			return false;
+	}
+	return true;
+}
+
+struct ReadResult
+{
+	size_t index;
+	Blob blob;
+};
+
+/// ReadFiles() and collect handler calls in order
+std::vector<ReadResult> ReadAll(const FileServer<DummyFileLoader>& fileServer, const std::vector<Hash>& files, size_t maxGap)
+{
+	HandlerQueue queue;
+	std::vector<ReadResult> results;
+	fileServer.ReadFiles(files.data(), files.size(), [&results](size_t index, Blob& blob){results.push_back(ReadResult{index, std::move(blob)});}, queue, maxGap);
+	for(size_t i = 0; i < files.size(); ++i)
+		queue.RunOneTask();
+	return results;
+}
+}
+
+TEST_CASE("TestFileServerPlanReads")
+{
+	TestFiles testFiles;
+	TaskDispatcher dispatcher;
+	DummyFileLoader fileLoader;
+	FileServer<DummyFileLoader> fileServer(fileLoader, ".", dispatcher);
+	fileServer.SetFileList(kPlainPath);
+	fileServer.AddPackageFile(kPackagePath, dispatcher);
+
+	const Hash files[] = {4, 3, HashUtils::MakeHash(kPlainPath), 1, 5, 2, 6};
+
+	SECTION("Small gaps")
+	{
+		std::vector<CoalescedRead> reads = fileServer.PlanReads(files, 7, 100);
+		REQUIRE(reads.size() == 4);
+
+		// Plain files first, read entirely:
+		CHECK(reads[0].wholeFile);
+		REQUIRE(reads[0].parts.size() == 1);
+		CHECK(reads[0].parts[0].index == 2);
+
+		// Adjacent and overlapping entries, and empty ones in between:
+		CHECK_FALSE(reads[1].wholeFile);
+		CHECK(reads[1].offset == kDataBegin);
+		CHECK(reads[1].size == 150);
+		REQUIRE(reads[1].parts.size() == 4);
+		CHECK(reads[1].parts[0].index == 3);
+		CHECK(reads[1].parts[1].index == 5);
+		CHECK(reads[1].parts[2].index == 1);
+		CHECK(reads[1].parts[2].offset == 120);
+		CHECK(reads[1].parts[2].size == 20);
+		CHECK(reads[1].parts[3].index == 4);
+		CHECK(reads[1].parts[3].size == 0);
+
+		// Gap exceeds maxGap:
+		CHECK(reads[2].offset == kDataBegin + 1000);
+		CHECK(reads[2].size == 10);
+
+		// Empty entry is an empty read, not the whole package:
+		CHECK_FALSE(reads[3].wholeFile);
+		CHECK(reads[3].size == 0);
+		REQUIRE(reads[3].parts.size() == 1);
+		CHECK(reads[3].parts[0].index == 6);
+	}
+
+	SECTION("Gap threshold")
+	{
+		CHECK(fileServer.PlanReads(files, 7, 849).size() == 4);
+		std::vector<CoalescedRead> reads = fileServer.PlanReads(files, 7, 850);
+		REQUIRE(reads.size() == 3);
+		CHECK(reads[1].size == 1010);
+		CHECK(reads[1].parts.size() == 5);
+	}
+
+	SECTION("Read size limit")
+	{
+		std::vector<CoalescedRead> reads = fileServer.PlanReads(files, 7, 100, 120);
+		REQUIRE(reads.size() == 5);
+		CHECK(reads[1].size == 100);
+		CHECK(reads[2].offset == kDataBegin + 100);
+		CHECK(reads[2].size == 50);
+		CHECK(reads[2].parts.size() == 3); // 2, 3 and 5
+	}
+}
+
+TEST_CASE("TestFileServerReadFiles")
+{
+	TestFiles testFiles;
+	TaskDispatcher dispatcher;
+	DummyFileLoader fileLoader;
+	FileServer<DummyFileLoader> fileServer(fileLoader, ".", dispatcher);
+	fileServer.SetFileList(kPlainPath);
+	fileServer.AddPackageFile(kPackagePath, dispatcher);
+
+	const std::vector<Hash> files = {4, 3, HashUtils::MakeHash(kPlainPath), 1, 5, 2, 6};
+	for(size_t maxGap: {size_t(0), size_t(100), FileServer<DummyFileLoader>::kDefaultMaxReadGap})
+	{
+		std::vector<ReadResult> results = ReadAll(fileServer, files, maxGap);
+		REQUIRE(results.size() == files.size());
+
+		// Handlers are called in read order, parts by offset:
+		const size_t expectedOrder[] = {2, 3, 5, 1, 4, 0, 6};
+		for(size_t i = 0; i < results.size(); ++i)
+			CHECK(results[i].index == expectedOrder[i]);
+
+		for(auto& result: results)
+		{
+			const Hash file = files[result.index];
+			if(file == HashUtils::MakeHash(kPlainPath))
+			{
+				REQUIRE(result.blob.GetSize() == 5);
+				CHECK(memcmp(result.blob.GetData(), "plain", 5) == 0);
+			}
+			else
+			{
+				for(auto& entry: kEntries)
+				{
+					if(entry.name == file)
+						CHECK(HasEntryContents(result.blob, entry));
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("TestFileServerEmptyEntry")
+{
+	TestFiles testFiles;
+	TaskDispatcher dispatcher;
+	DummyFileLoader fileLoader;
+	FileServer<DummyFileLoader> fileServer(fileLoader, ".", dispatcher);
+	fileServer.AddPackageFile(kPackagePath, dispatcher);
+
+	HandlerQueue queue;
+	bool called = false;
+	fileServer.ReadFile(6, [&called](Blob& blob){called = true; CHECK(blob.GetSize() == 0);}, queue);
+	queue.RunOneTask();
+	CHECK(called);
+
+	CHECK(fileServer.ReadFileSync(6, dispatcher).GetSize() == 0);
+	CHECK(HasEntryContents(fileServer.ReadFileSync(3, dispatcher), kEntries[2]));
+}
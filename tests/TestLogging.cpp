@@ -0,0 +1,145 @@
+/*	TestLogging.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/util/Logging.h>
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace molecular;
+using namespace molecular::util;
+
+namespace
+{
+
+/// Run function with stderr redirected to a temporary file
+/** @returns Everything written to stderr meanwhile. */
+std::string CaptureStderr(const std::function<void()>& function)
+{
+	FlushLog();
+	fflush(stderr);
+	FILE* file = tmpfile();
+	REQUIRE(file);
+#ifdef _WIN32
+	const int saved = _dup(_fileno(stderr));
+	_dup2(_fileno(file), _fileno(stderr));
+#else
+	const int saved = dup(fileno(stderr));
+	dup2(fileno(file), fileno(stderr));
+#endif
+
+	function();
+
+	FlushLog();
+	fflush(stderr);
+#ifdef _WIN32
+	_dup2(saved, _fileno(stderr));
+	_close(saved);
+#else
+	dup2(saved, fileno(stderr));
+	close(saved);
+#endif
+
+	std::string text;
+	rewind(file);
+	char buffer[4096];
+	size_t size;
+	while((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		text.append(buffer, size);
+	fclose(file);
+	return text;
+}
+
+size_t CountLines(const std::string& text, const std::string& prefix)
+{
+	size_t count = 0;
+	size_t begin = 0;
+	while(begin < text.size())
+	{
+		size_t end = text.find('\n', begin);
+		if(end == std::string::npos)
+			end = text.size();
+		if(text.compare(begin, prefix.size(), prefix) == 0)
+			count++;
+		begin = end + 1;
+	}
+	return count;
+}
+
+/// Logs when destroyed
+/** Destroyed after the thread's logging state if constructed before it. */
+struct LogOnDestruction
+{
+	~LogOnDestruction()
+	{
+		LOG(ERROR) << "Thread local destroyed";
+	}
+};
+
+}
+
+TEST_CASE("TestLoggingErrorsNotRateLimited")
+{
+	const int count = 3 * MOLECULAR_LOG_RATE_LIMIT + 10;
+	const std::string text = CaptureStderr([count](){
+		for(int i = 0; i < count; ++i)
+			LOG(ERROR) << "Burst " << i;
+	});
+	CHECK(CountLines(text, "ERROR: Burst ") == size_t(count));
+	CHECK(text.find("suppressed") == std::string::npos);
+
+	if(MOLECULAR_LOG_RATE_LIMIT > 0)
+	{
+		// Warnings from one site still are:
+		const std::string warnings = CaptureStderr([count](){
+			for(int i = 0; i < count; ++i)
+				LOG(WARNING) << "Burst " << i;
+		});
+		CHECK(CountLines(warnings, "WARNING: Burst ") < size_t(count));
+	}
+}
+
+TEST_CASE("TestLoggingFromThreadLocalDestructor")
+{
+	const std::string text = CaptureStderr([](){
+		std::thread([](){
+			thread_local LogOnDestruction logOnDestruction;
+			(void)logOnDestruction;
+			LOG(ERROR) << "Thread running";
+		}).join();
+	});
+	CHECK(CountLines(text, "ERROR: Thread running") == 1);
+	CHECK(CountLines(text, "ERROR: Thread local destroyed") == 1);
+	CHECK(text.find("running") < text.find("destroyed"));
+}
@@ -0,0 +1,77 @@
+/*	TestMeshBoundsCollectionFile.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <catch.hpp>
+#include <molecular/gfx/MeshBoundsCollectionFile.h>
+#include <molecular/util/FileTypeIdentification.h>
+
+using namespace molecular;
+using namespace molecular::gfx;
+
+TEST_CASE("TestMeshBoundsCollectionFileHashed")
+{
+	std::vector<Hash> meshes;
+	std::vector<util::AxisAlignedBox> bounds;
+	for(uint32_t i = 1; i <= 100; ++i)
+	{
+		meshes.push_back(i * 64); // Colliding slots
+		bounds.push_back(util::AxisAlignedBox(0, 0, 0, float(i), 1, 1));
+	}
+	const std::vector<uint8_t> contents = MeshBoundsCollectionFile::BuildHashed(meshes.data(), bounds.data(), 100);
+	CHECK(util::FileTypeIdentification::IsMeshBoundsCollection(contents.data(), contents.size()));
+
+	const MeshBoundsCollectionFile& file = *reinterpret_cast<const MeshBoundsCollectionFile*>(contents.data());
+	CHECK(file.magic == +MeshBoundsCollectionFile::kMagicHashed);
+	REQUIRE(file.count == 256);
+	CHECK(contents.size() == sizeof(MeshBoundsCollectionFile) + 256 * (sizeof(Hash) + sizeof(util::AxisAlignedBox)));
+	for(uint32_t i = 1; i <= 100; ++i)
+		CHECK(file.GetBounds(i * 64).GetMax()[0] == float(i));
+	CHECK(&file.GetBounds(1) == &util::AxisAlignedBox::kDefault);
+
+	unsigned int used = 0;
+	for(unsigned int i = 0; i < file.count; ++i)
+		used += file.IsEmpty(i) ? 0 : 1;
+	CHECK(used == 100);
+
+	const Hash invalid[] = {5, 0};
+	CHECK_THROWS(MeshBoundsCollectionFile::BuildHashed(invalid, bounds.data(), 2));
+	const Hash duplicate[] = {5, 5};
+	CHECK_THROWS(MeshBoundsCollectionFile::BuildHashed(duplicate, bounds.data(), 2));
+}
+
+TEST_CASE("TestMeshBoundsCollectionFileLinear")
+{
+	struct
+	{
+		uint32_t magic = MeshBoundsCollectionFile::kMagic;
+		uint32_t count = 2;
+		uint32_t hashes[2] = {17, 42};
+		util::AxisAlignedBox bounds[2] = {util::AxisAlignedBox(0, 0, 0, 1, 1, 1), util::AxisAlignedBox(0, 0, 0, 2, 2, 2)};
+	} contents;
+	const MeshBoundsCollectionFile& file = *reinterpret_cast<const MeshBoundsCollectionFile*>(&contents);
+	CHECK(file.GetBounds(42).GetMax()[0] == 2.0f);
+	CHECK(file.GetBounds(17).GetMax()[0] == 1.0f);
+	CHECK_FALSE(file.IsEmpty(0));
+	CHECK(&file.GetBounds(3) == &util::AxisAlignedBox::kDefault);
+}
@@ -0,0 +1,326 @@
+/*	TestMeshCooking.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/gfx/MeshCooking.h>
+#include <molecular/gfx/PreparedMesh.h>
+#include <molecular/util/Vector3.h>
+
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <utility>
+
+using namespace molecular;
+using namespace molecular::gfx;
+using meshfile::MeshFile;
+
+namespace
+{
+/// Quad with interleaved float positions and normals
+/** Normals hold the vertex number, so vertices can be told apart after
+	reordering. */
+std::vector<uint8_t> MakeQuadFile()
+{
+	const float vertices[] = {
+		0, 0, 0, 0, 0, 0,
+		1, 0, 0, 0, 0, 1,
+		1, 1, 0, 0, 0, 2,
+		0, 1, 0, 0, 0, 3
+	};
+	const uint16_t indices[] = {0, 1, 2, 0, 2, 3};
+
+	VertexAttributeInfo position;
+	position.type = VertexAttributeInfo::kFloat;
+	position.semantic = VertexAttributeInfo::kPosition;
+	position.components = 3;
+	position.normalized = false;
+	position.stride = 6 * sizeof(float);
+	position.offset = 0;
+	position.buffer = 0;
+	VertexAttributeInfo normal = position;
+	normal.semantic = VertexAttributeInfo::kNormal;
+	normal.offset = 3 * sizeof(float);
+
+	IndexBufferInfo info;
+	info.type = IndexBufferInfo::Type::kUInt16;
+	info.mode = IndexBufferInfo::Mode::kTriangles;
+	info.buffer = 1;
+	info.offset = 0;
+	info.count = 6;
+	info.vertexDataSet = 0;
+	info.material[0] = 0;
+
+	const uint8_t* vertexBytes = reinterpret_cast<const uint8_t*>(vertices);
+	const uint8_t* indexBytes = reinterpret_cast<const uint8_t*>(indices);
+	return MeshCooking::WriteMeshFile(util::AxisAlignedBox(0, 0, 0, 1, 1, 0), {4}, {{position, normal}}, {info},
+			{MeshFile::Buffer::Type::kVertex, MeshFile::Buffer::Type::kIndex},
+			{std::vector<uint8_t>(vertexBytes, vertexBytes + sizeof(vertices)), std::vector<uint8_t>(indexBytes, indexBytes + sizeof(indices))});
+}
+
+const VertexAttributeInfo& FindAttribute(const std::vector<VertexAttributeInfo>& attributes, Hash semantic)
+{
+	for(auto& attribute: attributes)
+	{
+		if(attribute.semantic == semantic)
+			return attribute;
+	}
+	throw std::runtime_error("Attribute not found");
+}
+
+Vector3 ReadVector3(const PreparedMesh& mesh, const VertexAttributeInfo& attribute, size_t vertex)
+{
+	float values[3];
+	const uint8_t* data = static_cast<const uint8_t*>(mesh.vertexBuffers.at(attribute.buffer).data);
+	memcpy(values, data + attribute.offset + vertex * attribute.stride, sizeof(values));
+	return Vector3(values[0], values[1], values[2]);
+}
+
+/// Writes the subset of NVidia's NMB format that NmbFile reads
+class NmbWriter
+{
+public:
+	NmbWriter()
+	{
+		Put(1); // Magic
+		Put(0);
+		Put(0);
+	}
+
+	/// Mesh chunk with an index buffer per entry of indexBuffers
+	/** @param vertexBuffers Name, components (2 or 3) and values. */
+	void AddMesh(const std::string& name,
+			const std::vector<std::tuple<std::string, int, std::vector<float>>>& vertexBuffers,
+			const std::vector<std::pair<uint32_t, std::vector<uint16_t>>>& indexBuffers)
+	{
+		Put(0x70000031); // kPolySurfaceShape
+		Put(kBeginMarker);
+		PutString(name);
+		data.push_back(0);
+		Put(0);
+		Put(0);
+		Put(static_cast<uint32_t>(vertexBuffers.size()));
+		for(auto& vertexBuffer: vertexBuffers)
+		{
+			const int components = std::get<1>(vertexBuffer);
+			const std::vector<float>& values = std::get<2>(vertexBuffer);
+			const uint16_t type = components == 3 ? 2 : 1; // Index into NmbFile's element sizes
+			data.insert(data.end(), reinterpret_cast<const uint8_t*>(&type), reinterpret_cast<const uint8_t*>(&type + 1));
+			data.push_back(0);
+			data.push_back(0);
+			Put(0);
+			PutString(std::get<0>(vertexBuffer));
+			Put(0);
+			Put(0);
+			Put(0);
+			Put(static_cast<uint32_t>(values.size() / components));
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+			data.insert(data.end(), bytes, bytes + values.size() * sizeof(float));
+			Put(kEndMarker);
+		}
+		Put(0);
+		Put(static_cast<uint32_t>(indexBuffers.size()));
+		for(auto& indexBuffer: indexBuffers)
+		{
+			Put(0);
+			Put(0);
+			Put(indexBuffer.first); // Operation, 3 = triangles, 5 = strip
+			Put(0);
+			Put(static_cast<uint32_t>(indexBuffer.second.size()));
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(indexBuffer.second.data());
+			data.insert(data.end(), bytes, bytes + indexBuffer.second.size() * sizeof(uint16_t));
+			Put(kEndMarker);
+		}
+		Put(kEndMarker);
+	}
+
+	std::vector<uint8_t> Finish()
+	{
+		Put(kEndMarker);
+		return data;
+	}
+
+private:
+	static const uint32_t kBeginMarker = 0xfffffffd;
+	static const uint32_t kEndMarker = 0xfffffffc;
+
+	void Put(uint32_t value)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value); // Little endian
+		data.insert(data.end(), bytes, bytes + sizeof(value));
+	}
+
+	void PutString(const std::string& string)
+	{
+		Put(static_cast<uint32_t>(string.size()));
+		data.insert(data.end(), string.begin(), string.end());
+	}
+
+	std::vector<uint8_t> data;
+};
+
+std::vector<uint16_t> ReadIndices(const PreparedMesh& mesh, const IndexBufferInfo& info)
+{
+	REQUIRE(info.type == IndexBufferInfo::Type::kUInt16);
+	const uint8_t* data = static_cast<const uint8_t*>(mesh.indexBuffers.at(info.buffer).data);
+	std::vector<uint16_t> indices(info.count);
+	memcpy(indices.data(), data + info.offset, info.count * sizeof(uint16_t));
+	return indices;
+}
+}
+
+TEST_CASE("TestMeshCookingPositionStream")
+{
+	const std::vector<uint8_t> file = MakeQuadFile();
+
+	SECTION("Separate stream")
+	{
+		const std::vector<uint8_t> cooked = MeshCooking::Cook(file, 16, false, false, 1, 0.5f, 0, true);
+		const PreparedMesh mesh = PreparedMesh::FromMeshFile(*reinterpret_cast<const MeshFile*>(cooked.data()));
+		REQUIRE(mesh.vertexDataSets.size() == 1);
+		REQUIRE(mesh.vertexCounts[0] == 4);
+		const std::vector<VertexAttributeInfo>& attributes = mesh.vertexDataSets[0];
+		const VertexAttributeInfo& position = FindAttribute(attributes, VertexAttributeInfo::kPosition);
+		const VertexAttributeInfo& normal = FindAttribute(attributes, VertexAttributeInfo::kNormal);
+
+		// Depth-only passes bind the tightly packed positions alone:
+		const std::vector<unsigned int> streamBuffers = PreparedMesh::GetPositionStreamBuffers(attributes);
+		REQUIRE(streamBuffers.size() == 1);
+		CHECK(streamBuffers[0] == position.buffer);
+		CHECK(normal.buffer != position.buffer);
+		CHECK(position.stride == 3 * sizeof(float));
+
+		// Vertices still correspond across both buffers:
+		const Vector3 originalPositions[] = {Vector3(0, 0, 0), Vector3(1, 0, 0), Vector3(1, 1, 0), Vector3(0, 1, 0)};
+		for(size_t v = 0; v < 4; ++v)
+		{
+			const int original = int(ReadVector3(mesh, normal, v)[2]);
+			REQUIRE(original >= 0);
+			REQUIRE(original < 4);
+			const Vector3 cookedPosition = ReadVector3(mesh, position, v);
+			for(int i = 0; i < 3; ++i)
+				CHECK(cookedPosition[i] == originalPositions[original][i]);
+		}
+	}
+
+	SECTION("Interleaved")
+	{
+		const std::vector<uint8_t> cooked = MeshCooking::Cook(file, 16, false, false, 1, 0.5f, 0, false);
+		const PreparedMesh mesh = PreparedMesh::FromMeshFile(*reinterpret_cast<const MeshFile*>(cooked.data()));
+		REQUIRE(mesh.vertexDataSets.size() == 1);
+		CHECK(PreparedMesh::GetPositionStreamBuffers(mesh.vertexDataSets[0]).empty());
+	}
+}
+
+TEST_CASE("TestMeshCookingConvertNmb")
+{
+	const std::vector<float> quadPositions = {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0};
+	const std::vector<float> quadNormals = {0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1};
+	const std::vector<float> quadTexCoords = {0, 0, 1, 0, 1, 1, 0, 1};
+	const std::vector<uint16_t> quadList = {0, 1, 2, 0, 2, 3};
+	const std::vector<uint16_t> quadStrip = {0, 1, 3, 2};
+	const std::vector<float> trianglePositions = {-1, 0, 2, 0, -2, 2, 0, 0, 3};
+
+	NmbWriter writer;
+	writer.AddMesh("quad", {
+			std::make_tuple("a2v.objCoord", 3, quadPositions),
+			std::make_tuple("a2v.objNormal", 3, quadNormals),
+			std::make_tuple("a2v.tex", 2, quadTexCoords)},
+			{{3, quadList}, {5, quadStrip}});
+	writer.AddMesh("triangle", {std::make_tuple("a2v.worldCoord", 3, trianglePositions)}, {});
+	const std::vector<uint8_t> nmb = writer.Finish();
+
+	const std::vector<uint8_t> file = MeshCooking::ConvertNmb(nmb);
+	const PreparedMesh mesh = PreparedMesh::FromMeshFile(*reinterpret_cast<const MeshFile*>(file.data()));
+
+	// Bounds span the positions of both meshes:
+	CHECK(mesh.bounds.GetMin()[0] == -1.0f);
+	CHECK(mesh.bounds.GetMin()[1] == -2.0f);
+	CHECK(mesh.bounds.GetMin()[2] == 0.0f);
+	CHECK(mesh.bounds.GetMax()[0] == 1.0f);
+	CHECK(mesh.bounds.GetMax()[1] == 1.0f);
+	CHECK(mesh.bounds.GetMax()[2] == 3.0f);
+
+	// One vertex data set per mesh, attributes interleaved in NMB order:
+	REQUIRE(mesh.vertexDataSets.size() == 2);
+	REQUIRE(mesh.vertexCounts[0] == 4);
+	REQUIRE(mesh.vertexCounts[1] == 3);
+	const std::vector<VertexAttributeInfo>& quad = mesh.vertexDataSets[0];
+	REQUIRE(quad.size() == 3);
+	CHECK(quad[0].semantic == +VertexAttributeInfo::kPosition);
+	CHECK(quad[1].semantic == +VertexAttributeInfo::kNormal);
+	CHECK(quad[2].semantic == +VertexAttributeInfo::kTextureCoords);
+	CHECK(quad[0].components == 3);
+	CHECK(quad[2].components == 2);
+	for(auto& attribute: quad)
+	{
+		CHECK(attribute.type == VertexAttributeInfo::kFloat);
+		CHECK(attribute.buffer == quad[0].buffer);
+		CHECK(attribute.stride == 8 * sizeof(float));
+	}
+	for(size_t v = 0; v < 4; ++v)
+	{
+		const Vector3 position = ReadVector3(mesh, quad[0], v);
+		const Vector3 normal = ReadVector3(mesh, quad[1], v);
+		for(int i = 0; i < 3; ++i)
+		{
+			CHECK(position[i] == quadPositions[v * 3 + i]);
+			CHECK(normal[i] == quadNormals[v * 3 + i]);
+		}
+		float texCoords[2];
+		memcpy(texCoords, static_cast<const uint8_t*>(mesh.vertexBuffers.at(quad[2].buffer).data) + quad[2].offset + v * quad[2].stride, sizeof(texCoords));
+		CHECK(texCoords[0] == quadTexCoords[v * 2]);
+		CHECK(texCoords[1] == quadTexCoords[v * 2 + 1]);
+	}
+
+	const std::vector<VertexAttributeInfo>& triangle = mesh.vertexDataSets[1];
+	REQUIRE(triangle.size() == 1);
+	CHECK(triangle[0].semantic == +VertexAttributeInfo::kPosition);
+	CHECK(triangle[0].buffer != quad[0].buffer);
+	CHECK(ReadVector3(mesh, triangle[0], 2)[2] == 3.0f);
+
+	// Index buffers keep their primitive mode, the triangle has none:
+	REQUIRE(mesh.indexBufferInfos.size() == 2);
+	const IndexBufferInfo& list = mesh.indexBufferInfos[0];
+	const IndexBufferInfo& strip = mesh.indexBufferInfos[1];
+	CHECK(list.mode == IndexBufferInfo::Mode::kTriangles);
+	CHECK(strip.mode == IndexBufferInfo::Mode::kTriangleStrip);
+	CHECK(list.vertexDataSet == 0);
+	CHECK(strip.vertexDataSet == 0);
+	CHECK(ReadIndices(mesh, list) == quadList);
+	CHECK(ReadIndices(mesh, strip) == quadStrip);
+
+	// The converted file is valid input for cooking:
+	const std::vector<uint8_t> cooked = MeshCooking::Cook(file, 16, true, false, 1, 0.5f, 0, false);
+	const PreparedMesh cookedMesh = PreparedMesh::FromMeshFile(*reinterpret_cast<const MeshFile*>(cooked.data()));
+	REQUIRE(cookedMesh.indexBufferInfos.size() == 2);
+	CHECK(cookedMesh.indexBufferInfos[1].mode == IndexBufferInfo::Mode::kTriangles);
+	CHECK(cookedMesh.indexBufferInfos[1].count == 6);
+}
+
+TEST_CASE("TestMeshCookingConvertNmbWithoutMeshes")
+{
+	CHECK_THROWS(MeshCooking::ConvertNmb(NmbWriter().Finish()));
+}
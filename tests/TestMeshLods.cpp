@@ -0,0 +1,95 @@
+/*	TestMeshLods.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/gfx/MeshLodFile.h>
+#include <molecular/gfx/MeshManager.h>
+#include <molecular/util/FileTypeIdentification.h>
+
+#include <vector>
+
+using namespace molecular;
+using namespace molecular::gfx;
+
+TEST_CASE("TestMeshLodsSelectLevel")
+{
+	MeshLods lods;
+	CHECK(lods.SelectLevel(100.0f, 1.0f, 0) == MeshLods::kMaxLevels - 1); // Not known yet
+
+	lods.levelCount = 3;
+	lods.errors = {{0.0f, 0.01f, 0.1f, 0.0f}};
+	CHECK(lods.SelectLevel(1000.0f, 1.0f, 0) == 0);
+	CHECK(lods.SelectLevel(50.0f, 1.0f, 0) == 1);
+	CHECK(lods.SelectLevel(5.0f, 1.0f, 0) == 2);
+
+	// Coarser levels need a margin, finer ones do not:
+	CHECK(lods.SelectLevel(90.0f, 1.0f, 0) == 0);
+	CHECK(lods.SelectLevel(90.0f, 1.0f, 1) == 1);
+	CHECK(lods.SelectLevel(110.0f, 1.0f, 1) == 0);
+	CHECK(lods.SelectLevel(60.0f, 1.0f, 0) == 1);
+}
+
+TEST_CASE("TestMeshLodFileHeader")
+{
+	std::vector<uint8_t> contents(MeshLodFile::GetHeaderSize(2), 0);
+	MeshLodFile& file = *reinterpret_cast<MeshLodFile*>(contents.data());
+	file.magic = MeshLodFile::kMagic;
+	file.numLevels = 2;
+	CHECK(MeshLodFile::IsValidHeader(contents.data(), contents.size()));
+	CHECK(util::FileTypeIdentification::IsMeshLodChain(contents.data(), contents.size()));
+	CHECK_FALSE(MeshLodFile::IsValidHeader(contents.data(), contents.size() - 1));
+
+	file.numLevels = MeshLodFile::kMaxLevels + 1;
+	CHECK_FALSE(MeshLodFile::IsValidHeader(contents.data(), contents.size()));
+	file.numLevels = 0;
+	CHECK_FALSE(MeshLodFile::IsValidHeader(contents.data(), contents.size()));
+}
+
+TEST_CASE("TestMeshLodFileClusterCone")
+{
+	MeshLodFile::Cluster cluster = {};
+	cluster.radius = 1.0f;
+	cluster.coneAxis[2] = 1.0f; // Facing +z
+	cluster.coneCutoff = 0.5f;
+
+	const float inFront[4] = {0, 0, 10, 1};
+	const float behind[4] = {0, 0, -10, 1};
+	const float close[4] = {0, 0, -1.5f, 1};
+	CHECK_FALSE(cluster.IsCulledByCone(inFront));
+	CHECK(cluster.IsCulledByCone(behind));
+	CHECK_FALSE(cluster.IsCulledByCone(close)); // Could see some triangles
+	CHECK(cluster.IsCulledByCone(inFront, true));
+	CHECK_FALSE(cluster.IsCulledByCone(behind, true));
+
+	const float parallel[4] = {0, 0, 1, 0};
+	const float sideways[4] = {1, 0, 0, 0};
+	CHECK(cluster.IsCulledByCone(parallel));
+	CHECK_FALSE(cluster.IsCulledByCone(sideways));
+
+	// Wide cones are never culled:
+	cluster.coneCutoff = 1.0f;
+	CHECK_FALSE(cluster.IsCulledByCone(behind));
+	CHECK_FALSE(cluster.IsCulledByCone(parallel));
+}
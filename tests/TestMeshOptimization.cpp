@@ -0,0 +1,183 @@
+/*	TestMeshOptimization.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <catch.hpp>
+#include <molecular/util/MeshOptimization.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+
+using namespace molecular;
+using namespace molecular::util;
+
+namespace
+{
+/// Triangles of a size x size vertex grid in random order
+std::vector<uint32_t> ShuffledGrid(uint32_t size)
+{
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for(uint32_t y = 0; y + 1 < size; ++y)
+	{
+		for(uint32_t x = 0; x + 1 < size; ++x)
+		{
+			const uint32_t v = y * size + x;
+			triangles.push_back({{v, v + 1, v + size}});
+			triangles.push_back({{v + 1, v + size + 1, v + size}});
+		}
+	}
+	std::mt19937 random(42);
+	std::shuffle(triangles.begin(), triangles.end(), random);
+
+	std::vector<uint32_t> indices;
+	for(auto& triangle: triangles)
+		indices.insert(indices.end(), triangle.begin(), triangle.end());
+	return indices;
+}
+
+/// Triangles with vertices rotated so the smallest index is first, sorted
+std::vector<std::array<uint32_t, 3>> Canonical(const std::vector<uint32_t>& indices)
+{
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for(size_t i = 0; i < indices.size(); i += 3)
+	{
+		std::array<uint32_t, 3> t = {{indices[i], indices[i + 1], indices[i + 2]}};
+		std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+		triangles.push_back(t);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+}
+
+TEST_CASE("TestMeshOptimizationStripToList")
+{
+	// Two strips joined by degenerate triangles:
+	const std::vector<uint32_t> strip = {0, 1, 2, 3, 3, 4, 4, 5, 6};
+	const std::vector<uint32_t> expected = {0, 1, 2, 2, 1, 3, 4, 5, 6};
+	CHECK(MeshOptimization::StripToList(strip) == expected);
+	CHECK(MeshOptimization::StripToList({0, 1}).empty());
+}
+
+TEST_CASE("TestMeshOptimizationVertexCache")
+{
+	const uint32_t size = 32;
+	const std::vector<uint32_t> indices = ShuffledGrid(size);
+	const auto before = MeshOptimization::Analyze(indices, size * size);
+
+	std::vector<size_t> clusters;
+	const std::vector<uint32_t> optimized = MeshOptimization::OptimizeVertexCache(indices, size * size, MeshOptimization::kDefaultCacheSize, &clusters);
+	CHECK(Canonical(optimized) == Canonical(indices));
+	REQUIRE_FALSE(clusters.empty());
+	CHECK(clusters.front() == 0);
+
+	const auto after = MeshOptimization::Analyze(optimized, size * size);
+	CHECK(after.acmr < 0.8f);
+	CHECK(after.acmr < before.acmr);
+	CHECK(after.atvr < before.atvr);
+
+	std::vector<float> positions;
+	for(uint32_t i = 0; i < size * size; ++i)
+		positions.insert(positions.end(), {float(i % size), float(i / size), 0.0f});
+	const std::vector<uint32_t> sorted = MeshOptimization::OptimizeOverdraw(optimized, clusters, positions.data(), 3 * sizeof(float), size * size);
+	CHECK(Canonical(sorted) == Canonical(indices));
+}
+
+TEST_CASE("TestMeshOptimizationVertexFetch")
+{
+	std::vector<uint32_t> indices = {3, 1, 2, 2, 1, 0};
+	const std::vector<uint32_t> remap = MeshOptimization::OptimizeVertexFetch(indices, 5);
+	CHECK(indices == std::vector<uint32_t>({0, 1, 2, 2, 1, 3}));
+	CHECK(remap == std::vector<uint32_t>({3, 1, 2, 0, 4}));
+}
+
+TEST_CASE("TestMeshOptimizationSimplify")
+{
+	const uint32_t size = 16;
+	const std::vector<uint32_t> indices = ShuffledGrid(size);
+	std::vector<float> positions;
+	for(uint32_t i = 0; i < size * size; ++i)
+		positions.insert(positions.end(), {float(i % size), float(i / size), 0.0f});
+
+	// A plane simplifies without error down to its border:
+	float error = -1;
+	const std::vector<uint32_t> flat = MeshOptimization::Simplify(indices, positions.data(), 3 * sizeof(float), size * size, 0, &error);
+	CHECK(flat.size() < indices.size() / 2);
+	CHECK(error == Approx(0.0f).margin(1e-3));
+	double area = 0;
+	for(size_t i = 0; i < flat.size(); i += 3)
+	{
+		const float* a = &positions[flat[i] * 3];
+		const float* b = &positions[flat[i + 1] * 3];
+		const float* c = &positions[flat[i + 2] * 3];
+		const double z = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+		CHECK(z > 0); // No flipped or degenerate triangles
+		area += z / 2;
+	}
+	CHECK(area == Approx((size - 1) * (size - 1)));
+
+	// Curvature costs something:
+	for(uint32_t i = 0; i < size * size; ++i)
+		positions[i * 3 + 2] = 0.1f * (positions[i * 3] * positions[i * 3] + positions[i * 3 + 1] * positions[i * 3 + 1]);
+	const std::vector<uint32_t> curved = MeshOptimization::Simplify(indices, positions.data(), 3 * sizeof(float), size * size, indices.size() / 2, &error);
+	CHECK(curved.size() <= indices.size() / 2);
+	CHECK(error > 0.0f);
+}
+
+TEST_CASE("TestMeshOptimizationClusters")
+{
+	const uint32_t size = 16;
+	const std::vector<uint32_t> indices = ShuffledGrid(size);
+	std::vector<float> positions;
+	for(uint32_t i = 0; i < size * size; ++i)
+		positions.insert(positions.end(), {float(i % size), float(i / size), 0.0f});
+
+	const std::vector<MeshOptimization::Cluster> clusters = MeshOptimization::BuildClusters(indices, positions.data(), 3 * sizeof(float), size * size, 100);
+	REQUIRE(clusters.size() == (indices.size() / 3 + 99) / 100);
+	size_t next = 0;
+	for(auto& cluster: clusters)
+	{
+		CHECK(cluster.firstIndex == next);
+		next += cluster.indexCount;
+		for(size_t i = cluster.firstIndex; i < cluster.firstIndex + cluster.indexCount; ++i)
+		{
+			const float* p = &positions[indices[i] * 3];
+			const float dx = p[0] - cluster.center[0], dy = p[1] - cluster.center[1], dz = p[2] - cluster.center[2];
+			CHECK(std::sqrt(dx * dx + dy * dy + dz * dz) <= cluster.radius + 1e-4f);
+		}
+
+		// Flat counter-clockwise grid faces +z:
+		CHECK(cluster.coneAxis[2] == Approx(1.0f));
+		CHECK(cluster.coneCutoff == Approx(0.0f).margin(1e-4));
+	}
+	CHECK(next == indices.size());
+
+	// Normals pointing in all directions make the cone useless:
+	const std::vector<float> tetrahedron = {0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1};
+	const std::vector<uint32_t> faces = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3};
+	const auto closed = MeshOptimization::BuildClusters(faces, tetrahedron.data(), 3 * sizeof(float), 4);
+	REQUIRE(closed.size() == 1);
+	CHECK(closed[0].coneCutoff == 1.0f);
+}
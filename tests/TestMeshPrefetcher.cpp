@@ -0,0 +1,167 @@
+/*	TestMeshPrefetcher.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/gfx/MeshPrefetcher.h>
+#include <molecular/util/Math.h>
+
+#include <vector>
+
+using namespace molecular;
+using namespace molecular::gfx;
+
+namespace
+{
+/// Meshes with three levels, records StartLoad calls without loading anything
+class RecordingLoader : public MeshManager::Loader
+{
+public:
+	struct Load
+	{
+		Hash mesh;
+		unsigned int level;
+	};
+
+	MeshLods* Create() override
+	{
+		MeshLods* lods = new MeshLods;
+		lods->levels.fill(nullptr);
+		lods->levelCount = 3;
+		lods->errors = {{0.0f, 0.01f, 0.1f, 0.0f}};
+		return lods;
+	}
+
+	void Destroy(MeshLods*& lods) override {delete lods;}
+
+	void StartLoad(MeshManager::Asset& asset, unsigned int minLevel, unsigned int maxLevel) override
+	{
+		for(unsigned int level = minLevel; level <= maxLevel; ++level)
+			loads.push_back(Load{asset.GetLocation().meshFile, level});
+	}
+
+	void Unload(MeshLods*&, unsigned int, unsigned int) override {}
+
+	std::vector<Load> loads;
+};
+
+const Hash kNear = 10;
+const Hash kMedium = 20;
+const Hash kFar = 30;
+const Hash kBehind = 40;
+const Hash kSide = 50;
+
+/// Cubes with an edge length of 2 around the given centers
+std::vector<uint8_t> MakeMeshBounds()
+{
+	const Hash meshes[] = {kNear, kMedium, kFar, kBehind, kSide};
+	const Vector3 centers[] = {Vector3(0, 0, -5), Vector3(0, 0, -100), Vector3(0, 0, -900), Vector3(0, 0, 50), Vector3(70, 0, -20)};
+	std::vector<util::AxisAlignedBox> bounds;
+	for(auto& center: centers)
+		bounds.push_back(util::AxisAlignedBox(center - Vector3(1, 1, 1), center + Vector3(1, 1, 1)));
+	return MeshBoundsCollectionFile::BuildHashed(meshes, bounds.data(), 5);
+}
+
+/// Camera at x looking down the negative z axis
+Matrix4 ViewMatrix(float x)
+{
+	return Matrix4::Translation(-x, 0, 0);
+}
+
+const Matrix4 kProjection = Matrix4::ProjectionPerspective(0.5f * util::Math::kPi_f, 1, 0.5f, 1000);
+const Vector2 kViewport(1000, 1000);
+}
+
+TEST_CASE("TestMeshPrefetcherLevels")
+{
+	RecordingLoader loader;
+	MeshManager manager(loader);
+	MeshPrefetcher prefetcher(manager);
+	const std::vector<uint8_t> bounds = MakeMeshBounds();
+	prefetcher.SetMeshBounds(reinterpret_cast<const MeshBoundsCollectionFile*>(bounds.data()));
+
+	// Something actually drawn, at the smallest size on screen:
+	MeshLocator behind;
+	behind.meshFile = kBehind;
+	manager.GetAsset(behind)->Use(1, MeshPrefetcher::kMaxPriority);
+
+	manager.Update(1);
+	prefetcher.Update(ViewMatrix(0), kProjection, kViewport);
+	CHECK(prefetcher.GetOutstandingCount() == 3);
+	manager.Update(2);
+
+	// Drawn meshes first, then nearer ones. Finer levels for larger sizes on screen:
+	REQUIRE(loader.loads.size() == 4);
+	CHECK(loader.loads[0].mesh == kBehind);
+	CHECK(loader.loads[1].mesh == kNear);
+	CHECK(loader.loads[1].level == 0);
+	CHECK(loader.loads[2].mesh == kMedium);
+	CHECK(loader.loads[2].level == 1);
+	CHECK(loader.loads[3].mesh == kFar);
+	CHECK(loader.loads[3].level == 2);
+}
+
+TEST_CASE("TestMeshPrefetcherBudget")
+{
+	RecordingLoader loader;
+	MeshManager manager(loader);
+	MeshPrefetcher prefetcher(manager);
+	const std::vector<uint8_t> bounds = MakeMeshBounds();
+	prefetcher.SetMeshBounds(reinterpret_cast<const MeshBoundsCollectionFile*>(bounds.data()));
+	prefetcher.SetMaxOutstanding(2);
+
+	manager.Update(1);
+	prefetcher.Update(ViewMatrix(0), kProjection, kViewport);
+	manager.Update(2);
+	REQUIRE(loader.loads.size() == 2);
+	CHECK(loader.loads[0].mesh == kNear);
+	CHECK(loader.loads[1].mesh == kMedium);
+
+	// Outstanding loads keep their slots:
+	prefetcher.Update(ViewMatrix(0), kProjection, kViewport);
+	manager.Update(3);
+	CHECK(loader.loads.size() == 2);
+	CHECK(prefetcher.GetOutstandingCount() == 2);
+}
+
+TEST_CASE("TestMeshPrefetcherVelocity")
+{
+	RecordingLoader loader;
+	MeshManager manager(loader);
+	MeshPrefetcher prefetcher(manager);
+	const std::vector<uint8_t> bounds = MakeMeshBounds();
+	prefetcher.SetMeshBounds(reinterpret_cast<const MeshBoundsCollectionFile*>(bounds.data()));
+
+	manager.Update(1);
+	prefetcher.Update(ViewMatrix(0), kProjection, kViewport);
+	manager.Update(2);
+	CHECK(loader.loads.size() == 3);
+
+	// Moving sideways, the side mesh comes into view within the look ahead frames:
+	prefetcher.Update(ViewMatrix(2), kProjection, kViewport);
+	manager.Update(3);
+	REQUIRE(loader.loads.size() == 4);
+	CHECK(loader.loads[3].mesh == kSide);
+	CHECK(loader.loads[3].level == 0);
+}
@@ -0,0 +1,149 @@
+/*	TestPackageFile.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/util/PackageFile.h>
+#include <molecular/util/PackageFileWriter.h>
+#include <molecular/util/MemoryStreamStorage.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace molecular;
+using namespace molecular::util;
+
+TEST_CASE("TestPackageFileDirectory")
+{
+	std::vector<PackageFile::Entry> entries;
+	for(uint32_t i = 1; i <= 1000; ++i)
+		entries.push_back(PackageFile::Entry{i * 7919, i, 16 + i});
+
+	PackageFileDirectory directory;
+	directory.Populate("first.pak", entries.begin(), entries.end());
+
+	PackageFileDirectory::Entry entry;
+	for(uint32_t i = 1; i <= 1000; ++i)
+	{
+		REQUIRE(directory.FindEntry(i * 7919, entry));
+		CHECK(entry.size == i);
+		CHECK(entry.offset == 16 + i);
+		CHECK(strcmp(entry.file, "first.pak") == 0);
+	}
+	CHECK_FALSE(directory.FindEntry(1, entry));
+	CHECK_THROWS(directory.GetEntry(1));
+
+	// Later package files override earlier ones:
+	const PackageFile::Entry overriding{7919, 5, 100};
+	directory.Populate("second.pak", &overriding, &overriding + 1);
+	CHECK(strcmp(directory.GetEntry(7919).file, "second.pak") == 0);
+	CHECK(directory.GetEntry(7919).size == 5);
+	CHECK(strcmp(directory.GetEntry(2 * 7919).file, "first.pak") == 0);
+}
+
+TEST_CASE("TestHashedPackageFile")
+{
+	std::vector<PackageFile::Entry> entries;
+	for(uint32_t i = 0; i < 100; ++i)
+		entries.push_back(PackageFile::Entry{i * 64, i, 1000 + i}); // Colliding slots
+	std::vector<PackageFile::Entry> table = HashedPackageFile::BuildTable(entries.begin(), entries.end());
+	CHECK(table.size() == HashedPackageFile::GetTableSize(100));
+	CHECK(table.size() == 256);
+
+	std::vector<uint8_t> fileData(sizeof(HashedPackageFile) + table.size() * sizeof(PackageFile::Entry));
+	HashedPackageFile& file = *reinterpret_cast<HashedPackageFile*>(fileData.data());
+	file.magic = HashedPackageFile::kMagic;
+	file.count = 100;
+	file.tableSize = table.size();
+	file.flags = 0;
+	memcpy(file.entries, table.data(), table.size() * sizeof(PackageFile::Entry));
+
+	for(uint32_t i = 0; i < 100; ++i)
+	{
+		const PackageFile::Entry* entry = file.Find(i * 64);
+		REQUIRE(entry);
+		CHECK(entry->size == i);
+		CHECK(entry->offset == 1000 + i);
+	}
+	CHECK(file.Find(1) == nullptr);
+
+	MemoryReadStorage storage(fileData.data(), fileData.size());
+	PackageFileDirectory directory;
+	directory.ReadFromFile(storage, "hashed.pak");
+	CHECK(directory.GetEntry(64 * 99).size == 99);
+	CHECK(strcmp(directory.GetEntry(64).file, "hashed.pak") == 0);
+}
+
+namespace
+{
+/// Storage that appends to a vector
+struct VectorWriteStorage
+{
+	void Write(const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		contents.insert(contents.end(), bytes, bytes + size);
+	}
+
+	std::vector<uint8_t> contents;
+};
+}
+
+TEST_CASE("TestPackageFileWriter")
+{
+	PackageFileWriter writer(256);
+	const std::vector<std::vector<uint8_t>> files = {
+		std::vector<uint8_t>(10, 1),
+		std::vector<uint8_t>(300, 2),
+		std::vector<uint8_t>(0),
+		std::vector<uint8_t>(50, 4)
+	};
+	writer.AddFile(11, files[0].size());
+	writer.AddFile(22, files[1].size(), 18); // Aligned payload after 18 byte header
+	writer.AddFile(33, files[2].size());
+	writer.AddFile(44, files[3].size());
+	CHECK_THROWS(writer.AddFile(22, 5));
+
+	CHECK(writer.GetOffset(0) % 256 == 0);
+	CHECK((writer.GetOffset(1) + 18) % 256 == 0);
+	CHECK(writer.GetOffset(1) >= writer.GetOffset(0) + files[0].size());
+	CHECK(writer.GetOffset(3) > writer.GetOffset(1));
+
+	VectorWriteStorage storage;
+	writer.Write(storage, [&](size_t index){return files[index];});
+	REQUIRE(storage.contents.size() == writer.GetPackageSize());
+
+	const HashedPackageFile& file = *reinterpret_cast<const HashedPackageFile*>(storage.contents.data());
+	CHECK(file.magic == +HashedPackageFile::kMagic);
+	CHECK(file.count == 4);
+	const Hash names[] = {11, 22, 33, 44};
+	for(size_t i = 0; i < 4; ++i)
+	{
+		const PackageFile::Entry* entry = file.Find(names[i]);
+		REQUIRE(entry);
+		CHECK(entry->offset == writer.GetOffset(i));
+		REQUIRE(entry->size == files[i].size());
+		CHECK(std::equal(files[i].begin(), files[i].end(), storage.contents.begin() + entry->offset));
+	}
+}
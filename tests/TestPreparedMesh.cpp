@@ -0,0 +1,150 @@
+/*	TestPreparedMesh.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/gfx/MeshManager.h>
+#include <molecular/gfx/PreparedMesh.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace molecular;
+using namespace molecular::gfx;
+
+namespace
+{
+/// Triangle with interleaved float positions and normals
+PreparedMesh MakeTriangle(std::vector<float>& vertices)
+{
+	vertices = {
+		0, 0, 0, 0, 0, 1,
+		1, 0, 0, 0, 0, 1,
+		0, 1, 0, 0, 0, 1
+	};
+	VertexAttributeInfo position;
+	position.type = VertexAttributeInfo::kFloat;
+	position.semantic = VertexAttributeInfo::kPosition;
+	position.components = 3;
+	position.stride = 6 * sizeof(float);
+	position.offset = 0;
+	position.buffer = 0;
+	VertexAttributeInfo normal = position;
+	normal.semantic = VertexAttributeInfo::kNormal;
+	normal.offset = 3 * sizeof(float);
+
+	PreparedMesh mesh;
+	mesh.vertexDataSets.push_back({position, normal});
+	mesh.vertexCounts.push_back(3);
+	mesh.vertexBuffers.push_back(PreparedMesh::Buffer{vertices.data(), vertices.size() * sizeof(float)});
+	return mesh;
+}
+}
+
+TEST_CASE("TestPreparedMeshMorphTargets")
+{
+	std::vector<float> vertices;
+	PreparedMesh base = MakeTriangle(vertices);
+
+	MorphTargetData target = MorphTargetData::FromPreparedMesh(base);
+	REQUIRE(target.vertexDataSets.size() == 1);
+	REQUIRE(target.vertexDataSets[0].positions.size() == 9);
+	REQUIRE(target.vertexDataSets[0].normals.size() == 9);
+
+	// Unchanged target adds no deltas:
+	base.AddMorphTarget(target);
+	REQUIRE(base.morphTargets.size() == 1);
+	CHECK(base.morphTargets[0].vertexDataSets[0].empty());
+	CHECK(base.vertexBuffers.size() == 1);
+
+	target.vertexDataSets[0].positions[7] = 3.0f; // Move third vertex up
+	target.vertexDataSets[0].normals[5] = 0.5f;
+	base.AddMorphTarget(target);
+	REQUIRE(base.morphTargets.size() == 2);
+	const std::vector<VertexAttributeInfo>& deltas = base.morphTargets[1].vertexDataSets[0];
+	REQUIRE(deltas.size() == 2);
+	REQUIRE(base.vertexBuffers.size() == 2);
+	CHECK(deltas[0].semantic == +VertexAttributeInfo::kPosition);
+	CHECK(deltas[1].semantic == +VertexAttributeInfo::kNormal);
+	CHECK(deltas[0].buffer == 1);
+
+	const float* data = static_cast<const float*>(base.vertexBuffers[1].data);
+	const size_t stride = deltas[0].stride / sizeof(float);
+	CHECK(data[2 * stride + deltas[0].offset / sizeof(float) + 1] == 2.0f);
+	CHECK(data[1 * stride + deltas[1].offset / sizeof(float) + 2] == -0.5f);
+	CHECK(data[0 * stride] == 0.0f);
+
+	// Vertex count mismatch, as with simplified levels:
+	target.vertexDataSets[0].positions.resize(6);
+	base.AddMorphTarget(target);
+	CHECK(base.morphTargets[2].vertexDataSets[0].empty());
+}
+
+TEST_CASE("TestPreparedMeshMorphTargetVertexOrder")
+{
+	std::vector<float> vertices;
+	PreparedMesh base = MakeTriangle(vertices);
+	const uint16_t baseIndices[] = {0, 1, 2};
+	IndexBufferInfo info;
+	info.type = IndexBufferInfo::Type::kUInt16;
+	info.mode = IndexBufferInfo::Mode::kTriangles;
+	info.buffer = 1;
+	info.offset = 0;
+	info.count = 3;
+	info.vertexDataSet = 0;
+	base.indexBufferInfos.push_back(info);
+	base.indexBuffers.resize(2);
+	base.indexBuffers[1] = PreparedMesh::Buffer{baseIndices, sizeof(baseIndices)};
+
+	// Same triangle, cooked separately with the first two vertices swapped:
+	std::vector<float> targetVertices;
+	PreparedMesh targetMesh = MakeTriangle(targetVertices);
+	std::swap_ranges(targetVertices.begin(), targetVertices.begin() + 6, targetVertices.begin() + 6);
+	targetVertices[13] = 2.0f; // Move third vertex up
+	const uint16_t targetIndices[] = {1, 0, 2};
+	targetMesh.indexBufferInfos = base.indexBufferInfos;
+	targetMesh.indexBuffers.resize(2);
+	targetMesh.indexBuffers[1] = PreparedMesh::Buffer{targetIndices, sizeof(targetIndices)};
+
+	// Pairing vertices by index would move the first two vertices:
+	base.AddMorphTarget(MorphTargetData::FromPreparedMesh(targetMesh));
+	REQUIRE(base.morphTargets.size() == 1);
+	CHECK(base.morphTargets[0].vertexDataSets[0].empty());
+
+	// Equal vertex order:
+	std::swap_ranges(targetVertices.begin(), targetVertices.begin() + 6, targetVertices.begin() + 6);
+	targetMesh.indexBuffers[1] = PreparedMesh::Buffer{baseIndices, sizeof(baseIndices)};
+	base.AddMorphTarget(MorphTargetData::FromPreparedMesh(targetMesh));
+	REQUIRE(base.morphTargets.size() == 2);
+	CHECK_FALSE(base.morphTargets[1].vertexDataSets[0].empty());
+}
+
+TEST_CASE("TestMeshLocatorHash")
+{
+	MeshLocator locator;
+	locator.meshFile = 1;
+	const Hash plain = MakeHash(locator);
+	locator.morphTargets.push_back(2);
+	CHECK(MakeHash(locator) != plain);
+}
@@ -0,0 +1,62 @@
+/*	TestRangeAllocator.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/util/RangeAllocator.h>
+
+using namespace molecular::util;
+
+TEST_CASE("TestRangeAllocator")
+{
+	RangeAllocator allocator(1000);
+	const size_t a = allocator.Allocate(100);
+	const size_t b = allocator.Allocate(100, 64);
+	const size_t c = allocator.Allocate(100);
+	CHECK(a == 0);
+	CHECK(b == 128);
+	CHECK(c == 228);
+	CHECK(allocator.Allocate(100, 16) == 336); // Padding before b stays free
+	CHECK(allocator.Allocate(28) == 100);
+	CHECK(allocator.GetUsed() == 428);
+	CHECK(allocator.Allocate(1000) == RangeAllocator::kInvalid);
+
+	// Freed neighbours merge into one range:
+	allocator.Free(b);
+	allocator.Free(a);
+	CHECK(allocator.GetFreeRangeCount() == 4);
+	allocator.Free(100);
+	CHECK(allocator.GetFreeRangeCount() == 3);
+	CHECK(allocator.GetLargestFreeRange() == 1000 - 436);
+	CHECK(allocator.Allocate(228) == 0);
+	CHECK_THROWS(allocator.Free(50));
+
+	allocator.Free(0);
+	allocator.Free(c);
+	allocator.Free(336);
+	CHECK(allocator.IsEmpty());
+	CHECK(allocator.GetUsed() == 0);
+	CHECK(allocator.GetFreeRangeCount() == 1);
+	CHECK(allocator.GetLargestFreeRange() == 1000);
+}
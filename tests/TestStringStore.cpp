@@ -26,7 +26,9 @@ SOFTWARE.
 #include <catch.hpp>
 #include <molecular/util/StringStore.h>
 #include <molecular/util/Hash.h>
+#include <cstring>
 #include <iostream>
+#include <limits>
 
 using Catch::Matchers::Equals;
 using namespace molecular;
@@ -71,3 +73,103 @@ asdasd)";
 	CHECK_THAT(store.GetString("lalala"_H), Equals("lalala"));
 	CHECK_THAT(store.GetString("asdasd"_H), Equals("asdasd"));
 }
+
+TEST_CASE("TestStringStorePerfectHash")
+{
+	std::string text;
+	for(int i = 0; i < 1000; ++i)
+		text += "textures/texture" + std::to_string(i) + ".dds\n";
+	text.pop_back();
+
+	StringStore textStore;
+	textStore.LoadFromText(text.data(), text.size());
+	std::vector<uint8_t> file = textStore.ToPerfectHashFile();
+	REQUIRE(file.size() > sizeof(PerfectHashStringStoreFile));
+
+	StringStore mappedStore;
+	mappedStore.LoadFromMappedFile(file.data(), file.size());
+	StringStore copiedStore(file.data(), file.size());
+	CHECK(mappedStore.GetStringCount() == 1000);
+	CHECK(copiedStore.GetStringCount() == 1000);
+	for(int i = 0; i < 1000; ++i)
+	{
+		const std::string path = "textures/texture" + std::to_string(i) + ".dds";
+		CHECK_THAT(mappedStore.GetString(HashUtils::MakeHash(path)), Equals(path));
+		CHECK_THAT(copiedStore.GetString(HashUtils::MakeHash(path)), Equals(path));
+	}
+	CHECK(mappedStore.FindString("textures/texture1000.dds"_H) == nullptr);
+	CHECK_THROWS(mappedStore.GetString("nope"_H));
+
+	// Round trip through perfect hash file:
+	StringStore roundTrip(copiedStore.ToPerfectHashFile().data(), file.size());
+	CHECK_THAT(roundTrip.GetString("textures/texture42.dds"_H), Equals("textures/texture42.dds"));
+
+	file.resize(file.size() - 1);
+	CHECK_THROWS(mappedStore.LoadFromMappedFile(file.data(), file.size()));
+}
+
+TEST_CASE("TestStringStorePerfectHashEmpty")
+{
+	StringStore emptyStore;
+	std::vector<uint8_t> file = emptyStore.ToPerfectHashFile();
+	StringStore store;
+	store.LoadFromMappedFile(file.data(), file.size());
+	CHECK(store.GetStringCount() == 0);
+	CHECK(store.FindString("bla"_H) == nullptr);
+}
+
+TEST_CASE("TestStringStorePerfectHashCorrupt")
+{
+	std::string text;
+	for(int i = 0; i < 10; ++i)
+		text += "string" + std::to_string(i) + ";";
+	text.pop_back();
+	StringStore textStore;
+	textStore.LoadFromText(text.data(), text.size());
+	const std::vector<uint8_t> file = textStore.ToPerfectHashFile();
+	PerfectHashStringStoreFile header;
+	memcpy(&header, file.data(), sizeof(header));
+	const size_t displacementsOffset = sizeof(PerfectHashStringStoreFile);
+	const size_t entriesOffset = displacementsOffset + header.bucketCount * sizeof(int32_t);
+
+	StringStore store;
+	std::vector<uint8_t> corrupt = file;
+	store.LoadFromMappedFile(corrupt.data(), corrupt.size());
+	CHECK_THAT(store.GetString("string7"_H), Equals("string7"));
+
+	SECTION("Displacement past entries")
+	{
+		const int32_t displacement = -int32_t(header.count) - 1;
+		memcpy(corrupt.data() + displacementsOffset, &displacement, sizeof(displacement));
+		CHECK_THROWS(store.LoadFromMappedFile(corrupt.data(), corrupt.size()));
+		CHECK_THROWS(StringStore(corrupt.data(), corrupt.size()));
+	}
+
+	SECTION("Most negative displacement")
+	{
+		const int32_t displacement = std::numeric_limits<int32_t>::min();
+		memcpy(corrupt.data() + displacementsOffset, &displacement, sizeof(displacement));
+		CHECK_THROWS(store.LoadFromMappedFile(corrupt.data(), corrupt.size()));
+	}
+
+	SECTION("String offset past string list")
+	{
+		const uint32_t offset = header.stringListSize;
+		memcpy(corrupt.data() + entriesOffset + sizeof(uint32_t), &offset, sizeof(offset));
+		CHECK_THROWS(store.LoadFromMappedFile(corrupt.data(), corrupt.size()));
+	}
+
+	SECTION("Unterminated string list")
+	{
+		corrupt.back() = 'x';
+		CHECK_THROWS(store.LoadFromMappedFile(corrupt.data(), corrupt.size()));
+	}
+
+	SECTION("Huge header sizes")
+	{
+		header.count = std::numeric_limits<uint32_t>::max();
+		header.bucketCount = std::numeric_limits<uint32_t>::max();
+		memcpy(corrupt.data(), &header, sizeof(header));
+		CHECK_THROWS(store.LoadFromMappedFile(corrupt.data(), corrupt.size()));
+	}
+}
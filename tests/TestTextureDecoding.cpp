@@ -0,0 +1,94 @@
+/*	TestTextureDecoding.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <catch.hpp>
+#include <molecular/util/TextureDecoding.h>
+
+#include <numeric>
+
+using namespace molecular;
+using namespace molecular::util;
+
+TEST_CASE("TestTextureDecodingDownsample")
+{
+	SECTION("Even size")
+	{
+		const uint8_t in[] = {
+			0, 4, 10, 20,
+			8, 4, 30, 40
+		};
+		uint8_t out[2];
+		TextureDecoding::Downsample(in, 4, 2, 1, out);
+		CHECK(out[0] == 4);
+		CHECK(out[1] == 25);
+	}
+
+	SECTION("Odd width keeps last column")
+	{
+		const uint8_t in[] = {0, 0, 0, 0, 250};
+		uint8_t out[2];
+		TextureDecoding::Downsample(in, 5, 1, 1, out);
+		CHECK(out[0] == 0);
+		CHECK(out[1] == 100); // Weights 1/5, 2/5, 2/5
+	}
+
+	SECTION("Odd size keeps last row and column")
+	{
+		// Two channels, only the bottom right pixel is set:
+		uint8_t in[3 * 3 * 2] = {};
+		in[8 * 2] = 90;
+		in[8 * 2 + 1] = 180;
+		uint8_t out[2];
+		TextureDecoding::Downsample(in, 3, 3, 2, out);
+		CHECK(out[0] == 10);
+		CHECK(out[1] == 20);
+	}
+
+	SECTION("Odd sizes keep the average")
+	{
+		const unsigned int width = 7, height = 5;
+		uint8_t in[width * height];
+		for(unsigned int i = 0; i < width * height; ++i)
+			in[i] = uint8_t(i * 37 % 256);
+		uint8_t out[3 * 2];
+		TextureDecoding::Downsample(in, width, height, 1, out);
+		const float inAverage = std::accumulate(in, in + width * height, 0.0f) / (width * height);
+		const float outAverage = std::accumulate(out, out + 3 * 2, 0.0f) / (3 * 2);
+		CHECK(outAverage == Approx(inAverage).margin(0.5f));
+	}
+}
+
+TEST_CASE("TestTextureDecodingGenerateMipLevels")
+{
+	DecodedTexture texture;
+	texture.data.assign(3 * 3 * 4, 0);
+	texture.data[8 * 4] = 180; // Bottom right pixel, first channel
+	texture.levels.push_back(DecodedTexture::Level{3, 3, 0, texture.data.size()});
+	TextureDecoding::GenerateMipLevels(texture, 4);
+	REQUIRE(texture.levels.size() == 2);
+	CHECK(texture.levels[1].width == 1);
+	CHECK(texture.levels[1].height == 1);
+	CHECK(texture.data[texture.levels[1].offset] == 20);
+}
@@ -0,0 +1,61 @@
+/*	TestTextureFileLayout.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <catch.hpp>
+#include <molecular/util/TextureFileLayout.h>
+#include "DdsTestData.h"
+#include "KtxTestData.h"
+
+using namespace molecular;
+using namespace molecular::util;
+
+TEST_CASE("TestTextureFileLayoutDds")
+{
+	TextureFileLayout layout;
+	REQUIRE(TextureFileLayout::FromHeader(DdsTestData::ddsDxt1, TextureFileLayout::kMaxHeaderSize, layout));
+	REQUIRE(layout.levels.size() == 1);
+	CHECK(layout.levels[0].width == 8);
+	CHECK(layout.levels[0].height == 8);
+	CHECK(layout.GetRangeOffset(0) == 128);
+	CHECK(layout.GetRangeSize(0, 0) == 32);
+
+	// Uncompressed images are not streamed:
+	CHECK_FALSE(TextureFileLayout::FromHeader(DdsTestData::ddsRgb, TextureFileLayout::kMaxHeaderSize, layout));
+	CHECK_FALSE(TextureFileLayout::FromHeader(DdsTestData::ddsDxt1, 64, layout));
+}
+
+TEST_CASE("TestTextureFileLayoutKtx")
+{
+	TextureFileLayout layout;
+	REQUIRE(TextureFileLayout::FromHeader(KtxTestData::exampleImageMipMaps, TextureFileLayout::kMaxHeaderSize, layout));
+	REQUIRE(layout.levels.size() == 5);
+	const size_t sizes[] = {160, 48, 8, 8, 8};
+	for(unsigned int i = 0; i < 5; ++i)
+		CHECK(layout.levels[i].size == sizes[i]);
+
+	// Four bytes imageSize before each level:
+	CHECK(layout.levels[1].offset == layout.levels[0].offset + 160 + 4);
+	CHECK(layout.GetRangeSize(0, 4) == 160 + 48 + 8 + 8 + 8 + 4 * 4);
+	CHECK(layout.GetRangeOffset(4) + layout.GetRangeSize(4, 4) == sizeof(KtxTestData::exampleImageMipMaps));
+}
@@ -24,10 +24,14 @@ SOFTWARE.
 */
 
 #include <catch.hpp>
+#include <molecular/util/TextureDecoding.h>
 #include <molecular/util/TgaFile.h>
 #include <molecular/util/MemoryStreamStorage.h>
 #include "TgaTestData.h"
 
+#include <cstring>
+#include <vector>
+
 using namespace molecular;
 using namespace molecular::util;
 
@@ -49,3 +53,86 @@ TEST_CASE("TestTgaFileMono")
 	CHECK(false == file.IsUpsideDown());
 	CHECK(PF_L8 == file.GetFormat());
 }
+
+/// Create TGA header for a bottom-up image
+static std::vector<uint8_t> MakeTgaHeader(uint8_t imageType, uint16_t width, uint16_t height, uint8_t bitsPerPixel)
+{
+	TgaFile2::Header header;
+	header.imageType = imageType;
+	header.paletteBegin0 = header.paletteBegin1 = header.paletteLength0 = 0;
+	header.xOrigin0 = header.xOrigin1 = header.yOrigin0 = header.yOrigin1 = 0;
+	header.width0 = width & 0xff;
+	header.width1 = width >> 8;
+	header.height0 = height & 0xff;
+	header.height1 = height >> 8;
+	header.bitsPerPixel = bitsPerPixel;
+	std::vector<uint8_t> file(sizeof(header));
+	memcpy(file.data(), &header, sizeof(header));
+	return file;
+}
+
+TEST_CASE("TestTgaFileRle")
+{
+	// 3x2 BGR image, bottom line first. Packets span lines.
+	std::vector<uint8_t> raw = MakeTgaHeader(2, 3, 2, 24);
+	const uint8_t pixels[] = {
+		1, 2, 3, 1, 2, 3, 1, 2, 3, // Bottom line
+		1, 2, 3, 7, 8, 9, 4, 5, 6 // Top line
+	};
+	raw.insert(raw.end(), pixels, pixels + sizeof(pixels));
+
+	std::vector<uint8_t> rle = MakeTgaHeader(10, 3, 2, 24);
+	const uint8_t packets[] = {
+		0x83, 1, 2, 3, // Run of 4
+		0x01, 7, 8, 9, 4, 5, 6 // 2 raw pixels
+	};
+	rle.insert(rle.end(), packets, packets + sizeof(packets));
+
+	TgaFile2 rawFile(raw.data(), raw.size());
+	TgaFile2 rleFile(rle.data(), rle.size());
+	CHECK(rleFile.IsRle());
+	CHECK(rleFile.GetFormat() == PF_B8G8R8);
+	REQUIRE(rleFile.GetImageSize() == sizeof(pixels));
+
+	std::vector<uint8_t> rawDecoded(rawFile.GetImageSize()), rleDecoded(rleFile.GetImageSize());
+	rawFile.CopyImageDataTopDown(rawDecoded.data());
+	rleFile.CopyImageDataTopDown(rleDecoded.data());
+	CHECK(rawDecoded == rleDecoded);
+	CHECK(rleDecoded[3] == 7); // Top line first
+
+	rle.pop_back();
+	TgaFile2 truncated(rle.data(), rle.size());
+	CHECK_THROWS_AS(truncated.CopyImageDataTopDown(rleDecoded.data()), std::runtime_error);
+}
+
+TEST_CASE("TestTextureDecodingTga")
+{
+	std::vector<uint8_t> file = MakeTgaHeader(2, 4, 2, 24);
+	for(int i = 0; i < 8; ++i)
+	{
+		const uint8_t pixel[] = {uint8_t(i * 10), uint8_t(i), 200};
+		file.insert(file.end(), pixel, pixel + 3);
+	}
+
+	DecodedTexture texture = TextureDecoding::DecodeTga(file.data(), file.size());
+	CHECK(texture.format == PF_B8G8R8A8);
+	REQUIRE(texture.levels.size() == 3); // 4x2, 2x1, 1x1
+	CHECK(texture.levels[1].width == 2);
+	CHECK(texture.levels[1].height == 1);
+	CHECK(texture.levels[2].offset + texture.levels[2].size == texture.data.size());
+
+	// Top line comes from the end of the file:
+	const uint8_t* top = static_cast<const uint8_t*>(texture.GetLevelData(0));
+	CHECK(top[0] == 40);
+	CHECK(top[3] == 0xff);
+
+	// Average of pixels 0, 1, 4 and 5:
+	const uint8_t* level1 = static_cast<const uint8_t*>(texture.GetLevelData(1));
+	CHECK(level1[0] == 25);
+	CHECK(level1[2] == 200);
+
+	const std::vector<uint8_t> mono = MakeTgaHeader(3, 3, 1, 8);
+	std::vector<uint8_t> monoFile = mono;
+	monoFile.insert(monoFile.end(), {10, 20, 30});
+	CHECK(TextureDecoding::DecodeTga(monoFile.data(), monoFile.size()).levels.size() == 1);
+}
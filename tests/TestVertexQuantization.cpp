@@ -0,0 +1,69 @@
+/*	TestVertexQuantization.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <catch.hpp>
+#include <molecular/util/VertexQuantization.h>
+
+#include <cmath>
+
+using namespace molecular;
+using namespace molecular::util;
+
+TEST_CASE("TestVertexQuantizationHalf")
+{
+	CHECK(VertexQuantization::ToHalf(0.0f) == 0x0000);
+	CHECK(VertexQuantization::ToHalf(1.0f) == 0x3c00);
+	CHECK(VertexQuantization::ToHalf(-2.0f) == 0xc000);
+	CHECK(VertexQuantization::ToHalf(65504.0f) == 0x7bff);
+	CHECK(VertexQuantization::ToHalf(1e6f) == 0x7c00);
+	CHECK(VertexQuantization::ToHalf(std::ldexp(1.0f, -24)) == 0x0001); // Smallest subnormal
+
+	for(float value: {0.5f, 0.1234f, 0.999f, 3.75f, -0.001f})
+		CHECK(std::abs(VertexQuantization::FromHalf(VertexQuantization::ToHalf(value)) - value) <= std::abs(value) / 1024.0f);
+}
+
+TEST_CASE("TestVertexQuantizationUnorm16")
+{
+	CHECK(VertexQuantization::ToUnorm16(-1.0f, -1.0f, 2.0f) == 0);
+	CHECK(VertexQuantization::ToUnorm16(1.0f, -1.0f, 2.0f) == 65535);
+	CHECK(VertexQuantization::ToUnorm16(0.0f, -1.0f, 2.0f) == 32768);
+	CHECK(VertexQuantization::ToUnorm16(5.0f, -1.0f, 2.0f) == 65535);
+	CHECK(VertexQuantization::ToUnorm16(5.0f, 5.0f, 0.0f) == 0);
+}
+
+TEST_CASE("TestVertexQuantizationOctahedral")
+{
+	const float vectors[][3] = {{0, 0, 1}, {0, 0, -1}, {1, 0, 0}, {0, -1, 0}, {0.3f, -0.5f, -0.8f}, {-0.6f, 0.6f, 0.2f}};
+	for(auto& v: vectors)
+	{
+		const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		const float normalized[3] = {v[0] / length, v[1] / length, v[2] / length};
+		int16_t encoded[2];
+		VertexQuantization::EncodeOctahedral(normalized, encoded);
+		float decoded[3];
+		VertexQuantization::DecodeOctahedral(encoded, decoded);
+		const float dot = normalized[0] * decoded[0] + normalized[1] * decoded[1] + normalized[2] * decoded[2];
+		CHECK(dot > 0.99999f);
+	}
+}
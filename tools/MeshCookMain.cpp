@@ -0,0 +1,126 @@
+/*	MeshCookMain.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file MeshCookMain.cpp
+	molecular-meshcook: Command line front end of MeshCooking. NVidia NMB
+	files are converted to compiled meshes first. */
+
+#include <molecular/gfx/MeshCooking.h>
+#include <molecular/util/CommandLineParser.h>
+#include <molecular/util/FileStreamStorage.h>
+#include <molecular/util/FileTypeIdentification.h>
+#include <molecular/util/MeshOptimization.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace molecular;
+using namespace molecular::util;
+using namespace molecular::gfx;
+
+static std::vector<uint8_t> ReadContents(const std::string& path)
+{
+	FileReadStorage storage(path);
+	std::vector<uint8_t> contents(storage.GetSize());
+	if(storage.Read(contents.data(), contents.size()) != contents.size())
+		throw std::runtime_error("Cannot read " + path);
+	return contents;
+}
+
+static void PrintStatistics(const std::vector<MeshCooking::LevelStatistics>& statistics, bool clusters)
+{
+	for(size_t i = 0; i < statistics.size(); ++i)
+	{
+		const MeshCooking::LevelStatistics& level = statistics[i];
+		for(auto& set: level.vertexDataSets)
+		{
+			std::cout << "Vertex data set " << set.index << " before: ACMR " << set.before.acmr << ", ATVR " << set.before.atvr << std::endl;
+			std::cout << "Vertex data set " << set.index << " after: ACMR " << set.after.acmr << ", ATVR " << set.after.atvr << std::endl;
+		}
+		if(level.positionStreams)
+			std::cout << "Position streams split off for " << level.positionStreams << " vertex data sets" << std::endl;
+		if(level.quantizationBytesBefore)
+			std::cout << "Vertex data: " << level.quantizationBytesBefore << " bytes before, " << level.quantizationBytesAfter << " bytes after quantization" << std::endl;
+		if(i > 0)
+			std::cout << "Level " << i << ": " << level.triangles << " triangles, " << level.clusters << " clusters, error " << level.error << std::endl;
+		else if(clusters)
+			std::cout << "Level 0: " << level.clusters << " clusters" << std::endl;
+	}
+}
+
+void Run(int argc, char** argv)
+{
+	CommandLineParser cmd;
+	CommandLineParser::PositionalArg<std::string> input(cmd, "input", "Compiled mesh file or NMB file");
+	CommandLineParser::Option<std::string> output(cmd, "output", "File to write, overwrites input if empty", "");
+	CommandLineParser::Option<int> cacheSize(cmd, "cache-size", "Post-transform vertex cache entries", MeshOptimization::kDefaultCacheSize);
+	CommandLineParser::Option<int> overdraw(cmd, "overdraw", "Sort triangle clusters against overdraw if not 0", 1);
+	CommandLineParser::Option<int> quantize(cmd, "quantize", "Quantize vertex attributes if not 0", 0);
+	CommandLineParser::Option<int> lods(cmd, "lods", "Levels of detail including the original, writes a LOD chain if more than 1", 1);
+	CommandLineParser::Option<int> lodPercentage(cmd, "lod-percentage", "Percentage of triangles each level keeps of the previous one", 50);
+	CommandLineParser::Option<int> clusterSize(cmd, "cluster-size", "Triangles per culling cluster, writes a LOD chain with clusters if not 0", 0);
+	CommandLineParser::Option<int> positionStream(cmd, "position-stream", "Store positions in a separate buffer for depth-only passes if not 0", 0);
+	cmd.Parse(argc, argv);
+
+	if(*cacheSize <= 0)
+		throw std::runtime_error("Cache size must be positive");
+	if(*lods <= 0 || *lodPercentage <= 0 || *lodPercentage >= 100)
+		throw std::runtime_error("Invalid level of detail options");
+	if(*clusterSize < 0)
+		throw std::runtime_error("Cluster size must not be negative");
+	std::vector<uint8_t> contents = ReadContents(*input);
+	if(FileTypeIdentification::IsNmb(contents.data(), contents.size()))
+	{
+		if((*output).empty())
+			throw std::runtime_error("Output file required for NMB input");
+		MeshCooking::NmbStatistics nmbStatistics;
+		contents = MeshCooking::ConvertNmb(contents, &nmbStatistics);
+		for(auto& name: nmbStatistics.unknownVertexBuffers)
+			std::cerr << "Unknown NMB vertex buffer \"" << name << "\"" << std::endl;
+		std::cout << "Converted " << nmbStatistics.meshes << " NMB meshes" << std::endl;
+	}
+	std::vector<MeshCooking::LevelStatistics> statistics;
+	const std::vector<uint8_t> cooked = MeshCooking::Cook(contents, *cacheSize, *overdraw != 0, *quantize != 0, *lods, *lodPercentage / 100.0f, *clusterSize, *positionStream != 0, &statistics);
+	PrintStatistics(statistics, *clusterSize != 0);
+	const std::string outputPath = (*output).empty() ? *input : *output;
+	FileWriteStorage storage(outputPath.c_str());
+	storage.Write(cooked.data(), cooked.size());
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		Run(argc, argv);
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
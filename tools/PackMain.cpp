@@ -0,0 +1,200 @@
+/*	PackMain.cpp
+
+MIT License
+
+Copyright (c) 2020 Fabian Herb
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file PackMain.cpp
+	molecular-pack: Builds HashedPackageFiles laid out for fast loading. */
+
+#include <molecular/gfx/MeshBoundsCollectionFile.h>
+#include <molecular/util/BlockCompression.h>
+#include <molecular/util/CommandLineParser.h>
+#include <molecular/util/DdsFile.h>
+#include <molecular/util/FileStreamStorage.h>
+#include <molecular/util/FileTypeIdentification.h>
+#include <molecular/util/KtxFile.h>
+#include <molecular/util/PackageFileWriter.h>
+#include <molecular/util/StringUtils.h>
+#include <molecular/util/TgaFile.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace molecular;
+using namespace molecular::util;
+
+/// Read list of paths separated by newlines or semicolons, like contents.txt
+static std::vector<std::string> ReadFileList(const std::string& path)
+{
+	FileReadStorage storage(path);
+	const auto text = StringUtils::FromStorage(storage);
+	std::vector<std::string> list;
+	std::string current;
+	for(char c: text)
+	{
+		if(c == '\n' || c == '\r' || c == ';')
+		{
+			if(!current.empty())
+				list.push_back(current);
+			current.clear();
+		}
+		else
+			current.push_back(c);
+	}
+	if(!current.empty())
+		list.push_back(current);
+	return list;
+}
+
+static std::vector<uint8_t> ReadContents(const std::string& path)
+{
+	FileReadStorage storage(path);
+	std::vector<uint8_t> contents(storage.GetSize());
+	if(storage.Read(contents.data(), contents.size()) != contents.size())
+		throw std::runtime_error("Cannot read " + path);
+	return contents;
+}
+
+/// Offset of the first mip level in texture files, zero for other files
+/** Aligning this instead of the file header lets the largest mip level of a
+	memory-mapped texture start on a page boundary. */
+static uint64_t GetPayloadOffset(const std::vector<uint8_t>& contents)
+{
+	const void* data = contents.data();
+	const size_t size = contents.size();
+	const uint8_t* image = nullptr;
+	if(FileTypeIdentification::IsDds(data, size))
+	{
+		DdsFile file(data, size);
+		unsigned int width = 0, height = 0;
+		size_t imageSize = 0;
+		image = static_cast<const uint8_t*>(file.GetSingleImage(0, 0, width, height, imageSize));
+	}
+	else if(FileTypeIdentification::IsKtx(data, size))
+		image = static_cast<const uint8_t*>(KtxFile(data, size).GetImageData(0).first);
+	else if(FileTypeIdentification::IsTga(data, size))
+		image = static_cast<const uint8_t*>(TgaFile2(data, size).GetImageData());
+
+	return image ? image - contents.data() : 0;
+}
+
+/// Replace linear mesh bounds collections by hashed ones
+/** Other files are returned unchanged. */
+static std::vector<uint8_t> Cook(std::vector<uint8_t> contents)
+{
+	using gfx::MeshBoundsCollectionFile;
+	if(contents.size() < sizeof(MeshBoundsCollectionFile) || !FileTypeIdentification::IsMeshBoundsCollection(contents.data(), contents.size()))
+		return contents;
+	const MeshBoundsCollectionFile& file = *reinterpret_cast<const MeshBoundsCollectionFile*>(contents.data());
+	if(file.magic != MeshBoundsCollectionFile::kMagic || file.count == 0)
+		return contents;
+	if(contents.size() < sizeof(MeshBoundsCollectionFile) + file.count * (sizeof(Hash) + sizeof(AxisAlignedBox)))
+		throw std::runtime_error("Mesh bounds collection is truncated");
+	return MeshBoundsCollectionFile::BuildHashed(file.hashes, &file.GetBoundsByIndex(0), file.count);
+}
+
+/// Contents as stored in the package
+/** Compressed if that saves at least an eighth. Files that happen to start
+	like a BlockCompressedFile are always compressed, so they cannot be
+	mistaken for one. */
+static std::vector<uint8_t> Encode(std::vector<uint8_t> contents, bool compress)
+{
+	if(!compress)
+		return contents;
+	std::vector<uint8_t> compressed = BlockCompression::Compress(contents.data(), contents.size());
+	if(compressed.size() <= contents.size() - contents.size() / 8 || BlockCompression::IsCompressed(contents.data(), contents.size()))
+		return compressed;
+	return contents;
+}
+
+void Run(int argc, char** argv)
+{
+	CommandLineParser cmd;
+	CommandLineParser::Option<std::string> root(cmd, "root", "Directory the listed paths are relative to", ".");
+	CommandLineParser::Option<std::string> files(cmd, "files", "List of files to pack, contents.txt in root if empty", "");
+	CommandLineParser::Option<std::string> order(cmd, "order", "Files in the order they are loaded. Listed files are stored first, in this order", "");
+	CommandLineParser::Option<std::string> output(cmd, "output", "Package file to write", "package.pak");
+	CommandLineParser::Option<int> alignment(cmd, "alignment", "Alignment of file payloads in bytes", PackageFileWriter::kDefaultAlignment);
+	CommandLineParser::Option<int> compress(cmd, "compress", "Compress files with BlockCompression if not 0", 0);
+	cmd.Parse(argc, argv);
+
+	const std::string rootDir = *root + "/";
+	std::vector<std::string> paths = ReadFileList((*files).empty() ? rootDir + "contents.txt" : *files);
+	if(!(*order).empty())
+	{
+		// Files in the access order first, then the rest in list order:
+		const std::unordered_set<std::string> available(paths.begin(), paths.end());
+		std::unordered_set<std::string> ordered;
+		std::vector<std::string> sortedPaths;
+		for(auto& path: ReadFileList(*order))
+		{
+			if(available.count(path) && ordered.insert(path).second)
+				sortedPaths.push_back(path);
+		}
+		for(auto& path: paths)
+		{
+			if(!ordered.count(path))
+				sortedPaths.push_back(path);
+		}
+		paths.swap(sortedPaths);
+	}
+
+	const bool compressFiles = *compress != 0;
+	PackageFileWriter writer(*alignment, compressFiles ? HashedPackageFile::kCompressedEntries : 0);
+	// Only sizes and payload offsets are kept from this pass, so memory use
+	// does not grow with the package size:
+	for(auto& path: paths)
+	{
+		const std::vector<uint8_t> contents = Cook(ReadContents(rootDir + path));
+		const std::vector<uint8_t> encoded = Encode(contents, compressFiles);
+		// Payload alignment only matters for data that can be used in place:
+		const bool compressed = compressFiles && BlockCompression::IsCompressed(encoded.data(), encoded.size());
+		const uint64_t payloadOffset = compressed ? 0 : GetPayloadOffset(contents);
+		writer.AddFile(HashUtils::MakeHash(path), encoded.size(), payloadOffset);
+	}
+
+	FileWriteStorage storage((*output).c_str());
+	// Cooking and encoding are deterministic, Write() checks the sizes:
+	writer.Write(storage, [&](size_t index){
+		return Encode(Cook(ReadContents(rootDir + paths[index])), compressFiles);
+	});
+	std::cout << "Wrote " << *output << ": " << writer.GetFileCount() << " files, "
+			<< writer.GetPackageSize() << " bytes" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		Run(argc, argv);
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}